@@ -0,0 +1,1065 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/*
+ * Replay benchmark for the 802.11 frame and IE parsers.
+ *
+ * Runs a corpus of beacon, probe, association, action, EAPOL and data frames
+ * through the 802.11 phy's dissectors and reports ns and heap allocations per
+ * frame for each frame type, and per call for the IE walk and each typed IE
+ * parser the IE dissector dispatches to.
+ *
+ * The built-in corpus is modeled on frames from common APs and clients: HT,
+ * VHT and HE capabilities, RSN and WPA, WMM, WPS, P2P, OWE transition and
+ * Cisco vendor IEs, EAPOL-Key handshake frames and a WPS EAP exchange.  A
+ * classic pcap file (DLT 105 or 127) can be given to replay captured frames
+ * instead.
+ *
+ * The phy is registered against the same core the server builds for it (entry,
+ * time, packet chain, alert and device trackers, with a default config and an
+ * httpd which is never started), and each frame is handed to it as a packet from
+ * the packet chain pool.  The frame totals cover the top-level dissector and the
+ * IE, EAPOL and WPS dissectors the tracker calls; they do not include device
+ * tracking or logging.
+ *
+ * Usage: dot11_dissect_bench [iterations] [capture.pcap]
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "alertracker.h"
+#include "configfile.h"
+#include "devicetracker.h"
+#include "entrytracker.h"
+#include "eventbus.h"
+#include "globalregistry.h"
+#include "kis_httpd_registry.h"
+#include "kis_net_beast_httpd.h"
+#include "messagebus.h"
+#include "packetchain.h"
+#include "phy_80211.h"
+#include "streamtracker.h"
+#include "timetracker.h"
+#include "util.h"
+
+#include "dot11_parsers/dot11_ie.h"
+#include "dot11_parsers/dot11_ie_7_country.h"
+#include "dot11_parsers/dot11_ie_11_qbss.h"
+#include "dot11_parsers/dot11_ie_33_power.h"
+#include "dot11_parsers/dot11_ie_36_supported_channels.h"
+#include "dot11_parsers/dot11_ie_45_ht_cap.h"
+#include "dot11_parsers/dot11_ie_48_rsn.h"
+#include "dot11_parsers/dot11_ie_54_mobility.h"
+#include "dot11_parsers/dot11_ie_61_ht_op.h"
+#include "dot11_parsers/dot11_ie_133_cisco_ccx.h"
+#include "dot11_parsers/dot11_ie_150_cisco_powerlevel.h"
+#include "dot11_parsers/dot11_ie_191_vht_cap.h"
+#include "dot11_parsers/dot11_ie_192_vht_op.h"
+#include "dot11_parsers/dot11_ie_221_cisco_client_mfp.h"
+#include "dot11_parsers/dot11_ie_221_dji_droneid.h"
+#include "dot11_parsers/dot11_ie_221_ms_wps.h"
+#include "dot11_parsers/dot11_ie_221_wfa.h"
+#include "dot11_parsers/dot11_ie_221_wfa_wpa.h"
+#include "dot11_parsers/dot11_ie_221_wpa_transition.h"
+#include "dot11_parsers/dot11_ie_255_ext_tag.h"
+#include "dot11_parsers/dot11_p2p_ie.h"
+
+// Count every heap allocation made through operator new, which covers make_shared,
+// the pools' fallback allocations, and std::string and std::vector growth.  The
+// benchmark itself is single threaded, but the event bus runs its own thread.
+//
+// The default array, nothrow and aligned forms all land here or in the matching
+// delete.  GCC sees free() called on memory from operator new once the replacement
+// delete is inlined into this file, which is the pairing we want.
+static std::atomic<uint64_t> alloc_count {0};
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(size_t sz) {
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+
+    void *p = malloc(sz == 0 ? 1 : sz);
+    if (p == nullptr)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+#pragma GCC diagnostic pop
+
+// Keep parser results live so the calls can't be discarded
+static uint64_t sink = 0;
+
+// IE parsers, dispatched the way packet_dot11_ie_dissector does: by tag number, and
+// for vendor tags by OUI and, where the dissector checks it, OUI type
+struct ie_parser {
+    const char *name;
+    uint8_t tag_num;
+    uint32_t oui;
+    int oui_type;
+    void (*parse)(const dot11_ie::dot11_ie_tag& tag);
+};
+
+static bool ie_parser_match(const ie_parser& p, const dot11_ie::dot11_ie_tag& tag) {
+    if (tag.tag_num() != p.tag_num)
+        return false;
+
+    if (p.oui == 0)
+        return true;
+
+    return tag.vendor_oui_int() == p.oui &&
+        (p.oui_type < 0 || tag.vendor_oui_type() == p.oui_type);
+}
+
+static void parse_ie_7(const dot11_ie::dot11_ie_tag& tag) {
+    dot11_ie_7_country dot11d;
+    dot11d.set_allow_fragments(true);
+    dot11d.parse(tag.tag_data());
+    dot11d.parse_channels();
+    sink += dot11d.country_list()->size();
+}
+
+static void parse_ie_11(const dot11_ie::dot11_ie_tag& tag) {
+    auto qbss = Globalreg::new_from_pool<dot11_ie_11_qbss>();
+    qbss->parse(tag.tag_data());
+    sink += qbss->station_count();
+}
+
+static void parse_ie_33(const dot11_ie::dot11_ie_tag& tag) {
+    auto power = Globalreg::new_from_pool<dot11_ie_33_power>();
+    power->parse(tag.tag_data());
+    sink += power->max_power();
+}
+
+static void parse_ie_36(const dot11_ie::dot11_ie_tag& tag) {
+    auto channels = Globalreg::new_from_pool<dot11_ie_36_supported_channels>();
+    channels->parse(tag.tag_data());
+    sink += channels->supported_channels().size();
+}
+
+static void parse_ie_45(const dot11_ie::dot11_ie_tag& tag) {
+    auto ht = Globalreg::new_from_pool<dot11_ie_45_ht_cap>();
+    ht->parse(tag.tag_data());
+    sink += ht->ht_capabilities();
+}
+
+static void parse_ie_48(const dot11_ie::dot11_ie_tag& tag) {
+    try {
+        auto rsn = Globalreg::new_from_pool<dot11_ie_48_rsn>();
+        rsn->parse(tag.tag_data());
+
+        sink += rsn->group_cipher()->cipher_type();
+        for (const auto& c : *rsn->pairwise_ciphers())
+            sink += c->cipher_type();
+        for (const auto& a : *rsn->akm_ciphers())
+            sink += a->management_type();
+    } catch (const std::exception& e) {
+        // The dissector falls back to the group cipher of a truncated RSN tag
+        auto rsn = Globalreg::new_from_pool<dot11_ie_48_rsn_partial>();
+        rsn->parse(tag.tag_data());
+        sink += rsn->rsn_version();
+    }
+}
+
+static void parse_ie_54(const dot11_ie::dot11_ie_tag& tag) {
+    auto mobility = Globalreg::new_from_pool<dot11_ie_54_mobility>();
+    mobility->parse(tag.tag_data());
+    sink += mobility->mobility_domain();
+}
+
+static void parse_ie_61(const dot11_ie::dot11_ie_tag& tag) {
+    auto ht = Globalreg::new_from_pool<dot11_ie_61_ht_op>();
+    ht->parse(tag.tag_data());
+    sink += ht->primary_channel();
+}
+
+static void parse_ie_133(const dot11_ie::dot11_ie_tag& tag) {
+    auto ccx = Globalreg::new_from_pool<dot11_ie_133_cisco_ccx>();
+    ccx->parse(tag.tag_data());
+    sink += ccx->station_count();
+}
+
+static void parse_ie_150_cisco(const dot11_ie::dot11_ie_tag& tag) {
+    auto power = Globalreg::new_from_pool<dot11_ie_150_cisco_powerlevel>();
+    power->parse(tag.vendor_tag_data());
+    sink += power->cisco_ccx_txpower();
+}
+
+static void parse_ie_191(const dot11_ie::dot11_ie_tag& tag) {
+    auto vht = Globalreg::new_from_pool<dot11_ie_191_vht_cap>();
+    vht->parse(tag.tag_data());
+    sink += vht->vht_cap_80mhz_shortgi();
+}
+
+static void parse_ie_192(const dot11_ie::dot11_ie_tag& tag) {
+    auto vht = Globalreg::new_from_pool<dot11_ie_192_vht_op>();
+    vht->parse(tag.tag_data());
+    sink += vht->center1();
+}
+
+static void parse_ie_221_dji(const dot11_ie::dot11_ie_tag& tag) {
+    auto droneid = Globalreg::new_from_pool<dot11_ie_221_dji_droneid>();
+    droneid->parse(tag.vendor_tag_data());
+    sink += droneid->subcommand();
+}
+
+static void parse_ie_221_wpa(const dot11_ie::dot11_ie_tag& tag) {
+    auto wpa = Globalreg::new_from_pool<dot11_ie_221_wfa_wpa>();
+    wpa->parse(tag.vendor_tag_data());
+
+    sink += wpa->multicast_cipher()->cipher_type();
+    for (const auto& c : *wpa->unicast_ciphers())
+        sink += c->cipher_type();
+    for (const auto& a : *wpa->akm_ciphers())
+        sink += a->cipher_type();
+}
+
+static void parse_ie_221_mfp(const dot11_ie::dot11_ie_tag& tag) {
+    auto mfp = Globalreg::new_from_pool<dot11_ie_221_cisco_client_mfp>();
+    mfp->parse(tag.vendor_tag_data());
+    sink += mfp->client_mfp();
+}
+
+static void parse_ie_221_owe(const dot11_ie::dot11_ie_tag& tag) {
+    auto owe = Globalreg::new_from_pool<dot11_ie_221_owe_transition>();
+    owe->parse(tag.vendor_tag_data());
+    sink += owe->ssid().length();
+}
+
+static void parse_ie_221_wfa(const dot11_ie::dot11_ie_tag& tag) {
+    auto wfa = Globalreg::new_from_pool<dot11_ie_221_wfa>();
+    wfa->parse(tag.vendor_tag_data());
+
+    if (wfa->wfa_subtype() == dot11_ie_221_wfa::wfa_sub_p2p()) {
+        auto p2p = Globalreg::new_from_pool<dot11_wfa_p2p_ie>();
+        p2p->parse(wfa->wfa_content());
+
+        for (const auto& t : *p2p->tags())
+            sink += t->tag_len();
+    }
+}
+
+static void parse_ie_221_wps(const dot11_ie::dot11_ie_tag& tag) {
+    auto wps = Globalreg::new_from_pool<dot11_ie_221_ms_wps>();
+    wps->parse(tag.vendor_tag_data());
+    sink += wps->wps_elements()->size();
+}
+
+static void parse_ie_255(const dot11_ie::dot11_ie_tag& tag) {
+    dot11_ie_255_ext ext;
+    ext.parse(tag.tag_data());
+    sink += ext.subtag_num();
+}
+
+static const ie_parser ie_parsers[] = {
+    { "7 country", 7, 0, -1, parse_ie_7 },
+    { "11 qbss", 11, 0, -1, parse_ie_11 },
+    { "33 power", 33, 0, -1, parse_ie_33 },
+    { "36 channels", 36, 0, -1, parse_ie_36 },
+    { "45 ht cap", 45, 0, -1, parse_ie_45 },
+    { "48 rsn", 48, 0, -1, parse_ie_48 },
+    { "54 mobility", 54, 0, -1, parse_ie_54 },
+    { "61 ht op", 61, 0, -1, parse_ie_61 },
+    { "133 cisco ccx", 133, 0, -1, parse_ie_133 },
+    { "150 cisco power", 150, dot11_ie_150_cisco_powerlevel::cisco_oui(), -1, parse_ie_150_cisco },
+    { "191 vht cap", 191, 0, -1, parse_ie_191 },
+    { "192 vht op", 192, 0, -1, parse_ie_192 },
+    { "221 dji droneid", 221, dot11_ie_221_dji_droneid::vendor_oui(), -1, parse_ie_221_dji },
+    { "221 wpa", 221, dot11_ie_221_wfa_wpa::ms_wps_oui(),
+        dot11_ie_221_wfa_wpa::wfa_wpa_subtype(), parse_ie_221_wpa },
+    { "221 cisco mfp", 221, dot11_ie_221_cisco_client_mfp::cisco_oui(),
+        dot11_ie_221_cisco_client_mfp::client_mfp_subtype(), parse_ie_221_mfp },
+    { "221 owe transition", 221, dot11_ie_221_owe_transition::vendor_oui(),
+        (int) dot11_ie_221_owe_transition::owe_transition_subtype(), parse_ie_221_owe },
+    { "221 wfa/p2p", 221, dot11_ie_221_wfa::wfa_oui(), -1, parse_ie_221_wfa },
+    { "221 wps", 221, dot11_ie_221_ms_wps::ms_wps_oui(),
+        dot11_ie_221_ms_wps::ms_wps_subtype(), parse_ie_221_wps },
+    { "255 ext (he)", 255, 0, -1, parse_ie_255 },
+};
+
+static const size_t num_ie_parsers = sizeof(ie_parsers) / sizeof(ie_parser);
+
+enum frame_kind {
+    kind_beacon, kind_probe_req, kind_probe_resp, kind_assoc_req,
+    kind_action, kind_eapol, kind_data, kind_other, kind_max
+};
+
+static const char *frame_kind_names[] = {
+    "beacon", "probe req", "probe resp", "assoc req",
+    "action", "eapol", "data", "other"
+};
+
+// The phy and the packet chain state it dissects into
+static kis_80211_phy *phy = nullptr;
+static std::shared_ptr<packet_chain> packetchain;
+static int pack_comp_linkframe, pack_comp_80211;
+
+// Handshake records are built against a device; this one is never tracked
+static std::shared_ptr<dot11_tracked_device> eapol_dev;
+
+// Bring up the parts of the server the 802.11 phy needs, in the order kismet_server
+// creates them, and register the phy.  The httpd is created but never started, and
+// no timer or packet processing threads are spawned.
+static bool start_phy() {
+    Globalreg::globalreg = new global_registry();
+
+    auto entrytracker = entry_tracker::create_entrytracker();
+
+    Globalreg::globalreg->server_uuid =
+        entrytracker->register_and_get_field_as<tracker_element_uuid>("kismet.server.uuid",
+                tracker_element_factory<tracker_element_uuid>(),
+                "unique server UUID");
+
+    time_tracker::create_timetracker();
+    event_bus::create_eventbus();
+    Globalreg::globalreg->messagebus = message_bus::create_messagebus();
+
+    // Every option takes its default
+    Globalreg::globalreg->kismet_config = new config_file();
+
+    kis_net_beast_httpd::create_httpd();
+    stream_tracker::create_streamtracker();
+    kis_httpd_registry::create_http_registry();
+    packetchain = packet_chain::create_packetchain();
+    alert_tracker::create_alertracker();
+    auto devicetracker = device_tracker::create_device_tracker();
+
+    if (Globalreg::globalreg->fatal_condition)
+        return false;
+
+    auto phyid = devicetracker->register_phy_handler(new kis_80211_phy());
+    phy = dynamic_cast<kis_80211_phy *>(devicetracker->fetch_phy_handler(phyid));
+
+    if (phy == nullptr)
+        return false;
+
+    pack_comp_linkframe = packetchain->register_packet_component("LINKFRAME");
+    pack_comp_80211 = packetchain->register_packet_component("PHY80211");
+
+    eapol_dev = std::make_shared<dot11_tracked_device>(entrytracker->get_field_id("dot11.device"));
+
+    return true;
+}
+
+// Run a frame through the phy's dissectors the way the packet chain and the tracker
+// do: the top-level dissector, then the IE dissector for management frames and the
+// EAPOL and WPS dissectors for data frames.  The frame type and the dissected
+// record are only returned when asked for.  Malformed frames are counted, not fatal.
+static bool dissect_frame(const std::string& frame, frame_kind *kind = nullptr,
+        std::shared_ptr<dot11_packinfo> *info = nullptr) {
+    auto pack = packetchain->generate_packet();
+
+    auto chunk = packetchain->new_packet_component<kis_datachunk>();
+    chunk->dlt = KDLT_IEEE802_11;
+    chunk->set_data(nonstd::string_view(frame.data(), frame.length()));
+
+    pack->original_len = frame.length();
+    pack->insert(pack_comp_linkframe, chunk);
+
+    frame_kind k = kind_other;
+    bool ok = true;
+
+    try {
+        phy->packet_dot11_dissector(pack);
+
+        auto packinfo = pack->fetch<dot11_packinfo>(pack_comp_80211);
+
+        if (packinfo == nullptr || packinfo->corrupt) {
+            ok = false;
+        } else if (packinfo->type == packet_management) {
+            switch (packinfo->subtype) {
+                case packet_sub_beacon:
+                    k = kind_beacon;
+                    break;
+                case packet_sub_probe_req:
+                    k = kind_probe_req;
+                    break;
+                case packet_sub_probe_resp:
+                    k = kind_probe_resp;
+                    break;
+                case packet_sub_association_req:
+                case packet_sub_reassociation_req:
+                    k = kind_assoc_req;
+                    break;
+                case packet_sub_action:
+                    k = kind_action;
+                    break;
+                default:
+                    break;
+            }
+
+            if (phy->packet_dot11_ie_dissector(pack, packinfo) < 0)
+                ok = false;
+
+            sink += packinfo->ietag_csum;
+        } else if (packinfo->type == packet_data) {
+            k = kind_data;
+
+            auto eapol = phy->packet_dot11_eapol_handshake(pack, eapol_dev);
+
+            if (phy->packet_dot11_wps_m3(pack) || eapol != nullptr)
+                k = kind_eapol;
+        }
+
+        if (info != nullptr)
+            *info = packinfo;
+    } catch (const std::exception& e) {
+        ok = false;
+    }
+
+    if (kind != nullptr)
+        *kind = k;
+
+    return ok;
+}
+
+struct bench_result {
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    uint64_t allocs = 0;
+    double ns = 0;
+};
+
+template<typename T, typename F>
+static bench_result run(const std::vector<T>& items, unsigned int iterations, F&& fn) {
+    bench_result r;
+
+    if (items.empty())
+        return r;
+
+    uint64_t start_allocs = alloc_count;
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned int i = 0; i < iterations; i++) {
+        for (const auto& item : items) {
+            if (!fn(item))
+                r.errors++;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    r.calls = (uint64_t) items.size() * iterations;
+    r.allocs = alloc_count - start_allocs;
+    r.ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    return r;
+}
+
+static void print_result(const char *name, const bench_result& r, unsigned int iterations) {
+    if (r.calls == 0)
+        return;
+
+    printf("%-22s %10lu %12.1f %12.2f %8lu\n", name,
+            (unsigned long) (r.calls / iterations),
+            r.ns / r.calls, (double) r.allocs / r.calls,
+            (unsigned long) (r.errors / iterations));
+}
+
+class frame_builder {
+public:
+    frame_builder& u8(uint8_t v) {
+        data.push_back((char) v);
+        return *this;
+    }
+
+    frame_builder& u16le(uint16_t v) {
+        return u8(v & 0xFF).u8(v >> 8);
+    }
+
+    frame_builder& u16be(uint16_t v) {
+        return u8(v >> 8).u8(v & 0xFF);
+    }
+
+    frame_builder& u32be(uint32_t v) {
+        return u16be(v >> 16).u16be(v & 0xFFFF);
+    }
+
+    frame_builder& bytes(const std::string& v) {
+        data.append(v);
+        return *this;
+    }
+
+    frame_builder& fill(size_t len, uint8_t v) {
+        data.append(len, (char) v);
+        return *this;
+    }
+
+    frame_builder& oui(uint32_t v) {
+        return u8((v >> 16) & 0xFF).u8((v >> 8) & 0xFF).u8(v & 0xFF);
+    }
+
+    frame_builder& ie(uint8_t tag, const std::string& content) {
+        return u8(tag).u8(content.length()).bytes(content);
+    }
+
+    // Management header with fixed AP, client and broadcast addresses
+    frame_builder& mgmt(uint8_t fc0, bool from_ap) {
+        u8(fc0).u8(0).u16le(0);
+        bytes(from_ap ? bcast : ap).bytes(from_ap ? ap : client).bytes(from_ap ? ap : bcast);
+        return u16le(0x1230);
+    }
+
+    frame_builder& beacon_fixed() {
+        return fill(8, 0x5a).u16le(100).u16le(0x0431);
+    }
+
+    std::string data;
+
+    static const std::string ap, client, bcast;
+};
+
+const std::string frame_builder::ap("\x00\x11\x22\x33\x44\x55", 6);
+const std::string frame_builder::client("\x02\xaa\xbb\xcc\xdd\xee", 6);
+const std::string frame_builder::bcast("\xff\xff\xff\xff\xff\xff", 6);
+
+static std::string ie_content(const std::function<void (frame_builder&)>& fn) {
+    frame_builder b;
+    fn(b);
+    return b.data;
+}
+
+static std::string rsn_ie(bool sae) {
+    return ie_content([sae](frame_builder& b) {
+        b.u16le(1).oui(0x000fac).u8(4);
+        b.u16le(1).oui(0x000fac).u8(4);
+        b.u16le(sae ? 2 : 1).oui(0x000fac).u8(2);
+        if (sae)
+            b.oui(0x000fac).u8(8);
+        b.u16le(sae ? 0x00cc : 0x000c);
+    });
+}
+
+static std::string wpa_ie() {
+    return ie_content([](frame_builder& b) {
+        b.oui(0x0050f2).u8(1).u16le(1);
+        b.oui(0x0050f2).u8(2);
+        b.u16le(2).oui(0x0050f2).u8(4).oui(0x0050f2).u8(2);
+        b.u16le(1).oui(0x0050f2).u8(2);
+    });
+}
+
+static std::string wmm_ie() {
+    return ie_content([](frame_builder& b) {
+        b.oui(0x0050f2).u8(2).u8(1).u8(1).u8(0x81).u8(0);
+        b.u8(0x03).u8(0xa4).u16le(0);
+        b.u8(0x27).u8(0xa4).u16le(0);
+        b.u8(0x42).u8(0x43).u16le(0x5e);
+        b.u8(0x62).u8(0x32).u16le(0x2f);
+    });
+}
+
+static std::string wps_ie(bool ap) {
+    auto str = [](frame_builder& b, uint16_t type, const std::string& s) {
+        b.u16be(type).u16be(s.length()).bytes(s);
+    };
+
+    return ie_content([ap, str](frame_builder& b) {
+        b.oui(0x0050f2).u8(4);
+        b.u16be(0x104a).u16be(1).u8(0x10);
+        if (ap) {
+            b.u16be(0x1044).u16be(1).u8(0x02);
+            b.u16be(0x1057).u16be(1).u8(0x00);
+        } else {
+            b.u16be(0x103a).u16be(1).u8(0x00);
+            b.u16be(0x1008).u16be(2).u16be(0x4388);
+        }
+        b.u16be(0x1047).u16be(16).fill(16, 0x3c);
+        str(b, 0x1021, "NETGEAR, Inc.");
+        str(b, 0x1023, "R7000");
+        str(b, 0x1024, "R7000");
+        str(b, 0x1042, "4R512B5C00A31");
+        b.u16be(0x1054).u16be(8).u16be(6).u32be(0x0050f204).u16be(1);
+        str(b, 0x1011, ap ? "R7000" : "Pixel 7");
+        b.u16be(0x103c).u16be(1).u8(0x03);
+        b.u16be(0x1049).u16be(6).oui(0x00372a).u8(0x00).u8(0x01).u8(0x20);
+    });
+}
+
+static std::string p2p_ie() {
+    return ie_content([](frame_builder& b) {
+        b.oui(0x506f9a).u8(9);
+        b.u8(2).u16le(2).u8(0x25).u8(0x00);
+        b.u8(13).u16le(6 + 2 + 8 + 1 + 4 + 11);
+        b.bytes(frame_builder::client).u16be(0x0188);
+        b.u16be(10).u32be(0x0050f204).u16be(5).u8(0);
+        b.u16be(0x1011).u16be(11).bytes("DIRECT-roku");
+    });
+}
+
+static std::string owe_ie() {
+    return ie_content([](frame_builder& b) {
+        b.oui(0x506f9a).u8(28).bytes(frame_builder::ap).u8(9).bytes("owe-guest");
+    });
+}
+
+static std::string ht_cap_ie() {
+    return ie_content([](frame_builder& b) {
+        b.u16le(0x09ef).u8(0x17);
+        b.u8(0xff).u8(0xff).u8(0xff).fill(7, 0).u16le(0).u32be(0);
+        b.u16be(0).u32be(0).u8(0);
+    });
+}
+
+static std::string ht_op_ie() {
+    return ie_content([](frame_builder& b) {
+        b.u8(36).u8(0x05).u16be(0).u16be(0).u16le(0).fill(14, 0);
+    });
+}
+
+static std::string vht_cap_ie() {
+    return ie_content([](frame_builder& b) {
+        b.fill(4, 0).u16le(0xfffa).u16le(0).u16le(0xfffa).u16le(0);
+        b.data[0] = (char) 0xb2;
+        b.data[1] = (char) 0x01;
+        b.data[2] = (char) 0x80;
+        b.data[3] = (char) 0x33;
+    });
+}
+
+static std::string vht_op_ie() {
+    return ie_content([](frame_builder& b) {
+        b.u8(1).u8(42).u8(0).u16be(0xfcff);
+    });
+}
+
+static std::string he_cap_ie() {
+    return ie_content([](frame_builder& b) {
+        b.u8(35).u8(0x0d).u8(0x01).u8(0x08).u8(0x1a).u8(0x40).u8(0x00);
+        b.u8(0x04).u8(0x70).u8(0x0c).u8(0x89).u8(0x7f).u8(0x03).u8(0x80).u8(0x04).u8(0x00);
+        b.u16le(0xfffa).u16le(0xfffa).fill(4, 0xff);
+    });
+}
+
+static std::string he_op_ie() {
+    return ie_content([](frame_builder& b) {
+        b.u8(36).u8(0xf4).u8(0x3f).u8(0x00).u8(0x07).u8(0xfc).u8(0xff);
+    });
+}
+
+static std::string ext_caps_ie() {
+    return ie_content([](frame_builder& b) {
+        b.u8(0x04).u8(0x00).u8(0x08).u8(0x00).u8(0x00).u8(0x00).u8(0x00).u8(0x40);
+    });
+}
+
+static std::string rates_ie(bool ext) {
+    return ext ? "\x0c\x12\x18\x60" : "\x82\x84\x8b\x96\x24\x30\x48\x6c";
+}
+
+static std::string country_ie() {
+    return ie_content([](frame_builder& b) {
+        b.bytes("US").u8(0x20);
+        b.u8(1).u8(11).u8(30);
+        b.u8(36).u8(4).u8(23);
+        b.u8(52).u8(4).u8(24);
+        b.u8(100).u8(12).u8(24);
+        b.u8(149).u8(5).u8(30);
+        b.u8(0);
+    });
+}
+
+static std::string cisco_ccx_ie() {
+    return ie_content([](frame_builder& b) {
+        b.fill(10, 0).bytes("AP-3802-FLOOR2").fill(2, 0).u8(7).fill(3, 0);
+    });
+}
+
+static std::string cisco_power_ie() {
+    return ie_content([](frame_builder& b) {
+        b.oui(0x004096).u8(0).u8(17).u8(0);
+    });
+}
+
+static std::string cisco_mfp_ie() {
+    return ie_content([](frame_builder& b) {
+        b.oui(0x004096).u8(0x14).u8(0x01);
+    });
+}
+
+static std::string eapol_key(uint16_t key_info, uint64_t replay, const std::string& key_data) {
+    frame_builder k;
+    k.u8(2).u16be(key_info).u16be(16);
+    k.u32be(replay >> 32).u32be(replay & 0xFFFFFFFF);
+    k.fill(32, 0x6e).fill(16, 0).fill(8, 0).fill(8, 0);
+    k.fill(16, (key_info & 0x0100) ? 0x4d : 0x00);
+    k.u16be(key_data.length()).bytes(key_data);
+
+    frame_builder b;
+    b.u8(2).u8(3).u16be(k.data.length()).bytes(k.data);
+    return b.data;
+}
+
+static std::string eap_wps(uint8_t msg_type) {
+    frame_builder fields;
+    fields.u16be(0x104a).u16be(1).u8(0x10);
+    fields.u16be(0x1022).u16be(1).u8(msg_type);
+    fields.u16be(0x1039).u16be(16).fill(16, 0x4e);
+    fields.u16be(0x1014).u16be(32).fill(32, 0x48);
+    fields.u16be(0x1015).u16be(32).fill(32, 0x49);
+    fields.u16be(0x1005).u16be(8).fill(8, 0x41);
+
+    frame_builder eap;
+    eap.u8(1).u8(7).u16be(fields.data.length() + 14).u8(254);
+    eap.oui(0x00372a).u32be(1).u8(4).u8(0).bytes(fields.data);
+
+    frame_builder b;
+    b.u8(1).u8(0).u16be(eap.data.length()).bytes(eap.data);
+    return b.data;
+}
+
+static std::string qos_data(bool from_ap, const std::string& llc_payload) {
+    frame_builder b;
+    b.u8(0x88).u8(from_ap ? 0x02 : 0x01).u16le(0x2c);
+    if (from_ap)
+        b.bytes(frame_builder::client).bytes(frame_builder::ap).bytes(frame_builder::ap);
+    else
+        b.bytes(frame_builder::ap).bytes(frame_builder::client).bytes(frame_builder::ap);
+    b.u16le(0x5670).u16le(0x0006);
+    b.bytes(llc_payload);
+    return b.data;
+}
+
+static std::vector<std::string> builtin_corpus() {
+    std::vector<std::string> corpus;
+    std::string eapol_llc_str("\xaa\xaa\x03\x00\x00\x00\x88\x8e", 8);
+
+    // Enterprise AP beacon: 802.11ac with Cisco extensions and fast roaming
+    corpus.push_back(frame_builder().mgmt(0x80, true).beacon_fixed()
+            .ie(0, "CorpWireless").ie(1, rates_ie(false)).ie(3, "\x24")
+            .ie(5, std::string("\x00\x01\x00\x00", 4)).ie(7, country_ie())
+            .ie(11, std::string("\x05\x00\x2a\x12\x7a", 5))
+            .ie(45, ht_cap_ie()).ie(48, rsn_ie(false)).ie(54, "\x4a\x21\x01")
+            .ie(61, ht_op_ie()).ie(127, ext_caps_ie()).ie(133, cisco_ccx_ie())
+            .ie(150, cisco_power_ie()).ie(191, vht_cap_ie()).ie(192, vht_op_ie())
+            .ie(221, cisco_mfp_ie()).ie(221, wmm_ie()).data);
+
+    // Consumer 802.11ax AP beacon with WPS and WPA3 transition
+    corpus.push_back(frame_builder().mgmt(0x80, true).beacon_fixed()
+            .ie(0, "NETGEAR42").ie(1, rates_ie(false)).ie(3, "\x06")
+            .ie(5, std::string("\x00\x03\x00\x00", 4)).ie(7, country_ie())
+            .ie(42, std::string("\x00", 1)).ie(50, rates_ie(true))
+            .ie(45, ht_cap_ie()).ie(48, rsn_ie(true)).ie(61, ht_op_ie())
+            .ie(127, ext_caps_ie()).ie(191, vht_cap_ie()).ie(192, vht_op_ie())
+            .ie(255, he_cap_ie()).ie(255, he_op_ie())
+            .ie(221, wps_ie(true)).ie(221, wmm_ie()).data);
+
+    // Legacy WPA/WPA2 mixed mode beacon and an OWE transition beacon
+    corpus.push_back(frame_builder().mgmt(0x80, true).beacon_fixed()
+            .ie(0, "linksys").ie(1, rates_ie(false)).ie(3, "\x01")
+            .ie(5, std::string("\x00\x01\x00\x00", 4)).ie(42, std::string("\x04", 1))
+            .ie(50, rates_ie(true)).ie(48, rsn_ie(false)).ie(221, wpa_ie()).ie(221, wmm_ie()).data);
+
+    corpus.push_back(frame_builder().mgmt(0x80, true).beacon_fixed()
+            .ie(0, "").ie(1, rates_ie(false)).ie(3, "\x0b")
+            .ie(45, ht_cap_ie()).ie(48, rsn_ie(false)).ie(61, ht_op_ie())
+            .ie(221, owe_ie()).ie(221, wmm_ie()).data);
+
+    // Wi-Fi Direct group owner
+    corpus.push_back(frame_builder().mgmt(0x80, true).beacon_fixed()
+            .ie(0, "DIRECT-roku-830").ie(1, "\x8c\x12\x98\x24\xb0\x48\x60\x6c")
+            .ie(3, "\x95").ie(45, ht_cap_ie()).ie(48, rsn_ie(false)).ie(61, ht_op_ie())
+            .ie(221, wps_ie(true)).ie(221, p2p_ie()).ie(221, wmm_ie()).data);
+
+    // Wildcard and directed probe requests from a phone
+    corpus.push_back(frame_builder().mgmt(0x40, false)
+            .ie(0, "").ie(1, "\x02\x04\x0b\x16").ie(50, "\x0c\x12\x18\x24\x30\x48\x60\x6c")
+            .ie(3, "\x01").ie(45, ht_cap_ie()).ie(127, ext_caps_ie())
+            .ie(191, vht_cap_ie()).ie(255, he_cap_ie()).ie(221, wps_ie(false))
+            .ie(221, p2p_ie()).data);
+
+    corpus.push_back(frame_builder().mgmt(0x40, false)
+            .ie(0, "CorpWireless").ie(1, "\x02\x04\x0b\x16").ie(50, "\x0c\x12\x18\x24\x30\x48\x60\x6c")
+            .ie(45, ht_cap_ie()).ie(127, ext_caps_ie()).data);
+
+    // Probe response
+    corpus.push_back(frame_builder().mgmt(0x50, true).beacon_fixed()
+            .ie(0, "CorpWireless").ie(1, rates_ie(false)).ie(3, "\x24").ie(7, country_ie())
+            .ie(45, ht_cap_ie()).ie(48, rsn_ie(false)).ie(54, "\x4a\x21\x01")
+            .ie(61, ht_op_ie()).ie(191, vht_cap_ie()).ie(192, vht_op_ie())
+            .ie(221, cisco_mfp_ie()).ie(221, wmm_ie()).data);
+
+    // Association request with power and channel capabilities
+    corpus.push_back(frame_builder().mgmt(0x00, false).u16le(0x1431).u16le(10)
+            .ie(0, "CorpWireless").ie(1, rates_ie(false)).ie(33, "\x03\x14")
+            .ie(36, "\x24\x04\x34\x04\x64\x0b\x95\x05").ie(48, rsn_ie(false))
+            .ie(54, "\x4a\x21\x01").ie(45, ht_cap_ie()).ie(191, vht_cap_ie())
+            .ie(221, wmm_ie()).data);
+
+    // 802.11k neighbor report response and a block ack request
+    {
+        frame_builder nbr;
+        nbr.bytes(frame_builder::ap).u32be(0x8f000000).u8(115).u8(36).u8(9);
+
+        corpus.push_back(frame_builder().mgmt(0xd0, true).u8(5).u8(5).u8(1)
+                .ie(52, nbr.data).ie(52, nbr.data).data);
+        corpus.push_back(frame_builder().mgmt(0xd0, false).u8(3).u8(0).u8(1)
+                .u16le(0x1002).u16le(0).u16le(0x0010).data);
+    }
+
+    // WPA2 4-way handshake messages 1 and 2, and a WPS M3 exchange
+    corpus.push_back(qos_data(true, eapol_llc_str + eapol_key(0x008a, 1, "")));
+    corpus.push_back(qos_data(false, eapol_llc_str +
+                eapol_key(0x010a, 1, std::string("\x30\x14", 2) + rsn_ie(false))));
+    corpus.push_back(qos_data(false, eapol_llc_str + eap_wps(0x07)));
+
+    // Plain IPv4 data
+    corpus.push_back(qos_data(false, std::string("\xaa\xaa\x03\x00\x00\x00\x08\x00", 8) +
+                std::string(64, '\x45')));
+
+    return corpus;
+}
+
+// Strip the radiotap header, and the FCS if radiotap says it is present
+static bool radiotap_strip(std::string& frame) {
+    if (frame.length() < 8)
+        return false;
+
+    auto rt = (const uint8_t *) frame.data();
+    size_t it_len = rt[2] | (rt[3] << 8);
+    uint32_t present = rt[4] | (rt[5] << 8) | (rt[6] << 16) | ((uint32_t) rt[7] << 24);
+
+    if (it_len > frame.length())
+        return false;
+
+    // Skip extended present bitmaps to find the first field
+    size_t offt = 8;
+    uint32_t p = present;
+    while ((p & 0x80000000) && offt + 4 <= it_len) {
+        p = rt[offt] | (rt[offt + 1] << 8) | (rt[offt + 2] << 16) | ((uint32_t) rt[offt + 3] << 24);
+        offt += 4;
+    }
+
+    bool fcs = false;
+
+    if (present & 0x02) {
+        // Flags follow the 8-byte aligned TSFT, if there is one
+        if (present & 0x01)
+            offt = ((offt + 7) & ~7) + 8;
+
+        if (offt < it_len)
+            fcs = rt[offt] & 0x10;
+    }
+
+    frame.erase(0, it_len);
+
+    if (fcs) {
+        if (frame.length() < 4)
+            return false;
+        frame.resize(frame.length() - 4);
+    }
+
+    return true;
+}
+
+// DLT_IEEE802_11_RADIO, which only pcap.h defines
+static const uint32_t dlt_radiotap = 127;
+
+// Read a classic pcap file without libpcap; only 802.11 and radiotap are useful
+// here, anything else is rejected
+static bool load_pcap(const char *fname, std::vector<std::string>& corpus) {
+    std::ifstream f(fname, std::ios::binary);
+
+    if (!f) {
+        fprintf(stderr, "FATAL: could not open %s\n", fname);
+        return false;
+    }
+
+    uint8_t hdr[24];
+    if (!f.read((char *) hdr, sizeof(hdr))) {
+        fprintf(stderr, "FATAL: %s is too short to be a pcap file\n", fname);
+        return false;
+    }
+
+    uint32_t magic = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((uint32_t) hdr[3] << 24);
+    bool swapped;
+
+    if (magic == 0xa1b2c3d4 || magic == 0xa1b23c4d) {
+        swapped = false;
+    } else if (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1) {
+        swapped = true;
+    } else {
+        fprintf(stderr, "FATAL: %s is not a pcap file (pcapng is not supported)\n", fname);
+        return false;
+    }
+
+    auto u32 = [swapped](const uint8_t *b) -> uint32_t {
+        if (swapped)
+            return ((uint32_t) b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+        return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t) b[3] << 24);
+    };
+
+    uint32_t dlt = u32(hdr + 20);
+
+    if (dlt != KDLT_IEEE802_11 && dlt != dlt_radiotap) {
+        fprintf(stderr, "FATAL: %s has DLT %u, expected 802.11 (105) or radiotap (127)\n",
+                fname, dlt);
+        return false;
+    }
+
+    uint8_t rec[16];
+    while (f.read((char *) rec, sizeof(rec))) {
+        uint32_t caplen = u32(rec + 8);
+
+        if (caplen > 65535) {
+            fprintf(stderr, "FATAL: %s has an invalid record length %u\n", fname, caplen);
+            return false;
+        }
+
+        std::string frame(caplen, '\0');
+        if (!f.read(&frame[0], caplen))
+            break;
+
+        if (dlt == dlt_radiotap && !radiotap_strip(frame))
+            continue;
+
+        corpus.push_back(std::move(frame));
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int iterations = 20000;
+
+    if (argc > 1)
+        iterations = strtoul(argv[1], NULL, 10);
+
+    if (iterations == 0) {
+        fprintf(stderr, "usage: %s [iterations] [capture.pcap]\n", argv[0]);
+        return 1;
+    }
+
+    if (!start_phy()) {
+        fprintf(stderr, "FATAL: could not start the IEEE802.11 phy\n");
+        return 1;
+    }
+
+    std::vector<std::string> corpus;
+
+    if (argc > 2) {
+        if (!load_pcap(argv[2], corpus))
+            return 1;
+        printf("corpus: %zu frames from %s\n", corpus.size(), argv[2]);
+    } else {
+        corpus = builtin_corpus();
+        printf("corpus: %zu built-in frames\n", corpus.size());
+    }
+
+    if (corpus.empty()) {
+        fprintf(stderr, "FATAL: no frames to replay\n");
+        return 1;
+    }
+
+    // Sort the corpus by the frame type the dissector finds and collect the tags each
+    // IE parser sees; tags are parsed in place, so the views point into the corpus,
+    // which is not modified after this
+    std::vector<std::string> by_kind[kind_max];
+    std::vector<dot11_ie::dot11_ie_tag> by_parser[num_ie_parsers];
+    std::vector<std::pair<const std::string *, size_t>> ie_bodies;
+
+    for (const auto& frame : corpus) {
+        auto kind = kind_other;
+        std::shared_ptr<dot11_packinfo> packinfo;
+
+        dissect_frame(frame, &kind, &packinfo);
+
+        by_kind[kind].push_back(frame);
+
+        if (packinfo == nullptr || packinfo->ie_tags == nullptr)
+            continue;
+
+        ie_bodies.push_back(std::make_pair(&frame, (size_t) packinfo->header_offset));
+
+        for (const auto& tag : packinfo->ie_tags->tags()) {
+            for (size_t i = 0; i < num_ie_parsers; i++) {
+                if (ie_parser_match(ie_parsers[i], tag))
+                    by_parser[i].push_back(tag);
+            }
+        }
+    }
+
+    printf("%-22s %10s %12s %12s %8s\n", "parser", "calls/pass", "ns/call", "allocs/call", "errors");
+
+    auto walk_r = run(ie_bodies, iterations, [](const std::pair<const std::string *, size_t>& b) {
+        auto ie_tags = Globalreg::new_from_pool<dot11_ie>();
+
+        try {
+            ie_tags->parse(b.first->data() + b.second, b.first->length() - b.second);
+        } catch (const std::exception& e) {
+            return false;
+        }
+
+        sink += ie_tags->tags().size();
+        return true;
+    });
+    print_result("ie walk", walk_r, iterations);
+
+    for (size_t i = 0; i < num_ie_parsers; i++) {
+        auto r = run(by_parser[i], iterations, [i](const dot11_ie::dot11_ie_tag& tag) {
+            try {
+                ie_parsers[i].parse(tag);
+            } catch (const std::exception& e) {
+                return false;
+            }
+
+            return true;
+        });
+
+        print_result(ie_parsers[i].name, r, iterations);
+    }
+
+    printf("\n%-22s %10s %12s %12s %8s\n", "frame total", "frames/pass", "ns/frame", "allocs/frame", "errors");
+
+    auto frame_fn = [](const std::string& frame) {
+        return dissect_frame(frame);
+    };
+
+    for (unsigned int k = 0; k < kind_max; k++)
+        print_result(frame_kind_names[k], run(by_kind[k], iterations, frame_fn), iterations);
+
+    print_result("all", run(corpus, iterations, frame_fn), iterations);
+
+    fprintf(stderr, "(%016lx)\n", (unsigned long) sink);
+
+    return 0;
+}
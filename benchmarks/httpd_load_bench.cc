@@ -0,0 +1,950 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/*
+ * Load and latency benchmark for the REST and websocket API.
+ *
+ * Drives a mix of REST pollers and websocket subscribers against a Kismet
+ * server over loopback and reports requests/sec, latency percentiles and
+ * bytes per endpoint, websocket message rates and stalls, and the server
+ * thread count, RSS and CPU use sampled from /proc during the run.
+ *
+ * With --server the bench starts its own Kismet server in a scratch home
+ * directory, with logging disabled, a generated login, and a pcapfile source
+ * replaying a synthetic capture of beacons, probes and data frames from
+ * --devices devices at --pps packets per second, so that device tracking
+ * runs under the HTTP load.  --source replaces the synthetic capture with
+ * any other datasource definition.  Without --server the bench connects to
+ * an already running server with --user/--password or --apikey, and --pid
+ * enables the /proc sampling.
+ *
+ * REST pollers run closed loop over a keep-alive connection unless --rate
+ * limits each one to a number of requests per second.  The REST mix is a
+ * comma separated list of [POST ]uri[=weight]; POST entries send a
+ * summarized device field request the way the web UI polls.  The websocket
+ * mix is a list of devices|events[=weight]: 'devices' subscribes to every
+ * device through /devices/monitor.ws, 'events' to the timestamp and message
+ * events through /eventbus/events.ws.
+ *
+ * Usage: httpd_load_bench [options]
+ *   --server <kismet>     start and load this server binary
+ *   --source <def>        datasource for the started server
+ *   --devices <n>         devices in the synthetic capture (500)
+ *   --pps <n>             synthetic capture packet rate (1000)
+ *   --host <host>         server address (127.0.0.1)
+ *   --port <port>         server port (2501, 2599 with --server)
+ *   --user <user>         login user
+ *   --password <pass>     login password
+ *   --apikey <key>        API key, instead of a login
+ *   --pid <pid>           server process to sample, without --server
+ *   --rest <n>            REST clients (8)
+ *   --ws <n>              websocket clients (0)
+ *   --rate <n>            requests/sec per REST client, 0 for closed loop (0)
+ *   --mix <list>          REST endpoint mix
+ *   --ws-mix <list>       websocket subscription mix (devices=1,events=1)
+ *   --duration <sec>      measured run time (30)
+ *   --warmup <sec>        load time before measuring (5)
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/asio.hpp"
+#include "boost/beast.hpp"
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+namespace websocket = boost::beast::websocket;
+using tcp = boost::asio::ip::tcp;
+
+using bench_clock = std::chrono::steady_clock;
+
+struct bench_options {
+    std::string server;
+    std::string source;
+    unsigned int devices = 500;
+    unsigned int pps = 1000;
+
+    std::string host = "127.0.0.1";
+    std::string port;
+    std::string user;
+    std::string password;
+    std::string apikey;
+    pid_t pid = 0;
+
+    unsigned int rest_clients = 8;
+    unsigned int ws_clients = 0;
+    double rate = 0;
+    std::string mix =
+        "/system/status.json=4,"
+        "/datasource/all_sources.json=2,"
+        "/channels/channels.json=1,"
+        "/devices/views/all/devices.json=1,"
+        "/devices/last-time/-10/devices.json=2,"
+        "POST /devices/last-time/-10/devices.json=4";
+    std::string ws_mix = "devices=1,events=1";
+
+    unsigned int duration = 30;
+    unsigned int warmup = 5;
+};
+
+// Fields requested by POST entries and device monitor subscriptions, roughly what the
+// web UI device list asks for
+static const char *summary_fields[] = {
+    "kismet.device.base.macaddr",
+    "kismet.device.base.key",
+    "kismet.device.base.type",
+    "kismet.device.base.commonname",
+    "kismet.device.base.channel",
+    "kismet.device.base.signal/kismet.common.signal.last_signal",
+    "kismet.device.base.packets.total",
+    "kismet.device.base.last_time",
+    nullptr,
+};
+
+static std::string summary_fields_json() {
+    std::string r = "[";
+
+    for (unsigned int i = 0; summary_fields[i] != nullptr; i++) {
+        if (i > 0)
+            r += ",";
+        r += "\"" + std::string(summary_fields[i]) + "\"";
+    }
+
+    return r + "]";
+}
+
+static std::string url_encode(const std::string& in) {
+    static const char *hex = "0123456789ABCDEF";
+    std::string r;
+
+    for (auto c : in) {
+        if (isalnum((unsigned char) c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            r += c;
+        } else {
+            r += '%';
+            r += hex[((unsigned char) c) >> 4];
+            r += hex[((unsigned char) c) & 0x0F];
+        }
+    }
+
+    return r;
+}
+
+static std::string base64_encode(const std::string& in) {
+    static const char *b64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string r;
+    size_t i = 0;
+
+    for (; i + 2 < in.length(); i += 3) {
+        uint32_t v = ((uint8_t) in[i] << 16) | ((uint8_t) in[i + 1] << 8) | (uint8_t) in[i + 2];
+        r += b64[(v >> 18) & 0x3F];
+        r += b64[(v >> 12) & 0x3F];
+        r += b64[(v >> 6) & 0x3F];
+        r += b64[v & 0x3F];
+    }
+
+    if (i + 1 == in.length()) {
+        uint32_t v = (uint8_t) in[i] << 16;
+        r += b64[(v >> 18) & 0x3F];
+        r += b64[(v >> 12) & 0x3F];
+        r += "==";
+    } else if (i + 2 == in.length()) {
+        uint32_t v = ((uint8_t) in[i] << 16) | ((uint8_t) in[i + 1] << 8);
+        r += b64[(v >> 18) & 0x3F];
+        r += b64[(v >> 12) & 0x3F];
+        r += b64[(v >> 6) & 0x3F];
+        r += '=';
+    }
+
+    return r;
+}
+
+// Split a comma separated name=weight list; entries without a weight count once
+static std::vector<std::pair<std::string, unsigned int>> parse_mix(const std::string& mix) {
+    std::vector<std::pair<std::string, unsigned int>> r;
+    std::stringstream ss(mix);
+    std::string entry;
+
+    while (std::getline(ss, entry, ',')) {
+        if (entry.length() == 0)
+            continue;
+
+        unsigned int weight = 1;
+        auto eq = entry.rfind('=');
+
+        if (eq != std::string::npos) {
+            weight = strtoul(entry.substr(eq + 1).c_str(), NULL, 10);
+            entry = entry.substr(0, eq);
+        }
+
+        if (weight > 0)
+            r.push_back(std::make_pair(entry, weight));
+    }
+
+    return r;
+}
+
+// Per-endpoint results, merged from every client at the end of the run
+struct endpoint_stats {
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+    std::vector<uint32_t> latency_us;
+
+    void merge(const endpoint_stats& s) {
+        requests += s.requests;
+        errors += s.errors;
+        bytes += s.bytes;
+        latency_us.insert(latency_us.end(), s.latency_us.begin(), s.latency_us.end());
+    }
+};
+
+struct ws_stats {
+    uint64_t clients = 0;
+    uint64_t failed = 0;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t max_gap_us = 0;
+
+    void merge(const ws_stats& s) {
+        clients += s.clients;
+        failed += s.failed;
+        messages += s.messages;
+        bytes += s.bytes;
+        max_gap_us = std::max(max_gap_us, s.max_gap_us);
+    }
+};
+
+struct rest_request {
+    std::string name;
+    http::verb method;
+    std::string target;
+    std::string body;
+};
+
+// Shared run state; clients only count results while measuring is set
+struct bench_state {
+    std::atomic<bool> running{true};
+    std::atomic<bool> measuring{false};
+
+    std::mutex result_mutex;
+    std::map<std::string, endpoint_stats> endpoints;
+    std::map<std::string, ws_stats> websockets;
+};
+
+static void set_auth(http::fields& fields, const bench_options& opts) {
+    if (opts.apikey.length()) {
+        fields.set(http::field::cookie, "KISMET=" + opts.apikey);
+    } else if (opts.user.length()) {
+        fields.set(http::field::authorization,
+                "Basic " + base64_encode(opts.user + ":" + opts.password));
+    }
+}
+
+static void rest_client(const bench_options& opts, bench_state& state,
+        const std::vector<rest_request>& requests, unsigned int seed) {
+    std::map<std::string, endpoint_stats> local;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, requests.size() - 1);
+
+    auto interval = opts.rate > 0 ?
+        std::chrono::duration_cast<bench_clock::duration>(std::chrono::duration<double>(1.0 / opts.rate)) :
+        bench_clock::duration::zero();
+    auto next = bench_clock::now();
+
+    asio::io_context ioc;
+    tcp::resolver resolver(ioc);
+    std::unique_ptr<beast::tcp_stream> stream;
+    beast::flat_buffer buffer;
+
+    while (state.running) {
+        auto& req_def = requests[pick(rng)];
+        bool measured = state.measuring;
+
+        if (interval != bench_clock::duration::zero()) {
+            std::this_thread::sleep_until(next);
+            next += interval;
+
+            // Don't try to catch up after a stall; that measures the bench, not the server
+            if (next < bench_clock::now())
+                next = bench_clock::now();
+        }
+
+        auto start = bench_clock::now();
+
+        try {
+            if (stream == nullptr) {
+                stream = std::make_unique<beast::tcp_stream>(ioc);
+                stream->connect(resolver.resolve(opts.host, opts.port));
+                buffer.clear();
+            }
+
+            http::request<http::string_body> req{req_def.method, req_def.target, 11};
+            req.set(http::field::host, opts.host);
+            req.set(http::field::user_agent, "httpd_load_bench");
+            req.keep_alive(true);
+            set_auth(req.base(), opts);
+
+            if (req_def.body.length()) {
+                req.set(http::field::content_type, "application/x-www-form-urlencoded");
+                req.body() = req_def.body;
+            }
+
+            req.prepare_payload();
+
+            stream->expires_after(std::chrono::seconds(30));
+            http::write(*stream, req);
+
+            http::response_parser<http::string_body> parser;
+            parser.body_limit(boost::none);
+            http::read(*stream, buffer, parser);
+
+            auto& res = parser.get();
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(bench_clock::now() - start);
+
+            if (measured) {
+                auto& s = local[req_def.name];
+                s.requests++;
+                s.bytes += res.body().length();
+                s.latency_us.push_back(elapsed.count());
+
+                if (res.result_int() != 200)
+                    s.errors++;
+            }
+
+            if (!res.keep_alive())
+                stream.reset();
+
+        } catch (const std::exception& e) {
+            if (measured)
+                local[req_def.name].errors++;
+
+            stream.reset();
+
+            // Back off so a refused connection doesn't spin the client
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(state.result_mutex);
+    for (const auto& s : local)
+        state.endpoints[s.first].merge(s.second);
+}
+
+static void ws_client(const bench_options& opts, bench_state& state, const std::string& kind) {
+    ws_stats local;
+    local.clients = 1;
+
+    std::string target;
+    std::vector<std::string> subscribe;
+
+    if (kind == "devices") {
+        target = "/devices/monitor.ws";
+        subscribe.push_back("{\"monitor\":\"*\",\"request\":1,\"rate\":1,\"fields\":" +
+                summary_fields_json() + "}");
+    } else {
+        target = "/eventbus/events.ws";
+        subscribe.push_back("{\"SUBSCRIBE\":\"TIMESTAMP\"}");
+        subscribe.push_back("{\"SUBSCRIBE\":\"MESSAGE\"}");
+    }
+
+    if (opts.apikey.length())
+        target += "?KISMET=" + url_encode(opts.apikey);
+
+    try {
+        asio::io_context ioc;
+        tcp::resolver resolver(ioc);
+        websocket::stream<beast::tcp_stream> ws(ioc);
+
+        beast::get_lowest_layer(ws).expires_after(std::chrono::seconds(30));
+        beast::get_lowest_layer(ws).connect(resolver.resolve(opts.host, opts.port));
+        beast::get_lowest_layer(ws).expires_never();
+
+        ws.set_option(websocket::stream_base::decorator(
+                    [&opts](websocket::request_type& req) {
+                        req.set(http::field::user_agent, "httpd_load_bench");
+                        set_auth(req, opts);
+                    }));
+
+        ws.handshake(opts.host + ":" + opts.port, target);
+        ws.text(true);
+
+        for (const auto& s : subscribe)
+            ws.write(asio::buffer(s));
+
+        // Reads block, so the run end closes the socket from a watcher to unblock them
+        std::thread watcher([&state, &ws]() {
+                while (state.running)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                beast::error_code ec;
+                beast::get_lowest_layer(ws).socket().shutdown(tcp::socket::shutdown_both, ec);
+            });
+
+        beast::flat_buffer buffer;
+        auto last = bench_clock::now();
+
+        while (state.running) {
+            beast::error_code ec;
+            auto sz = ws.read(buffer, ec);
+
+            if (ec)
+                break;
+
+            buffer.consume(buffer.size());
+
+            auto now = bench_clock::now();
+
+            if (state.measuring) {
+                local.messages++;
+                local.bytes += sz;
+                local.max_gap_us = std::max<uint64_t>(local.max_gap_us,
+                        std::chrono::duration_cast<std::chrono::microseconds>(now - last).count());
+            }
+
+            last = now;
+        }
+
+        if (state.running)
+            local.failed = 1;
+
+        watcher.join();
+    } catch (const std::exception& e) {
+        fprintf(stderr, "websocket %s: %s\n", target.c_str(), e.what());
+        local.failed = 1;
+    }
+
+    std::lock_guard<std::mutex> lk(state.result_mutex);
+    state.websockets[kind].merge(local);
+}
+
+// Server thread count, RSS, and CPU time from /proc
+struct proc_sample {
+    unsigned int threads = 0;
+    unsigned long rss_kb = 0;
+    double cpu_sec = 0;
+};
+
+static bool sample_proc(pid_t pid, proc_sample& sample) {
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+
+    if (!status.is_open())
+        return false;
+
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 8, "Threads:") == 0)
+            sample.threads = strtoul(line.c_str() + 8, NULL, 10);
+        else if (line.compare(0, 6, "VmRSS:") == 0)
+            sample.rss_kb = strtoul(line.c_str() + 6, NULL, 10);
+    }
+
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string contents;
+    std::getline(stat, contents);
+
+    // utime and stime are fields 14 and 15, counted after the parenthesized command name
+    auto paren = contents.rfind(')');
+    if (paren != std::string::npos) {
+        std::stringstream ss(contents.substr(paren + 2));
+        std::string field;
+        unsigned long utime = 0, stime = 0;
+
+        for (unsigned int f = 3; f <= 15 && ss >> field; f++) {
+            if (f == 14)
+                utime = strtoul(field.c_str(), NULL, 10);
+            else if (f == 15)
+                stime = strtoul(field.c_str(), NULL, 10);
+        }
+
+        sample.cpu_sec = (double) (utime + stime) / sysconf(_SC_CLK_TCK);
+    }
+
+    return true;
+}
+
+static void put_le16(std::string& s, uint16_t v) {
+    s += (char) (v & 0xFF);
+    s += (char) (v >> 8);
+}
+
+static void put_le32(std::string& s, uint32_t v) {
+    for (unsigned int i = 0; i < 4; i++)
+        s += (char) ((v >> (i * 8)) & 0xFF);
+}
+
+static std::string dev_mac(unsigned int dev) {
+    // Locally administered unicast addresses
+    std::string mac;
+    mac += (char) 0x02;
+    mac += (char) 0x4B;
+    mac += (char) 0x49;
+    mac += (char) ((dev >> 16) & 0xFF);
+    mac += (char) ((dev >> 8) & 0xFF);
+    mac += (char) (dev & 0xFF);
+    return mac;
+}
+
+// A DLT 105 capture where one in eight devices is an AP sending beacons, and the rest are
+// clients of those APs sending probe requests and data.  Long enough to keep the source
+// replaying for the whole run at the requested rate.
+static bool write_synthetic_pcap(const std::string& fname, unsigned int devices, unsigned int frames) {
+    std::ofstream f(fname, std::ios::binary);
+
+    if (!f.is_open())
+        return false;
+
+    std::string hdr;
+    put_le32(hdr, 0xa1b2c3d4);
+    put_le16(hdr, 2);
+    put_le16(hdr, 4);
+    put_le32(hdr, 0);
+    put_le32(hdr, 0);
+    put_le32(hdr, 65535);
+    put_le32(hdr, 105);
+    f.write(hdr.data(), hdr.length());
+
+    const std::string bcast(6, (char) 0xFF);
+    unsigned int aps = std::max(1U, devices / 8);
+
+    for (unsigned int i = 0; i < frames; i++) {
+        unsigned int dev = i % devices;
+        unsigned int ap = dev % aps;
+        std::string frame;
+
+        if (dev < aps) {
+            // Beacon with an SSID, rates, and DS channel
+            std::string ssid = "bench-" + std::to_string(dev);
+            frame += std::string("\x80\x00\x00\x00", 4);
+            frame += bcast + dev_mac(dev) + dev_mac(dev);
+            put_le16(frame, (i & 0xFFF) << 4);
+            frame += std::string(8, '\0');
+            put_le16(frame, 100);
+            put_le16(frame, 0x0411);
+            frame += (char) 0;
+            frame += (char) ssid.length();
+            frame += ssid;
+            frame += std::string("\x01\x08\x82\x84\x8b\x96\x0c\x12\x18\x24", 10);
+            frame += std::string("\x03\x01", 2);
+            frame += (char) (1 + (dev % 11));
+        } else if ((i / devices) % 4 == 0) {
+            // Broadcast probe request
+            frame += std::string("\x40\x00\x00\x00", 4);
+            frame += bcast + dev_mac(dev) + bcast;
+            put_le16(frame, (i & 0xFFF) << 4);
+            frame += std::string("\x00\x00", 2);
+            frame += std::string("\x01\x08\x82\x84\x8b\x96\x0c\x12\x18\x24", 10);
+        } else {
+            // ToDS data to the AP
+            frame += std::string("\x08\x01\x00\x00", 4);
+            frame += dev_mac(ap) + dev_mac(dev) + dev_mac(ap);
+            put_le16(frame, (i & 0xFFF) << 4);
+            frame += std::string("\xaa\xaa\x03\x00\x00\x00\x08\x00", 8);
+            frame += std::string(64, '\0');
+        }
+
+        std::string rec;
+        put_le32(rec, 1700000000 + i / 1000);
+        put_le32(rec, (i % 1000) * 1000);
+        put_le32(rec, frame.length());
+        put_le32(rec, frame.length());
+        f.write(rec.data(), rec.length());
+        f.write(frame.data(), frame.length());
+    }
+
+    return f.good();
+}
+
+static pid_t start_server(const bench_options& opts, const std::string& workdir) {
+    auto conf = workdir + "/kismet_bench.conf";
+    std::ofstream f(conf);
+
+    f << "httpd_username=" << opts.user << "\n"
+        << "httpd_password=" << opts.password << "\n"
+        << "httpd_bind_address=127.0.0.1\n"
+        << "httpd_port=" << opts.port << "\n"
+        << "enable_logging=false\n";
+    f.close();
+
+    auto pid = fork();
+
+    if (pid < 0)
+        return -1;
+
+    if (pid == 0) {
+        auto log = open((workdir + "/kismet.log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (log >= 0) {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+
+        std::vector<std::string> args = {
+            opts.server, "--no-ncurses", "--no-line-wrap", "--no-plugins",
+            "--homedir", workdir, "--override", conf, "-c", opts.source,
+        };
+
+        std::vector<char *> argv;
+        for (auto& a : args)
+            argv.push_back(&a[0]);
+        argv.push_back(nullptr);
+
+        execvp(argv[0], argv.data());
+        fprintf(stderr, "FATAL: could not exec %s: %s\n", opts.server.c_str(), strerror(errno));
+        _exit(1);
+    }
+
+    return pid;
+}
+
+// Wait for the server to answer an authenticated status request
+static bool wait_for_server(const bench_options& opts, pid_t pid, unsigned int timeout) {
+    auto deadline = bench_clock::now() + std::chrono::seconds(timeout);
+
+    while (bench_clock::now() < deadline) {
+        if (pid > 0 && waitpid(pid, NULL, WNOHANG) == pid)
+            return false;
+
+        try {
+            asio::io_context ioc;
+            tcp::resolver resolver(ioc);
+            beast::tcp_stream stream(ioc);
+
+            stream.expires_after(std::chrono::seconds(5));
+            stream.connect(resolver.resolve(opts.host, opts.port));
+
+            http::request<http::string_body> req{http::verb::get, "/system/status.json", 11};
+            req.set(http::field::host, opts.host);
+            set_auth(req.base(), opts);
+            http::write(stream, req);
+
+            beast::flat_buffer buffer;
+            http::response<http::string_body> res;
+            http::read(stream, buffer, res);
+
+            if (res.result_int() == 200)
+                return true;
+        } catch (const std::exception& e) {
+            ;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+
+    return false;
+}
+
+static uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.size() == 0)
+        return 0;
+
+    auto idx = (size_t) (p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--server kismet [--source def] [--devices n] [--pps n]]\n"
+            "       [--host host] [--port port] [--user user --password pass | --apikey key] [--pid pid]\n"
+            "       [--rest n] [--ws n] [--rate n] [--mix list] [--ws-mix list]\n"
+            "       [--duration sec] [--warmup sec]\n", argv0);
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opts;
+
+    static struct option long_options[] = {
+        { "server", required_argument, 0, 'S' },
+        { "source", required_argument, 0, 'c' },
+        { "devices", required_argument, 0, 'n' },
+        { "pps", required_argument, 0, 'P' },
+        { "host", required_argument, 0, 'H' },
+        { "port", required_argument, 0, 'p' },
+        { "user", required_argument, 0, 'u' },
+        { "password", required_argument, 0, 'w' },
+        { "apikey", required_argument, 0, 'k' },
+        { "pid", required_argument, 0, 'i' },
+        { "rest", required_argument, 0, 'r' },
+        { "ws", required_argument, 0, 'W' },
+        { "rate", required_argument, 0, 'R' },
+        { "mix", required_argument, 0, 'm' },
+        { "ws-mix", required_argument, 0, 'M' },
+        { "duration", required_argument, 0, 'd' },
+        { "warmup", required_argument, 0, 't' },
+        { "help", no_argument, 0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    int r;
+    while ((r = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (r) {
+            case 'S': opts.server = optarg; break;
+            case 'c': opts.source = optarg; break;
+            case 'n': opts.devices = strtoul(optarg, NULL, 10); break;
+            case 'P': opts.pps = strtoul(optarg, NULL, 10); break;
+            case 'H': opts.host = optarg; break;
+            case 'p': opts.port = optarg; break;
+            case 'u': opts.user = optarg; break;
+            case 'w': opts.password = optarg; break;
+            case 'k': opts.apikey = optarg; break;
+            case 'i': opts.pid = strtol(optarg, NULL, 10); break;
+            case 'r': opts.rest_clients = strtoul(optarg, NULL, 10); break;
+            case 'W': opts.ws_clients = strtoul(optarg, NULL, 10); break;
+            case 'R': opts.rate = strtod(optarg, NULL); break;
+            case 'm': opts.mix = optarg; break;
+            case 'M': opts.ws_mix = optarg; break;
+            case 'd': opts.duration = strtoul(optarg, NULL, 10); break;
+            case 't': opts.warmup = strtoul(optarg, NULL, 10); break;
+            default: usage(argv[0]);
+        }
+    }
+
+    if (opts.duration == 0 || opts.devices == 0 || opts.pps == 0 ||
+            (opts.rest_clients == 0 && opts.ws_clients == 0))
+        usage(argv[0]);
+
+    // Progress lines go out before the long waits, even when piped
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    // Clients are blocked in reads when the server goes away
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<rest_request> requests;
+    for (const auto& m : parse_mix(opts.mix)) {
+        rest_request req;
+        req.name = m.first;
+        req.method = http::verb::get;
+        req.target = m.first;
+
+        if (m.first.compare(0, 5, "POST ") == 0) {
+            req.method = http::verb::post;
+            req.target = m.first.substr(5);
+            req.body = "json=" + url_encode("{\"fields\":" + summary_fields_json() + "}");
+        }
+
+        for (unsigned int w = 0; w < m.second; w++)
+            requests.push_back(req);
+    }
+
+    std::vector<std::string> ws_kinds;
+    for (const auto& m : parse_mix(opts.ws_mix)) {
+        if (m.first != "devices" && m.first != "events") {
+            fprintf(stderr, "FATAL: unknown websocket type '%s', expected devices or events\n",
+                    m.first.c_str());
+            exit(1);
+        }
+
+        for (unsigned int w = 0; w < m.second; w++)
+            ws_kinds.push_back(m.first);
+    }
+
+    if ((opts.rest_clients > 0 && requests.size() == 0) ||
+            (opts.ws_clients > 0 && ws_kinds.size() == 0)) {
+        fprintf(stderr, "FATAL: empty REST or websocket mix\n");
+        exit(1);
+    }
+
+    std::string workdir;
+    pid_t server_pid = opts.pid;
+
+    if (opts.server.length()) {
+        char tmpl[] = "/tmp/kismet-bench-XXXXXX";
+
+        if (mkdtemp(tmpl) == NULL) {
+            fprintf(stderr, "FATAL: could not create a scratch directory: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        workdir = tmpl;
+
+        if (opts.port.length() == 0)
+            opts.port = "2599";
+
+        std::random_device rnd;
+        opts.user = "bench";
+        opts.password = std::to_string(rnd()) + std::to_string(rnd());
+        opts.apikey = "";
+
+        if (opts.source.length() == 0) {
+            auto pcap = workdir + "/synthetic.pcap";
+            auto frames = opts.pps * (opts.warmup + opts.duration + 30);
+
+            if (!write_synthetic_pcap(pcap, opts.devices, frames)) {
+                fprintf(stderr, "FATAL: could not write %s\n", pcap.c_str());
+                exit(1);
+            }
+
+            opts.source = pcap + ":type=pcapfile,pps=" + std::to_string(opts.pps);
+            printf("synthetic capture: %u devices, %u frames at %u pps\n",
+                    opts.devices, frames, opts.pps);
+        }
+
+        server_pid = start_server(opts, workdir);
+
+        if (server_pid < 0) {
+            fprintf(stderr, "FATAL: could not start %s: %s\n", opts.server.c_str(), strerror(errno));
+            exit(1);
+        }
+
+        printf("server: %s pid %d, output in %s/kismet.log\n", opts.server.c_str(),
+                server_pid, workdir.c_str());
+    } else if (opts.port.length() == 0) {
+        opts.port = "2501";
+    }
+
+    if (!wait_for_server(opts, opts.server.length() ? server_pid : 0, 60)) {
+        fprintf(stderr, "FATAL: no authenticated response from %s:%s\n",
+                opts.host.c_str(), opts.port.c_str());
+        if (opts.server.length()) {
+            kill(server_pid, SIGTERM);
+            waitpid(server_pid, NULL, 0);
+        }
+        exit(1);
+    }
+
+    bench_state state;
+    std::vector<std::thread> clients;
+
+    for (unsigned int c = 0; c < opts.rest_clients; c++)
+        clients.push_back(std::thread(rest_client, std::cref(opts), std::ref(state),
+                    std::cref(requests), c + 1));
+
+    for (unsigned int c = 0; c < opts.ws_clients; c++)
+        clients.push_back(std::thread(ws_client, std::cref(opts), std::ref(state),
+                    ws_kinds[c % ws_kinds.size()]));
+
+    printf("load: %u REST clients (%s), %u websocket clients, %us warmup, %us measured\n",
+            opts.rest_clients, opts.rate > 0 ? (std::to_string(opts.rate) + "/s each").c_str() : "closed loop",
+            opts.ws_clients, opts.warmup, opts.duration);
+
+    std::this_thread::sleep_for(std::chrono::seconds(opts.warmup));
+
+    proc_sample first, last, peak;
+    bool have_proc = server_pid > 0 && sample_proc(server_pid, first);
+    unsigned long rss_total = 0;
+    unsigned int n_samples = 0;
+
+    state.measuring = true;
+    auto start = bench_clock::now();
+    auto end = start + std::chrono::seconds(opts.duration);
+
+    while (bench_clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+        if (have_proc && sample_proc(server_pid, last)) {
+            peak.threads = std::max(peak.threads, last.threads);
+            peak.rss_kb = std::max(peak.rss_kb, last.rss_kb);
+            rss_total += last.rss_kb;
+            n_samples++;
+        }
+    }
+
+    state.measuring = false;
+    double elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+    state.running = false;
+    for (auto& c : clients)
+        c.join();
+
+    printf("\n%-48s %9s %9s %7s %9s %9s %9s %9s %10s\n", "endpoint", "requests", "req/s", "errors",
+            "p50 ms", "p90 ms", "p99 ms", "max ms", "KB/req");
+
+    endpoint_stats total;
+    for (auto& e : state.endpoints) {
+        auto& s = e.second;
+        std::sort(s.latency_us.begin(), s.latency_us.end());
+
+        printf("%-48s %9lu %9.1f %7lu %9.2f %9.2f %9.2f %9.2f %10.1f\n", e.first.c_str(),
+                s.requests, s.requests / elapsed, s.errors,
+                percentile(s.latency_us, 0.50) / 1000.0, percentile(s.latency_us, 0.90) / 1000.0,
+                percentile(s.latency_us, 0.99) / 1000.0, percentile(s.latency_us, 1.0) / 1000.0,
+                s.requests ? (double) s.bytes / s.requests / 1024 : 0);
+
+        total.merge(s);
+    }
+
+    if (state.endpoints.size()) {
+        std::sort(total.latency_us.begin(), total.latency_us.end());
+
+        printf("%-48s %9lu %9.1f %7lu %9.2f %9.2f %9.2f %9.2f %10.1f\n", "total",
+                total.requests, total.requests / elapsed, total.errors,
+                percentile(total.latency_us, 0.50) / 1000.0, percentile(total.latency_us, 0.90) / 1000.0,
+                percentile(total.latency_us, 0.99) / 1000.0, percentile(total.latency_us, 1.0) / 1000.0,
+                total.requests ? (double) total.bytes / total.requests / 1024 : 0);
+    }
+
+    if (state.websockets.size()) {
+        printf("\n%-12s %8s %8s %10s %10s %10s %12s\n", "websocket", "clients", "failed",
+                "messages", "msg/s", "KB/s", "max gap ms");
+
+        for (const auto& w : state.websockets) {
+            auto& s = w.second;
+            printf("%-12s %8lu %8lu %10lu %10.1f %10.1f %12.1f\n", w.first.c_str(),
+                    s.clients, s.failed, s.messages, s.messages / elapsed,
+                    s.bytes / elapsed / 1024, s.max_gap_us / 1000.0);
+        }
+    }
+
+    if (have_proc && n_samples > 0) {
+        printf("\nserver: %u threads (peak %u), RSS %.1f MB (mean %.1f, peak %.1f), CPU %.0f%%\n",
+                last.threads, peak.threads, last.rss_kb / 1024.0,
+                (double) rss_total / n_samples / 1024.0, peak.rss_kb / 1024.0,
+                100.0 * (last.cpu_sec - first.cpu_sec) / elapsed);
+    }
+
+    if (opts.server.length()) {
+        kill(server_pid, SIGTERM);
+
+        // Give the server time to shut down cleanly before forcing it
+        for (unsigned int i = 0; i < 100 && waitpid(server_pid, NULL, WNOHANG) != server_pid; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        if (kill(server_pid, 0) == 0) {
+            kill(server_pid, SIGKILL);
+            waitpid(server_pid, NULL, 0);
+        }
+    }
+
+    return 0;
+}
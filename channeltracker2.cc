@@ -72,13 +72,15 @@ channel_tracker_v2::channel_tracker_v2() :
     auto httpd = Globalreg::fetch_mandatory_global_as<kis_net_beast_httpd>();
 
     httpd->register_route("/channels/channels", {"GET", "POST"}, httpd->RO_ROLE, {},
-            std::make_shared<kis_net_web_tracked_endpoint>(
-                [this](std::shared_ptr<kis_net_beast_httpd_connection>) {
-                    auto ret = std::make_shared<tracker_element_map>();
-                    ret->insert(channel_map);
-                    ret->insert(frequency_map);
-                    return ret;
-                }, lock));
+            std::make_shared<kis_net_web_cached_endpoint>(
+                std::make_shared<kis_net_web_tracked_endpoint>(
+                    [this](std::shared_ptr<kis_net_beast_httpd_connection>) {
+                        auto ret = std::make_shared<tracker_element_map>();
+                        ret->insert(channel_map);
+                        ret->insert(frequency_map);
+                        return ret;
+                    }, lock),
+                std::chrono::seconds(1)));
 
 
     timer_id = timetracker->register_timer(SERVER_TIMESLICES_SEC, nullptr, 1, 
@@ -131,13 +131,13 @@ class_filter_mac_addr::class_filter_mac_addr(const std::string& in_id, const std
 
     auto httpd = Globalreg::fetch_mandatory_global_as<kis_net_beast_httpd>();
 
-    httpd->register_route(seturl, {"POST"}, httpd->LOGON_ROLE, {"cmd"},
+    httpd->register_bulk_route(seturl, {"POST"}, httpd->LOGON_ROLE, {"cmd"},
             std::make_shared<kis_net_web_function_endpoint>(
                 [this, seturl](std::shared_ptr<kis_net_beast_httpd_connection> con) {
                     return edit_endp_handler(con);
                 }, mutex));
 
-    httpd->register_route(remurl, {"POST"}, httpd->LOGON_ROLE, {"cmd"},
+    httpd->register_bulk_route(remurl, {"POST"}, httpd->LOGON_ROLE, {"cmd"},
             std::make_shared<kis_net_web_function_endpoint>(
                 [this, seturl](std::shared_ptr<kis_net_beast_httpd_connection> con) {
                     return remove_endp_handler(con);
@@ -64,6 +64,15 @@
 #error undefined byte order, compile with -D__BYTE_ORDER=1234 (if little endian) or -D__BYTE_ORDER=4321 (big endian)
 #endif
 
+// hardware CRC paths are compiled in where the toolchain can target them and
+// selected at runtime by crc32_fast when the CPU supports them
+#if !defined(CRC32_NO_HW_ACCEL) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #define CRC32_HAVE_PCLMUL
+#endif
+#if !defined(CRC32_NO_HW_ACCEL) && defined(__aarch64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+  #define CRC32_HAVE_ARMV8_CRC
+#endif
+
 
 namespace
 {
@@ -538,8 +547,8 @@ uint32_t crc32_16bytes_prefetch(const void* data, size_t length, uint32_t previo
 #endif
 
 
-/// compute CRC32 using the fastest algorithm for large datasets on modern CPUs
-uint32_t crc32_fast(const void* data, size_t length, uint32_t previousCrc32)
+/// fastest table-driven implementation available in this build
+static uint32_t crc32_fast_sw(const void* data, size_t length, uint32_t previousCrc32)
 {
 #ifdef CRC32_USE_LOOKUP_TABLE_SLICING_BY_16
   return crc32_16bytes (data, length, previousCrc32);
@@ -554,6 +563,236 @@ uint32_t crc32_fast(const void* data, size_t length, uint32_t previousCrc32)
 #endif
 }
 
+static const char *crc32_fast_sw_name()
+{
+#ifdef CRC32_USE_LOOKUP_TABLE_SLICING_BY_16
+  return "slicing-by-16";
+#elif defined(CRC32_USE_LOOKUP_TABLE_SLICING_BY_8)
+  return "slicing-by-8";
+#elif defined(CRC32_USE_LOOKUP_TABLE_SLICING_BY_4)
+  return "slicing-by-4";
+#elif defined(CRC32_USE_LOOKUP_TABLE_BYTE)
+  return "bytewise";
+#else
+  return "half-byte";
+#endif
+}
+
+
+#ifdef CRC32_HAVE_PCLMUL
+#include <smmintrin.h>
+#include <wmmintrin.h>
+
+/// fold 16-byte blocks with carry-less multiplies and Barrett-reduce to 32 bits,
+/// see Gopal et al, "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ"
+/// (Intel, 2009).  length must be >= 64 and a multiple of 16; crc is the raw
+/// (already inverted) state and the raw state is returned.
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32_pclmul_fold(const uint8_t* buf, size_t length, uint32_t crc)
+{
+  alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+  alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+  alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+  alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+  x1 = _mm_loadu_si128((const __m128i*) (buf + 0x00));
+  x2 = _mm_loadu_si128((const __m128i*) (buf + 0x10));
+  x3 = _mm_loadu_si128((const __m128i*) (buf + 0x20));
+  x4 = _mm_loadu_si128((const __m128i*) (buf + 0x30));
+
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) crc));
+
+  x0 = _mm_load_si128((const __m128i*) k1k2);
+
+  buf    += 64;
+  length -= 64;
+
+  // fold four lanes of 64 bytes in parallel
+  while (length >= 64)
+  {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+    y5 = _mm_loadu_si128((const __m128i*) (buf + 0x00));
+    y6 = _mm_loadu_si128((const __m128i*) (buf + 0x10));
+    y7 = _mm_loadu_si128((const __m128i*) (buf + 0x20));
+    y8 = _mm_loadu_si128((const __m128i*) (buf + 0x30));
+
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+    buf    += 64;
+    length -= 64;
+  }
+
+  // fold the four lanes into one
+  x0 = _mm_load_si128((const __m128i*) k3k4);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  // remaining 16-byte blocks
+  while (length >= 16)
+  {
+    x2 = _mm_loadu_si128((const __m128i*) buf);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    buf    += 16;
+    length -= 16;
+  }
+
+  // 128 -> 64 bits
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+
+  x0 = _mm_loadl_epi64((const __m128i*) k5k0);
+
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett reduction to 32 bits
+  x0 = _mm_load_si128((const __m128i*) poly);
+
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return (uint32_t) _mm_extract_epi32(x1, 1);
+}
+
+static uint32_t crc32_pclmul(const void* data, size_t length, uint32_t previousCrc32)
+{
+  // short runs don't amortize the fold setup
+  if (length < 64)
+    return crc32_fast_sw(data, length, previousCrc32);
+
+  const uint8_t* buf = (const uint8_t*) data;
+  size_t folded = length & ~((size_t) 15);
+
+  uint32_t crc = ~crc32_pclmul_fold(buf, folded, ~previousCrc32);
+
+  if (folded == length)
+    return crc;
+
+  return crc32_fast_sw(buf + folded, length - folded, crc);
+}
+
+static bool crc32_have_pclmul()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+}
+#endif // CRC32_HAVE_PCLMUL
+
+
+#ifdef CRC32_HAVE_ARMV8_CRC
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+
+/// ARMv8 CRC32 instructions implement the same reflected polynomial directly
+__attribute__((target("+crc")))
+static uint32_t crc32_armv8(const void* data, size_t length, uint32_t previousCrc32)
+{
+  uint32_t crc = ~previousCrc32;
+  const uint8_t* buf = (const uint8_t*) data;
+
+  while (length >= 8)
+  {
+    uint64_t word;
+    __builtin_memcpy(&word, buf, sizeof(word));
+    crc = __crc32d(crc, word);
+    buf    += 8;
+    length -= 8;
+  }
+
+  while (length-- != 0)
+    crc = __crc32b(crc, *buf++);
+
+  return ~crc;
+}
+
+static bool crc32_have_armv8()
+{
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+#endif // CRC32_HAVE_ARMV8_CRC
+
+
+namespace
+{
+  typedef uint32_t (*crc32_impl_t)(const void* data, size_t length, uint32_t previousCrc32);
+
+  struct crc32_dispatch
+  {
+    crc32_impl_t impl;
+    const char*  name;
+  };
+
+  /// probe the CPU once and pick the best implementation
+  crc32_dispatch crc32_select()
+  {
+#ifdef CRC32_HAVE_PCLMUL
+    if (crc32_have_pclmul())
+      return { crc32_pclmul, "pclmulqdq" };
+#endif
+#ifdef CRC32_HAVE_ARMV8_CRC
+    if (crc32_have_armv8())
+      return { crc32_armv8, "armv8-crc32" };
+#endif
+    return { crc32_fast_sw, crc32_fast_sw_name() };
+  }
+
+  const crc32_dispatch& crc32_selected()
+  {
+    static const crc32_dispatch selected = crc32_select();
+    return selected;
+  }
+} // anonymous namespace
+
+
+/// compute CRC32 using the fastest algorithm for large datasets on modern CPUs
+uint32_t crc32_fast(const void* data, size_t length, uint32_t previousCrc32)
+{
+  return crc32_selected().impl(data, length, previousCrc32);
+}
+
+
+/// name of the implementation crc32_fast dispatches to
+const char *crc32_fast_impl()
+{
+  return crc32_selected().name;
+}
+
 
 /// merge two CRC32 such that result = crc32(dataB, lengthB, crc32(dataA, lengthA))
 uint32_t crc32_combine(uint32_t crcA, uint32_t crcB, size_t lengthB)
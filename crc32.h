@@ -9,6 +9,10 @@
 // if running on an embedded system, you might consider shrinking the
 // big Crc32Lookup table by undefining these lines:
 
+// uint8_t, uint32_t, int32_t, UINTPTR_MAX; must come before the table selection
+// below or every build silently falls back to the half-byte algorithm
+#include <stdint.h>
+
 #if UINTPTR_MAX == 0xffffffff
 
 // Don't define lookup tables on 32bit (mostly armhf/armel) because it seems to
@@ -34,14 +38,15 @@
 // - crc32_16bytes  needs all of Crc32Lookup
 // using the aforementioned #defines the table is automatically fitted to your needs
 
-// uint8_t, uint32_t, int32_t
-#include <stdint.h>
 // size_t
 #include <cstddef>
 
 // crc32_fast selects the fastest algorithm depending on flags (CRC32_USE_LOOKUP_...)
+// and, at runtime, on hardware support (PCLMULQDQ on x86-64, CRC32 on ARMv8)
 /// compute CRC32 using the fastest algorithm for large datasets on modern CPUs
 uint32_t crc32_fast    (const void* data, size_t length, uint32_t previousCrc32 = 0);
+/// name of the implementation crc32_fast selected for this CPU
+const char *crc32_fast_impl();
 
 /// merge two CRC32 such that result = crc32(dataB, lengthB, crc32(dataA, lengthA))
 uint32_t crc32_combine (uint32_t crcA, uint32_t crcB, size_t lengthB);
@@ -610,7 +610,9 @@ void datasource_tracker::trigger_deferred_startup() {
     auto httpd = Globalreg::fetch_mandatory_global_as<kis_net_beast_httpd>();
 
     httpd->register_route("/datasource/all_sources", {"GET", "POST"}, httpd->RO_ROLE, {},
-            std::make_shared<kis_net_web_tracked_endpoint>(datasource_vec, dst_lock));
+            std::make_shared<kis_net_web_cached_endpoint>(
+                std::make_shared<kis_net_web_tracked_endpoint>(datasource_vec, dst_lock),
+                std::chrono::seconds(1)));
 
     httpd->register_route("/datasource/defaults", {"GET", "POST"}, httpd->RO_ROLE, {},
             std::make_shared<kis_net_web_tracked_endpoint>(config_defaults, dst_lock));
@@ -1097,16 +1099,19 @@ void datasource_tracker::trigger_deferred_startup() {
 
                 ds_bridge->bridged_ds->attach_io(ws_io);
 
+                ws->set_closure_cb([ds_bridge]() {
+                        kis_lock_guard<kis_mutex> lk(ds_bridge->mutex, "dst websocket bridge teardown");
+                        if (ds_bridge->bridged_ds != nullptr &&
+                                ds_bridge->bridged_ds->get_source_running()) {
+                            ds_bridge->bridged_ds->handle_error("websocket connection closed");
+                        }
+                    });
+
                 // Blind-catch all errors b/c we must release our listeners at the end
                 try {
                     ws->handle_request(con);
-                } catch (...) { }
-
-                if (ds_bridge->bridged_ds != nullptr) {
-                    kis_lock_guard<kis_mutex> lk(ds_bridge->mutex, "dst websocket bridge teardown");
-                    if (ds_bridge->bridged_ds->get_source_running()) {
-                        ds_bridge->bridged_ds->handle_error("websocket connection closed");
-                    }
+                } catch (...) {
+                    ws->close();
                 }
                 }));
 
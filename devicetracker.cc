@@ -53,6 +53,7 @@
 #include "packet.h"
 #include "packetchain.h"
 #include "pcapng_stream_futurebuf.h"
+#include "sqlite3_cpp11.h"
 #include "util.h"
 #include "zstr.hpp"
 
@@ -323,19 +324,19 @@ device_tracker::device_tracker() :
     httpd->register_route("/devices/views/all_views", {"GET", "POST"}, httpd->RO_ROLE, {},
             std::make_shared<kis_net_web_tracked_endpoint>(view_vec, get_devicelist_mutex()));
 
-    httpd->register_route("/devices/multimac/devices", {"POST"}, httpd->RO_ROLE, {},
+    httpd->register_bulk_route("/devices/multimac/devices", {"POST"}, httpd->RO_ROLE, {},
             std::make_shared<kis_net_web_tracked_endpoint>(
                 [this](shared_con con) -> std::shared_ptr<tracker_element> {
                     return multimac_endp_handler(con);
                 }, get_devicelist_mutex()));
 
-    httpd->register_route("/devices/multikey/devices", {"POST"}, httpd->RO_ROLE, {},
+    httpd->register_bulk_route("/devices/multikey/devices", {"POST"}, httpd->RO_ROLE, {},
             std::make_shared<kis_net_web_tracked_endpoint>(
                 [this](shared_con con) -> std::shared_ptr<tracker_element> {
                     return multikey_endp_handler(con, false);
                 }, get_devicelist_mutex()));
 
-    httpd->register_route("/devices/multikey/as-object/devices", {"POST"}, httpd->RO_ROLE, {},
+    httpd->register_bulk_route("/devices/multikey/as-object/devices", {"POST"}, httpd->RO_ROLE, {},
             std::make_shared<kis_net_web_tracked_endpoint>(
                 [this](shared_con con) -> std::shared_ptr<tracker_element> {
                     return multikey_endp_handler(con, true);
@@ -635,11 +636,11 @@ device_tracker::device_tracker() :
                 [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
 
                 // consumer-supplied key# per monitor request, timer id of monitor event
-                std::unordered_map<unsigned int, int> key_timer_map;
+                auto key_timer_map = std::make_shared<std::unordered_map<unsigned int, int>>();
 
                 auto ws = 
                     std::make_shared<kis_net_web_websocket_endpoint>(con,
-                        [this, &key_timer_map, con](std::shared_ptr<kis_net_web_websocket_endpoint> ws,
+                        [this, key_timer_map, con](std::shared_ptr<kis_net_web_websocket_endpoint> ws,
                             boost::beast::flat_buffer& buf, bool text) {
 
                         if (!text) {
@@ -656,10 +657,10 @@ device_tracker::device_tracker() :
                             ss >> json;
 
                             if (!json["cancel"].is_null()) {
-                                auto kt_v = key_timer_map.find(json["cancel"]);
-                                if (kt_v != key_timer_map.end()) {
+                                auto kt_v = key_timer_map->find(json["cancel"]);
+                                if (kt_v != key_timer_map->end()) {
                                     timetracker->remove_timer(kt_v->second);
-                                    key_timer_map.erase(kt_v);
+                                    key_timer_map->erase(kt_v);
                                 }
                             }
 
@@ -681,21 +682,22 @@ device_tracker::device_tracker() :
                                 auto rate = json["rate"];
 
                                 // Remove any existing request under this ID
-                                auto kt_v = key_timer_map.find(req_id);
-                                if (kt_v != key_timer_map.end())
+                                auto kt_v = key_timer_map->find(req_id);
+                                if (kt_v != key_timer_map->end())
                                     timetracker->remove_timer(kt_v->second);
 
                                 auto rename_map = Globalreg::new_from_pool<tracker_element_serializer::rename_map>();
 
-                                time_t last_tm = 0;
+                                // Shared with the timer, which outlives this message handler
+                                auto last_tm = std::make_shared<time_t>(0);
 
                                 // Generate a timer event that goes and looks for the devices and
                                 // serializes them with the fields record
                                 auto tid = 
                                     timetracker->register_timer(std::chrono::seconds(rate), true,
-                                            [this, con, dev_r, dev_k, dev_m, json, ws, &last_tm, rename_map, format_t](int) -> int {
+                                            [this, con, dev_r, dev_k, dev_m, json, ws, last_tm, rename_map, format_t](int) -> int {
                                                 if (dev_r == "*") {
-                                                    auto worker = device_tracker_view_function_worker([json, last_tm, format_t, this, ws](std::shared_ptr<kis_tracked_device_base> dev) -> bool {
+                                                    auto worker = device_tracker_view_function_worker([json, last_tm = *last_tm, format_t, this, ws](std::shared_ptr<kis_tracked_device_base> dev) -> bool {
                                                         if (dev->get_mod_time() > last_tm) {
                                                             std::stringstream ss;
                                                             entrytracker->serialize_with_json_summary(format_t, ss, dev, json);
@@ -712,7 +714,7 @@ device_tracker::device_tracker() :
 
                                                     auto dev = fetch_device(dev_k);
                                                     if (dev != nullptr) {
-                                                        if (dev->get_mod_time() > last_tm) {
+                                                        if (dev->get_mod_time() > *last_tm) {
                                                             std::stringstream ss;
                                                             entrytracker->serialize_with_json_summary(format_t, ss, dev, json);
                                                             auto data = ss.str();
@@ -724,7 +726,7 @@ device_tracker::device_tracker() :
 
                                                     const auto mmp = tracked_mac_multimap.equal_range(dev_m);
                                                     for (auto mmpi = mmp.first; mmpi != mmp.second; ++mmpi) {
-                                                        if (mmpi->second->get_mod_time() > last_tm) {
+                                                        if (mmpi->second->get_mod_time() > *last_tm) {
                                                             std::stringstream ss;
                                                             entrytracker->serialize_with_json_summary(format_t, ss, mmpi->second, json);
                                                             auto data = ss.str();
@@ -733,12 +735,12 @@ device_tracker::device_tracker() :
                                                     }
                                                 }
 
-                                                last_tm = (time_t) Globalreg::globalreg->last_tv_sec;
+                                                *last_tm = (time_t) Globalreg::globalreg->last_tv_sec;
 
                                                 return 1;
                                             });
 
-                                key_timer_map[req_id] = tid;
+                                (*key_timer_map)[req_id] = tid;
                             }
 
                         } catch (const std::exception& e) {
@@ -750,14 +752,17 @@ device_tracker::device_tracker() :
 
                 ws->text();
 
+                ws->set_closure_cb([this, key_timer_map]() {
+                        for (const auto& t : *key_timer_map)
+                            timetracker->remove_timer(t.second);
+                        key_timer_map->clear();
+                    });
+
                 try {
                     ws->handle_request(con);
                 } catch (const std::exception& e) {
-                    ;
+                    ws->close();
                 }
-
-                for (const auto t : key_timer_map)
-                    timetracker->remove_timer(t.second);
             }));
 
     phy_phyentry_id =
@@ -794,6 +799,7 @@ device_tracker::device_tracker() :
     // Open and upgrade the DB, default path
     database_open("");
     database_upgrade_db();
+    preload_stored_names_tags();
 
     new_datasource_evt_id = 
         eventbus->register_listener(datasource_tracker::event_new_datasource(),
@@ -1508,6 +1514,10 @@ void device_tracker::timetracker_event(int eventid) {
                 // Forget the immutable vec pointer to it
                 (immutable_tracked_vec->begin() + pi)->reset();
 
+                auto evt = eventbus->get_eventbus_event(event_remove_device());
+                evt->get_event_content()->insert(event_remove_device(), d);
+                eventbus->publish(evt);
+
                 purged = true;
 
             }
@@ -1557,6 +1567,10 @@ void device_tracker::timetracker_event(int eventid) {
             // Forget it from the immutable vec, but keep its
             // position; we need to have vecpos = devid
             (immutable_tracked_vec->begin() + d->get_kis_internal_id())->reset();
+
+            auto evt = eventbus->get_eventbus_event(event_remove_device());
+            evt->get_event_content()->insert(event_remove_device(), d);
+            eventbus->publish(evt);
         }
 
         // Do an update since we're trimming something
@@ -1626,6 +1640,7 @@ int device_tracker::database_upgrade_db() {
         if (r != SQLITE_OK) {
             _MSG("device_tracker unable to create device_names table in " + ds_dbfile + ": " +
                     std::string(sErrMsg), MSGFLAG_ERROR);
+            kissqlite3::release_statement_cache(db);
             sqlite3_close(db);
             db = NULL;
             return -1;
@@ -1646,6 +1661,7 @@ int device_tracker::database_upgrade_db() {
         if (r != SQLITE_OK) {
             _MSG("device_tracker unable to create device_tags table in " + ds_dbfile + ": " +
                     std::string(sErrMsg), MSGFLAG_ERROR);
+            kissqlite3::release_statement_cache(db);
             sqlite3_close(db);
             db = NULL;
             return -1;
@@ -1777,116 +1793,70 @@ void device_tracker::databaselog_write_devices() {
     last_database_logged = log_time;
 }
 
-void device_tracker::load_stored_username(std::shared_ptr<kis_tracked_device_base> in_dev) {
-    // Lock the database; we're doing a single query
+void device_tracker::preload_stored_names_tags() {
     kis_lock_guard<kis_mutex> lk(ds_mutex);
 
     if (!database_valid())
         return;
 
-    // This should only get called inside device creation which should be a safe time, don't lock here
-    // Lock the device itself
-    // auto devlocker = devicelist_range_scope_locker(shared_from_this(), in_dev);
-
-    std::string sql;
-    std::string keystring = in_dev->get_key().as_string();
-
-    int r;
-    sqlite3_stmt *stmt = NULL;
-    const char *pz = NULL;
-
-    sql = 
-        "SELECT name FROM device_names WHERE key = ? ";
+    using namespace kissqlite3;
 
-    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &stmt, &pz);
+    try {
+        auto name_q = _SELECT(db, "device_names", {"key", "name"});
 
-    if (r != SQLITE_OK) {
-        _MSG("device_tracker unable to prepare database query for stored devicename in " +
-                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
-        return;
-    }
+        for (auto r : name_q) {
+            auto key = device_key(sqlite3_column_as<std::string>(r, 0));
 
-    sqlite3_reset(stmt);
-    sqlite3_bind_text(stmt, 1, keystring.c_str(), keystring.length(), 0);
+            if (key.get_error())
+                continue;
 
-    while (1) {
-        r = sqlite3_step(stmt);
+            stored_usernames[key] = sqlite3_column_as<std::string>(r, 1);
+        }
 
-        if (r == SQLITE_ROW) {
-            const unsigned char *rowstr;
+        auto tag_q = _SELECT(db, "device_tags", {"key", "tag", "content"});
 
-            rowstr = (const unsigned char *) sqlite3_column_text(stmt, 0);
+        for (auto r : tag_q) {
+            auto key = device_key(sqlite3_column_as<std::string>(r, 0));
 
-            in_dev->set_username(std::string((const char *) rowstr));
+            if (key.get_error())
+                continue;
 
-        } else if (r == SQLITE_DONE) {
-            break;
-        } else {
-            _MSG("device_tracker encountered an error loading stored device username: " + 
-                    std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
-            break;
+            stored_tags[key].emplace_back(sqlite3_column_as<std::string>(r, 1),
+                    sqlite3_column_as<std::string>(r, 2));
         }
+    } catch (const std::exception& e) {
+        _MSG_ERROR("device_tracker unable to load stored device names and tags from {}: {}",
+                ds_dbfile, e.what());
     }
-
-    sqlite3_finalize(stmt);
 }
 
-void device_tracker::load_stored_tags(std::shared_ptr<kis_tracked_device_base> in_dev) {
-    // Lock the database; we're doing a single query
+void device_tracker::load_stored_username(std::shared_ptr<kis_tracked_device_base> in_dev) {
+    // This should only get called inside device creation which should be a safe time, don't 
+    // lock the device, only the preloaded map
     kis_lock_guard<kis_mutex> lk(ds_mutex);
 
-    if (!database_valid())
-        return;
-
-    // This should be safe b/c it's only called inside device creation, don't lock
-    // Lock the device itself
-    // auto devlocker = devicelist_range_scope_locker(shared_from_this(), in_dev);
-
-    std::string sql;
-    std::string keystring = in_dev->get_key().as_string();
+    auto n = stored_usernames.find(in_dev->get_key());
 
-    int r;
-    sqlite3_stmt *stmt = NULL;
-    const char *pz = NULL;
+    if (n != stored_usernames.end())
+        in_dev->set_username(n->second);
+}
 
-    sql = 
-        "SELECT tag, content FROM device_tags WHERE key = ?";
+void device_tracker::load_stored_tags(std::shared_ptr<kis_tracked_device_base> in_dev) {
+    // This should be safe b/c it's only called inside device creation, don't lock the
+    // device, only the preloaded map
+    kis_lock_guard<kis_mutex> lk(ds_mutex);
 
-    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &stmt, &pz);
+    auto t = stored_tags.find(in_dev->get_key());
 
-    if (r != SQLITE_OK) {
-        _MSG("device_tracker unable to prepare database query for stored devicetag in " +
-                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+    if (t == stored_tags.end())
         return;
-    }
-
-    sqlite3_reset(stmt);
-    sqlite3_bind_text(stmt, 1, keystring.c_str(), keystring.length(), 0);
 
-    while (1) {
-        r = sqlite3_step(stmt);
+    for (const auto& tc : t->second) {
+        auto tagc = std::make_shared<tracker_element_string>();
+        tagc->set(tc.second);
 
-        if (r == SQLITE_ROW) {
-            const unsigned char *tagstr;
-            const unsigned char *contentstr;
-
-            tagstr = (const unsigned char *) sqlite3_column_text(stmt, 0);
-            contentstr = (const unsigned char *) sqlite3_column_text(stmt, 1);
-
-            auto tagc = std::make_shared<tracker_element_string>();
-            tagc->set(std::string((const char *) contentstr));
-
-            in_dev->get_tag_map()->insert(std::string((const char *) tagstr), tagc);
-        } else if (r == SQLITE_DONE) {
-            break;
-        } else {
-            _MSG("device_tracker encountered an error loading stored device username: " + 
-                    std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
-            break;
-        }
+        in_dev->get_tag_map()->insert(tc.first, tagc);
     }
-
-    sqlite3_finalize(stmt);
 }
 
 void device_tracker::set_device_user_name(std::shared_ptr<kis_tracked_device_base> in_dev,
@@ -1902,39 +1872,30 @@ void device_tracker::set_device_user_name(std::shared_ptr<kis_tracked_device_bas
         return;
     }
 
-    std::string sql;
-
-    int r;
-    sqlite3_stmt *stmt = NULL;
-    const char *pz = NULL;
-
     std::string keystring = in_dev->get_key().as_string();
 
-    sql = 
-        "INSERT INTO device_names "
-        "(key, name) "
-        "VALUES (?, ?)";
+    // Lock the database and the stored map for the update
+    kis_lock_guard<kis_mutex> dlk(ds_mutex);
+
+    stored_usernames[in_dev->get_key()] = in_username;
 
-    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &stmt, &pz);
+    std::shared_ptr<sqlite3_stmt> stmt;
 
-    if (r != SQLITE_OK) {
-        _MSG("device_tracker unable to prepare database insert for device name in " +
-                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+    try {
+        stmt = kissqlite3::prepare_cached(db, 
+                "INSERT INTO device_names "
+                "(key, name) "
+                "VALUES (?, ?)");
+    } catch (const std::exception& e) {
+        _MSG_ERROR("device_tracker unable to prepare database insert for device name in {}: {}",
+                ds_dbfile, e.what());
         return;
     }
- 
-    sqlite3_reset(stmt);
 
-    sqlite3_bind_text(stmt, 1, keystring.c_str(), keystring.length(), 0);
-    sqlite3_bind_text(stmt, 2, in_username.c_str(), in_username.length(), 0);
+    sqlite3_bind_text(stmt.get(), 1, keystring.c_str(), keystring.length(), 0);
+    sqlite3_bind_text(stmt.get(), 2, in_username.c_str(), in_username.length(), 0);
 
-    // Only lock the database while we're inserting
-    {
-        kis_lock_guard<kis_mutex> lk(ds_mutex);
-        sqlite3_step(stmt);
-    }
-
-    sqlite3_finalize(stmt);
+    sqlite3_step(stmt.get());
 
     return;
 }
@@ -1962,40 +1923,37 @@ void device_tracker::set_device_tag(std::shared_ptr<kis_tracked_device_base> in_
         return;
     }
 
-    std::string sql;
-
-    int r;
-    sqlite3_stmt *stmt = NULL;
-    const char *pz = NULL;
-
     std::string keystring = in_dev->get_key().as_string();
 
-    sql = 
-        "INSERT INTO device_tags "
-        "(key, tag, content) "
-        "VALUES (?, ?, ?)";
-
-    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &stmt, &pz);
-
-    if (r != SQLITE_OK) {
-        _MSG("device_tracker unable to prepare database insert for device tags in " +
-                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+    // Lock the database and the stored map for the update
+    kis_lock_guard<kis_mutex> dlk(ds_mutex);
+
+    auto& stored = stored_tags[in_dev->get_key()];
+    auto st = std::find_if(stored.begin(), stored.end(), 
+            [&in_tag](const auto& t) { return t.first == in_tag; });
+    if (st != stored.end())
+        st->second = in_content;
+    else
+        stored.emplace_back(in_tag, in_content);
+
+    std::shared_ptr<sqlite3_stmt> stmt;
+
+    try {
+        stmt = kissqlite3::prepare_cached(db, 
+                "INSERT INTO device_tags "
+                "(key, tag, content) "
+                "VALUES (?, ?, ?)");
+    } catch (const std::exception& e) {
+        _MSG_ERROR("device_tracker unable to prepare database insert for device tags in {}: {}",
+                ds_dbfile, e.what());
         return;
     }
- 
-    sqlite3_reset(stmt);
-
-    sqlite3_bind_text(stmt, 1, keystring.c_str(), keystring.length(), 0);
-    sqlite3_bind_text(stmt, 2, in_tag.c_str(), in_tag.length(), 0);
-    sqlite3_bind_text(stmt, 3, in_content.c_str(), in_content.length(), 0);
 
-    // Only lock the database while we're inserting
-    {
-        kis_lock_guard<kis_mutex> lk(ds_mutex);
-        sqlite3_step(stmt);
-    }
+    sqlite3_bind_text(stmt.get(), 1, keystring.c_str(), keystring.length(), 0);
+    sqlite3_bind_text(stmt.get(), 2, in_tag.c_str(), in_tag.length(), 0);
+    sqlite3_bind_text(stmt.get(), 3, in_content.c_str(), in_content.length(), 0);
 
-    sqlite3_finalize(stmt);
+    sqlite3_step(stmt.get());
 
     return;
 }
@@ -102,6 +102,10 @@ public:
         return "NEW_DEVICE";
     }
 
+    static std::string event_remove_device() {
+        return "REMOVE_DEVICE";
+    }
+
     std::string fetch_phy_name(int in_phy);
 
 	int fetch_num_devices();
@@ -390,6 +394,15 @@ protected:
     // Insert a device directly into the records
     void add_device(std::shared_ptr<kis_tracked_device_base> device);
 
+    // Stored usernames and tags, loaded from the database at startup so that creating
+    // a device never has to query the database; protected by ds_mutex
+    ankerl::unordered_dense::map<device_key, std::string> stored_usernames;
+    ankerl::unordered_dense::map<device_key, 
+        std::vector<std::pair<std::string, std::string>>> stored_tags;
+
+    // Load all stored usernames and tags
+    void preload_stored_names_tags();
+
     // Load stored username
     void load_stored_username(std::shared_ptr<kis_tracked_device_base> in_dev);
 
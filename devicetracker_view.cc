@@ -100,12 +100,16 @@ device_tracker_view::device_tracker_view(const std::string& in_id, const std::st
 void device_tracker_view::register_urls(const std::string& in_id) { 
     auto httpd = Globalreg::fetch_mandatory_global_as<kis_net_beast_httpd>();
 
+    // Dashboards and API pollers repeat the same view requests; datatables requests carry
+    // a per-client draw counter and generally won't share a cached response
     auto uri = fmt::format("/devices/views/{}/devices", in_id);
     httpd->register_route(uri, {"GET", "POST"}, httpd->RO_ROLE, {},
-            std::make_shared<kis_net_web_function_endpoint>(
-                [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
-                    return device_endpoint_handler(con);
-                }, devicetracker->get_devicelist_mutex()));
+            std::make_shared<kis_net_web_cached_endpoint>(
+                std::make_shared<kis_net_web_function_endpoint>(
+                    [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
+                        return device_endpoint_handler(con);
+                    }, devicetracker->get_devicelist_mutex()),
+                std::chrono::seconds(1)));
 
     uri = fmt::format("/devices/views/{}/last-time/:timestamp/devices", in_id);
     httpd->register_route(uri, {"GET", "POST"}, httpd->RO_ROLE, {},
@@ -119,12 +123,12 @@ void device_tracker_view::register_urls(const std::string& in_id) {
             std::make_shared<kis_net_web_function_endpoint>(
                 [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
 
-                std::unordered_map<unsigned int, int> key_timer_map;
+                auto key_timer_map = std::make_shared<std::unordered_map<unsigned int, int>>();
                 auto timetracker = Globalreg::fetch_mandatory_global_as<time_tracker>();
 
                 auto ws = 
                     std::make_shared<kis_net_web_websocket_endpoint>(con,
-                        [this, timetracker, &key_timer_map, con](std::shared_ptr<kis_net_web_websocket_endpoint> ws,
+                        [this, timetracker, key_timer_map, con](std::shared_ptr<kis_net_web_websocket_endpoint> ws,
                             boost::beast::flat_buffer& buf, bool text) {
 
                         if (!text) {
@@ -142,10 +146,10 @@ void device_tracker_view::register_urls(const std::string& in_id) {
 
                             auto cancel_j = json["cancel"];
                             if (cancel_j.is_number()) {
-                                auto kt_v = key_timer_map.find(cancel_j);
-                                if (kt_v != key_timer_map.end()) {
+                                auto kt_v = key_timer_map->find(cancel_j);
+                                if (kt_v != key_timer_map->end()) {
                                     timetracker->remove_timer(kt_v->second);
-                                    key_timer_map.erase(kt_v);
+                                    key_timer_map->erase(kt_v);
                                 }
                             }
 
@@ -165,8 +169,8 @@ void device_tracker_view::register_urls(const std::string& in_id) {
                                 unsigned int rate = json["rate"];
 
                                 // Remove any existing request under this ID
-                                auto kt_v = key_timer_map.find(req_id);
-                                if (kt_v != key_timer_map.end())
+                                auto kt_v = key_timer_map->find(req_id);
+                                if (kt_v != key_timer_map->end())
                                     timetracker->remove_timer(kt_v->second);
 
                                 auto rename_map = Globalreg::new_from_pool<tracker_element_serializer::rename_map>();
@@ -224,7 +228,7 @@ void device_tracker_view::register_urls(const std::string& in_id) {
                                                 return 1;
                                             });
 
-                                key_timer_map[req_id] = tid;
+                                (*key_timer_map)[req_id] = tid;
                             }
 
                         } catch (const std::exception& e) {
@@ -236,15 +240,18 @@ void device_tracker_view::register_urls(const std::string& in_id) {
 
                 ws->text();
 
+                ws->set_closure_cb([timetracker, key_timer_map]() {
+                        for (const auto &t : *key_timer_map)
+                            timetracker->remove_timer(t.second);
+                        key_timer_map->clear();
+                    });
+
                 try {
                     ws->handle_request(con);
                 } catch (const std::exception& e) {
-                    ;
+                    ws->close();
                 }
 
-                for (const auto &t : key_timer_map)
-                    timetracker->remove_timer(t.second);
-
                 }));
 }
 
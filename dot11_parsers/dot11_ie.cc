@@ -16,25 +16,30 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
-#include "globalregistry.h"
 #include "dot11_ie.h"
 
-void dot11_ie::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_tags = Globalreg::new_from_pool<shared_ie_tag_vector>();
-    m_tags_map = Globalreg::new_from_pool<shared_ie_tag_map>();
-
-    while (!p_io->is_eof()) {
-        auto t = Globalreg::new_from_pool<dot11_ie_tag>();
-        t->parse(p_io);
-        m_tags->push_back(t);
-        (*m_tags_map)[t->tag_num()] = t;
+void dot11_ie::parse(const char *data, size_t len) {
+    m_tags.clear();
+
+    size_t offt = 0;
+
+    while (offt < len) {
+        if (len - offt < 2)
+            throw std::runtime_error("truncated IE tag header");
+
+        uint8_t tag_num = data[offt];
+        uint8_t tag_len = data[offt + 1];
+        offt += 2;
+
+        if (len - offt < tag_len)
+            throw std::runtime_error("IE tag length exceeds frame");
+
+        m_tags.emplace_back(tag_num, std::string_view(data + offt, tag_len));
+        offt += tag_len;
     }
 }
 
-void dot11_ie::dot11_ie_tag::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_tag_num = p_io->read_u1();
-    m_tag_len = p_io->read_u1();
-    m_tag_data = p_io->read_bytes(tag_len());
-    m_tag_data_stream.reset(new kaitai::kstream(m_tag_data));
+void dot11_ie::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    m_owned_data = p_io->read_bytes_full();
+    parse(m_owned_data.data(), m_owned_data.length());
 }
-
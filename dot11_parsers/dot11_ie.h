@@ -19,27 +19,31 @@
 #ifndef __DOT11_IE_H__
 #define __DOT11_IE_H__
 
-/* Parse a dot11 ie stream into individual objects.
+/* Parse a dot11 ie stream into individual tags.
  *
- * This uses the kaitai stream buffer from the kaitai runtime as it is a 
- * solid implementation of buffer-bounded operations and data extraction.
+ * The tag stream is walked in place; each tag is a bounds-checked view into the
+ * original frame bytes, so walking the tags performs no copies and, once the pooled
+ * tag vector has grown to fit, no allocations.  Tags reference the buffer they were
+ * parsed from, which must outlive the dot11_ie object; for the packet IE tags this is
+ * the packet itself.
  *
- * Much of this is modeled on how kaitai generates parsers.
+ * The typed IE parsers read the tag data through a kis_span_stream over the same
+ * bytes, so decoding a tag does not copy it into a stream either.
  *
  */
 
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
-#include <unordered_map>
 #include <kaitai/kaitaistream.h>
 #include "multi_constexpr.h"
 
 class dot11_ie {
 public:
     class dot11_ie_tag;
-    typedef std::vector<std::shared_ptr<dot11_ie_tag>> shared_ie_tag_vector;
-    typedef std::unordered_map<uint8_t, std::shared_ptr<dot11_ie_tag>> shared_ie_tag_map;
+    typedef std::vector<dot11_ie_tag> ie_tag_vector;
 
     dot11_ie() {
 
@@ -49,61 +53,93 @@ public:
 
     }
 
+    // Parse a tag stream in place; throws std::runtime_error if a tag runs past the 
+    // end of the buffer
+    void parse(const char *data, size_t len);
+
+    void parse(std::string_view data) {
+        parse(data.data(), data.length());
+    }
+
+    // Parse the remainder of a kaitai stream; the remaining data is copied and owned
+    // by this object
     void parse(std::shared_ptr<kaitai::kstream> p_io);
 
-    std::shared_ptr<shared_ie_tag_vector> tags() const {
+    const ie_tag_vector& tags() const {
         return m_tags;
     }
 
-    std::shared_ptr<shared_ie_tag_map> tags_map() const {
-        return m_tags_map;
+    // Find the last tag of a given number, or nullptr
+    const dot11_ie_tag *find_tag(uint8_t tag_num) const {
+        for (auto t = m_tags.rbegin(); t != m_tags.rend(); ++t) {
+            if (t->tag_num() == tag_num)
+                return &(*t);
+        }
+
+        return nullptr;
     }
 
     void reset() {
-        m_tags->clear();
-        m_tags_map->clear();
+        m_tags.clear();
+        m_owned_data.clear();
     }
 
 protected:
-    std::shared_ptr<shared_ie_tag_vector> m_tags;
-    std::shared_ptr<shared_ie_tag_map> m_tags_map;
+    ie_tag_vector m_tags;
+    std::string m_owned_data;
 
 public:
     class dot11_ie_tag {
     public:
-        dot11_ie_tag() { } 
-        ~dot11_ie_tag() { }
-
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        dot11_ie_tag(uint8_t tag_num, std::string_view tag_data) :
+            m_tag_num {tag_num},
+            m_tag_data {tag_data} { }
 
         constexpr17 uint8_t tag_num() const {
             return m_tag_num;
         }
 
         constexpr17 uint8_t tag_len() const {
-            return m_tag_len;
+            return m_tag_data.length();
         }
 
-        std::string tag_data() const {
+        constexpr17 std::string_view tag_data() const {
             return m_tag_data;
         }
 
-        std::shared_ptr<kaitai::kstream> tag_data_stream() const {
-            return m_tag_data_stream;
+        // Vendor tags (150 and 221) start with a 3 byte OUI and, typically, a 
+        // vendor-specific type byte
+        constexpr17 bool has_vendor_oui() const {
+            return m_tag_data.length() >= 3;
         }
 
-        void reset() {
-            m_tag_num = 0;
-            m_tag_len = 0;
-            m_tag_data = "";
-            m_tag_data_stream.reset();
+        constexpr17 uint32_t vendor_oui_int() const {
+            if (!has_vendor_oui())
+                return 0;
+
+            return (((uint8_t) m_tag_data[0]) << 16) + 
+                (((uint8_t) m_tag_data[1]) << 8) + 
+                ((uint8_t) m_tag_data[2]);
+        }
+
+        constexpr17 uint8_t vendor_oui_type() const {
+            if (m_tag_data.length() < 4)
+                return 0;
+
+            return m_tag_data[3];
+        }
+
+        // Vendor content after the OUI, including the type byte
+        constexpr17 std::string_view vendor_tag_data() const {
+            if (!has_vendor_oui())
+                return std::string_view{};
+
+            return m_tag_data.substr(3);
         }
 
     protected:
         uint8_t m_tag_num;
-        uint8_t m_tag_len;
-        std::string m_tag_data;
-        std::shared_ptr<kaitai::kstream> m_tag_data_stream;
+        std::string_view m_tag_data;
     };
 
 };
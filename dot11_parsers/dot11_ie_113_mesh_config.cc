@@ -18,13 +18,14 @@
 
 #include "dot11_ie_113_mesh_config.h"
 
-void dot11_ie_113_mesh_config::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_path_select_proto = p_io->read_u1();
-    m_path_select_metric = p_io->read_u1();
-    m_congestion_control = p_io->read_u1();
-    m_sync_method = p_io->read_u1();
-    m_auth_protocol = p_io->read_u1();
-    m_formation_info = p_io->read_u1();
-    m_capability_info = p_io->read_u1();
+void dot11_ie_113_mesh_config::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_path_select_proto = p_io.read_u1();
+    m_path_select_metric = p_io.read_u1();
+    m_congestion_control = p_io.read_u1();
+    m_sync_method = p_io.read_u1();
+    m_auth_protocol = p_io.read_u1();
+    m_formation_info = p_io.read_u1();
+    m_capability_info = p_io.read_u1();
 }
 
@@ -21,7 +21,7 @@
 
 #include <string>
 #include <memory>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_113_mesh_config {
@@ -29,7 +29,7 @@ public:
     dot11_ie_113_mesh_config() { }
     ~dot11_ie_113_mesh_config() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint8_t path_select_pro() const {
         return m_path_select_proto;
@@ -29,7 +29,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_11_qbss {
@@ -37,7 +37,7 @@ public:
     dot11_ie_11_qbss() { }
     ~dot11_ie_11_qbss() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint16_t station_count() const {
         return m_station_count;
@@ -18,10 +18,11 @@
 
 #include "dot11_ie_133_cisco_ccx.h"
 
-void dot11_ie_133_cisco_ccx::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_ccx_unk1 = p_io->read_bytes(10);
-    m_ap_name = p_io->read_bytes(16);
-    m_station_count = p_io->read_u1();
-    m_ccx_unk2 = p_io->read_bytes(3);
+void dot11_ie_133_cisco_ccx::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_ccx_unk1 = p_io.read_bytes(10);
+    m_ap_name = p_io.read_bytes(16);
+    m_station_count = p_io.read_u1();
+    m_ccx_unk2 = p_io.read_bytes(3);
 
 }
@@ -28,7 +28,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_133_cisco_ccx {
@@ -36,7 +36,7 @@ public:
     dot11_ie_133_cisco_ccx() { }
     ~dot11_ie_133_cisco_ccx() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     std::string ccx_unk1() const {
         return m_ccx_unk1;
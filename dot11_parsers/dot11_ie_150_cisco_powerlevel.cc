@@ -18,10 +18,11 @@
 
 #include "dot11_ie_150_cisco_powerlevel.h"
 
-void dot11_ie_150_cisco_powerlevel::parse(std::shared_ptr<kaitai::kstream> p_io) {
+void dot11_ie_150_cisco_powerlevel::parse(std::string_view data) {
+    kis_span_stream p_io(data);
     // Throw away IE type field
-    p_io->read_u1();
+    p_io.read_u1();
 
-    m_txpower = p_io->read_u1();
+    m_txpower = p_io.read_u1();
 }
 
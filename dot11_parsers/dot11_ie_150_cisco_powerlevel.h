@@ -22,7 +22,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_150_cisco_powerlevel {
@@ -38,7 +38,7 @@ public:
         return 0x00;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     unsigned int cisco_ccx_txpower() {
         return m_txpower;
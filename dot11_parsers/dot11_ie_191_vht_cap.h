@@ -28,7 +28,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_191_vht_cap {
@@ -42,7 +42,7 @@ public:
     } 
     ~dot11_ie_191_vht_cap() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint32_t vht_capabilities() const {
         return m_vht_capabilities;
@@ -18,10 +18,11 @@
 
 #include "dot11_ie_192_vht_op.h"
 
-void dot11_ie_192_vht_op::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_channel_width = p_io->read_u1();
-    m_center1 = p_io->read_u1();
-    m_center2 = p_io->read_u1();
-    m_basic_mcs_map = p_io->read_u2be();
+void dot11_ie_192_vht_op::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_channel_width = p_io.read_u1();
+    m_center1 = p_io.read_u1();
+    m_center2 = p_io.read_u1();
+    m_basic_mcs_map = p_io.read_u2be();
 }
 
@@ -28,7 +28,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_192_vht_op {
@@ -43,7 +43,7 @@ public:
         ch_80_80 = 3
     };
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 ch_channel_width channel_width() const {
         return (ch_channel_width) m_channel_width;
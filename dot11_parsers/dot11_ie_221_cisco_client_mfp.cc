@@ -18,11 +18,12 @@
 
 #include "dot11_ie_221_cisco_client_mfp.h"
 
-void dot11_ie_221_cisco_client_mfp::parse(std::shared_ptr<kaitai::kstream> p_io) {
+void dot11_ie_221_cisco_client_mfp::parse(std::string_view data) {
+    kis_span_stream p_io(data);
     // Throw out sub-type
-    p_io->read_u1();
+    p_io.read_u1();
 
-    uint8_t l_mfp = p_io->read_u1();
+    uint8_t l_mfp = p_io.read_u1();
     m_client_mfp = (l_mfp & 0x01);
 }
 
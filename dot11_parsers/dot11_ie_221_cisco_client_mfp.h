@@ -22,7 +22,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_221_cisco_client_mfp {
@@ -38,7 +38,7 @@ public:
         return 0x14;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 bool client_mfp() {
         return m_client_mfp;
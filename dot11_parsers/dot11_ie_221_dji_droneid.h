@@ -44,7 +44,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_221_dji_droneid {
@@ -66,7 +66,7 @@ public:
         return 0x263712;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint8_t vendor_type() const {
         return m_vendor_type;
@@ -110,7 +110,6 @@ public:
         m_unk2 = 0;
         m_subcommand = 0;
         m_raw_record_data = "";
-        m_raw_record_data_stream.reset();
         m_record.reset();
     }
 
@@ -120,7 +119,6 @@ protected:
     uint8_t m_unk2;
     uint8_t m_subcommand;
     std::string m_raw_record_data;
-    std::shared_ptr<kaitai::kstream> m_raw_record_data_stream;
     std::shared_ptr<dji_subcommand_common> m_record;
 
 public:
@@ -129,7 +127,7 @@ public:
         dji_subcommand_common() { }
         virtual ~dji_subcommand_common() { }
 
-        virtual void parse(std::shared_ptr<kaitai::kstream> p_io __attribute__((unused))) { }
+        virtual void parse(kis_span_stream& p_io __attribute__((unused))) { }
     };
 
     class dji_subcommand_flight_reg : public dji_subcommand_common {
@@ -137,7 +135,7 @@ public:
         dji_subcommand_flight_reg() { }
         virtual ~dji_subcommand_flight_reg() { }
 
-        virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+        virtual void parse(kis_span_stream& p_io);
 
         const uint8_t version() const {
             return m_version;
@@ -470,7 +468,7 @@ public:
         dji_subcommand_flight_purpose() { }
         virtual ~dji_subcommand_flight_purpose() { }
 
-        virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+        virtual void parse(kis_span_stream& p_io);
 
         std::string serialnumber() {
             return m_serialnumber;
@@ -18,7 +18,8 @@
 
 #include "dot11_ie_221_ms_wmm.h"
 
-void dot11_ie_221_ms_wmm::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_wme_subtype = p_io->read_u1();
+void dot11_ie_221_ms_wmm::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_wme_subtype = p_io.read_u1();
 }
 
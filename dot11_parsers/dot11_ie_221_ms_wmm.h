@@ -29,7 +29,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_221_ms_wmm {
@@ -37,7 +37,7 @@ public:
     dot11_ie_221_ms_wmm() { } 
     ~dot11_ie_221_ms_wmm() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint8_t wme_subtype() const {
         return m_wme_subtype;
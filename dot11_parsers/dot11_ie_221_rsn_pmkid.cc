@@ -18,7 +18,8 @@
 
 #include "dot11_ie_221_rsn_pmkid.h"
 
-void dot11_ie_221_rsn_pmkid::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_vendor_type = p_io->read_u1();
-    m_pmkid = p_io->read_bytes_full();
+void dot11_ie_221_rsn_pmkid::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_vendor_type = p_io.read_u1();
+    m_pmkid = p_io.read_bytes_full();
 }
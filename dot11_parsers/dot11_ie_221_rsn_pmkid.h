@@ -21,7 +21,7 @@
 
 #include <string>
 #include <memory>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_221_rsn_pmkid {
@@ -37,7 +37,7 @@ public:
         return 4;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint8_t vendor_type() const {
         return m_vendor_type;
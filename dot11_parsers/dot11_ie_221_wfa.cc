@@ -18,10 +18,10 @@
 
 #include "dot11_ie_221_wfa.h"
 
-void dot11_ie_221_wfa::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_wfa_subtype = p_io->read_u1();
+void dot11_ie_221_wfa::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_wfa_subtype = p_io.read_u1();
 
-    m_wfa_content = p_io->read_bytes_full();
-    m_wfa_content_stream.reset(new kaitai::kstream(m_wfa_content));
+    m_wfa_content = p_io.read_bytes_full();
 }
 
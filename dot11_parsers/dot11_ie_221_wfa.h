@@ -25,7 +25,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_221_wfa {
@@ -77,26 +77,25 @@ public:
         return 28;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
     
     constexpr17 uint8_t wfa_subtype() const {
         return m_wfa_subtype;
     }
 
-    std::shared_ptr<kaitai::kstream> wfa_content_stream() const {
-        return m_wfa_content_stream;
+    // View of the content after the subtype, valid for the lifetime of this object
+    std::string_view wfa_content() const {
+        return m_wfa_content;
     }
 
     void reset() {
         m_wfa_subtype = 0;
         m_wfa_content = "";
-        m_wfa_content_stream.reset();
     }
 
 protected:
     uint8_t m_wfa_subtype;
     std::string m_wfa_content;
-    std::shared_ptr<kaitai::kstream> m_wfa_content_stream;
 };
 
 
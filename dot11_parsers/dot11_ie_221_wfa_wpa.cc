@@ -19,19 +19,20 @@
 #include "globalregistry.h"
 #include "dot11_ie_221_wfa_wpa.h"
 
-void dot11_ie_221_wfa_wpa::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_vendor_subtype = p_io->read_u1();
-    m_wpa_version = p_io->read_u2le();
+void dot11_ie_221_wfa_wpa::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_vendor_subtype = p_io.read_u1();
+    m_wpa_version = p_io.read_u2le();
     m_multicast_cipher.reset(new wpa_v1_cipher());
     m_multicast_cipher->parse(p_io);
-    m_unicast_count = p_io->read_u2le();
+    m_unicast_count = p_io.read_u2le();
     m_unicast_ciphers = Globalreg::new_from_pool<shared_wpa_v1_cipher_vector>();
     for (uint16_t i = 0; i < unicast_count(); i++) {
         auto c = Globalreg::new_from_pool<wpa_v1_cipher>();
         c->parse(p_io);
         m_unicast_ciphers->push_back(c);
     }
-    m_akm_count = p_io->read_u2le();
+    m_akm_count = p_io.read_u2le();
     m_akm_ciphers = Globalreg::new_from_pool<shared_wpa_v1_cipher_vector>();
     for (uint16_t i = 0; i < akm_count(); i++) {
         auto c = Globalreg::new_from_pool<wpa_v1_cipher>();
@@ -40,7 +41,7 @@ void dot11_ie_221_wfa_wpa::parse(std::shared_ptr<kaitai::kstream> p_io) {
     }
 }
 
-void dot11_ie_221_wfa_wpa::wpa_v1_cipher::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_oui = p_io->read_bytes(3);
-    m_cipher_type = p_io->read_u1();
+void dot11_ie_221_wfa_wpa::wpa_v1_cipher::parse(kis_span_stream& p_io) {
+    m_oui = p_io.read_bytes(3);
+    m_cipher_type = p_io.read_u1();
 }
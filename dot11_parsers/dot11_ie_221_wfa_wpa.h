@@ -28,7 +28,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_221_wfa_wpa {
@@ -47,7 +47,7 @@ public:
         return 0x01;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint8_t vendor_subtype() const {
         return m_vendor_subtype;
@@ -124,7 +124,7 @@ public:
         wpa_v1_cipher() {}
         ~wpa_v1_cipher() {}
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        void parse(kis_span_stream& p_io);
 
         std::string oui() const {
             return m_oui;
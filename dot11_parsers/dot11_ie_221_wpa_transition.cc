@@ -18,13 +18,14 @@
 
 #include "dot11_ie_221_wpa_transition.h"
 
-void dot11_ie_221_owe_transition::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_vendor_type = p_io->read_u1();
+void dot11_ie_221_owe_transition::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_vendor_type = p_io.read_u1();
 
-    m_bssid = mac_addr(p_io->read_bytes(6).data(), 6);
+    m_bssid = mac_addr(p_io.read_bytes(6).data(), 6);
 
-    auto ssid_len = p_io->read_u1();
-    m_ssid = p_io->read_bytes(ssid_len);
+    auto ssid_len = p_io.read_u1();
+    m_ssid = p_io.read_bytes(ssid_len);
 
 }
 
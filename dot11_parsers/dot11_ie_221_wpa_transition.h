@@ -22,7 +22,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 #include "macaddr.h"
 
@@ -39,7 +39,7 @@ public:
         return 28;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint8_t vendor_type() const {
         return m_vendor_type;
@@ -18,8 +18,8 @@
 
 #include "dot11_ie_255_ext_tag.h"
 
-void dot11_ie_255_ext::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_subtag_num = p_io->read_u1();
-    m_subtag_data = p_io->read_bytes_full();
-    m_subtag_data_stream.reset(new kaitai::kstream(m_subtag_data));
+void dot11_ie_255_ext::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_subtag_num = p_io.read_u1();
+    m_subtag_data = p_io.read_bytes_full();
 }
@@ -22,7 +22,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_255_ext {
@@ -30,7 +30,7 @@ public:
     dot11_ie_255_ext() { }
     ~dot11_ie_255_ext() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint8_t subtag_num() const {
         return m_subtag_num;
@@ -40,14 +40,9 @@ public:
         return m_subtag_data;
     }
 
-    std::shared_ptr<kaitai::kstream> tag_data_stream() const {
-        return m_subtag_data_stream;
-    }
-
 protected:
     uint8_t m_subtag_num;
     std::string m_subtag_data;
-    std::shared_ptr<kaitai::kstream> m_subtag_data_stream;
 };
 
 #endif /* ifndef DOT11_IE_255_EXT_TAG */
@@ -18,8 +18,9 @@
 
 #include "dot11_ie_33_power.h"
 
-void dot11_ie_33_power::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_min_power = p_io->read_u1();
-    m_max_power = p_io->read_u1();
+void dot11_ie_33_power::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_min_power = p_io.read_u1();
+    m_max_power = p_io.read_u1();
 }
 
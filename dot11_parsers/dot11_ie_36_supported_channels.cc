@@ -19,12 +19,13 @@
 #include "dot11_ie_36_supported_channels.h"
 #include "fmt.h"
 
-void dot11_ie_36_supported_channels::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    while (!p_io->is_eof()) {
+void dot11_ie_36_supported_channels::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    while (!p_io.is_eof()) {
         unsigned int start, count;
 
-        start = p_io->read_u1();
-        count = p_io->read_u1();
+        start = p_io.read_u1();
+        count = p_io.read_u1();
 
         if (start + count > 0xFF) 
             throw std::runtime_error(fmt::format("Invalid IEEE 802.11 IE 36; Start channel {} + "
@@ -28,7 +28,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_36_supported_channels {
@@ -36,7 +36,7 @@ public:
     dot11_ie_36_supported_channels() { }
     ~dot11_ie_36_supported_channels() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     std::vector<unsigned int> supported_channels() const {
         return m_supported_channels;
@@ -28,7 +28,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_45_ht_cap {
@@ -38,7 +38,7 @@ public:
     dot11_ie_45_ht_cap() { }
     ~dot11_ie_45_ht_cap() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint16_t ht_capabilities() const {
         return m_ht_capabilities;
@@ -148,7 +148,7 @@ public:
 
         }
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        void parse(kis_span_stream& p_io);
 
         std::string rx_mcs() const {
             return m_rx_mcs;
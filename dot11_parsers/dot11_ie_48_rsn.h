@@ -31,7 +31,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_48_rsn {
@@ -45,7 +45,7 @@ public:
     dot11_ie_48_rsn() { }
     ~dot11_ie_48_rsn() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint16_t rsn_version() const {
         return m_rsn_version;
@@ -137,7 +137,7 @@ public:
 
         ~dot11_ie_48_rsn_rsn_cipher() { }
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        void parse(kis_span_stream& p_io);
 
         std::string cipher_suite_oui() const {
             return m_cipher_suite_oui;
@@ -174,7 +174,7 @@ public:
         dot11_ie_48_rsn_rsn_management() { }
         ~dot11_ie_48_rsn_rsn_management() { }
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        void parse(kis_span_stream& p_io);
 
         std::string management_suite_oui() const {
             return m_management_suite_oui;
@@ -201,7 +201,7 @@ public:
     dot11_ie_48_rsn_partial() { }
     ~dot11_ie_48_rsn_partial() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint16_t rsn_version() const {
         return m_rsn_version;
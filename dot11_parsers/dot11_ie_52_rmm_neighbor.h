@@ -29,7 +29,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_52_rmm {
@@ -38,7 +38,7 @@ public:
 
     ~dot11_ie_52_rmm() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     std::string bssid() const {
         return m_bssid;
@@ -18,8 +18,9 @@
 
 #include "dot11_ie_54_mobility.h"
 
-void dot11_ie_54_mobility::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_mobility_domain = p_io->read_u2le();
-    m_mobility_policy = p_io->read_u1();
+void dot11_ie_54_mobility::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_mobility_domain = p_io.read_u2le();
+    m_mobility_policy = p_io.read_u1();
 }
 
@@ -26,7 +26,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_54_mobility {
@@ -35,7 +35,7 @@ public:
 
     ~dot11_ie_54_mobility() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint16_t mobility_domain() const {
         return m_mobility_domain;
@@ -28,7 +28,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_61_ht_op {
@@ -36,7 +36,7 @@ public:
     dot11_ie_61_ht_op() { }
     ~dot11_ie_61_ht_op() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     constexpr17 uint8_t primary_channel() const {
         return m_primary_channel;
@@ -18,14 +18,20 @@
 
 #include "dot11_ie_7_country.h"
 
-void dot11_ie_7_country::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_country_code = p_io->read_bytes(2);
-    m_environment = p_io->read_u1();
+void dot11_ie_7_country::parse(std::string_view data) {
+    kis_span_stream p_io(data);
+    m_country_code = p_io.read_bytes(2);
+    m_environment = p_io.read_u1();
     m_country_list.reset(new shared_dot11d_country_triplet_vector());
+
+    // Triplets are only parsed on demand by parse_channels
+    m_triplet_data = p_io.read_span_full();
 }
 
 void dot11_ie_7_country::parse_channels() {
-    while (!p_io_c->is_eof()) {
+    kis_span_stream p_io_c(m_triplet_data);
+
+    while (!p_io_c.is_eof()) {
         // Do our best to read all the channel codings; if we allow broken
         // country tags, read as far as we can and then stop, otherwise
         // pass the error upstream
@@ -42,9 +48,9 @@ void dot11_ie_7_country::parse_channels() {
     }
 }
 
-void dot11_ie_7_country::dot11d_country_triplet::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_first_channel = p_io->read_u1();
-    m_num_channels = p_io->read_u1();
-    m_max_power = p_io->read_u1();
+void dot11_ie_7_country::dot11d_country_triplet::parse(kis_span_stream& p_io) {
+    m_first_channel = p_io.read_u1();
+    m_num_channels = p_io.read_u1();
+    m_max_power = p_io.read_u1();
 }
 
@@ -31,7 +31,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_ie_7_country {
@@ -52,7 +52,7 @@ public:
         i_allow_fragments = in_f;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
     void parse_channels();
 
     std::string country_code() const {
@@ -68,7 +68,8 @@ public:
     }
 
 protected:
-    std::shared_ptr<kaitai::kstream> p_io_c;
+    // Triplet data, parsed on demand; a view into the tag data passed to parse()
+    std::string_view m_triplet_data;
     std::string m_country_code;
     uint8_t m_environment;
     std::shared_ptr<shared_dot11d_country_triplet_vector> m_country_list;
@@ -81,7 +82,7 @@ public:
         dot11d_country_triplet() {}
         ~dot11d_country_triplet() {}
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        void parse(kis_span_stream& p_io);
 
         constexpr17 uint8_t first_channel() const {
             return m_first_channel;
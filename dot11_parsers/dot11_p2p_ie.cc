@@ -19,20 +19,20 @@
 #include "globalregistry.h"
 #include "dot11_p2p_ie.h"
 
-void dot11_wfa_p2p_ie::parse(std::shared_ptr<kaitai::kstream> p_io) {
+void dot11_wfa_p2p_ie::parse(std::string_view data) {
+    kis_span_stream p_io(data);
     m_tags = Globalreg::new_from_pool<shared_ie_tag_vector>();
 
-    while (!p_io->is_eof()) {
+    while (!p_io.is_eof()) {
         auto t = Globalreg::new_from_pool<dot11_wfa_p2p_ie_tag>();
         t->parse(p_io);
         m_tags->push_back(t);
     }
 }
 
-void dot11_wfa_p2p_ie::dot11_wfa_p2p_ie_tag::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_tag_num = p_io->read_u1();
-    m_tag_len = p_io->read_u2le();
-    m_tag_data = p_io->read_bytes(tag_len());
-    m_tag_data_stream.reset(new kaitai::kstream(m_tag_data));
+void dot11_wfa_p2p_ie::dot11_wfa_p2p_ie_tag::parse(kis_span_stream& p_io) {
+    m_tag_num = p_io.read_u1();
+    m_tag_len = p_io.read_u2le();
+    m_tag_data = p_io.read_bytes(tag_len());
 }
 
@@ -29,7 +29,7 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <kaitai/kaitaistream.h>
+#include "kis_span_stream.h"
 #include "multi_constexpr.h"
 
 class dot11_wfa_p2p_ie {
@@ -41,7 +41,7 @@ public:
 
     ~dot11_wfa_p2p_ie() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    void parse(std::string_view data);
 
     std::shared_ptr<shared_ie_tag_vector> tags() const {
         return m_tags;
@@ -60,7 +60,7 @@ public:
         dot11_wfa_p2p_ie_tag() { } 
         ~dot11_wfa_p2p_ie_tag() { }
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        void parse(kis_span_stream& p_io);
 
         constexpr17 uint8_t tag_num() const {
             return m_tag_num;
@@ -74,22 +74,16 @@ public:
             return m_tag_data;
         }
 
-        std::shared_ptr<kaitai::kstream> tag_data_stream() const {
-            return m_tag_data_stream;
-        }
-
         void reset() {
             m_tag_num = 0;
             m_tag_len = 0;
             m_tag_data = "";
-            m_tag_data_stream.reset();
         }
 
     protected:
         uint8_t m_tag_num;
         uint16_t m_tag_len;
         std::string m_tag_data;
-        std::shared_ptr<kaitai::kstream> m_tag_data_stream;
     };
 };
 
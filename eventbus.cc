@@ -59,13 +59,13 @@ void event_bus::trigger_deferred_startup() {
 
     httpd->register_websocket_route("/eventbus/events", httpd->RO_ROLE, {"ws"},
             std::make_shared<kis_net_web_function_endpoint>(
-                [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
+                [this, httpd](std::shared_ptr<kis_net_beast_httpd_connection> con) {
 
-                std::unordered_map<std::string, unsigned long> reg_map;
+                auto reg_map = std::make_shared<std::unordered_map<std::string, unsigned long>>();
 
                 auto ws = 
                     std::make_shared<kis_net_web_websocket_endpoint>(con, 
-                        [this, &reg_map](std::shared_ptr<kis_net_web_websocket_endpoint> ws,
+                        [this, reg_map](std::shared_ptr<kis_net_web_websocket_endpoint> ws,
                             boost::beast::flat_buffer& buf, bool text) mutable {
 
                             if (!text) {
@@ -85,30 +85,36 @@ void event_bus::trigger_deferred_startup() {
                             }
 
                             if (!json["SUBSCRIBE"].is_null()) {
-                                auto e_k = reg_map.find(json["SUBSCRIBE"].get<std::string>());
-                                if (e_k != reg_map.end()) {
+                                auto e_k = reg_map->find(json["SUBSCRIBE"].get<std::string>());
+                                if (e_k != reg_map->end()) {
                                     remove_listener(e_k->second);
-                                    reg_map.erase(e_k);
+                                    reg_map->erase(e_k);
                                 }
 
+                                // Subscribers asking for the same fields share serialized events
+                                auto format = json;
+                                format.erase("SUBSCRIBE");
+                                auto format_key = format.dump();
+
                                 auto id = 
                                     register_listener(json["SUBSCRIBE"].get<std::string>(), 
-                                            [ws, json](std::shared_ptr<eventbus_event> evt) {
-                                                std::stringstream os;
-                                                Globalreg::globalreg->entrytracker->serialize_with_json_summary("json", os, 
-                                                        evt->get_event_content(), json);
-												auto data = os.str();
-                                                ws->write(data);
+                                            [this, ws, format, format_key](std::shared_ptr<eventbus_event> evt) {
+                                                auto data = serialize_shared(evt, format_key, format);
+
+                                                if (is_state_event(evt->get_event_id()))
+                                                    ws->write(data, evt->get_event_id());
+                                                else
+                                                    ws->write(data);
                                             });
 
-                                reg_map[json["SUBSCRIBE"].get<std::string>()] = id;
+                                (*reg_map)[json["SUBSCRIBE"].get<std::string>()] = id;
                             } 
 
                             if (!json["UNSUBSCRIBE"].is_null()) {
-                                auto e_k = reg_map.find(json["UNSUBSCRIBE"].get<std::string>());
-                                if (e_k != reg_map.end()) {
+                                auto e_k = reg_map->find(json["UNSUBSCRIBE"].get<std::string>());
+                                if (e_k != reg_map->end()) {
                                     remove_listener(e_k->second);
-                                    reg_map.erase(e_k);
+                                    reg_map->erase(e_k);
                                 }
 
                             }
@@ -116,15 +122,24 @@ void event_bus::trigger_deferred_startup() {
 
                 ws->text();
 
+                // Events are only useful while they're recent, so don't let a slow client
+                // queue them without bound
+                ws->set_queue_max(httpd->websocket_queue_max());
+
+                // Listeners are only added from the read handler, which runs on the same
+                // strand as the closure
+                ws->set_closure_cb([this, reg_map]() {
+                        for (auto s : *reg_map)
+                            remove_listener(s.second);
+                        reg_map->clear();
+                    });
+
                 // Blind-catch all errors b/c we must release our listeners at the end
                 try {
                     ws->handle_request(con);
                 } catch (const std::exception& e) {
                     ws->close();
                 }
-
-                for (auto s : reg_map)
-                    remove_listener(s.second);
                 }));
 
 }
@@ -194,6 +209,8 @@ void event_bus::event_queue_dispatcher() {
                 }
             }
 
+            dispatch_serial_cache.clear();
+
             // Loop for more events
             continue;
         }
@@ -206,6 +223,32 @@ void event_bus::event_queue_dispatcher() {
     }
 }
 
+std::shared_ptr<const std::string> event_bus::serialize_shared(std::shared_ptr<eventbus_event> evt,
+        const std::string& format_key, const nlohmann::json& format) {
+    auto cached = dispatch_serial_cache.find(format_key);
+    if (cached != dispatch_serial_cache.end())
+        return cached->second;
+
+    std::stringstream os;
+    Globalreg::globalreg->entrytracker->serialize_with_json_summary("json", os, 
+            evt->get_event_content(), format);
+
+    auto data = std::make_shared<const std::string>(os.str());
+    dispatch_serial_cache[format_key] = data;
+
+    return data;
+}
+
+void event_bus::register_state_event(const std::string& type) {
+    std::lock_guard<kis_mutex> lk(handler_mutex);
+    state_events.insert(type);
+}
+
+bool event_bus::is_state_event(const std::string& type) {
+    std::lock_guard<kis_mutex> lk(handler_mutex);
+    return state_events.find(type) != state_events.end();
+}
+
 unsigned long event_bus::register_listener(const std::string& channel, cb_func cb) {
     return register_listener(std::list<std::string>{channel}, cb);
 }
@@ -48,8 +48,11 @@
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "nlohmann/json.hpp"
+
 #include "globalregistry.h"
 #include "kis_mutex.h"
 #include "trackedcomponent.h"
@@ -128,6 +131,17 @@ public:
 
     std::shared_ptr<eventbus_event> get_eventbus_event(const std::string& type);
 
+    // Serialize an event for a websocket subscriber.  Subscribers requesting the same format
+    // share one serialized copy of each event instead of serializing it per subscriber.  Only
+    // valid from within an event callback.
+    std::shared_ptr<const std::string> serialize_shared(std::shared_ptr<eventbus_event> evt,
+            const std::string& format_key, const nlohmann::json& format);
+
+    // Events which are periodic snapshots of state (timestamps, stats, location); a slow 
+    // subscriber only needs the most recent one, so queued copies may be coalesced
+    void register_state_event(const std::string& type);
+    bool is_state_event(const std::string& type);
+
     template<typename T>
     void publish(T event) {
         // kis_lock_guard<kis_mutex> lk(mutex, "eventbus publish");
@@ -165,6 +179,12 @@ protected:
     std::unordered_map<std::string, std::vector<std::shared_ptr<callback_listener>>> callback_table;
     std::unordered_map<unsigned long, std::shared_ptr<callback_listener>> callback_id_table;
 
+    std::unordered_set<std::string> state_events;
+
+    // Serialized copies of the event currently being dispatched, by format; only touched 
+    // by the dispatch thread
+    std::unordered_map<std::string, std::shared_ptr<const std::string>> dispatch_serial_cache;
+
     // Event pool and handler thread
     std::queue<std::shared_ptr<eventbus_event>> event_queue;
     std::thread event_dispatch_t;
@@ -21,14 +21,17 @@
 
 #include "config.h"
 
+#include <functional>
 #include <sstream>
 #include <string>
 #include <mutex>
 #include <future>
 #include <list>
+#include <vector>
 
 #include <stdlib.h>
 #include <string.h>
+#include <zlib.h>
 
 #include "messagebus.h"
 
@@ -45,6 +48,23 @@
 // wait() - waits until data is *present in the buffer*, should be called by the consumer
 // wait_write() - waits until the buffer *has flushed data*, should be called by a producer
 //  looking to throttle size buffer size.
+//
+// async_wait() is the non-blocking form of wait() for consumers running on an io
+// context; the callback may be called from the producer thread and must not block.
+// async_wait_write() is the non-blocking form of wait_write() for producers, and calls
+// back once the buffer has drained to a given size; it is called from the consumer thread.
+//
+// future_chainbuf_reader reads the buffer as a std::streambuf, blocking in wait().
+//
+// Stream mode content can be gzip compressed as it is written, on the producer side,
+// with set_gzip().  Compressed data is handed to the consumer as the compressor emits 
+// it, when the producer flushes the stream, and when the buffer completes.
+//
+// Producers which batch data before handing it to the buffer can register a drain
+// callback with set_drain_cb(); it is called by the consumer when it is about to block
+// waiting for data, so that the producer can hand over any partial batch.  Producers 
+// must also check waiting() when they add to a batch and hand it over immediately if 
+// the consumer is already blocked.
 class future_chainbuf : public std::stringbuf {
 protected:
     class data_chunk {
@@ -116,9 +136,13 @@ public:
         total_sz_{0},
         waiting_{false},
         write_waiting_{false},
+        write_cb_sz_{0},
         complete_{false},
         cancel_{false},
-        packet_{false} { }
+        packet_{false},
+        gzip_{false},
+        zs_{nullptr},
+        capture_{nullptr} { }
         
     future_chainbuf(size_t chunk_sz, size_t sync_sz = 1024) :
         chunk_sz_{chunk_sz},
@@ -126,9 +150,13 @@ public:
         total_sz_{0},
         waiting_{false},
         write_waiting_{false},
+        write_cb_sz_{0},
         complete_{false},
         cancel_{false},
-        packet_{false} { }
+        packet_{false},
+        gzip_{false},
+        zs_{nullptr},
+        capture_{nullptr} { }
 
     ~future_chainbuf() {
         cancel();
@@ -151,39 +179,54 @@ public:
         return target->used();
     }
 
-    void consume(size_t sz) {
+    // Get all the pending chunks, up to max_sz, without consuming them; the chunks 
+    // remain valid until they are consumed.
+    size_t get_chunks(std::vector<std::pair<const char *, size_t>>& chunks, size_t max_sz) {
         const std::lock_guard<std::recursive_mutex> lock(mutex_);
 
+        size_t total = 0;
+
+        for (auto c : chunk_list_) {
+            if (total >= max_sz)
+                break;
+
+            if (c->used() == 0)
+                continue;
+
+            chunks.push_back(std::make_pair(c->content(), c->used()));
+            total += c->used();
+        }
+
+        return total;
+    }
+
+    void consume(size_t sz) {
+        std::unique_lock<std::recursive_mutex> lk(mutex_);
+
         if (chunk_list_.size() == 0)
             return;
 
-        data_chunk *target = chunk_list_.front();
-
         size_t consumed_sz = 0;
 
-        while (consumed_sz < sz && consumed_sz < total_sz_) {
-            size_t consumed_chunk_sz;
-
-            consumed_chunk_sz = target->consume(sz);
-            consumed_sz += consumed_chunk_sz;
-
-            if (target->exhausted()) {
-                if (chunk_list_.size() == 1) {
-                    if (packet_) {
-                        chunk_list_.pop_front();
-                        delete target;
-                        target = nullptr;
-                    } else {
-                        target->recycle();
-                    }
-
-                    break;
-                } else {
-                    chunk_list_.pop_front();
-                    delete target;
-                    target = chunk_list_.front();
-                }
+        while (consumed_sz < sz && chunk_list_.size() > 0) {
+            data_chunk *target = chunk_list_.front();
+
+            consumed_sz += target->consume(sz - consumed_sz);
+
+            // Partially consumed chunk
+            if (target->used() > 0)
+                break;
+
+            // Packet chunks are never written to again once they're queued
+            if (target->exhausted() || packet_) {
+                chunk_list_.pop_front();
+                delete target;
+                continue;
             }
+
+            // A drained chunk which can still be written to is always the tail chunk
+            target->recycle();
+            break;
         }
 
         if (consumed_sz > total_sz_)
@@ -197,6 +240,11 @@ public:
         } catch (const std::future_error& e) {
             ;
         }
+
+        if (write_cb_ != nullptr && total_sz_ <= write_cb_sz_) {
+            lk.unlock();
+            wake_write();
+        }
     }
 
     void put_data(const char *data, size_t sz) {
@@ -213,6 +261,19 @@ public:
             throw std::runtime_error("can't put char* in packet mode");
         }
 
+        if (capture_ != nullptr)
+            capture_->append(data, sz);
+
+        if (gzip_) {
+            deflate_locked(data, sz, Z_NO_FLUSH);
+            mutex_.unlock();
+
+            if (size() > sync_sz_)
+                wake();
+
+            return;
+        }
+
         data_chunk *target;
 
         if (chunk_list_.size() != 0) {
@@ -241,7 +302,7 @@ public:
         mutex_.unlock();
 
         if (packet_ || size() > sync_sz_)
-            sync();
+            wake();
     }
 
     // Secondary put_data that takes a shared buffer pointer and directly applies it
@@ -262,7 +323,20 @@ public:
             mutex_.unlock();
 
             if (packet_ || size() > sync_sz_)
-                sync();
+                wake();
+
+            return;
+        }
+
+        if (capture_ != nullptr)
+            capture_->append(data.get(), sz);
+
+        if (gzip_) {
+            deflate_locked(data.get(), sz, Z_NO_FLUSH);
+            mutex_.unlock();
+
+            if (size() > sync_sz_)
+                wake();
 
             return;
         }
@@ -295,7 +369,7 @@ public:
         mutex_.unlock();
 
         if (packet_ || size() > sync_sz_)
-            sync();
+            wake();
 
     }
 
@@ -306,7 +380,7 @@ public:
         put_data(s, n);
 
         if (size() > sync_sz_)
-            sync();
+            wake();
 
         return n;
     }
@@ -318,20 +392,43 @@ public:
         put_data((char *) &ch, 1);
 
         if (size() > sync_sz_)
-            sync();
+            wake();
 
         return ch;
     }
 
+    // Flushing the stream flushes any compressed data held by the encoder
     int sync() override {
-        const std::lock_guard<std::recursive_mutex> lock(mutex_);
-        try {
-            wait_promise_.set_value();
-        } catch (const std::future_error& e) {
-            ;
+        if (gzip_) {
+            const std::lock_guard<std::recursive_mutex> lock(mutex_);
+            if (running() && zs_ != nullptr)
+                deflate_locked(nullptr, 0, Z_SYNC_FLUSH);
         }
 
-        waiting_ = false;
+        return wake();
+    }
+
+    // Wake any consumer waiting for data
+    int wake() {
+        std::function<void ()> cb;
+
+        {
+            const std::lock_guard<std::recursive_mutex> lock(mutex_);
+            try {
+                wait_promise_.set_value();
+            } catch (const std::future_error& e) {
+                ;
+            }
+
+            waiting_ = false;
+
+            cb = std::move(wait_cb_);
+            wait_cb_ = nullptr;
+        }
+
+        // Async waiters are called outside of the lock
+        if (cb != nullptr)
+            cb();
 
         return 1;
     }
@@ -360,26 +457,104 @@ public:
         complete_ = false;
         cancel_ = false;
         waiting_ = false;
+
+        end_gzip_locked();
     }
 
     void cancel() {
         mutex_.lock();
         cancel_ = true;
+        end_gzip_locked();
         mutex_.unlock();
-        sync();
+        wake();
+        wake_write();
     }
 
     void complete() {
         mutex_.lock();
+
+        // Write the end of the compressed stream
+        if (running() && zs_ != nullptr)
+            deflate_locked(nullptr, 0, Z_FINISH);
+        end_gzip_locked();
+
         complete_ = true;
         mutex_.unlock();
-        sync();
+        wake();
+        wake_write();
     }
 
     void set_packetmode() {
+        clear_gzip();
         packet_ = true;
     }
 
+    // Compress stream content with gzip; only possible before any data has been written.
+    // Returns if the stream will be compressed.
+    bool set_gzip(int level) {
+        const std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+        if (gzip_)
+            return true;
+
+        if (packet_ || total_sz_ > 0 || !running())
+            return false;
+
+        zs_ = new z_stream;
+        memset(zs_, 0, sizeof(z_stream));
+
+        // 15 window bits + 16 for a gzip wrapper instead of raw zlib
+        if (deflateInit2(zs_, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            delete zs_;
+            zs_ = nullptr;
+            return false;
+        }
+
+        gzip_ = true;
+
+        return true;
+    }
+
+    // Stop compressing if nothing has been written yet; returns if the stream is uncompressed
+    bool clear_gzip() {
+        const std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+        if (!gzip_)
+            return true;
+
+        if (zs_ != nullptr && zs_->total_in > 0)
+            return false;
+
+        end_gzip_locked();
+        gzip_ = false;
+
+        return true;
+    }
+
+    bool gzip() const {
+        return gzip_;
+    }
+
+    bool packetmode() const {
+        return packet_;
+    }
+
+    // Copy all stream content written from now on, before compression, into capture; the
+    // capture string must remain valid until it is cleared with a nullptr
+    void set_capture(std::string *capture) {
+        const std::lock_guard<std::recursive_mutex> lock(mutex_);
+        capture_ = capture;
+    }
+
+    void set_drain_cb(std::function<void ()> cb) {
+        const std::lock_guard<std::mutex> lock(drain_mutex_);
+        drain_cb_ = cb;
+    }
+
+    bool waiting() const {
+        return waiting_;
+    }
+
     size_t wait() {
         std::unique_lock<std::recursive_mutex> lk(mutex_);
         if (waiting_)
@@ -394,11 +569,43 @@ public:
         auto ft = wait_promise_.get_future();
         lk.unlock();
 
+        // Let a batching producer hand over anything pending; this has to happen after
+        // we're flagged as waiting so that a producer either sees us waiting or has
+        // already batched data we can drain.
+        {
+            const std::lock_guard<std::mutex> lock(drain_mutex_);
+            if (drain_cb_ != nullptr)
+                drain_cb_();
+        }
+
         ft.wait();
 
         return total_sz_;
     }
 
+    void async_wait(std::function<void ()> cb) {
+        std::unique_lock<std::recursive_mutex> lk(mutex_);
+        if (waiting_)
+            throw std::runtime_error("future_stream already blocking");
+
+        if (total_sz_ > 0 || !running()) {
+            lk.unlock();
+            cb();
+            return;
+        }
+
+        waiting_ = true;
+        wait_promise_ = std::promise<void>();
+        wait_cb_ = cb;
+        lk.unlock();
+
+        {
+            const std::lock_guard<std::mutex> lock(drain_mutex_);
+            if (drain_cb_ != nullptr)
+                drain_cb_();
+        }
+    }
+
     size_t wait_write() {
         std::unique_lock<std::recursive_mutex> lk(mutex_);
 
@@ -418,6 +625,38 @@ public:
         return total_sz_;
     }
 
+    // Call cb once the buffer holds no more than max_sz, or the buffer is finished
+    void async_wait_write(size_t max_sz, std::function<void ()> cb) {
+        std::unique_lock<std::recursive_mutex> lk(mutex_);
+
+        if (write_cb_ != nullptr)
+            throw std::runtime_error("future_stream already waiting for write");
+
+        if (total_sz_ <= max_sz || !running()) {
+            lk.unlock();
+            cb();
+            return;
+        }
+
+        write_cb_sz_ = max_sz;
+        write_cb_ = cb;
+    }
+
+    // Wake any producer waiting asynchronously for the buffer to drain
+    void wake_write() {
+        std::function<void ()> cb;
+
+        {
+            const std::lock_guard<std::recursive_mutex> lock(mutex_);
+            cb = std::move(write_cb_);
+            write_cb_ = nullptr;
+        }
+
+        // Called outside of the lock, like async waiters
+        if (cb != nullptr)
+            cb();
+    }
+
 protected:
     std::recursive_mutex mutex_;
 
@@ -428,16 +667,121 @@ protected:
     std::atomic<size_t> total_sz_;
 
     std::promise<void> wait_promise_;
+    std::function<void ()> wait_cb_;
     std::atomic<bool> waiting_;
 
     std::promise<void> write_wait_promise_;
     std::atomic<bool> write_waiting_;
+    std::function<void ()> write_cb_;
+    size_t write_cb_sz_;
 
     std::atomic<bool> complete_;
     std::atomic<bool> cancel_;
 
     std::atomic<bool> packet_;
 
+    std::mutex drain_mutex_;
+    std::function<void ()> drain_cb_;
+
+    // Compressed stream mode; gzip_ remains set once the encoder has finished so the
+    // consumer can still tell the content is compressed
+    std::atomic<bool> gzip_;
+    z_stream *zs_;
+
+    std::string *capture_;
+
+    // Run the encoder over data, appending the compressed output to the chunk chain
+    void deflate_locked(const char *data, size_t sz, int flush) {
+        if (zs_ == nullptr)
+            return;
+
+        zs_->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        zs_->avail_in = sz;
+
+        do {
+            data_chunk *target = nullptr;
+
+            if (chunk_list_.size() != 0)
+                target = chunk_list_.back();
+
+            if (target == nullptr || target->available() == 0) {
+                target = new data_chunk(chunk_sz_);
+                chunk_list_.push_back(target);
+            }
+
+            auto avail = target->available();
+
+            zs_->next_out = reinterpret_cast<Bytef *>(target->chunk_.get() + target->end_);
+            zs_->avail_out = avail;
+
+            deflate(zs_, flush);
+
+            target->end_ += avail - zs_->avail_out;
+            total_sz_ += avail - zs_->avail_out;
+        } while (zs_->avail_in > 0 || zs_->avail_out == 0);
+    }
+
+    void end_gzip_locked() {
+        if (zs_ == nullptr)
+            return;
+
+        deflateEnd(zs_);
+        delete zs_;
+        zs_ = nullptr;
+    }
+};
+
+// Read side of a future_chainbuf, for consuming a stream through std::istream while it is
+// still being produced.  Reads block until data arrives; the stream ends once the producer
+// completes or cancels the buffer and the remaining data has been read.
+class future_chainbuf_reader : public std::streambuf {
+public:
+    future_chainbuf_reader(future_chainbuf& buf) :
+        buf_{buf},
+        exposed_{0} { }
+
+    ~future_chainbuf_reader() {
+        release();
+    }
+
+protected:
+    future_chainbuf& buf_;
+
+    // Length of the chunk currently exposed as the get area; chunks stay valid until
+    // they're consumed
+    size_t exposed_;
+
+    void release() {
+        if (exposed_ > 0) {
+            buf_.consume(exposed_);
+            exposed_ = 0;
+        }
+
+        setg(nullptr, nullptr, nullptr);
+    }
+
+    virtual int_type underflow() override {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+        release();
+
+        while (true) {
+            char *data;
+            auto sz = buf_.get(&data);
+
+            if (sz > 0) {
+                exposed_ = sz;
+                setg(data, data, data + sz);
+                return traits_type::to_int_type(*gptr());
+            }
+
+            if (!buf_.running())
+                return traits_type::eof();
+
+            buf_.wait();
+        }
+    }
 };
 
 
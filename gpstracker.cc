@@ -60,6 +60,7 @@ gps_tracker::~gps_tracker() {
 void gps_tracker::trigger_deferred_startup() {
     timetracker = Globalreg::fetch_mandatory_global_as<time_tracker>();
     eventbus = Globalreg::fetch_mandatory_global_as<event_bus>();
+    eventbus->register_state_event(event_gps_location());
 
     tracked_uuid_addition_id = 
         Globalreg::globalreg->entrytracker->register_field("kismet.common.location.gps_uuid", 
@@ -162,6 +162,34 @@ std::string json_adapter::sanitize_string(const std::string& s) noexcept {
     return result;
 }
 
+std::string json_adapter::field_name(int field_id, shared_tracker_element e,
+        std::shared_ptr<tracker_element_serializer::rename_map> name_map) {
+    std::string tname;
+
+    if (name_map != nullptr && e != nullptr) {
+        auto nmi = name_map->find(e);
+        if (nmi != name_map->end() && nmi->second->rename.length() != 0)
+            return nmi->second->rename;
+    }
+
+    if (e == nullptr)
+        return Globalreg::globalreg->entrytracker->get_field_name(field_id);
+
+    if (e->get_type() == tracker_type::tracker_placeholder_missing) {
+        tname = static_cast<tracker_element_placeholder *>(e.get())->get_name();
+    } else if (e->get_type() == tracker_type::tracker_alias) {
+        tname = static_cast<tracker_element_alias *>(e.get())->get_alias_name();
+    } else {
+        tname = Globalreg::globalreg->entrytracker->get_field_name(field_id);
+    }
+
+    // Default to the defined name if we got a blank
+    if (tname == "")
+        tname = Globalreg::globalreg->entrytracker->get_field_name(field_id);
+
+    return tname;
+}
+
 void json_adapter::pack(std::ostream &stream, shared_tracker_element e, 
         std::shared_ptr<tracker_element_serializer::rename_map> name_map,
         bool prettyprint, unsigned int depth,
@@ -278,7 +306,6 @@ void json_adapter::pack(std::ostream &stream, shared_tracker_element e,
 
                 prepend_comma = false;
                 for (auto i : *static_cast<tracker_element_map *>(e.get())) {
-                    bool named = false;
 
                     if (i.second == NULL)
                         continue;
@@ -293,33 +320,7 @@ void json_adapter::pack(std::ostream &stream, shared_tracker_element e,
                     prepend_comma = true;
 
                     if (!as_vector) {
-                        if (name_map != NULL) {
-                            tracker_element_serializer::rename_map::iterator nmi = name_map->find(i.second);
-                            if (nmi != name_map->end() && nmi->second->rename.length() != 0) {
-                                tname = nmi->second->rename;
-                                named = true;
-                            }
-                        }
-
-                        if (!named) {
-                            if (i.second == NULL) {
-                                tname = Globalreg::globalreg->entrytracker->get_field_name(i.first);
-                            } else {
-                                if (i.second->get_type() == tracker_type::tracker_placeholder_missing) {
-                                    tname = static_cast<tracker_element_placeholder *>(i.second.get())->get_name();
-                                } else if (i.second->get_type() == tracker_type::tracker_alias) {
-                                    tname = static_cast<tracker_element_alias *>(i.second.get())->get_alias_name();
-                                } else {
-                                    tname = Globalreg::globalreg->entrytracker->get_field_name(i.first);
-                                }
-
-                                // Default to the defined name if we got a blank
-                                if (tname == "")
-                                    tname = Globalreg::globalreg->entrytracker->get_field_name(i.first);
-                            }
-                        }
-
-                        tname = json_adapter::sanitize_string(name_permuter(tname));
+                        tname = json_adapter::sanitize_string(name_permuter(field_name(i.first, i.second, name_map)));
 
                         if (prettyprint) {
                             stream << indent << "\"description." << tname << "\": ";
@@ -38,6 +38,10 @@ void pack(std::ostream &stream, shared_tracker_element e,
         std::function<std::string (const std::string&)> name_permuter = 
             [](const std::string& s) -> std::string { return s; });
 
+// Name a field of a map as pack() does, honoring renames, aliases, and placeholders
+std::string field_name(int field_id, shared_tracker_element e,
+        std::shared_ptr<tracker_element_serializer::rename_map> name_map = nullptr);
+
 std::string sanitize_string(const std::string& in) noexcept;
 std::size_t sanitize_extra_space(const std::string& in) noexcept;
 
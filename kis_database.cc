@@ -17,6 +17,7 @@
 */
 
 #include "kis_database.h"
+#include "sqlite3_cpp11.h"
 #include "configfile.h"
 #include "messagebus.h"
 #include "globalregistry.h"
@@ -33,6 +34,7 @@ kis_database::~kis_database() {
     kis_lock_guard<kis_mutex> lk(ds_mutex);
 
     if (db != NULL) {
+        kissqlite3::release_statement_cache(db);
         sqlite3_close(db);
         db = NULL;
     }
@@ -68,6 +70,8 @@ bool kis_database::database_open(std::string in_file_path, int in_flags) {
         return false;
     }
 
+    kissqlite3::enable_statement_cache(db);
+
     // Do we have a KISMET table?  If not, this is probably a new database.
     bool k_t_exists = false;
 
@@ -86,6 +90,7 @@ bool kis_database::database_open(std::string in_file_path, int in_flags) {
     if (r != SQLITE_OK) {
         _MSG("kis_database unable to query for KISMET master table in " + ds_dbfile + ": " + 
                 std::string(sErrMsg), MSGFLAG_ERROR);
+        kissqlite3::release_statement_cache(db);
         sqlite3_close(db);
         db = NULL;
         return false;
@@ -105,6 +110,7 @@ void kis_database::database_close() {
     kis_lock_guard<kis_mutex> lk(ds_mutex, "database_close");
 
     if (db != NULL) {
+        kissqlite3::release_statement_cache(db);
         sqlite3_close(db);
     }
 
@@ -133,6 +139,7 @@ bool kis_database::database_create_master_table() {
     if (r != SQLITE_OK) {
         _MSG("kis_database unable to create KISMET master table in " + ds_dbfile + ": " +
                 std::string(sErrMsg), MSGFLAG_ERROR);
+        kissqlite3::release_statement_cache(db);
         sqlite3_close(db);
         db = NULL;
         return false;
@@ -146,6 +153,7 @@ bool kis_database::database_create_master_table() {
     if (r != SQLITE_OK) {
         _MSG("kis_database unable to generate prepared statement for master table in " +
                 ds_dbfile + ": " + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+        kissqlite3::release_statement_cache(db);
         sqlite3_close(db);
         db = NULL;
         return false;
@@ -201,6 +209,7 @@ unsigned int kis_database::database_get_db_version() {
     if (r != SQLITE_OK) {
         _MSG("kis_database unable to query db_version in" + ds_dbfile + ": " +
                 std::string(sErrMsg), MSGFLAG_ERROR);
+        kissqlite3::release_statement_cache(db);
         sqlite3_close(db);
         db = NULL;
         return 0;
@@ -229,6 +238,7 @@ bool kis_database::database_set_db_version(unsigned int version) {
     if (r != SQLITE_OK) {
         _MSG("kis_database unable to generate prepared statement to update master table in " +
                 ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+        kissqlite3::release_statement_cache(db);
         sqlite3_close(db);
         db = NULL;
         return false;
@@ -28,6 +28,8 @@
 #include "messagebus.h"
 #include "packetchain.h"
 #include "sqlite3_cpp11.h"
+#include "util.h"
+#include "xxhash.h"
 
 kis_database_logfile::kis_database_logfile():
     kis_logfile(shared_log_builder(NULL)), 
@@ -37,6 +39,7 @@ kis_database_logfile::kis_database_logfile():
     eventbus = Globalreg::fetch_mandatory_global_as<event_bus>();
 
     transaction_mutex.set_name("kis_database_logfile_transaction");
+    device_delta_mutex.set_name("kis_database_logfile_device_delta");
 
     std::shared_ptr<packet_chain> packetchain =
         Globalreg::fetch_mandatory_global_as<packet_chain>("PACKETCHAIN");
@@ -52,6 +55,13 @@ kis_database_logfile::kis_database_logfile():
 
     last_device_log = 0;
 
+    log_device_deltas = false;
+    device_delta_compact = 20;
+
+    wal_mode = false;
+    wal_checkpoint_sec = 30;
+    checkpoint_shutdown = false;
+
     devicetracker =
         Globalreg::fetch_mandatory_global_as<device_tracker>();
 
@@ -59,11 +69,13 @@ kis_database_logfile::kis_database_logfile():
 
     message_evt_id = 0;
     alert_evt_id = 0;
+    remove_device_evt_id = 0;
 }
 
 kis_database_logfile::~kis_database_logfile() {
     eventbus->remove_listener(message_evt_id);
     eventbus->remove_listener(alert_evt_id);
+    eventbus->remove_listener(remove_device_evt_id);
 
     close_log();
 }
@@ -99,7 +111,52 @@ bool kis_database_logfile::open_log(std::string in_path) {
         return false;
     }
 
-    sqlite3_exec(db, "PRAGMA journal_mode=PERSIST", NULL, NULL, NULL);
+    wal_mode = 
+        Globalreg::globalreg->kismet_config->fetch_opt_bool("kis_log_wal", false);
+    wal_checkpoint_sec =
+        Globalreg::globalreg->kismet_config->fetch_opt_uint("kis_log_wal_checkpoint", 30);
+
+    // An ephemeral log is unlinked after opening, so readers could not re-open it, and
+    // the WAL files would be left behind
+    if (wal_mode && 
+            Globalreg::globalreg->kismet_config->fetch_opt_bool("kis_log_ephemeral_dangerous", false)) {
+        _MSG_INFO("Kismetdb WAL mode is not available for ephemeral logs, using the "
+                "standard journal.");
+        wal_mode = false;
+    }
+
+    if (wal_mode) {
+        // SQLite returns the journal mode actually in effect; WAL can be refused, for
+        // instance on filesystems without shared memory support
+        std::string journal_mode;
+
+        sqlite3_exec(db, "PRAGMA journal_mode=WAL", 
+                [](void *aux, int argc, char **argv, char **) -> int {
+                    if (argc > 0 && argv[0] != nullptr)
+                        *static_cast<std::string *>(aux) = argv[0];
+                    return 0;
+                }, &journal_mode, NULL);
+
+        if (str_lower(journal_mode) != "wal") {
+            _MSG_ERROR("Kismetdb log could not be put into WAL mode (journal mode is '{}'), "
+                    "using the standard journal.", journal_mode);
+            wal_mode = false;
+        }
+    }
+
+    if (wal_mode) {
+        // Commits only need to reach the WAL; syncing happens at checkpoint, so a crash
+        // loses at most the open commit window.  Checkpoints are run from our own
+        // thread instead of automatically inside a commit.
+        sqlite3_exec(db, "PRAGMA synchronous=NORMAL", NULL, NULL, NULL);
+        sqlite3_exec(db, "PRAGMA wal_autocheckpoint=0", NULL, NULL, NULL);
+        sqlite3_exec(db, "PRAGMA journal_size_limit=67108864", NULL, NULL, NULL);
+
+        checkpoint_shutdown = false;
+        checkpoint_t = std::thread([this]() { checkpoint_thread(); });
+    } else {
+        sqlite3_exec(db, "PRAGMA journal_mode=PERSIST", NULL, NULL, NULL);
+    }
     
     // Go into transactional mode where we only commit every 10 seconds
     sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
@@ -169,6 +226,13 @@ bool kis_database_logfile::open_log(std::string in_path) {
 
                     sqlite3_exec(db, pkt_delete.c_str(), NULL, NULL, NULL);
 
+                    sqlite3_exec(db, "DELETE FROM device_deltas WHERE devkey NOT IN "
+                            "(SELECT devkey FROM devices)", NULL, NULL, NULL);
+
+                    // Force new snapshots of any devices which come back
+                    kis_lock_guard<kis_mutex> lk(device_delta_mutex, "kismetdb device timeout");
+                    device_delta_map.clear();
+
                     return 1;
                     });
     } else {
@@ -241,6 +305,12 @@ bool kis_database_logfile::open_log(std::string in_path) {
     log_data_packets =
         Globalreg::globalreg->kismet_config->fetch_opt_bool("kis_log_data_packets", true);
 
+    log_device_deltas =
+        Globalreg::globalreg->kismet_config->fetch_opt_bool("kis_log_device_deltas", false);
+
+    device_delta_compact =
+        Globalreg::globalreg->kismet_config->fetch_opt_uint("kis_log_device_delta_compact", 20);
+
     auto httpd = Globalreg::fetch_mandatory_global_as<kis_net_beast_httpd>();
 
     httpd->register_route("/logging/kismetdb/pcap/drop", {"POST"}, httpd->LOGON_ROLE, {"cmd"},
@@ -390,6 +460,22 @@ bool kis_database_logfile::open_log(std::string in_path) {
                 handle_alert(al);
                 });
 
+    if (log_device_deltas) {
+        remove_device_evt_id =
+            eventbus->register_listener(device_tracker::event_remove_device(),
+                    [this](std::shared_ptr<eventbus_event> evt) {
+
+                    auto dev_k = evt->get_event_content()->find(device_tracker::event_remove_device());
+                    if (dev_k == evt->get_event_content()->end())
+                        return;
+
+                    auto d = std::static_pointer_cast<kis_tracked_device_base>(dev_k->second);
+
+                    kis_lock_guard<kis_mutex> lk(device_delta_mutex, "kismetdb remove device");
+                    device_delta_map.erase(d->get_key());
+                    });
+    }
+
     // Post that we've got the logfile ready
     auto evt = eventbus->get_eventbus_event(event_log_open());
     eventbus->publish(evt);
@@ -440,6 +526,7 @@ void kis_database_logfile::close_log() {
     // Kill the eventbus subs
     eventbus->remove_listener(message_evt_id);
     eventbus->remove_listener(alert_evt_id);
+    eventbus->remove_listener(remove_device_evt_id);
 
     // Kill the hooks
     auto packetchain =
@@ -451,9 +538,22 @@ void kis_database_logfile::close_log() {
     set_int_log_open(false);
     db_enabled = false;
 
+    {
+        std::lock_guard<std::mutex> lk(checkpoint_mutex);
+        checkpoint_shutdown = true;
+    }
+    checkpoint_cv.notify_all();
+
+    if (checkpoint_t.joinable())
+        checkpoint_t.join();
+
     // End the transaction
     sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
 
+    // Fold the WAL back into the log so it is a single file again
+    if (wal_mode)
+        sqlite3_exec(db, "PRAGMA wal_checkpoint(TRUNCATE)", NULL, NULL, NULL);
+
     sqlite3_exec(db, "PRAGMA journal_mode=DELETE", NULL, NULL, NULL);
     sqlite3_exec(db, "BEGIN_EXCLUSIVE", NULL, NULL, NULL);
     sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
@@ -510,6 +610,44 @@ int kis_database_logfile::database_upgrade_db() {
         return -1;
     }
 
+    sql =
+        "CREATE TABLE device_deltas ("
+
+        "id INTEGER PRIMARY KEY, " // Delta order, preserved across vacuum
+
+        "ts_sec INT, " // Time logged
+
+        "devkey TEXT, " // Device key
+
+        "phyname TEXT, " // Phy records
+        "devmac TEXT, "
+
+        "delta BLOB" // Changed device fields
+        ")";
+
+    r = sqlite3_exec(db, sql.c_str(),
+            [] (void *, int, char **, char **) -> int { return 0; }, NULL, &sErrMsg);
+
+    if (r != SQLITE_OK) {
+        _MSG("Kismet log was unable to create device_deltas table in " + ds_dbfile + ": " +
+                std::string(sErrMsg), MSGFLAG_ERROR);
+        close_log();
+        return -1;
+    }
+
+    sql = 
+        "CREATE INDEX device_deltas_devkey ON device_deltas (devkey)";
+
+    r = sqlite3_exec(db, sql.c_str(),
+            [] (void *, int, char **, char **) -> int { return 0; }, NULL, &sErrMsg);
+
+    if (r != SQLITE_OK) {
+        _MSG("Kismet log was unable to create device_deltas index in " + ds_dbfile + ": " +
+                std::string(sErrMsg), MSGFLAG_ERROR);
+        close_log();
+        return -1;
+    }
+
     sql =
         "CREATE TABLE packets ("
 
@@ -775,26 +913,12 @@ int kis_database_logfile::log_device(std::shared_ptr<kis_tracked_device_base> d)
     if (!db_enabled)
         return 0;
 
-    std::string sql;
-
-    std::string phystring;
-    std::string macstring;
-    std::string typestring;
-    std::string keystring;
-
     if (d == nullptr)
         return 0;
 
     if (device_mac_filter->filter(d->get_macaddr(), d->get_phyid()))
         return 0;
 
-    phystring = d->get_phyname();
-    macstring = d->get_macaddr().mac_to_string();
-    typestring = d->get_type_string();
-    keystring = d->get_key().as_string();
-
-    int spos = 1;
-
     std::stringstream sstr;
 
     // We don't have to lock because we're called by a device worker, which locks
@@ -811,14 +935,225 @@ int kis_database_logfile::log_device(std::shared_ptr<kis_tracked_device_base> d)
     }
 #endif
 
-    int r = Globalreg::globalreg->entrytracker->serialize("json", sstr, d, nullptr);
+    int r;
+
+    if (!log_device_deltas) {
+        r = Globalreg::globalreg->entrytracker->serialize("json", sstr, d, nullptr);
 
-    if (r < 0) {
-        _MSG_ERROR("Failure serializing device key {} to the kisdatabaselog", d->get_key());
-        return 0;
+        if (r < 0) {
+            _MSG_ERROR("Failure serializing device key {} to the kisdatabaselog", d->get_key());
+            return 0;
+        }
+
+        return log_device_snapshot(d, sstr.str());
+    }
+
+    kis_lock_guard<kis_mutex> lk(device_delta_mutex, "kismetdb log_device");
+
+    auto state_k = device_delta_map.find(d->get_key());
+    bool have_state = state_k != device_delta_map.end() &&
+        state_k->second.num_deltas < device_delta_compact;
+
+    const auto lookup_hash = 
+        [&state_k](uint64_t path_hash, uint64_t content_hash, unsigned int& matched) -> bool {
+            const auto& fh = state_k->second.field_hashes;
+
+            auto p = std::lower_bound(fh.begin(), fh.end(), std::make_pair(path_hash, (uint64_t) 0));
+
+            if (p == fh.end() || p->first != path_hash)
+                return false;
+
+            matched++;
+
+            return p->second == content_hash;
+        };
+
+    // Serialize a single field
+    const auto pack_field = [&sstr](shared_tracker_element e) -> std::string {
+        sstr.str("");
+        sstr.clear();
+        json_adapter::pack(sstr, e);
+        return sstr.str();
+    };
+
+    // Fields which serialize as JSON objects have each of their own fields hashed
+    const auto field_object = [](shared_tracker_element e) -> std::shared_ptr<tracker_element_map> {
+        if (e->get_type() == tracker_type::tracker_alias)
+            e = static_cast<tracker_element_alias *>(e.get())->get();
+
+        if (e == nullptr || e->get_type() != tracker_type::tracker_map)
+            return nullptr;
+
+        auto m = std::static_pointer_cast<tracker_element_map>(e);
+
+        if (m->as_vector() || m->as_key_vector())
+            return nullptr;
+
+        return m;
+    };
+
+    const auto append_field = [](std::string& obj, const std::string& name, const std::string& content) {
+        if (obj.length() > 0)
+            obj += ",";
+        obj += "\"";
+        obj += name;
+        obj += "\": ";
+        obj += content;
+    };
+
+    // Build the device JSON a field at a time, hashing each top-level field and the fields
+    // of any top-level objects as they're written, instead of parsing the serialized device
+    // back to find them
+    std::vector<std::pair<uint64_t, uint64_t>> field_hashes;
+    std::string device_fields, replace_fields, merge_fields;
+    unsigned int matched = 0;
+
+    // Object fields get a fixed content hash so we notice when they change type
+    const uint64_t object_hash = 0;
+
+    {
+        serializer_scope scope(d, nullptr);
+
+        for (const auto& i : *d) {
+            if (i.second == nullptr)
+                continue;
+
+            auto k = json_adapter::sanitize_string(json_adapter::field_name(i.first, i.second));
+            auto k_hash = XXH64(k.data(), k.length(), 0);
+
+            auto obj = field_object(i.second);
+
+            if (obj == nullptr) {
+                auto content = pack_field(i.second);
+                auto content_hash = XXH64(content.data(), content.length(), 0);
+
+                field_hashes.emplace_back(k_hash, content_hash);
+
+                if (have_state && !lookup_hash(k_hash, content_hash, matched))
+                    append_field(replace_fields, k, content);
+
+                append_field(device_fields, k, content);
+
+                continue;
+            }
+
+            serializer_scope obj_scope(obj, nullptr);
+
+            bool changed_type = false;
+
+            field_hashes.emplace_back(k_hash, object_hash);
+
+            if (have_state && !lookup_hash(k_hash, object_hash, matched))
+                changed_type = true;
+
+            std::string obj_fields, obj_merge;
+
+            for (const auto& si : *obj) {
+                if (si.second == nullptr)
+                    continue;
+
+                auto sk = json_adapter::sanitize_string(json_adapter::field_name(si.first, si.second));
+                auto sk_hash = XXH64(sk.data(), sk.length(), k_hash);
+                auto content = pack_field(si.second);
+                auto content_hash = XXH64(content.data(), content.length(), 0);
+
+                field_hashes.emplace_back(sk_hash, content_hash);
+
+                if (have_state && !lookup_hash(sk_hash, content_hash, matched) && !changed_type)
+                    append_field(obj_merge, sk, content);
+
+                append_field(obj_fields, sk, content);
+            }
+
+            auto obj_content = "{" + obj_fields + "}";
+
+            if (changed_type)
+                append_field(replace_fields, k, obj_content);
+
+            if (obj_merge.length() > 0)
+                append_field(merge_fields, k, "{" + obj_merge + "}");
+
+            append_field(device_fields, k, obj_content);
+        }
     }
 
-    std::string streamstring = sstr.str();
+    auto streamstring = "{" + device_fields + "}";
+
+    std::sort(field_hashes.begin(), field_hashes.end());
+
+    // Fields which went away can't be expressed as a delta, and deltas which are 
+    // nearly as large as the device aren't worth keeping; write a new snapshot instead.
+    if (have_state && matched == state_k->second.field_hashes.size()) {
+        if (replace_fields.length() == 0 && merge_fields.length() == 0)
+            return 1;
+
+        auto deltastring = "{\"replace\": {" + replace_fields + "}, \"merge\": {" + merge_fields + "}}";
+
+        if (deltastring.length() * 2 < streamstring.length()) {
+            r = log_device_delta(d, deltastring);
+
+            if (r < 0)
+                return r;
+
+            if (r > 0) {
+                state_k->second.field_hashes = std::move(field_hashes);
+                state_k->second.num_deltas++;
+                return 1;
+            }
+        }
+    }
+
+    r = log_device_snapshot(d, streamstring);
+
+    if (r < 0)
+        return r;
+
+    auto& state = device_delta_map[d->get_key()];
+    state.field_hashes = std::move(field_hashes);
+    state.num_deltas = 0;
+
+    return r;
+}
+
+void kis_database_logfile::bind_device_location(sqlite3_stmt *stmt, int& spos,
+        std::shared_ptr<kis_tracked_device_base> d) {
+    if (d->has_location() && (d->get_location()->has_min_loc() &&
+                              d->get_location()->has_max_loc() &&
+                              d->get_location()->has_avg_loc())) {
+        sqlite3_bind_double(stmt, spos++, 
+                            d->get_location()->get_min_loc()->get_lat());
+        sqlite3_bind_double(stmt, spos++,
+                            d->get_location()->get_min_loc()->get_lon());
+        sqlite3_bind_double(stmt, spos++,
+                            d->get_location()->get_max_loc()->get_lat());
+        sqlite3_bind_double(stmt, spos++,
+                            d->get_location()->get_max_loc()->get_lon());
+        sqlite3_bind_double(stmt, spos++,
+                            d->get_location()->get_avg_loc()->get_lat());
+        sqlite3_bind_double(stmt, spos++,
+                            d->get_location()->get_avg_loc()->get_lon());
+    } else {
+        // Empty location
+        sqlite3_bind_double(stmt, spos++, 0);
+        sqlite3_bind_double(stmt, spos++, 0);
+        sqlite3_bind_double(stmt, spos++, 0);
+        sqlite3_bind_double(stmt, spos++, 0);
+        sqlite3_bind_double(stmt, spos++, 0);
+        sqlite3_bind_double(stmt, spos++, 0);
+    }
+}
+
+int kis_database_logfile::log_device_snapshot(std::shared_ptr<kis_tracked_device_base> d,
+        const std::string& streamstring) {
+    std::string sql;
+
+    std::string phystring = d->get_phyname();
+    std::string macstring = d->get_macaddr().mac_to_string();
+    std::string typestring = d->get_type_string();
+    std::string keystring = d->get_key().as_string();
+
+    int spos = 1;
+    int r;
 
     sqlite3_stmt *device_stmt;
     const char *device_pz;
@@ -850,30 +1185,7 @@ int kis_database_logfile::log_device(std::shared_ptr<kis_tracked_device_base> d)
             macstring.length(), SQLITE_TRANSIENT);
     sqlite3_bind_int(device_stmt, spos++, d->get_signal_data()->get_max_signal());
 
-    if (d->has_location() && (d->get_location()->has_min_loc() &&
-                              d->get_location()->has_max_loc() &&
-                              d->get_location()->has_avg_loc())) {
-        sqlite3_bind_double(device_stmt, spos++, 
-                            d->get_location()->get_min_loc()->get_lat());
-        sqlite3_bind_double(device_stmt, spos++,
-                            d->get_location()->get_min_loc()->get_lon());
-        sqlite3_bind_double(device_stmt, spos++,
-                            d->get_location()->get_max_loc()->get_lat());
-        sqlite3_bind_double(device_stmt, spos++,
-                            d->get_location()->get_max_loc()->get_lon());
-        sqlite3_bind_double(device_stmt, spos++,
-                            d->get_location()->get_avg_loc()->get_lat());
-        sqlite3_bind_double(device_stmt, spos++,
-                            d->get_location()->get_avg_loc()->get_lon());
-    } else {
-        // Empty location
-        sqlite3_bind_double(device_stmt, spos++, 0);
-        sqlite3_bind_double(device_stmt, spos++, 0);
-        sqlite3_bind_double(device_stmt, spos++, 0);
-        sqlite3_bind_double(device_stmt, spos++, 0);
-        sqlite3_bind_double(device_stmt, spos++, 0);
-        sqlite3_bind_double(device_stmt, spos++, 0);
-    }
+    bind_device_location(device_stmt, spos, d);
 
     sqlite3_bind_int64(device_stmt, spos++, d->get_datasize());
     sqlite3_bind_text(device_stmt, spos++, typestring.c_str(), 
@@ -896,6 +1208,132 @@ int kis_database_logfile::log_device(std::shared_ptr<kis_tracked_device_base> d)
 
     sqlite3_finalize(device_stmt);
 
+    if (!log_device_deltas)
+        return 1;
+
+    // The new snapshot supersedes any deltas
+    sql = 
+        "DELETE FROM device_deltas WHERE devkey = ?";
+
+    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &device_stmt, &device_pz);
+
+    if (r != SQLITE_OK) {
+        _MSG("kis_database_logfile unable to prepare database delete for device deltas in " +
+                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+        close_log();
+        return -1;
+    }
+
+    sqlite3_bind_text(device_stmt, 1, keystring.c_str(), 
+            keystring.length(), SQLITE_TRANSIENT);
+
+    if (sqlite3_step(device_stmt) != SQLITE_DONE) {
+        _MSG("kis_database_logfile unable to delete device deltas in " +
+                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+        close_log();
+        return -1;
+    }
+
+    sqlite3_finalize(device_stmt);
+
+    return 1;
+}
+
+int kis_database_logfile::log_device_delta(std::shared_ptr<kis_tracked_device_base> d,
+        const std::string& deltastring) {
+    std::string sql;
+
+    std::string phystring = d->get_phyname();
+    std::string macstring = d->get_macaddr().mac_to_string();
+    std::string typestring = d->get_type_string();
+    std::string keystring = d->get_key().as_string();
+
+    int spos = 1;
+    int r;
+
+    sqlite3_stmt *device_stmt;
+    const char *device_pz;
+
+    // Update the summary fields of the snapshot record so that queries against the
+    // devices table stay current
+    sql =
+        "UPDATE devices SET "
+        "last_time = ?, strongest_signal = ?, "
+        "min_lat = ?, min_lon = ?, max_lat = ?, max_lon = ?, "
+        "avg_lat = ?, avg_lon = ?, "
+        "bytes_data = ?, type = ? "
+        "WHERE phyname = ? AND devmac = ?";
+
+    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &device_stmt, &device_pz);
+
+    if (r != SQLITE_OK) {
+        _MSG("kis_database_logfile unable to prepare database update for devices in " +
+                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+        close_log();
+        return -1;
+    }
+
+    sqlite3_bind_int64(device_stmt, spos++, d->get_last_time());
+    sqlite3_bind_int(device_stmt, spos++, d->get_signal_data()->get_max_signal());
+
+    bind_device_location(device_stmt, spos, d);
+
+    sqlite3_bind_int64(device_stmt, spos++, d->get_datasize());
+    sqlite3_bind_text(device_stmt, spos++, typestring.c_str(), 
+            typestring.length(), SQLITE_TRANSIENT);
+    sqlite3_bind_text(device_stmt, spos++, phystring.c_str(), 
+            phystring.length(), SQLITE_TRANSIENT);
+    sqlite3_bind_text(device_stmt, spos++, macstring.c_str(), 
+            macstring.length(), SQLITE_TRANSIENT);
+
+    if (sqlite3_step(device_stmt) != SQLITE_DONE) {
+        _MSG("kis_database_logfile unable to update device in " +
+                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+        close_log();
+        return -1;
+    }
+
+    sqlite3_finalize(device_stmt);
+
+    // No snapshot to apply the delta to (timed out of the log, etc)
+    if (sqlite3_changes(db) == 0)
+        return 0;
+
+    sql =
+        "INSERT INTO device_deltas "
+        "(ts_sec, devkey, phyname, devmac, delta) "
+        "VALUES (?, ?, ?, ?, ?)";
+
+    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &device_stmt, &device_pz);
+
+    if (r != SQLITE_OK) {
+        _MSG("kis_database_logfile unable to prepare database insert for device deltas in " +
+                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+        close_log();
+        return -1;
+    }
+
+    spos = 1;
+
+    sqlite3_bind_int64(device_stmt, spos++, Globalreg::globalreg->last_tv_sec);
+    sqlite3_bind_text(device_stmt, spos++, keystring.c_str(), 
+            keystring.length(), SQLITE_TRANSIENT);
+    sqlite3_bind_text(device_stmt, spos++, phystring.c_str(), 
+            phystring.length(), SQLITE_TRANSIENT);
+    sqlite3_bind_text(device_stmt, spos++, macstring.c_str(), 
+            macstring.length(), SQLITE_TRANSIENT);
+    sqlite3_bind_blob(device_stmt, spos++, deltastring.c_str(), 
+            deltastring.length(), SQLITE_TRANSIENT);
+
+    if (sqlite3_step(device_stmt) != SQLITE_DONE) {
+        _MSG("kis_database_logfile unable to insert device delta in " +
+                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+        close_log();
+        return -1;
+    }
+
+    sqlite3_finalize(device_stmt);
+
     return 1;
 }
 
@@ -1391,6 +1829,69 @@ int kis_database_logfile::log_snapshot(std::shared_ptr<kis_gps_packinfo> gps, st
 }
 
 
+void kis_database_logfile::checkpoint_thread() {
+    thread_set_process_name("KISMETDB-WAL");
+
+    // Checkpoint from a dedicated connection so that syncing the WAL into the log
+    // never holds up the logging connection
+    sqlite3 *ckpt_db = nullptr;
+
+    auto r = sqlite3_open_v2(ds_dbfile.c_str(), &ckpt_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, NULL);
+
+    if (r != SQLITE_OK) {
+        _MSG_ERROR("Kismetdb log unable to open checkpoint connection to {}: {}, WAL "
+                "checkpoints will only happen when the log is closed.", ds_dbfile,
+                ckpt_db != nullptr ? sqlite3_errmsg(ckpt_db) : "unknown error");
+        sqlite3_close(ckpt_db);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lk(checkpoint_mutex);
+
+    while (!checkpoint_shutdown) {
+        checkpoint_cv.wait_for(lk, std::chrono::seconds(wal_checkpoint_sec > 0 ? wal_checkpoint_sec : 30),
+                [this]() { return checkpoint_shutdown; });
+
+        if (checkpoint_shutdown)
+            break;
+
+        lk.unlock();
+
+        // Passive checkpoints never wait on readers or the writer; anything still in
+        // use is picked up by the next pass
+        r = sqlite3_wal_checkpoint_v2(ckpt_db, NULL, SQLITE_CHECKPOINT_PASSIVE, NULL, NULL);
+
+        if (r != SQLITE_OK && r != SQLITE_BUSY)
+            _MSG_ERROR("Kismetdb log WAL checkpoint failed: {}", sqlite3_errmsg(ckpt_db));
+
+        lk.lock();
+    }
+
+    sqlite3_close(ckpt_db);
+}
+
+std::shared_ptr<sqlite3> kis_database_logfile::open_reader() {
+    if (!wal_mode)
+        return std::shared_ptr<sqlite3>(db, [](sqlite3 *) { });
+
+    sqlite3 *reader_db = nullptr;
+
+    auto r = sqlite3_open_v2(ds_dbfile.c_str(), &reader_db, 
+            SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+
+    if (r != SQLITE_OK) {
+        _MSG_ERROR("Kismetdb log unable to open reader connection to {}: {}",
+                ds_dbfile, reader_db != nullptr ? sqlite3_errmsg(reader_db) : "unknown error");
+        sqlite3_close(reader_db);
+        return std::shared_ptr<sqlite3>(db, [](sqlite3 *) { });
+    }
+
+    sqlite3_busy_timeout(reader_db, 5000);
+
+    // close_v2 defers the close until any outstanding statements are finalized
+    return std::shared_ptr<sqlite3>(reader_db, [](sqlite3 *d) { sqlite3_close_v2(d); });
+}
+
 void kis_database_logfile::usage(const char *argv0) {
 
 }
@@ -1399,7 +1900,11 @@ void kis_database_logfile::usage(const char *argv0) {
 void kis_database_logfile::pcapng_endp_handler(std::shared_ptr<kis_net_beast_httpd_connection> con) {
 	using namespace kissqlite3;
 
-	auto query = _SELECT(db, "packets", {"ts_sec", "ts_usec", "datasource", "dlt", "packet"});
+	// Exports can take a long time; in WAL mode they run on their own connection and
+	// only see committed data, without blocking the logging connection
+	auto reader_db = open_reader();
+
+	auto query = _SELECT(reader_db.get(), "packets", {"ts_sec", "ts_usec", "datasource", "dlt", "packet"});
 
 	auto ts_start_k = con->http_variables().find("timestamp_start");
 	if (ts_start_k != con->http_variables().end()) 
@@ -1503,7 +2008,7 @@ void kis_database_logfile::pcapng_endp_handler(std::shared_ptr<kis_net_beast_htt
 
 	// Get the list of all the interfaces we know about in the database and push them into the
 	// pcapng handler
-	auto datasource_query = _SELECT(db, "datasources", {"uuid", "name", "interface"});
+	auto datasource_query = _SELECT(reader_db.get(), "datasources", {"uuid", "name", "interface"});
 
 	for (auto ds : datasource_query)  {
 		pcapng->add_database_interface(sqlite3_column_as<std::string>(ds, 0),
@@ -1524,6 +2029,8 @@ void kis_database_logfile::pcapng_endp_handler(std::shared_ptr<kis_net_beast_htt
 		}
 	}
 
+	pcapng->flush();
+
 	streamtracker->remove_streamer(sid);
 }
 
@@ -1585,6 +2092,7 @@ pcapng_stream_database::pcapng_stream_database(future_chainbuf& buffer) :
 }
 
 pcapng_stream_database::~pcapng_stream_database() {
+    flush();
     chainbuf.cancel();
 }
 
@@ -38,8 +38,11 @@
 #include "config.h"
 
 #include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "globalregistry.h"
 #include "kis_mutex.h"
@@ -53,10 +56,11 @@
 #include "class_filter.h"
 #include "packet_filter.h"
 #include "messagebus.h"
+#include "unordered_dense.h"
 
 // Kismetdb version
 
-#define KISMETDB_LOG_VERSION        8
+#define KISMETDB_LOG_VERSION        9
 
 // This is a bit of a unique case - because so many things plug into this, it has
 // to exist as a global record; we build it like we do any other global record;
@@ -97,7 +101,9 @@ public:
         return db_enabled;
     }
 
-    // Log a vector of multiple devices, replacing any old device records
+    // Log a device; depending on the configuration this either replaces the old device
+    // record, or records a delta of the fields which changed since the last time the 
+    // device was logged
     virtual int log_device(std::shared_ptr<kis_tracked_device_base> in_device);
 
     // Device logs are non-streaming; we need to know the last time we generated
@@ -154,6 +160,38 @@ protected:
 
     std::atomic<time_t> last_device_log;
 
+    // Incremental device logging.  The first time a device is logged it is written as
+    // a complete snapshot to the devices table; after that, only the fields which have
+    // changed are written to the device_deltas table, and the summary columns of the 
+    // devices record are updated in place.  Once enough deltas accumulate, or a field
+    // is removed from the device, a new snapshot is written and the deltas are dropped.
+    //
+    // Deltas are JSON objects of the form:
+    //   { "replace": { "top.level.field": value, ... },
+    //     "merge": { "top.level.object": { "sub.field": value, ... }, ... } }
+    // and are applied to the snapshot in id order; 'replace' fields overwrite the 
+    // top-level field, 'merge' fields overwrite individual fields of a top-level object.
+    struct device_delta_state {
+        // Sorted list of (field path hash, field content hash) from the last time 
+        // this device was logged
+        std::vector<std::pair<uint64_t, uint64_t>> field_hashes;
+        unsigned int num_deltas;
+    };
+
+    bool log_device_deltas;
+    unsigned int device_delta_compact;
+    kis_mutex device_delta_mutex;
+    ankerl::unordered_dense::map<device_key, device_delta_state> device_delta_map;
+
+    // Write a complete device snapshot and discard any deltas
+    int log_device_snapshot(std::shared_ptr<kis_tracked_device_base> d, const std::string& json);
+    // Write a device delta and update the device summary; returns 0 if there is no
+    // snapshot record to update
+    int log_device_delta(std::shared_ptr<kis_tracked_device_base> d, const std::string& json);
+
+    void bind_device_location(sqlite3_stmt *stmt, int& spos, 
+            std::shared_ptr<kis_tracked_device_base> d);
+
     std::atomic<bool> in_transaction_sync;
 
     // Nasty define hack for checking if we're blocked on a really slow
@@ -181,6 +219,24 @@ protected:
     kis_mutex transaction_mutex;
     int transaction_timer;
 
+    // WAL mode; the log is written through a write-ahead log with relaxed syncing, 
+    // REST readers use their own read-only connections so they never contend with the
+    // logging connection, and the WAL is checkpointed on a background thread
+    bool wal_mode;
+    unsigned int wal_checkpoint_sec;
+
+    std::thread checkpoint_t;
+    std::mutex checkpoint_mutex;
+    std::condition_variable checkpoint_cv;
+    bool checkpoint_shutdown;
+
+    void checkpoint_thread();
+
+    // Open a read-only connection to the log for a REST reader; falls back to the
+    // logging connection when not in WAL mode.  The returned connection must outlive 
+    // any queries made against it.
+    std::shared_ptr<sqlite3> open_reader();
+
     // Packet time limit
     unsigned int packet_timeout;
     int packet_timeout_timer;
@@ -225,6 +281,9 @@ protected:
     void handle_alert(std::shared_ptr<tracked_alert> msg);
     unsigned long alert_evt_id;
 
+    // Drop the delta state of devices the tracker has forgotten
+    unsigned long remove_device_evt_id;
+
     bool log_duplicate_packets;
     bool log_data_packets;
 };
@@ -27,6 +27,7 @@
 #include "alertracker.h"
 
 #include "kis_dissector_ipdata.h"
+#include "kis_string_scan.h"
 #include "phy_80211_packetsignatures.h"
 
 int get_length_tag_offsets(unsigned int init_offset, 
@@ -118,106 +119,6 @@ kis_dissector_ip_data::~kis_dissector_ip_data() {
         packetchain->remove_handler(&ipdata_packethook, CHAINPOS_DATADISSECT);
 }
 
-#define MDNS_PTR_MASK		0xC0
-#define MDNS_PTR_ADDRESS	0x3FFF
-
-// Fetch a name; if it's a pointer, follow that reference and get the value
-// Cache offsets we've looked at in the map so we don't follow them repeatedly
-// Bytelen indicates how many bytes to advance the stream; negative indicates
-// error
-std::string MDNS_Fetchname(std::shared_ptr<kis_datachunk> chunk, unsigned int baseofft, 
-					  unsigned int startofft, std::map<unsigned int, std::string> *name_cache,
-					  int *bytelen) {
-	// If we're fed a bad offset just throw it back
-	if (startofft > chunk->length()) {
-		*bytelen = -1;
-		return "";
-	}
-
-	std::string dns_str;
-
-	unsigned int offt = startofft;
-
-	while (offt < chunk->length()) {
-		// Find a starting at this position
-		uint8_t len = chunk->data()[offt];
-
-		// If we hit a 0x00 we're at the end of the string
-		if (len == 0) {
-			offt += 1;
-			break;
-		}
-
-		// Pointer to another value
-		if ((len & MDNS_PTR_MASK) == MDNS_PTR_MASK) {
-			// Catch wonky records
-			if (offt + 1 >= chunk->length()) {
-				*bytelen = -1;
-				return dns_str;
-			}
-
-			// Derive the new start address
-			uint16_t ptr = 
-				kis_ntoh16(kis_extract16(&(chunk->data()[offt])));
-
-			ptr &= MDNS_PTR_ADDRESS;
-
-			// Get the cached value if we can, instead of following the pointer
-			std::map<unsigned int, std::string>::iterator nci = name_cache->find(ptr);
-			if (nci != name_cache->end()) {
-				if (dns_str == "")
-					dns_str = nci->second;
-				else
-					dns_str += "." + nci->second;
-			} else {
-				// Set our current location in the map to empty so we won't loop 
-				// on a malicious packet with self-referencing compression
-				// pointers
-				(*name_cache)[offt - baseofft] = "";
-
-				int junklen;
-				std::string ret = MDNS_Fetchname(chunk, baseofft, baseofft + ptr, name_cache, 
-											&junklen);
-
-				(*name_cache)[offt - baseofft] = ret;
-
-				if (dns_str == "")
-					dns_str = ret;
-				else
-					dns_str += "." + ret;
-
-				// All address pointers are len2 in the buffer
-				offt += 2;
-			}
-
-			// Pointer record indicates end of string
-			break;
-		}
-
-		// Skip the length byte
-		offt += 1;
-
-		if (offt + len >= chunk->length()) {
-			*bytelen = -1;
-			return dns_str;
-		}
-
-		std::string ret = 
-			munge_to_printable(std::string((char *) &(chunk->data()[offt]), len));
-
-		offt += len;
-
-		if (dns_str == "")
-			dns_str = ret;
-		else
-			dns_str += "." + ret;
-	}
-
-	*bytelen = (offt - startofft);
-
-	return dns_str;
-}
-
 int kis_dissector_ip_data::handle_packet(std::shared_ptr<kis_packet> in_pack) {
     std::shared_ptr<kis_data_packinfo> datainfo;
 	uint32_t addr;
@@ -275,8 +176,7 @@ int kis_dissector_ip_data::handle_packet(std::shared_ptr<kis_packet> in_pack) {
 					return 0;
 				}
 
-				datainfo->cdp_dev_id = 
-					munge_to_printable(std::string((char *) &(chunk->data()[offset + 4]), elemlen - 4));
+				datainfo->cdp_dev_id = munge_view_to_printable(chunk->substr(offset + 4, elemlen - 4));
 				gotinfo = 1;
 			} else if (elemtype == 0x03) {
 				if (elemlen < 4) {
@@ -284,8 +184,7 @@ int kis_dissector_ip_data::handle_packet(std::shared_ptr<kis_packet> in_pack) {
 					return 0;
 				}
 
-				datainfo->cdp_port_id = 
-					munge_to_printable(std::string((char *) &(chunk->data()[offset + 4]), elemlen - 4));
+				datainfo->cdp_port_id = munge_view_to_printable(chunk->substr(offset + 4, elemlen - 4));
 				gotinfo = 1;
 			}
 
@@ -508,20 +407,16 @@ int kis_dissector_ip_data::handle_packet(std::shared_ptr<kis_packet> in_pack) {
 					dhcp_tag_map[12].size() != 0) {
 
 					datainfo->discover_host = 
-						std::string((char *) &(chunk->data()[dhcp_tag_map[12][0] + 1]), 
-							   chunk->data()[dhcp_tag_map[12][0]]);
-
-					datainfo->discover_host = munge_to_printable(datainfo->discover_host);
+						munge_view_to_printable(chunk->substr(dhcp_tag_map[12][0] + 1,
+									(uint8_t) chunk->data()[dhcp_tag_map[12][0]]));
 				}
 
 				if (dhcp_tag_map.find(60) != dhcp_tag_map.end() &&
 					dhcp_tag_map[60].size() != 0) {
 
 					datainfo->discover_vendor = 
-						std::string((char *) &(chunk->data()[dhcp_tag_map[60][0] + 1]), 
-							   chunk->data()[dhcp_tag_map[60][0]]);
-					datainfo->discover_vendor = 
-						munge_to_printable(datainfo->discover_vendor);
+						munge_view_to_printable(chunk->substr(dhcp_tag_map[60][0] + 1,
+									(uint8_t) chunk->data()[dhcp_tag_map[60][0]]));
 				}
 
 				if (dhcp_tag_map.find(61) != dhcp_tag_map.end() &&
@@ -549,15 +444,14 @@ int kis_dissector_ip_data::handle_packet(std::shared_ptr<kis_packet> in_pack) {
 			uint16_t mdns_flags;
 			uint16_t answer_rr = 0, auth_rr = 0, additional_rr = 0;
 
-			// mdns name
-			std::string mdns_name;
-			std::string mdns_ptr;
-
 			// Skip UDP headers
 			unsigned int mdns_start = UDP_OFFSET + 8;
 			unsigned int offt = UDP_OFFSET + 8;
 
-			std::map<unsigned int, std::string> mdns_cache;
+			// Names are walked in place against the mdns message; compression
+			// pointers are relative to its start
+			auto mdns_msg = (const uint8_t *) chunk->data() + mdns_start;
+			size_t mdns_len = chunk->length() > mdns_start ? chunk->length() - mdns_start : 0;
 
 			// Skip transaction ID, we don't care
 			offt += 2;
@@ -598,17 +492,14 @@ int kis_dissector_ip_data::handle_packet(std::shared_ptr<kis_packet> in_pack) {
 
 			// printf("debug - mdns - looking at %u answers\n", answer_rr + auth_rr + additional_rr);
 			for (uint32_t a = 0; a < (uint32_t) (answer_rr + auth_rr + additional_rr); a++) {
-				int retbytes;
+				// We don't use the record name, only skip past it
+				size_t retbytes = dns_name_extract(mdns_msg, mdns_len, offt - mdns_start);
 
-				mdns_name = MDNS_Fetchname(chunk, mdns_start, offt, &mdns_cache, &retbytes);
-
-				if (retbytes <= 0)
+				if (retbytes == 0)
 					goto mdns_end;
 
 				offt += retbytes;
 
-				// printf("debug - mdns record name: %s\n", mdns_name.c_str());
-
 				if (offt + 2 >= chunk->length()) {
 					goto mdns_end;
 				}
@@ -646,16 +537,12 @@ int kis_dissector_ip_data::handle_packet(std::shared_ptr<kis_packet> in_pack) {
 					continue;
 				}
 
-				std::string mdns_rec;
+				retbytes = dns_name_extract(mdns_msg, mdns_len, offt - mdns_start);
 
-				mdns_rec = MDNS_Fetchname(chunk, mdns_start, offt, &mdns_cache, &retbytes);
-
-				if (retbytes <= 0)
+				if (retbytes == 0)
 					goto mdns_end;
 
 				offt += retbytes;
-
-				// printf("debug - mdns ptr %s\n", mdns_rec.c_str());
 			}
 
 mdns_end:
@@ -20,6 +20,7 @@
 
 #include "config.h"
 
+#include "crc32.h"
 #include "globalregistry.h"
 #include "util.h"
 #include "endian_magic.h"
@@ -287,10 +288,20 @@ int kis_dlt_ppi::handle_packet(std::shared_ptr<kis_packet> in_pack) {
         in_pack->insert(pack_comp_checksum, fcschunk);
     }
 
-    // We've put the FCS in the fcschunk, so we just call the datasource FCS function
     if (datasrc != NULL && datasrc->ref_source != NULL && fcschunk != NULL &&
             fcschunk->checksum_valid) {
-        datasrc->ref_source->checksum_packet(in_pack);
+        if (ppi_dlt == KDLT_IEEE802_11) {
+            // 802.11 uses the standard CRC32 FCS, so validate it locally the same
+            // way radiotap does, comparing both byte orders
+            uint32_t calc_crc = crc32_fast(decapchunk->data(), decapchunk->length());
+            uint32_t flipped_crc = kis_swap32(calc_crc);
+
+            if (memcmp(fcschunk->data(), &calc_crc, 4) && memcmp(fcschunk->data(), &flipped_crc, 4))
+                fcschunk->checksum_valid = 0;
+        } else {
+            // We've put the FCS in the fcschunk, so we just call the datasource FCS function
+            datasrc->ref_source->checksum_packet(in_pack);
+        }
     }
 
     return 1;
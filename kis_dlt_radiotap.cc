@@ -20,6 +20,7 @@
 
 #include "config.h"
 
+#include "crc32.h"
 #include "globalregistry.h"
 #include "util.h"
 #include "endian_magic.h"
@@ -72,8 +73,6 @@ kis_dlt_radiotap::kis_dlt_radiotap() :
 	dlt = DLT_IEEE802_11_RADIO;
 
 	_MSG("Registering support for DLT_RADIOTAP packet header decoding", MSGFLAG_INFO);
-
-    crc32_init_table_80211(crc32_table);
 }
 
 #define ALIGN_OFFSET(offset, width) \
@@ -455,7 +454,7 @@ int kis_dlt_radiotap::handle_packet(std::shared_ptr<kis_packet> in_pack) {
 
 		// Compare it and flag the packet
 		uint32_t calc_crc =
-			crc32_le_80211(crc32_table, decapchunk->data(), decapchunk->length());
+			crc32_fast(decapchunk->data(), decapchunk->length());
         uint32_t flipped_crc = kis_swap32(calc_crc);
 
         auto checksum_ptr = reinterpret_cast<const uint32_t *>(fcschunk->data());
@@ -485,47 +484,3 @@ int kis_dlt_radiotap::handle_packet(std::shared_ptr<kis_packet> in_pack) {
 #undef BITNO_2
 #undef BIT
 
-// Taken from the BBN USRP 802.11 encoding code
-unsigned int kis_dlt_radiotap::update_crc32_80211(unsigned int crc, const char *data,
-        int len, unsigned int poly) {
-	int i, j;
-	unsigned short ch;
-
-	for ( i = 0; i < len; ++i) {
-		ch = data[i];
-		for (j = 0; j < 8; ++j) {
-			if ((crc ^ ch) & 0x0001) {
-				crc = (crc >> 1) ^ poly;
-			} else {
-				crc = (crc >> 1);
-			}
-			ch >>= 1;
-		}
-	}
-	return crc;
-}
-
-void kis_dlt_radiotap::crc32_init_table_80211(unsigned int *crc32_table) {
-	int i;
-	char c;
-
-	for (i = 0; i < 256; ++i) {
-		c = i;
-		crc32_table[i] = update_crc32_80211(0, &c, 1, IEEE_802_3_CRC32_POLY);
-	}
-}
-
-unsigned int kis_dlt_radiotap::crc32_le_80211(unsigned int *crc32_table, 
-        const char *buf, int len) {
-	int i;
-	unsigned int crc = 0xFFFFFFFF;
-
-	for (i = 0; i < len; ++i) {
-		crc = (crc >> 8) ^ crc32_table[(crc ^ buf[i]) & 0xFF];
-	}
-
-	crc ^= 0xFFFFFFFF;
-
-	return crc;
-}
-
@@ -939,6 +939,9 @@ void kis_external_interface::handle_packet_http_register(uint32_t in_seqno,
                     // Unlock the external mutex prior to blocking
                     l.unlock();
 
+                    // Don't hold a handler thread while the helper answers
+                    con->release_handler();
+
                     // Block until we get a response
                     session->locker->block_until();
 
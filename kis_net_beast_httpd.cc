@@ -23,6 +23,8 @@
 #include <random>
 
 #include <stdio.h>
+#include <sys/stat.h>
+#include <zlib.h>
 
 #include "globalregistry.h"
 
@@ -36,6 +38,28 @@ const std::string kis_net_beast_httpd::LOGON_ROLE{"admin"};
 const std::string kis_net_beast_httpd::ANY_ROLE{"any"};
 const std::string kis_net_beast_httpd::RO_ROLE{"readonly"};
 
+const uint64_t kis_net_beast_httpd::LOGON_ROLE_BIT{1ULL << 0};
+const uint64_t kis_net_beast_httpd::OVERFLOW_ROLE_BIT{1ULL << 63};
+
+uint64_t kis_net_beast_httpd::role_bit(const std::string& role) {
+    static kis_mutex role_mutex;
+    static std::unordered_map<std::string, uint64_t> role_bits{{LOGON_ROLE, LOGON_ROLE_BIT}};
+
+    kis_lock_guard<kis_mutex> lk(role_mutex, "beast_httpd role_bit");
+
+    auto r = role_bits.find(role);
+    if (r != role_bits.end())
+        return r->second;
+
+    auto bit = OVERFLOW_ROLE_BIT;
+    if (role_bits.size() < 63)
+        bit = 1ULL << role_bits.size();
+
+    role_bits[role] = bit;
+
+    return bit;
+}
+
 const std::string kis_net_beast_httpd::AUTH_COOKIE{"KISMET"};
 
 std::shared_ptr<kis_net_beast_httpd> kis_net_beast_httpd::create_httpd() {
@@ -80,11 +104,18 @@ kis_net_beast_httpd::kis_net_beast_httpd(boost::asio::ip::tcp::endpoint& endpoin
     lifetime_global{},
     deferred_startup{},
     running{false},
+    static_cache_sz{0},
+    static_cache_max{0},
+    compress_level_{0},
+    websocket_queue_max_{0},
+    bulk_body_limit_{0},
     endpoint{endpoint},
     acceptor{Globalreg::globalreg->io} {
 
     route_mutex.set_name("kis_net_beast_httpd route vector");
     auth_mutex.set_name("kis_net_beast_httpd auth");
+    static_cache_mutex.set_name("kis_net_beast_httpd static cache");
+    websocket_mutex.set_name("kis_net_beast_httpd websockets");
 }
 
 void kis_net_beast_httpd::trigger_deferred_startup() {
@@ -130,6 +161,15 @@ void kis_net_beast_httpd::trigger_deferred_startup() {
         register_mime_type(comps[0], comps[1]);
     }
 
+    compress_level_ = 
+        std::min(9, Globalreg::globalreg->kismet_config->fetch_opt_as<int>("httpd_compress_level", 4));
+
+    websocket_queue_max_ =
+        Globalreg::globalreg->kismet_config->fetch_opt_as<size_t>("httpd_websocket_queue", 1024);
+
+    bulk_body_limit_ = 1024 * 1024 *
+        Globalreg::globalreg->kismet_config->fetch_opt_as<size_t>("httpd_bulk_body_mb", 64);
+
     allow_auth_creation = Globalreg::globalreg->kismet_config->fetch_opt_bool("httpd_allow_auth_creation", true);
     allow_auth_view = Globalreg::globalreg->kismet_config->fetch_opt_bool("httpd_allow_auth_view", true);
 
@@ -225,6 +265,18 @@ void kis_net_beast_httpd::trigger_deferred_startup() {
         serve_files = true;
         _MSG_INFO("Serving static file content from {}", http_data_dir);
 
+        static_cache_max = 1024 * 1024 *
+            Globalreg::globalreg->kismet_config->fetch_opt_as<size_t>("httpd_static_cache_mb", 32);
+
+        auto max_age = 
+            Globalreg::globalreg->kismet_config->fetch_opt_as<unsigned int>("httpd_static_max_age", 0);
+
+        // By default browsers revalidate every load, which costs a 304 when nothing changed
+        if (max_age == 0)
+            static_cache_control = "no-cache";
+        else
+            static_cache_control = fmt::format("max-age={}", max_age);
+
         register_static_dir("/", http_data_dir);
     }
 
@@ -381,6 +433,48 @@ void kis_net_beast_httpd::trigger_deferred_startup() {
 
                 }, auth_mutex));
 
+    register_route("/httpd/websockets", {"GET"}, LOGON_ROLE, {},
+            std::make_shared<kis_net_web_tracked_endpoint>(
+                [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
+
+                auto ret = std::make_shared<tracker_element_vector>();
+
+                for (const auto& w : websocket_list) {
+                    auto ws = w.lock();
+
+                    if (ws == nullptr)
+                        continue;
+
+                    // Another rare endpoint, so build it lazily
+                    auto wmap = std::make_shared<tracker_element_string_map>();
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.uri",
+                                std::make_shared<tracker_element_string>(ws->uri())));
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.remote",
+                                std::make_shared<tracker_element_string>(ws->remote())));
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.queue_max",
+                                std::make_shared<tracker_element_uint64>(ws->queue_max())));
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.queue_depth",
+                                std::make_shared<tracker_element_uint64>(ws->queue_depth())));
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.queue_bytes",
+                                std::make_shared<tracker_element_uint64>(ws->queue_bytes())));
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.lag_ms",
+                                std::make_shared<tracker_element_uint64>(ws->lag().count())));
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.queued",
+                                std::make_shared<tracker_element_uint64>(ws->queued())));
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.sent",
+                                std::make_shared<tracker_element_uint64>(ws->sent())));
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.dropped",
+                                std::make_shared<tracker_element_uint64>(ws->dropped())));
+                    wmap->insert(std::make_pair("kismet.httpd.websocket.coalesced",
+                                std::make_shared<tracker_element_uint64>(ws->coalesced())));
+
+                    ret->push_back(wmap);
+                }
+
+                return ret;
+
+                }, websocket_mutex));
+
 
     // Test echo websocket
     register_websocket_route("/debug/echo", LOGON_ROLE, {"ws"},
@@ -446,6 +540,15 @@ int kis_net_beast_httpd::start_httpd() {
 
     _MSG_INFO("HTTP server listening on {}:{}", endpoint.address(), endpoint.port());
 
+    auto n_handler_threads = 
+        Globalreg::globalreg->kismet_config->fetch_opt_as<unsigned int>("httpd_handler_threads", 0);
+
+    if (n_handler_threads == 0)
+        n_handler_threads = std::max(2U, static_cast<unsigned int>(std::thread::hardware_concurrency()));
+
+    handler_pool_ = std::make_shared<kis_net_beast_handler_pool>(n_handler_threads);
+    handler_pool_->start();
+
     running = true;
 
     start_accept();
@@ -468,6 +571,9 @@ int kis_net_beast_httpd::stop_httpd() {
         }
     }
 
+    if (handler_pool_ != nullptr)
+        handler_pool_->stop();
+
     return 1;
 }
 
@@ -487,36 +593,9 @@ void kis_net_beast_httpd::handle_connection(const boost::system::error_code& ec,
     if (!running)
         return;
 
-	// Spin each connection into its own thread
-    if (!ec) {
-        std::thread conthread([this, tcp_socket = boost::beast::tcp_stream(std::move(socket))]() mutable {
-                thread_set_process_name("BEAST");
-
-                while (tcp_socket.socket().is_open()) {
-					// Reset the timeout every loop through; each request in this 
-					// socket pipeline has up to 30 seconds to complete
-					boost::beast::get_lowest_layer(tcp_socket).expires_after(std::chrono::seconds(30));
-
-                    // Associate the socket
-                    auto conn = 
-                        std::make_shared<kis_net_beast_httpd_connection>(tcp_socket, shared_from_this());
-
-                    // Run the connection
-                    auto retain = conn->start();
-
-                    if (retain == false)
-                        break;
-                }
-
-                try {
-                    tcp_socket.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_send);
-                } catch (...) {
-                    ;
-                }
-            });
-
-        conthread.detach();
-    }
+    // Sessions keep themselves alive through their pending async operations
+    if (!ec)
+        std::make_shared<kis_net_beast_httpd_session>(std::move(socket), shared_from_this())->start();
 
     // Accept another connection
     return start_accept();
@@ -703,6 +782,8 @@ void kis_net_beast_httpd::register_route(const std::string& route, const std::li
         b_verbs.emplace_back(boost::beast::http::string_to_verb(v));
 
     route_vec.emplace_back(std::make_shared<kis_net_beast_route>(route, b_verbs, true, roles, handler));
+
+    rebuild_route_tables();
 }
 
 void kis_net_beast_httpd::register_route(const std::string& route, 
@@ -729,6 +810,30 @@ void kis_net_beast_httpd::register_route(const std::string& route,
         b_verbs.emplace_back(boost::beast::http::string_to_verb(v));
 
     route_vec.emplace_back(std::make_shared<kis_net_beast_route>(route, b_verbs, true, roles, extensions, handler));
+
+    rebuild_route_tables();
+}
+
+void kis_net_beast_httpd::register_bulk_route(const std::string& route, 
+        const std::list<std::string>& verbs, const std::string& role,
+        const std::list<std::string>& extensions, std::shared_ptr<kis_net_web_endpoint> handler) {
+
+    if (role.length() == 0)
+        throw std::runtime_error("can not register auth http route with no role");
+
+    kis_lock_guard<kis_mutex> lk(route_mutex, "beast_httpd register_bulk_route");
+
+    std::list<boost::beast::http::verb> b_verbs;
+    for (const auto& v : verbs) 
+        b_verbs.emplace_back(boost::beast::http::string_to_verb(v));
+
+    auto r = std::make_shared<kis_net_beast_route>(route, b_verbs, true, 
+            std::list<std::string>{role}, extensions, handler);
+    r->set_stream_body(true);
+
+    route_vec.emplace_back(r);
+
+    rebuild_route_tables();
 }
 
 void kis_net_beast_httpd::remove_route(const std::string& route) {
@@ -737,6 +842,7 @@ void kis_net_beast_httpd::remove_route(const std::string& route) {
     for (auto i = route_vec.begin(); i != route_vec.end(); ++i) {
         if ((*i)->route() == route) {
             route_vec.erase(i);
+            rebuild_route_tables();
             return;
         }
     }
@@ -751,6 +857,8 @@ void kis_net_beast_httpd::register_unauth_route(const std::string& route,
         b_verbs.emplace_back(boost::beast::http::string_to_verb(v));
     route_vec.emplace_back(std::make_shared<kis_net_beast_route>(route, b_verbs, false, 
                 std::list<std::string>{""}, handler));
+
+    rebuild_route_tables();
 }
 
 void kis_net_beast_httpd::register_unauth_route(const std::string& route, 
@@ -763,6 +871,8 @@ void kis_net_beast_httpd::register_unauth_route(const std::string& route,
     route_vec.emplace_back(std::make_shared<kis_net_beast_route>(route, b_verbs, false, 
                 std::list<std::string>{""},
                 extensions, handler));
+
+    rebuild_route_tables();
 }
 
 void kis_net_beast_httpd::register_websocket_route(const std::string& route, 
@@ -779,6 +889,14 @@ void kis_net_beast_httpd::register_websocket_route(const std::string& route,
     websocket_route_vec.emplace_back(std::make_shared<kis_net_beast_route>(route, 
                 std::list<boost::beast::http::verb>{}, true, roles, extensions, handler));
 
+    rebuild_route_tables();
+}
+
+void kis_net_beast_httpd::rebuild_route_tables() {
+    std::atomic_store(&route_table_,
+            std::shared_ptr<const kis_net_beast_route_table>(std::make_shared<kis_net_beast_route_table>(route_vec)));
+    std::atomic_store(&websocket_route_table_,
+            std::shared_ptr<const kis_net_beast_route_table>(std::make_shared<kis_net_beast_route_table>(websocket_route_vec)));
 }
 
 std::string kis_net_beast_httpd::create_auth(const std::string& name, const std::string& role, time_t expiry) {
@@ -808,6 +926,7 @@ std::string kis_net_beast_httpd::create_auth_impl(const std::string& name, const
     auto auth = std::make_shared<kis_net_beast_auth>(token, name, role, expiry);
 
     auth_vec.emplace_back(auth);
+    rebuild_auth_tokens();
     store_auth();
 
     return token;
@@ -818,7 +937,7 @@ std::string kis_net_beast_httpd::create_or_find_auth(const std::string& name,
     kis_lock_guard<kis_mutex> lk(auth_mutex, "beast_httpd create_or_find_auth");
 
     // Pull an existing token if one exists for this name
-    for (const auto& a : auth_vec) {
+    for (auto& a : auth_vec) {
         if (a->name() == name) {
             /*
             if (a->role() != role) 
@@ -826,14 +945,25 @@ std::string kis_net_beast_httpd::create_or_find_auth(const std::string& name,
                             "auth (found existing login for {} tried to create for {})", 
                             a->role, role));
                             */
-            
-            // Reset the role to the new one
-            if (a->role() != role) 
-                a->set_role(role);
 
-            if (a->expires() < expiry) {
-                a->set_expiration(expiry);
-                store_auth();
+            // Records may be in use by lockless token checks, so changes replace the record
+            if (a->role() != role || a->expires() < expiry) {
+                auto updated = std::make_shared<kis_net_beast_auth>(*a);
+
+                // Reset the role to the new one
+                if (updated->role() != role) 
+                    updated->set_role(role);
+
+                if (updated->expires() < expiry)
+                    updated->set_expiration(expiry);
+
+                bool expiry_changed = a->expires() != updated->expires();
+
+                a = updated;
+                rebuild_auth_tokens();
+
+                if (expiry_changed)
+                    store_auth();
             }
 
             return a->token();
@@ -865,6 +995,7 @@ bool kis_net_beast_httpd::remove_auth(const std::string& auth_name) {
     for (auto a = auth_vec.begin(); a != auth_vec.end(); ++a) {
         if ((*a)->name() == auth_name) {
             auth_vec.erase(a);
+            rebuild_auth_tokens();
             store_auth();
             return true;
         }
@@ -873,25 +1004,91 @@ bool kis_net_beast_httpd::remove_auth(const std::string& auth_name) {
     return false;
 }
 
-std::shared_ptr<kis_net_beast_auth> kis_net_beast_httpd::check_auth_token(const boost::beast::string_view& token) {
-    kis_lock_guard<kis_mutex> lk(auth_mutex, "beast_httpd check_auth_token");
+void kis_net_beast_httpd::register_websocket(std::shared_ptr<kis_net_web_websocket_endpoint> ws) {
+    kis_lock_guard<kis_mutex> lk(websocket_mutex, "beast_httpd register_websocket");
+    websocket_list.push_back(ws);
+}
+
+void kis_net_beast_httpd::remove_websocket(kis_net_web_websocket_endpoint *ws) {
+    kis_lock_guard<kis_mutex> lk(websocket_mutex, "beast_httpd remove_websocket");
 
-    // Step one: is it a JWT token? 
-    auto authtoken = check_jwt_token(token);
+    for (auto w = websocket_list.begin(); w != websocket_list.end(); ) {
+        auto l = w->lock();
+
+        if (l == nullptr || l.get() == ws)
+            w = websocket_list.erase(w);
+        else
+            ++w;
+    }
+}
 
-    if (authtoken != nullptr) 
-        return authtoken;
+void kis_net_beast_httpd::rebuild_auth_tokens() {
+    auto tokens = std::make_shared<auth_token_map_t>();
 
     for (const auto& a : auth_vec) {
-        if (a->check_auth(token)) 
-            return a;
+        auto hash = std::hash<std::string>{}(a->token());
+        tokens->emplace(hash, a);
+    }
+
+    std::atomic_store(&auth_tokens_, std::shared_ptr<const auth_token_map_t>(tokens));
+}
+
+std::shared_ptr<kis_net_beast_auth> kis_net_beast_httpd::check_auth_token(const boost::beast::string_view& token) {
+    if (token.length() == 0)
+        return nullptr;
+
+    // Step one: is it a JWT token?  Session tokens are hex and never contain the JWT 
+    // separators, so don't bother decoding them
+    if (token.find('.') != boost::beast::string_view::npos) {
+        auto authtoken = check_jwt_token(token);
+
+        if (authtoken != nullptr) 
+            return authtoken;
+    }
+
+    auto tokens = std::atomic_load(&auth_tokens_);
+
+    if (tokens == nullptr)
+        return nullptr;
 
+    auto hash = std::hash<std::string_view>{}(std::string_view(token.data(), token.length()));
+    auto range = tokens->equal_range(hash);
+
+    for (auto a = range.first; a != range.second; ++a) {
+        if (a->second->check_auth(token)) 
+            return a->second;
     }
 
     return nullptr;
 }
 
 std::shared_ptr<kis_net_beast_auth> kis_net_beast_httpd::check_jwt_token(const boost::beast::string_view& token) {
+    // Verified tokens are remembered per handler thread; the signing key and issuer don't 
+    // change while running, so a token which verified once will verify again
+    struct jwt_cache_entry {
+        std::string token;
+        std::shared_ptr<kis_net_beast_auth> auth;
+        time_t cache_expires;
+    };
+    thread_local std::unordered_multimap<size_t, jwt_cache_entry> jwt_cache;
+
+    auto now = static_cast<time_t>(Globalreg::globalreg->last_tv_sec);
+    auto hash = std::hash<std::string_view>{}(std::string_view(token.data(), token.length()));
+
+    auto range = jwt_cache.equal_range(hash);
+    for (auto c = range.first; c != range.second; ++c) {
+        boost_stringview_constant_time_string_compare_ne compare;
+
+        if (compare(c->second.token, token))
+            continue;
+
+        if (c->second.cache_expires > now)
+            return c->second.auth;
+
+        jwt_cache.erase(c);
+        break;
+    }
+
     try {
         auto decoded = jwt::decode(std::string(token));
 
@@ -903,6 +1100,20 @@ std::shared_ptr<kis_net_beast_auth> kis_net_beast_httpd::check_jwt_token(const b
 
         auto auth = std::make_shared<kis_net_beast_auth>(decoded);
 
+        if (jwt_cache.size() >= 128) {
+            for (auto c = jwt_cache.begin(); c != jwt_cache.end(); ) {
+                if (c->second.cache_expires <= now)
+                    c = jwt_cache.erase(c);
+                else
+                    ++c;
+            }
+
+            if (jwt_cache.size() >= 128)
+                jwt_cache.clear();
+        }
+
+        jwt_cache.emplace(hash, jwt_cache_entry{std::string(token), auth, now + jwt_cache_ttl});
+
         return auth;
 
     } catch (...) {
@@ -949,6 +1160,7 @@ void kis_net_beast_httpd::load_auth() {
     kis_lock_guard<kis_mutex> lk(auth_mutex, "beast_httpd load_auth");
 
     auth_vec.clear();
+    rebuild_auth_tokens();
 
     auto sessiondb_file = 
         Globalreg::globalreg->kismet_config->fetch_opt_path("httpd_session_db", 
@@ -976,30 +1188,51 @@ void kis_net_beast_httpd::load_auth() {
         }
     } catch (const std::exception& e) {
         _MSG_ERROR("(HTTPD) Could not process session data file, skipping loading saved sessions.");
+        rebuild_auth_tokens();
         return;
     }
+
+    rebuild_auth_tokens();
 }
 
 std::shared_ptr<kis_net_beast_route> kis_net_beast_httpd::find_endpoint(std::shared_ptr<kis_net_beast_httpd_connection> con) {
-    kis_lock_guard<kis_mutex> lk(route_mutex, "beast_httpd find_endpoint");
+    auto table = std::atomic_load(&route_table_);
 
-    for (const auto& r : route_vec) {
-        if (r->match_url(static_cast<const std::string>(con->uri()), con->uri_params_, con->http_variables_)) 
-            return r;
-    }
+    if (table == nullptr)
+        return nullptr;
 
-    return nullptr;
+    return table->match(con->uri(), con->uri_params_);
 }
 
 std::shared_ptr<kis_net_beast_route> kis_net_beast_httpd::find_websocket_endpoint(std::shared_ptr<kis_net_beast_httpd_connection> con) {
-    kis_lock_guard<kis_mutex> lk(route_mutex, "beast_httpd find_websocket_endpoint");
+    auto table = std::atomic_load(&websocket_route_table_);
 
-    for (const auto& r : websocket_route_vec) {
-        if (r->match_url(static_cast<const std::string>(con->uri()), con->uri_params_, con->http_variables_))
-            return r;
-    }
+    if (table == nullptr)
+        return nullptr;
 
-    return nullptr;
+    return table->match(con->uri(), con->uri_params_);
+}
+
+bool kis_net_beast_httpd::streams_request_body(const boost::beast::http::request_header<>& header) {
+    if (header.method() != boost::beast::http::verb::post)
+        return false;
+
+    auto table = std::atomic_load(&route_table_);
+
+    if (table == nullptr)
+        return false;
+
+    auto uri = header.target();
+    strip_uri_prefix(uri);
+
+    auto q = uri.find('?');
+    if (q != boost::beast::string_view::npos)
+        uri = uri.substr(0, q);
+
+    kis_net_beast_httpd_connection::uri_param_t params;
+    auto route = table->match(uri, params);
+
+    return route != nullptr && route->stream_body();
 }
 
 void kis_net_beast_httpd::register_static_dir(const std::string& prefix, const std::string& path) {
@@ -1034,249 +1267,813 @@ std::string kis_net_beast_httpd::escape_html(const boost::beast::string_view& ht
     return ss.str();
 }
 
-bool kis_net_beast_httpd::serve_file(std::shared_ptr<kis_net_beast_httpd_connection> con,
-                                     std::string uri) {
-    boost::beast::error_code ec;
-
-    if (uri.length() == 0)
-        uri = "/index.html";
-    else if (uri.back() == '/')
-        uri += "index.html";
-
-    for (auto sd : static_dir_vec) {
-        ec = {};
+// Gzip a static asset; returns false if compression failed
+static bool gzip_static_content(const std::string& in, std::string& out) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(z_stream));
 
-        if (uri.size() < sd.prefix.size())
-            continue;
+    // 15 window bits + 16 for a gzip wrapper instead of raw zlib
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
 
-        if (uri.find(sd.prefix) != 0)
-            continue;
+    out.resize(deflateBound(&zs, in.size()));
 
-        auto modified_fpath = sd.path + "/" + uri.substr(sd.prefix.length(), uri.length());
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+    zs.avail_in = in.size();
+    zs.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    zs.avail_out = out.size();
 
-        char *modified_realpath = nullptr;
-        char *base_realpath = realpath(sd.path.c_str(), nullptr);
+    auto r = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
 
-        modified_realpath = realpath(modified_fpath.c_str(), nullptr);
+    return r == Z_STREAM_END;
+}
 
-        if (modified_realpath == nullptr || base_realpath == nullptr) {
-            if (modified_realpath)
-                free(modified_realpath);
+// Only text-like content is worth compressing; images and fonts like woff are already compressed.
+// Used for static files and for compressing endpoint responses
+static bool content_compressible(const std::string& mime) {
+    return mime.find("text/") == 0 || mime == "application/javascript" || 
+        mime == "application/json" || mime == "application/xml" || mime == "image/svg+xml" ||
+        mime == "image/bmp" || mime == "image/vnd.microsoft.icon" || mime == "font/ttf" ||
+        mime == "font/otf" || mime == "application/vnd.ms-fontobject";
+}
 
-            if (base_realpath)
-                free(base_realpath);
+static std::shared_ptr<const std::string> load_static_content(const std::string& path) {
+    std::ifstream ifs(path, std::ios::in | std::ios::binary);
 
-            continue;
-        }
+    if (!ifs)
+        return nullptr;
 
-        if (strstr(modified_realpath, base_realpath) != modified_realpath) {
-            if (modified_realpath)
-                free(modified_realpath);
-            if (base_realpath)
-                free(base_realpath);
-            continue;
-        }
+    auto content = std::make_shared<std::string>(std::istreambuf_iterator<char>(ifs),
+            std::istreambuf_iterator<char>());
 
-        boost::beast::http::file_body::value_type body;
-        body.open(modified_realpath, boost::beast::file_mode::scan, ec);
+    if (ifs.bad())
+        return nullptr;
 
-        free(modified_realpath);
-        free(base_realpath);
+    return content;
+}
 
-        if (ec == boost::beast::errc::no_such_file_or_directory) {
-            continue;
-        } else if (ec) {
-            // _MSG_ERROR("(DEBUG) {} - {}", uri, ec.message());
+// Does an Accept-Encoding header allow a content coding?  A q-value of 0 refuses it.
+static bool accepts_content_encoding(boost::beast::string_view accept, boost::beast::string_view coding) {
+    for (const auto& e : boost::beast::http::ext_list{accept}) {
+        if (!boost::beast::iequals(e.first, coding))
             continue;
+
+        for (const auto& p : e.second) {
+            if (boost::beast::iequals(p.first, "q") && string_to_n_dfl<double>(static_cast<std::string>(p.second), 1) <= 0)
+                return false;
         }
 
-        auto const size = body.size();
+        return true;
+    }
 
-        if (con->request().method() == boost::beast::http::verb::head) {
-            boost::beast::http::response<boost::beast::http::empty_body> res{boost::beast::http::status::ok, 
-                con->request().version()};
+    return false;
+}
 
-            con->append_common_headers(res, uri);
+// Does an If-None-Match header match an entity tag?  Matching uses the weak comparison.
+static bool static_etag_matches(boost::beast::string_view header, const std::string& etag) {
+    if (etag.length() == 0)
+        return false;
 
-            res.content_length(size);
+    auto strip_weak = [](boost::beast::string_view t) {
+        while (t.length() && (t.front() == ' ' || t.front() == '\t'))
+            t.remove_prefix(1);
+        while (t.length() && (t.back() == ' ' || t.back() == '\t'))
+            t.remove_suffix(1);
+        if (t.starts_with("W/"))
+            t.remove_prefix(2);
+        return t;
+    };
 
-            ec = {};
+    auto tag = strip_weak(etag);
 
-            boost::beast::http::write(con->stream(), res, ec);
+    while (header.length()) {
+        auto c = header.find(',');
+        auto t = strip_weak(header.substr(0, c));
 
+        if (t == "*" || t == tag)
             return true;
-        }
-
-        boost::beast::http::response<boost::beast::http::file_body> res{std::piecewise_construct,
-                std::make_tuple(std::move(body)), std::make_tuple(boost::beast::http::status::ok, 
-                        con->request().version())};
-
-        con->append_common_headers(res, uri);
-        res.content_length(size);
-
-        ec = {};
 
-        boost::beast::http::write(con->stream(), res, ec);
+        if (c == boost::beast::string_view::npos)
+            break;
 
-        return true;
+        header.remove_prefix(c + 1);
     }
 
     return false;
 }
 
-bool kis_net_beast_httpd::serve_file(std::shared_ptr<kis_net_beast_httpd_connection> con) {
+std::shared_ptr<kis_net_beast_httpd::static_asset> 
+    kis_net_beast_httpd::find_static_asset(const std::string& fpath, const std::string& base) {
 
-    std::string uri;
-    auto encoding_pos = con->uri().find_first_of("?");
-    if (encoding_pos != con->uri().npos)
-        uri = static_cast<std::string>(con->uri().substr(0, encoding_pos));
-    else
-        uri = static_cast<std::string>(con->uri());
+    struct stat sb;
 
-    return serve_file(con, uri);
-}
+    {
+        kis_lock_guard<kis_mutex> lk(static_cache_mutex, "beast_httpd find_static_asset");
 
-void kis_net_beast_httpd::strip_uri_prefix(boost::beast::string_view& uri_view) {
-    if (allowed_prefix.length() == 0)
-        return;
+        auto k = static_cache.find(fpath);
+        if (k != static_cache.end()) {
+            auto& cached = k->second.asset;
 
-    if (uri_view.starts_with(allowed_prefix)) {
-        uri_view.remove_prefix(std::min(allowed_prefix.length(), uri_view.size()));
+            if (stat(cached->path.c_str(), &sb) == 0 && sb.st_mtime == cached->mtime &&
+                    sb.st_size == cached->size) {
+                static_cache_lru.splice(static_cache_lru.begin(), static_cache_lru, k->second.lru_pos);
+                return cached;
+            }
+
+            // Changed on disk; reload it
+            static_cache_sz -= cached->cached_sz();
+            static_cache_lru.erase(k->second.lru_pos);
+            static_cache.erase(k);
+        }
     }
-}
 
+    char *modified_realpath = realpath(fpath.c_str(), nullptr);
+    char *base_realpath = realpath(base.c_str(), nullptr);
 
+    if (modified_realpath == nullptr || base_realpath == nullptr ||
+            strstr(modified_realpath, base_realpath) != modified_realpath) {
+        if (modified_realpath)
+            free(modified_realpath);
+        if (base_realpath)
+            free(base_realpath);
 
-kis_net_beast_httpd_connection::kis_net_beast_httpd_connection(boost::beast::tcp_stream& socket,
-        std::shared_ptr<kis_net_beast_httpd> httpd) :
-    httpd{httpd},
-    stream_{socket},
-    login_valid_{false},
-    first_response_write{false} {
-        Globalreg::n_tracked_http_connections++;
+        return nullptr;
     }
 
-kis_net_beast_httpd_connection::~kis_net_beast_httpd_connection() {
-    Globalreg::n_tracked_http_connections--;
-    if (closure_cb)
-        closure_cb();
-}
+    auto asset = std::make_shared<static_asset>();
+    asset->path = modified_realpath;
 
-void kis_net_beast_httpd_connection::set_status(unsigned int status) {
-    if (first_response_write)
-        throw std::runtime_error("tried to set status connection already in progress");
+    free(modified_realpath);
+    free(base_realpath);
 
-    response.result(status);
-}
+    if (stat(asset->path.c_str(), &sb) != 0 || !S_ISREG(sb.st_mode))
+        return nullptr;
 
-void kis_net_beast_httpd_connection::set_status(boost::beast::http::status status) {
-    if (first_response_write)
-        throw std::runtime_error("tried to set status connection already in progress");
+    asset->mtime = sb.st_mtime;
+    asset->size = sb.st_size;
 
-    response.result(status);
-}
+    char lastmod[31];
+    struct tm tmstruct;
+    gmtime_r(&asset->mtime, &tmstruct);
+    strftime(lastmod, 31, "%a, %d %b %Y %H:%M:%S GMT", &tmstruct);
+    asset->last_modified = lastmod;
 
-void kis_net_beast_httpd_connection::set_mime_type(const std::string& type) {
-    if (first_response_write)
-        throw std::runtime_error("tried to set mime type of connection already in progress");
+    // Prefer precompressed files shipped with the content, as long as they're not stale
+    auto precompressed_sz = [&](const std::string& ext) -> off_t {
+        struct stat csb;
+        auto cpath = asset->path + ext;
 
-    response.set(boost::beast::http::field::content_type, type);
-}
+        if (stat(cpath.c_str(), &csb) != 0 || !S_ISREG(csb.st_mode) || csb.st_mtime < asset->mtime)
+            return -1;
 
-void kis_net_beast_httpd_connection::set_target_file(const std::string& fname) {
-    if (first_response_write)
-        throw std::runtime_error("tried to set file target on connection already in progress");
+        return csb.st_size;
+    };
 
-    response.set(boost::beast::http::field::content_disposition,
-            fmt::format("attachment; filename=\"{}\"", fname));
-}
+    auto brotli_sz = precompressed_sz(".br");
+    auto gzip_sz = precompressed_sz(".gz");
 
-void kis_net_beast_httpd_connection::clear_timeout() {
-    boost::beast::get_lowest_layer(stream_).expires_never();
-}
+    size_t needed_sz = static_cast<size_t>(sb.st_size) +
+        (brotli_sz > 0 ? brotli_sz : 0) + (gzip_sz > 0 ? gzip_sz : 0);
 
-void kis_net_beast_httpd_connection::append_header(const std::string& header, const std::string& value) {
-    if (first_response_write)
-        throw std::runtime_error("tried to set a header on a connection already in progress");
+    // Anything which could never be cached is streamed from disk as-is, instead of being
+    // loaded and compressed again for every request
+    if (static_cache_max == 0 || needed_sz > static_cache_max) {
+        // Streamed from disk; make sure we can actually read it
+        if (access(asset->path.c_str(), R_OK) != 0)
+            return nullptr;
 
-    response.set(header, value);
-}
+        asset->etag = fmt::format("W/\"{:x}-{:x}\"", asset->mtime, asset->size);
+        return asset;
+    }
 
-bool kis_net_beast_httpd_connection::start() {
-    parser_.emplace();
-    parser_->body_limit(100000);
+    asset->identity = load_static_content(asset->path);
 
-    try {
-        boost::beast::http::read(stream_, buffer, *parser_);
-    } catch (const boost::system::system_error& e) {
-        // Silently catch and fail on any error from the transport layer, because we don't
-        // care; we can't deal with a broken client spamming us
-        return do_close();
-    }
+    if (asset->identity == nullptr)
+        return nullptr;
 
-    request_ = boost::beast::http::request<boost::beast::http::string_body>(parser_->release());
+    auto crc = crc32(0L, reinterpret_cast<const Bytef *>(asset->identity->data()), asset->identity->size());
+    asset->etag = fmt::format("\"{:08x}-{:x}\"", crc, asset->identity->size());
 
-    uri_ = request_.target();
-    verb_ = request_.method();
+    if (brotli_sz >= 0)
+        asset->brotli = load_static_content(asset->path + ".br");
+    if (gzip_sz >= 0)
+        asset->gzip = load_static_content(asset->path + ".gz");
 
-    httpd->strip_uri_prefix(uri_);
-    auto trimmed_uri = httpd->decode_get_variables(uri_, http_variables_);
+    // Only compress what will fit in the cache with its compressed copy, which is never
+    // larger than the original
+    if (asset->gzip == nullptr && asset->identity->size() >= 256 &&
+            asset->cached_sz() + asset->identity->size() <= static_cache_max &&
+            content_compressible(resolve_mime_type(asset->path))) {
+        auto gz = std::make_shared<std::string>();
 
-    // Fix any double-slashes which will break the parser/splitter
-    std::regex re("/+/");
-    trimmed_uri = std::regex_replace(trimmed_uri, re, "/"); 
+        if (gzip_static_content(*asset->identity, *gz) && gz->size() < asset->identity->size())
+            asset->gzip = gz;
+    }
 
-    uri_ = boost::beast::string_view(trimmed_uri);
+    if (asset->gzip != nullptr)
+        asset->gzip_etag = fmt::format("\"{:08x}-{:x}-gz\"", crc, asset->identity->size());
+    if (asset->brotli != nullptr)
+        asset->brotli_etag = fmt::format("\"{:08x}-{:x}-br\"", crc, asset->identity->size());
+
+    {
+        kis_lock_guard<kis_mutex> lk(static_cache_mutex, "beast_httpd find_static_asset insert");
+
+        if (static_cache.find(fpath) == static_cache.end() &&
+                asset->cached_sz() <= static_cache_max) {
+            while (static_cache_sz + asset->cached_sz() > static_cache_max &&
+                    !static_cache_lru.empty()) {
+                auto e = static_cache.find(static_cache_lru.back());
+                static_cache_sz -= e->second.asset->cached_sz();
+                static_cache.erase(e);
+                static_cache_lru.pop_back();
+            }
 
-    // Process close headers - http 1.0 always closes unless keepalive, 1.1 never closes unless specified
-    bool client_req_close = false;
+            static_cache_lru.push_front(fpath);
+            static_cache_sz += asset->cached_sz();
+            static_cache[fpath] = static_cache_entry{asset, static_cache_lru.begin()};
+        }
+    }
 
-    if (request_.version() == 10)
-        client_req_close = true;
+    return asset;
+}
 
-    auto client_connection_h = request_.find(boost::beast::http::field::connection);
-    if (client_connection_h != request_.end()) {
-        auto connection_decode = httpd->decode_uri(client_connection_h->value(), true);
+void kis_net_beast_httpd::send_static_asset(std::shared_ptr<kis_net_beast_httpd_connection> con,
+        std::shared_ptr<static_asset> asset, const std::string& uri) {
 
-        if (request_.version() == 10 && connection_decode == "keep-alive") {
-            client_req_close = false;
-            response.set(boost::beast::http::field::connection, "keep-alive");
-        }
+    const auto& request = con->request();
 
-        if (connection_decode == "close") {
-            client_req_close = true;
-        }
+    auto body = asset->identity;
+    auto etag = &asset->etag;
+    std::string encoding;
+
+    auto accept = request[boost::beast::http::field::accept_encoding];
+
+    if (asset->brotli != nullptr && accepts_content_encoding(accept, "br")) {
+        body = asset->brotli;
+        etag = &asset->brotli_etag;
+        encoding = "br";
+    } else if (asset->gzip != nullptr && accepts_content_encoding(accept, "gzip")) {
+        body = asset->gzip;
+        etag = &asset->gzip_etag;
+        encoding = "gzip";
     }
 
-    // Handle CORS before auth and route finding; always returns
-    if (request_.method() == boost::beast::http::verb::options && httpd->allow_cors()) {
-        response.result(boost::beast::http::status::ok);
+    auto set_static_headers = [&](auto& r) {
+        con->append_common_headers(r, uri);
 
-        std::string uri_rewrite = "";
-        append_common_headers(response, uri_rewrite);
+        // Static content is cacheable, unlike the rest of the server
+        r.erase(boost::beast::http::field::pragma);
+        r.erase(boost::beast::http::field::expires);
+        r.set(boost::beast::http::field::cache_control, static_cache_control);
+        r.set(boost::beast::http::field::last_modified, asset->last_modified);
+        r.set(boost::beast::http::field::etag, *etag);
 
-        response.set(boost::beast::http::field::content_length, "0");
+        if (asset->gzip != nullptr || asset->brotli != nullptr) {
+            auto vary = r[boost::beast::http::field::vary];
+            if (vary.length())
+                r.set(boost::beast::http::field::vary, fmt::format("{}, Accept-Encoding", vary));
+            else
+                r.set(boost::beast::http::field::vary, "Accept-Encoding");
+        }
 
-        boost::beast::http::response_serializer<boost::beast::http::buffer_body,
-            boost::beast::http::fields> sr{response};
+        if (encoding.length())
+            r.set(boost::beast::http::field::content_encoding, encoding);
+    };
 
-        boost::system::error_code error;
-        boost::beast::http::write_header(stream_, sr, error);
+    auto inm = request[boost::beast::http::field::if_none_match];
 
-        if (error) 
-            return do_close();
+    if (inm.length() && (static_etag_matches(inm, asset->etag) || 
+                static_etag_matches(inm, asset->gzip_etag) ||
+                static_etag_matches(inm, asset->brotli_etag))) {
+        auto res = 
+            std::make_shared<boost::beast::http::response<boost::beast::http::empty_body>>(boost::beast::http::status::not_modified,
+                    request.version());
 
-        // Send the completion record for the chunked response
-        response.body().data = nullptr;
-        response.body().size = 0;
-        response.body().more = false;
+        set_static_headers(*res);
+        res->erase(boost::beast::http::field::content_encoding);
 
-        boost::beast::http::write(stream_, sr, error);
+        return con->send_response(res, con->client_req_close_);
+    }
 
-        if (error || client_req_close) 
-            return do_close();
+    if (request.method() == boost::beast::http::verb::head) {
+        auto res = 
+            std::make_shared<boost::beast::http::response<boost::beast::http::empty_body>>(boost::beast::http::status::ok, 
+                request.version());
 
-        return true;
+        set_static_headers(*res);
+        res->content_length(body != nullptr ? body->size() : asset->size);
+
+        return con->send_response(res, con->client_req_close_);
+    }
+
+    if (body != nullptr) {
+        // The response references the cached content directly, and holds the content until 
+        // it has been written
+        using span_response_t = boost::beast::http::response<boost::beast::http::span_body<const char>>;
+
+        auto res = std::shared_ptr<span_response_t>(new span_response_t(boost::beast::http::status::ok,
+                    request.version()), [body](span_response_t *r) { delete r; });
+
+        set_static_headers(*res);
+        res->body() = boost::beast::span<const char>(body->data(), body->size());
+        res->content_length(body->size());
+
+        return con->send_response(res, con->client_req_close_);
+    }
+
+    boost::beast::error_code ec;
+    boost::beast::http::file_body::value_type file;
+    file.open(asset->path.c_str(), boost::beast::file_mode::scan, ec);
+
+    if (ec) {
+        auto res = 
+            std::make_shared<boost::beast::http::response<boost::beast::http::string_body>>(boost::beast::http::status::internal_server_error,
+                    request.version());
+        res->set(boost::beast::http::field::server, "Kismet");
+        res->prepare_payload();
+
+        return con->send_response(res, true);
+    }
+
+    auto res = 
+        std::make_shared<boost::beast::http::response<boost::beast::http::file_body>>(std::piecewise_construct,
+            std::make_tuple(std::move(file)), std::make_tuple(boost::beast::http::status::ok, 
+                    request.version()));
+
+    set_static_headers(*res);
+    res->content_length(asset->size);
+
+    con->send_response(res, con->client_req_close_);
+}
+
+bool kis_net_beast_httpd::serve_file(std::shared_ptr<kis_net_beast_httpd_connection> con,
+                                     std::string uri) {
+    if (uri.length() == 0)
+        uri = "/index.html";
+    else if (uri.back() == '/')
+        uri += "index.html";
+
+    for (const auto& sd : static_dir_vec) {
+        if (uri.size() < sd.prefix.size())
+            continue;
+
+        if (uri.find(sd.prefix) != 0)
+            continue;
+
+        auto modified_fpath = sd.path + "/" + uri.substr(sd.prefix.length(), uri.length());
+
+        auto asset = find_static_asset(modified_fpath, sd.path);
+
+        if (asset == nullptr)
+            continue;
+
+        send_static_asset(con, asset, uri);
+
+        return true;
+    }
+
+    return false;
+}
+
+bool kis_net_beast_httpd::serve_file(std::shared_ptr<kis_net_beast_httpd_connection> con) {
+
+    std::string uri;
+    auto encoding_pos = con->uri().find_first_of("?");
+    if (encoding_pos != con->uri().npos)
+        uri = static_cast<std::string>(con->uri().substr(0, encoding_pos));
+    else
+        uri = static_cast<std::string>(con->uri());
+
+    return serve_file(con, uri);
+}
+
+void kis_net_beast_httpd::strip_uri_prefix(boost::beast::string_view& uri_view) {
+    if (allowed_prefix.length() == 0)
+        return;
+
+    if (uri_view.starts_with(allowed_prefix)) {
+        uri_view.remove_prefix(std::min(allowed_prefix.length(), uri_view.size()));
+    }
+}
+
+
+
+thread_local kis_net_beast_handler_pool *kis_net_beast_handler_pool::current_pool_ = nullptr;
+thread_local bool kis_net_beast_handler_pool::released_ = false;
+
+kis_net_beast_handler_pool::kis_net_beast_handler_pool(unsigned int n_threads) :
+    n_threads_{n_threads},
+    running_{false} { }
+
+void kis_net_beast_handler_pool::start() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+    }
+
+    for (unsigned int n = 0; n < n_threads_; n++)
+        spawn_worker();
+}
+
+void kis_net_beast_handler_pool::stop() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        task_queue_.clear();
+    }
+
+    cv_.notify_all();
+}
+
+void kis_net_beast_handler_pool::post(std::function<void ()> task) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!running_)
+            return;
+
+        task_queue_.emplace_back(std::move(task));
+    }
+
+    cv_.notify_one();
+}
+
+void kis_net_beast_handler_pool::release_current() {
+    if (current_pool_ == nullptr || released_)
+        return;
+
+    released_ = true;
+    thread_set_process_name("BEAST-STREAM");
+
+    current_pool_->spawn_worker();
+}
+
+void kis_net_beast_handler_pool::spawn_worker() {
+    // Workers are detached and hold a reference to the pool so that a released 
+    // worker finishing a long stream never outlives it
+    std::thread t([self = shared_from_this()]() {
+        thread_set_process_name("BEAST");
+        self->worker_loop();
+    });
+    t.detach();
+}
+
+void kis_net_beast_handler_pool::worker_loop() {
+    current_pool_ = this;
+    released_ = false;
+
+    while (true) {
+        std::function<void ()> task;
+
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            cv_.wait(lk, [this]() { return !running_ || task_queue_.size() > 0; });
+
+            if (!running_)
+                break;
+
+            task = std::move(task_queue_.front());
+            task_queue_.pop_front();
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            _MSG_ERROR("HTTP handler failed with uncaught exception: {}", e.what());
+        }
+
+        // A released worker has already been replaced
+        if (released_)
+            break;
+    }
+
+    current_pool_ = nullptr;
+}
+
+
+
+kis_net_beast_httpd_session::kis_net_beast_httpd_session(boost::asio::ip::tcp::socket&& socket,
+        std::shared_ptr<kis_net_beast_httpd> httpd) :
+    httpd{httpd},
+    stream_{std::move(socket)},
+    body_done_{true},
+    body_failed_{false},
+    body_reading_{false},
+    response_done_{true},
+    keep_alive_{false} { }
+
+void kis_net_beast_httpd_session::start() {
+    // The socket was accepted on its own strand; run everything there
+    boost::asio::dispatch(stream_.get_executor(),
+            boost::beast::bind_front_handler(&kis_net_beast_httpd_session::do_read, shared_from_this()));
+}
+
+void kis_net_beast_httpd_session::do_read() {
+    header_parser_.emplace();
+
+    // The header parser never reads the body; the length is checked against the limit of
+    // whichever parser reads it
+    header_parser_->body_limit(boost::none);
+
+    // Each request has up to 30 seconds to arrive, which also reaps idle keep-alive sockets
+    stream_.expires_after(std::chrono::seconds(30));
+
+    boost::beast::http::async_read_header(stream_, buffer_, *header_parser_,
+            boost::beast::bind_front_handler(&kis_net_beast_httpd_session::on_header, shared_from_this()));
+}
+
+void kis_net_beast_httpd_session::on_header(boost::beast::error_code ec, std::size_t) {
+    if (ec || !httpd->httpd_running())
+        return do_close();
+
+    auto content_len = header_parser_->content_length();
+
+    if (httpd->streams_request_body(header_parser_->get())) {
+        if (content_len && *content_len > httpd->bulk_body_limit())
+            return do_close();
+
+        // The bulk limit only applies once the request has been authenticated; nothing
+        // is read until then
+        body_parser_.emplace(std::move(*header_parser_));
+        body_parser_->body_limit(body_limit);
+
+        auto con = std::make_shared<kis_net_beast_httpd_connection>(stream_, httpd);
+        con->request_.base() = body_parser_->get().base();
+
+        body_stream_ = std::make_shared<future_chainbuf>();
+        con->request_body_ = body_stream_;
+
+        body_buf_.resize(65536);
+        body_done_ = false;
+        body_failed_ = false;
+        body_reading_ = false;
+
+        // The handler consumes the body while we read it, once it has authorized the request
+        con->read_body_cb_ = [self = shared_from_this()]() {
+            boost::asio::dispatch(self->stream_.get_executor(), [self]() { self->start_read_body(); });
+        };
+
+        return dispatch(con);
+    }
+
+    if (content_len && *content_len > body_limit)
+        return do_close();
+
+    parser_.emplace(std::move(*header_parser_));
+    parser_->body_limit(body_limit);
+
+    boost::beast::http::async_read(stream_, buffer_, *parser_,
+            boost::beast::bind_front_handler(&kis_net_beast_httpd_session::on_read, shared_from_this()));
+}
+
+void kis_net_beast_httpd_session::on_read(boost::beast::error_code ec, std::size_t) {
+    // Silently catch and fail on any error from the transport layer, because we don't
+    // care; we can't deal with a broken client spamming us
+    if (ec || !httpd->httpd_running())
+        return do_close();
+
+    auto con = std::make_shared<kis_net_beast_httpd_connection>(stream_, httpd);
+    con->request_ = parser_->release();
+
+    dispatch(con);
+}
+
+void kis_net_beast_httpd_session::start_read_body() {
+    if (body_reading_ || body_done_)
+        return;
+
+    body_reading_ = true;
+    body_parser_->body_limit(httpd->bulk_body_limit());
+
+    do_read_body();
+}
+
+void kis_net_beast_httpd_session::do_read_body() {
+    body_parser_->get().body().data = body_buf_.data();
+    body_parser_->get().body().size = body_buf_.size();
+
+    stream_.expires_after(std::chrono::seconds(30));
+
+    boost::beast::http::async_read(stream_, buffer_, *body_parser_,
+            boost::beast::bind_front_handler(&kis_net_beast_httpd_session::on_read_body, shared_from_this()));
+}
+
+void kis_net_beast_httpd_session::on_read_body(boost::beast::error_code ec, std::size_t) {
+    // buffer_body reports a full buffer as need_buffer; that's our cue to hand it off
+    if (ec == boost::beast::http::error::need_buffer)
+        ec = {};
+
+    if (ec || !httpd->httpd_running()) {
+        body_done_ = true;
+        body_failed_ = true;
+        body_stream_->cancel();
+
+        stream_.expires_never();
+        return maybe_next_request();
+    }
+
+    auto read_sz = body_buf_.size() - body_parser_->get().body().size;
+
+    // Once the response is done nobody is reading the body, but it still has to be 
+    // drained from the socket before the next request
+    if (read_sz > 0 && !response_done_) {
+        body_stream_->put_data(body_buf_.data(), read_sz);
+        body_stream_->wake();
+    }
+
+    if (!body_parser_->is_done()) {
+        // Don't read further ahead of the handler than body_buffer_max
+        return body_stream_->async_wait_write(body_buffer_max, [self = shared_from_this()]() {
+                boost::asio::dispatch(self->stream_.get_executor(), [self]() { self->do_read_body(); });
+            });
+    }
+
+    body_done_ = true;
+    body_stream_->complete();
+
+    stream_.expires_never();
+    maybe_next_request();
+}
+
+void kis_net_beast_httpd_session::dispatch(std::shared_ptr<kis_net_beast_httpd_connection> con) {
+    // Responses set their own write timeouts
+    stream_.expires_never();
+
+    auto pool = httpd->handler_pool();
+    if (pool == nullptr)
+        return do_close();
+
+    response_done_ = false;
+
+    pool->post([self = shared_from_this(), con]() {
+        con->start([self](bool keep_alive) {
+                boost::asio::dispatch(self->stream_.get_executor(),
+                        [self, keep_alive]() { self->on_complete(keep_alive); });
+            });
+        });
+}
+
+void kis_net_beast_httpd_session::on_complete(bool keep_alive) {
+    response_done_ = true;
+    keep_alive_ = keep_alive;
+
+    // Nobody consumes the body once the response is done; release any read waiting on the
+    // handler so the rest is drained from the socket.  A request refused before it was
+    // authorized to send the body is dropped instead of read.
+    if (body_parser_ && !body_done_) {
+        if (!body_reading_) {
+            body_done_ = true;
+            body_failed_ = true;
+        }
+
+        body_stream_->cancel();
+    }
+
+    maybe_next_request();
+}
+
+void kis_net_beast_httpd_session::maybe_next_request() {
+    // A streamed request is finished once both the response is written and the body is read;
+    // whichever finishes last moves on to the next request
+    if (!response_done_ || !body_done_)
+        return;
+
+    body_parser_.reset();
+    body_stream_.reset();
+
+    if (keep_alive_ && !body_failed_ && stream_.socket().is_open() && httpd->httpd_running())
+        return do_read();
+
+    do_close();
+}
+
+void kis_net_beast_httpd_session::do_close() {
+    boost::system::error_code ec;
+    stream_.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_send, ec);
+}
+
+
+
+kis_net_beast_httpd_connection::kis_net_beast_httpd_connection(boost::beast::tcp_stream& socket,
+        std::shared_ptr<kis_net_beast_httpd> httpd) :
+    httpd{httpd},
+    stream_{socket},
+    client_req_close_{false},
+    no_timeout_{false},
+    login_valid_{false},
+    login_role_bits_{0},
+    first_response_write{false} {
+        Globalreg::n_tracked_http_connections++;
+    }
+
+kis_net_beast_httpd_connection::~kis_net_beast_httpd_connection() {
+    Globalreg::n_tracked_http_connections--;
+    if (closure_cb)
+        closure_cb();
+}
+
+void kis_net_beast_httpd_connection::set_status(unsigned int status) {
+    if (first_response_write)
+        throw std::runtime_error("tried to set status connection already in progress");
+
+    response.result(status);
+}
+
+void kis_net_beast_httpd_connection::set_status(boost::beast::http::status status) {
+    if (first_response_write)
+        throw std::runtime_error("tried to set status connection already in progress");
+
+    response.result(status);
+}
+
+void kis_net_beast_httpd_connection::set_mime_type(const std::string& type) {
+    if (first_response_write)
+        throw std::runtime_error("tried to set mime type of connection already in progress");
+
+    response.set(boost::beast::http::field::content_type, type);
+}
+
+void kis_net_beast_httpd_connection::set_target_file(const std::string& fname) {
+    if (first_response_write)
+        throw std::runtime_error("tried to set file target on connection already in progress");
+
+    response.set(boost::beast::http::field::content_disposition,
+            fmt::format("attachment; filename=\"{}\"", fname));
+}
+
+void kis_net_beast_httpd_connection::clear_timeout() {
+    // Long-running streams aren't compressed, so that data isn't held by the encoder
+    response_stream_.clear_gzip();
+
+    no_timeout_ = true;
+    release_handler();
+}
+
+void kis_net_beast_httpd_connection::release_handler() {
+    kis_net_beast_handler_pool::release_current();
+}
+
+void kis_net_beast_httpd_connection::arm_write_timeout() {
+    if (no_timeout_)
+        stream_.expires_never();
+    else
+        stream_.expires_after(std::chrono::seconds(30));
+}
+
+void kis_net_beast_httpd_connection::append_header(const std::string& header, const std::string& value) {
+    if (first_response_write)
+        throw std::runtime_error("tried to set a header on a connection already in progress");
+
+    response.set(header, value);
+}
+
+void kis_net_beast_httpd_connection::start(std::function<void (bool)> complete_cb) {
+    complete_cb_ = complete_cb;
+
+    uri_ = request_.target();
+    verb_ = request_.method();
+
+    httpd->strip_uri_prefix(uri_);
+    trimmed_uri_ = httpd->decode_get_variables(uri_, http_variables_);
+
+    // Fix any double-slashes which will break the parser/splitter
+    std::regex re("/+/");
+    trimmed_uri_ = std::regex_replace(trimmed_uri_, re, "/"); 
+
+    uri_ = boost::beast::string_view(trimmed_uri_);
+
+    // Process close headers - http 1.0 always closes unless keepalive, 1.1 never closes unless specified
+    if (request_.version() == 10)
+        client_req_close_ = true;
+
+    auto client_connection_h = request_.find(boost::beast::http::field::connection);
+    if (client_connection_h != request_.end()) {
+        auto connection_decode = httpd->decode_uri(client_connection_h->value(), true);
+
+        if (request_.version() == 10 && connection_decode == "keep-alive") {
+            client_req_close_ = false;
+            response.set(boost::beast::http::field::connection, "keep-alive");
+        }
+
+        if (connection_decode == "close") {
+            client_req_close_ = true;
+        }
+    }
+
+    // Handle CORS before auth and route finding; always returns
+    if (request_.method() == boost::beast::http::verb::options && httpd->allow_cors()) {
+        auto res = 
+            std::make_shared<boost::beast::http::response<boost::beast::http::empty_body>>(boost::beast::http::status::ok,
+                    request_.version());
+
+        std::string uri_rewrite = "";
+        append_common_headers(*res, uri_rewrite);
+
+        res->content_length(0);
+
+        return send_response(res, client_req_close_);
     }
 
     // Extract the auth cookie
@@ -1298,6 +2095,7 @@ bool kis_net_beast_httpd_connection::start() {
     if (auth_t != nullptr) {
         login_valid_ = true;
         login_role_ = auth_t->role();
+        login_role_bits_ = auth_t->role_bits();
     } else {
         // _MSG_INFO("(DEBUG) {} {} had auth {} but isn't valid", verb_, uri_, auth_token_);
 
@@ -1324,6 +2122,7 @@ bool kis_net_beast_httpd_connection::start() {
 
                         if (login_valid_) {
                             login_role_ = kis_net_beast_httpd::LOGON_ROLE;
+                            login_role_bits_ = kis_net_beast_httpd::LOGON_ROLE_BIT;
 
                             // If we have a valid pw login and no, or an invalid, auth token, create one
                             // auth_token_ = httpd->create_or_find_auth("web logon", httpd->LOGON_ROLE, time(0) + (60*60*24));
@@ -1341,6 +2140,7 @@ bool kis_net_beast_httpd_connection::start() {
 
                 if (login_valid_) {
                     login_role_ = kis_net_beast_httpd::LOGON_ROLE;
+                    login_role_bits_ = kis_net_beast_httpd::LOGON_ROLE_BIT;
 
                     // auth_token_ = httpd->create_or_find_auth("web logon", httpd->LOGON_ROLE, time(0) + (60*60*24));
                     auth_token_ = httpd->create_jwt_auth("web logon", httpd->LOGON_ROLE, time(0) + (60*60*24));
@@ -1354,48 +2154,41 @@ bool kis_net_beast_httpd_connection::start() {
         auto route = httpd->find_websocket_endpoint(shared_from_this());
 
         if (route == nullptr) {
-            boost::beast::http::response<boost::beast::http::string_body> 
-                res{boost::beast::http::status::not_found, request_.version()};
+            auto res = 
+                std::make_shared<boost::beast::http::response<boost::beast::http::string_body>>(boost::beast::http::status::not_found,
+                        request_.version());
 
-            res.set(boost::beast::http::field::server, "Kismet");
-            res.set(boost::beast::http::field::content_type, "text/html");
-            res.body() = 
+            res->set(boost::beast::http::field::server, "Kismet");
+            res->set(boost::beast::http::field::content_type, "text/html");
+            res->body() = 
                 std::string(fmt::format("<html><head><title>404 not found</title></head>"
                             "<body><h1>404 Not Found</h1><br>"
                             "<p>Could not find <code>{}</code></p></body></html>\n",
                             httpd->escape_html(static_cast<std::string>(uri_))));
-            res.prepare_payload();
-
-            boost::system::error_code error;
+            res->prepare_payload();
 
-            boost::beast::http::write(stream_, res, error);
-
-            return do_close();
+            return send_response(res, true);
         }
 
-        if (!route->match_role(login_valid_, login_role_)) {
-            boost::beast::http::response<boost::beast::http::string_body> 
-                res{boost::beast::http::status::unauthorized, request_.version()};
+        if (!route->match_role(login_valid_, login_role_bits_, login_role_)) {
+            auto res = 
+                std::make_shared<boost::beast::http::response<boost::beast::http::string_body>>(boost::beast::http::status::unauthorized,
+                        request_.version());
 
-            res.set(boost::beast::http::field::server, "Kismet");
-            res.set(boost::beast::http::field::content_type, "text/html");
-            res.body() = std::string("<html><head><title>401 Permission denied</title></head><body>"
+            res->set(boost::beast::http::field::server, "Kismet");
+            res->set(boost::beast::http::field::content_type, "text/html");
+            res->body() = std::string("<html><head><title>401 Permission denied</title></head><body>"
                     "<h1>401 Permission denied</h1><br><p>This resource requires a login or session "
                     "token.</p></body></html>\n");
-            res.prepare_payload();
-
-            boost::system::error_code error;
+            res->prepare_payload();
 
-            boost::beast::http::write(stream_, res, error);
-
-            return do_close();
+            return send_response(res, true);
         }
 
-        boost::beast::get_lowest_layer(stream_).expires_never();
-
+        // The websocket takes over the stream and runs asynchronously until it closes
         route->invoke(shared_from_this());
 
-        return do_close();
+        return finish(false);
     }
 
     // Look for a route
@@ -1403,27 +2196,22 @@ bool kis_net_beast_httpd_connection::start() {
 
     if (route != nullptr) {
         if (!route->match_verb(verb_)) {
-            boost::beast::http::response<boost::beast::http::string_body> 
-                res{boost::beast::http::status::method_not_allowed, request_.version()};
-
-            res.set(boost::beast::http::field::server, "Kismet");
-            res.set(boost::beast::http::field::content_type, "text/html");
-            res.body() = std::string("<html><head><title>405 Incorrect method</title></head><body><h1>405 Incorrect method</h1><br><p>This method is not valid for this resource.</p></body></html>\n");
-            res.prepare_payload();
-
-            boost::system::error_code error;
+            auto res = 
+                std::make_shared<boost::beast::http::response<boost::beast::http::string_body>>(boost::beast::http::status::method_not_allowed,
+                        request_.version());
 
-            boost::beast::http::write(stream_, res, error);
+            res->set(boost::beast::http::field::server, "Kismet");
+            res->set(boost::beast::http::field::content_type, "text/html");
+            res->body() = std::string("<html><head><title>405 Incorrect method</title></head><body><h1>405 Incorrect method</h1><br><p>This method is not valid for this resource.</p></body></html>\n");
+            res->prepare_payload();
 
-            if (error || client_req_close) 
-                return do_close();
-
-            return true;
+            return send_response(res, client_req_close_);
         }
 
-        if (!route->match_role(login_valid_, login_role_)) {
-            boost::beast::http::response<boost::beast::http::string_body> 
-                res{boost::beast::http::status::unauthorized, request_.version()};
+        if (!route->match_role(login_valid_, login_role_bits_, login_role_)) {
+            auto res = 
+                std::make_shared<boost::beast::http::response<boost::beast::http::string_body>>(boost::beast::http::status::unauthorized,
+                        request_.version());
 
             // We don't generally want to send a WWW-Authorize header because it makes browsers prompt for logins
             // which interrupts the UI, and curl handles it fine - but wget will not send the auth until it gets
@@ -1433,23 +2221,16 @@ bool kis_net_beast_httpd_connection::start() {
                 auto ua = httpd->decode_uri(ua_h->value(), true);
 
                 if (ua.find_first_of("Wget") == 0) {
-                    res.set(boost::beast::http::field::www_authenticate, "Basic realm=Kismet");
+                    res->set(boost::beast::http::field::www_authenticate, "Basic realm=Kismet");
                 }
             }
 
-            res.set(boost::beast::http::field::server, "Kismet");
-            res.set(boost::beast::http::field::content_type, "text/html");
-            res.body() = std::string("<html><head><title>401 Permission denied</title></head><body><h1>401 Permission denied</h1><br><p>This resource requires a login or session token.</p></body></html>\n");
-            res.prepare_payload();
-
-            boost::system::error_code error;
-
-            boost::beast::http::write(stream_, res, error);
-
-            if (error || client_req_close) 
-                return do_close();
+            res->set(boost::beast::http::field::server, "Kismet");
+            res->set(boost::beast::http::field::content_type, "text/html");
+            res->body() = std::string("<html><head><title>401 Permission denied</title></head><body><h1>401 Permission denied</h1><br><p>This resource requires a login or session token.</p></body></html>\n");
+            res->prepare_payload();
 
-            return true;
+            return send_response(res, client_req_close_);
         }
     } else if (route == nullptr) {
         bool file_served = false;
@@ -1462,41 +2243,69 @@ bool kis_net_beast_httpd_connection::start() {
 
         // If we still didn't serve content, 404
         if (!file_served) {
-            boost::beast::http::response<boost::beast::http::string_body> 
-                res{boost::beast::http::status::not_found, request_.version()};
+            auto res = 
+                std::make_shared<boost::beast::http::response<boost::beast::http::string_body>>(boost::beast::http::status::not_found,
+                        request_.version());
 
-            res.set(boost::beast::http::field::server, "Kismet");
-            res.set(boost::beast::http::field::content_type, "text/html");
-            res.body() = 
+            res->set(boost::beast::http::field::server, "Kismet");
+            res->set(boost::beast::http::field::content_type, "text/html");
+            res->body() = 
                 std::string(fmt::format("<html><head><title>404 not found</title></head>"
                             "<body><h1>404 Not Found</h1><br>"
                             "<p>Could not find <code>{}</code></p></body></html>\n",
                             httpd->escape_html(static_cast<std::string>(uri_))));
-            res.prepare_payload();
-
-            boost::system::error_code error;
-
-            boost::beast::http::write(stream_, res, error);
-
-            if (error || client_req_close) 
-                return do_close();
+            res->prepare_payload();
 
-            return true;
+            return send_response(res, client_req_close_);
         }
 
-        if (client_req_close)
-            return do_close();
-
-        return true;
+        // serve_file has queued the response and finishes the request
+        return;
     }
 
+    // The request is authorized; start reading a streamed body
+    if (read_body_cb_ != nullptr)
+        read_body_cb_();
+
     append_common_headers(response, uri_);
 
+    // Compress text responses for clients which accept it; the handler compresses the content
+    // as it writes it to the response stream
+    if (httpd->compress_level() > 0 && 
+            content_compressible(static_cast<std::string>(response[boost::beast::http::field::content_type])) &&
+            accepts_content_encoding(request_[boost::beast::http::field::accept_encoding], "gzip"))
+        response_stream_.set_gzip(httpd->compress_level());
+
     if (request_.method() == boost::beast::http::verb::post) {
+        auto content_type = request_[boost::beast::http::field::content_type];
+
+        bool json_body = boost::beast::iequals(content_type, "application/json") ||
+            boost::beast::iequals(content_type, "application/json; charset=UTF-8");
+
         // Handle POST data fields
-        http_post = request_.body();
+        if (request_body_ != nullptr) {
+            future_chainbuf_reader reader(*request_body_);
 
-        auto content_type = request_[boost::beast::http::field::content_type];
+            if (json_body) {
+                // Parse bulk JSON as it arrives, without buffering the body first
+                std::istream is(&reader);
+
+                try {
+                    json_ = nlohmann::json::parse(is);
+                } catch (std::exception& e) {
+                    ;
+                }
+
+                json_body = false;
+            } else {
+                streamed_post_.assign(std::istreambuf_iterator<char>(&reader), 
+                        std::istreambuf_iterator<char>());
+            }
+
+            http_post = streamed_post_;
+        } else {
+            http_post = request_.body();
+        }
 
         if (boost::beast::iequals(content_type, "application/x-www-form-urlencoded") ||
                 boost::beast::iequals(content_type, "application/x-www-form-urlencoded; charset=UTF-8")) {
@@ -1512,8 +2321,7 @@ bool kis_net_beast_httpd_connection::start() {
                     ;
                 }
             }
-        } else if (boost::beast::iequals(content_type, "application/json") ||
-                boost::beast::iequals(content_type, "application/json; charset=UTF-8")) {
+        } else if (json_body) {
 
             try {
                 json_ = nlohmann::json::parse(http_post.data());
@@ -1527,120 +2335,149 @@ bool kis_net_beast_httpd_connection::start() {
     response.set(boost::beast::http::field::transfer_encoding, "chunked");
 
     // Create the chunked response serializer
-    boost::beast::http::response_serializer<boost::beast::http::buffer_body,
-        boost::beast::http::fields> sr{response};
-
-
-    // Spawn the generator thread
-    auto generator_launched = std::promise<void>();
-    auto generator_ft = generator_launched.get_future();
-
-    std::thread tr([this, route, generator_launched = std::move(generator_launched),
-            self = shared_from_this()]() mutable {
-        thread_set_process_name("BEAST-WAIT");
+    serializer_.emplace(response);
 
-        generator_launched.set_value();
+    // Start writing the response on the socket strand as soon as the handler produces
+    // data; the handler itself runs here, on the handler pool
+    boost::asio::post(stream_.get_executor(),
+            boost::beast::bind_front_handler(&kis_net_beast_httpd_connection::pump_response,
+                shared_from_this()));
 
+    try {
+        route->invoke(shared_from_this());
+    } catch (const std::exception& e) {
         try {
-            route->invoke(self);
-        } catch (const std::exception& e) {
-            try {
-                set_status(500);
-            } catch (...) {
-                ;
-            }
-
-            std::ostream os(&response_stream_);
-            os << "ERROR: " << e.what();
+            set_status(500);
+        } catch (...) {
+            ;
         }
 
-        response_stream_.complete();
-    });
-    tr.detach();
+        std::ostream os(&response_stream_);
+        os << "ERROR: " << e.what();
+    }
 
-    generator_ft.wait();
+    response_stream_.complete();
+}
 
-    boost::system::error_code error;
-    while (response_stream_.size() || response_stream_.running()) {
-        auto sz = response_stream_.size();
+void kis_net_beast_httpd_connection::set_content_encoding() {
+    if (!response_stream_.gzip())
+        return;
 
-        if (sz) {
-            // Write the headers once we have body content
-            if (!first_response_write) {
-                boost::beast::http::write_header(stream_, sr, error);
+    response.set(boost::beast::http::field::content_encoding, "gzip");
 
-                if (error) {
-                    // _MSG_ERROR("(DEBUG) {} {} - Error writing headers - {}", verb_, uri_, error.message());
-                    return do_close();
-                }
-            }
+    auto vary = response[boost::beast::http::field::vary];
+    if (vary.length())
+        response.set(boost::beast::http::field::vary, fmt::format("{}, Accept-Encoding", vary));
+    else
+        response.set(boost::beast::http::field::vary, "Accept-Encoding");
+}
 
-            // we no longer accept header modifiers
+void kis_net_beast_httpd_connection::pump_response() {
+    if (response_stream_.size()) {
+        // Write the headers once we have body content; we no longer accept header modifiers
+        if (!first_response_write) {
             first_response_write = true;
+            set_content_encoding();
+
+            arm_write_timeout();
+            boost::beast::http::async_write_header(stream_, *serializer_,
+                    [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
+                        if (ec) {
+                            self->response_stream_.cancel();
+                            return self->finish(false);
+                        }
 
-            char *body_data;
-            auto chunk_sz = response_stream_.get(&body_data);
+                        self->write_response_chunks();
+                    });
 
-            response.body().data = (void *) body_data;
-            response.body().size = chunk_sz;
-            response.body().more = true;
+            return;
+        }
+
+        return write_response_chunks();
+    }
 
-            boost::beast::http::write(stream_, sr, error);
+    // Wake back up on the strand when the handler produces more data or completes
+    if (response_stream_.running()) {
+        response_stream_.async_wait([self = shared_from_this()]() {
+                boost::asio::post(self->stream_.get_executor(),
+                        boost::beast::bind_front_handler(&kis_net_beast_httpd_connection::pump_response, self));
+                });
+        return;
+    }
 
-            response_stream_.consume(chunk_sz);
+    // Responses with no body content still need the headers
+    if (!first_response_write) {
+        first_response_write = true;
+        set_content_encoding();
 
-            // _MSG_INFO("(DEBUG) {} {} - Consumed {}/{} running {}", verb_, uri_, sz, response_stream_.size(), response_stream_.running());
+        arm_write_timeout();
+        boost::beast::http::async_write_header(stream_, *serializer_,
+                [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
+                    if (ec)
+                        return self->finish(false);
 
-            if (error == boost::beast::http::error::need_buffer) {
-                // Beast returns 'need_buffer' when it's completed writing a buffer, configure
-                // as a non-error
-                error = {};
-            } else if (error) {
-                // _MSG_INFO("(DEBUG) {} {} - chunk write error {}", verb_, uri_, error.message());
-                response_stream_.cancel();
-                return do_close();
-            }
-        }
+                    self->write_response_last();
+                });
 
-        // If the buffer has any pending data, regardless of error or completeness,
-        // this will instantly return, otherwise it will stall waiting for it to be 
-        // populated
-        response_stream_.wait();
+        return;
     }
 
-    // _MSG_INFO("(DEBUG) {} {} - Out of buffer poll loop, remaining {}, running {}", verb_, uri_, response_stream_.size(), response_stream_.running());
+    write_response_last();
+}
 
-    // Send the completion record for the chunked response
-    response.body().data = nullptr;
-    response.body().size = 0;
-    response.body().more = false;
+void kis_net_beast_httpd_connection::write_response_chunks() {
+    // Gather everything pending in the buffer into a single vectored chunk
+    // write instead of a chunk per buffered block
+    std::vector<std::pair<const char *, size_t>> pending_chunks;
+    std::vector<boost::asio::const_buffer> write_buffers;
 
-    boost::beast::http::write(stream_, sr, error);
+    auto chunk_sz = response_stream_.get_chunks(pending_chunks, 1024 * 1024);
 
-    if (error) {
-        // _MSG_INFO("(DEBUG) {} {} - Error writing conclusion of stream: {}", verb_, uri_, error.message());
-        return do_close();
-    }
+    for (const auto& c : pending_chunks)
+        write_buffers.emplace_back(c.first, c.second);
 
-    if (client_req_close)
-        return do_close();
+    arm_write_timeout();
+    boost::asio::async_write(stream_, boost::beast::http::make_chunk(write_buffers),
+            [self = shared_from_this(), chunk_sz](boost::beast::error_code ec, std::size_t) {
+                self->response_stream_.consume(chunk_sz);
+
+                if (ec) {
+                    self->response_stream_.cancel();
+                    return self->finish(false);
+                }
+
+                self->pump_response();
+            });
+}
+
+void kis_net_beast_httpd_connection::write_response_last() {
+    // Send the completion record for the chunked response
+    arm_write_timeout();
+    boost::asio::async_write(stream_, boost::beast::http::make_chunk_last(),
+            [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
+                self->finish(!ec && !self->client_req_close_);
+            });
+}
+
+void kis_net_beast_httpd_connection::finish(bool keep_alive) {
+    if (!keep_alive)
+        do_close();
 
-    return true;
+    auto cb = std::move(complete_cb_);
+    complete_cb_ = nullptr;
+
+    if (cb != nullptr)
+        cb(keep_alive);
 }
 
-bool kis_net_beast_httpd_connection::do_close() {
+void kis_net_beast_httpd_connection::do_close() {
     if (closure_cb) {
         closure_cb();
         closure_cb = nullptr;
     }
 
-    try {
-        stream_.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_send);
-    } catch (const std::exception& e) {
-        ;
-    }
-
-    return false;
+    boost::system::error_code ec;
+    stream_.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_send, ec);
 }
 
 
@@ -1652,20 +2489,13 @@ kis_net_beast_route::kis_net_beast_route(const std::string& route,
     verbs_{verbs},
     login_{login},
     roles_{roles},
+    stream_body_{false},
     match_types{false} {
 
-    // Generate the keys list
-    for (auto i = std::sregex_token_iterator(route.begin(), route.end(), path_re); 
-            i != std::sregex_token_iterator(); i++) {
-        match_keys.push_back(static_cast<std::string>(*i));
-    }
+    parse_route();
+    compute_role_mask();
 
     match_keys.push_back("GETVARS");
-
-    // Generate the extractor expressions
-    auto ext_str = std::regex_replace(route, path_re, path_capture_pattern);
-    // Match the RE + http variables
-    match_re = std::regex(fmt::format("^{}(\\?.*?)?$", ext_str));
 }
 
 kis_net_beast_route::kis_net_beast_route(const std::string& route, 
@@ -1677,73 +2507,56 @@ kis_net_beast_route::kis_net_beast_route(const std::string& route,
     verbs_{verbs},
     login_{login},
     roles_{roles},
-    match_types{true} {
+    stream_body_{false},
+    match_types{true},
+    extensions_{extensions.begin(), extensions.end()} {
 
-    // Generate the keys list
-    for (auto i = std::sregex_token_iterator(route.begin(), route.end(), path_re); 
-            i != std::sregex_token_iterator(); i++) {
-        match_keys.push_back(static_cast<std::string>(*i));
-    }
+    parse_route();
+    compute_role_mask();
 
     match_keys.push_back("FILETYPE");
     match_keys.push_back("GETVARS");
+}
 
-    // Generate the file type regex
-    auto ft_regex = std::string("\\.(");
-    if (extensions.size() == 0) {
-        // If passed an empty list we accept all types and resolve during serialization
-        ft_regex += "[A-Za-z0-9]+";
-    } else {
-        bool prepend_pipe = false;
-        for (const auto& i : extensions) {
-            if (prepend_pipe)
-                ft_regex += fmt::format("|{}", i);
-            else
-                ft_regex += fmt::format("{}", i);
-            prepend_pipe = true;
-        }
-    }
-    ft_regex += ")";
+void kis_net_beast_route::parse_route() {
+    std::string::size_type pos = 0;
 
-    // Generate the extractor expressions
-    auto ext_str = std::regex_replace(route, path_re, path_capture_pattern);
+    while (true) {
+        auto end = route_.find('/', pos);
+        auto seg = route_.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
 
-    // Match the RE + filetypes + http variables
-    match_re = std::regex(fmt::format("^{}{}(\\?.*?)?$", ext_str, ft_regex));
-}
+        // Keys keep their leading ':' in the uri params
+        if (seg.length() > 1 && seg[0] == ':') {
+            segments_.push_back(route_segment{seg, true});
+            match_keys.push_back(seg);
+        } else {
+            segments_.push_back(route_segment{seg, false});
+        }
 
-bool kis_net_beast_route::match_url(const std::string& url, 
-        kis_net_beast_httpd_connection::uri_param_t& uri_params,
-        kis_net_beast_httpd::http_var_map_t& uri_variables) {
+        if (end == std::string::npos)
+            break;
 
-    auto match_values = std::smatch();
+        pos = end + 1;
+    }
+}
 
-    if (!std::regex_match(url, match_values, match_re)) 
+bool kis_net_beast_route::match_extension(const boost::beast::string_view& ext) const {
+    if (ext.length() == 0)
         return false;
 
-    if (match_values.size() != match_keys.size() + 1) {
-        // _MSG_ERROR("(DEBUG) HTTP req {} didn't match enough elements, {} wanted {}", url, match_values.size(), match_keys.size());
-        return false;
+    // If passed an empty list we accept all types and resolve during serialization
+    if (extensions_.size() == 0) {
+        for (const auto& c : ext) 
+            if (!std::isalnum(static_cast<unsigned char>(c)))
+                return false;
+        return true;
     }
 
-    size_t key_num = 0;
-    bool first = true;
-    for (const auto& i : match_values) {
-        if (first) {
-            first = false;
-            continue;
-        }
-
-        if (key_num >= match_keys.size()) {
-            // _MSG_ERROR("(DEBUG) HTTP req {} matched more values than known keys in route, something is wrong key pos {}", url, key_num);
-            continue;
-        }
-
-        uri_params.emplace(std::make_pair(match_keys[key_num], static_cast<std::string>(i)));
-        key_num++;
-    }
+    for (const auto& e : extensions_)
+        if (ext == e)
+            return true;
 
-    return true;
+    return false;
 }
 
 bool kis_net_beast_route::match_verb(boost::beast::http::verb verb) {
@@ -1753,32 +2566,174 @@ bool kis_net_beast_route::match_verb(boost::beast::http::verb verb) {
     return false;
 }
 
-bool kis_net_beast_route::match_role(bool login, const std::string& role) {
-    if (login_ && !login)
-        return false;
-
-    bool valid = false;
-    bool any = false;
+void kis_net_beast_route::compute_role_mask() {
+    role_mask_ = 0;
+    any_role_ = false;
 
     for (const auto& r : roles_) {
         if (r == kis_net_beast_httpd::ANY_ROLE)
-            any = true;
-
-        constant_time_string_compare_ne compare;
+            any_role_ = true;
 
-        if (!compare(r, role))
-            valid = true;
+        role_mask_ |= kis_net_beast_httpd::role_bit(r);
     }
+}
+
+bool kis_net_beast_route::match_role(bool login, uint64_t role_bits, const std::string& role) const {
+    if (login_ && !login)
+        return false;
 
     // If the endpoint allows any role, always accept
-    if (any)
+    if (any_role_)
         return true;
 
     // If the supplied role is logon, it can do everything
-    if (role == kis_net_beast_httpd::LOGON_ROLE)
+    if (role_bits & kis_net_beast_httpd::LOGON_ROLE_BIT)
+        return true;
+
+    auto matched = role_bits & role_mask_;
+
+    if (matched & ~kis_net_beast_httpd::OVERFLOW_ROLE_BIT)
         return true;
 
-    return valid;
+    // Roles past the end of the bitmap share a bit and have to be compared by name
+    if (matched & kis_net_beast_httpd::OVERFLOW_ROLE_BIT) {
+        for (const auto& r : roles_) {
+            if (r == role)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool kis_net_beast_route::match_role(bool login, const std::string& role) {
+    return match_role(login, kis_net_beast_httpd::role_bit(role), role);
+}
+
+kis_net_beast_route_table::kis_net_beast_route_table(const std::vector<std::shared_ptr<kis_net_beast_route>>& routes) :
+    routes_{routes} {
+
+    for (size_t r = 0; r < routes_.size(); r++) {
+        auto node = &root_;
+
+        for (const auto& s : routes_[r]->segments_) {
+            auto& child = s.is_key ? node->key_child : node->children[s.segment];
+
+            if (child == nullptr)
+                child.reset(new route_node());
+
+            node = child.get();
+        }
+
+        if (routes_[r]->match_types)
+            node->typed_routes.push_back(r);
+        else
+            node->exact_routes.push_back(r);
+    }
+}
+
+std::shared_ptr<kis_net_beast_route> kis_net_beast_route_table::match(boost::beast::string_view url,
+        kis_net_beast_httpd_connection::uri_param_t& uri_params) const {
+
+    boost::beast::string_view getvars;
+
+    auto q_pos = url.find('?');
+    if (q_pos != boost::beast::string_view::npos) {
+        getvars = url.substr(q_pos);
+        url = url.substr(0, q_pos);
+    }
+
+    std::vector<boost::beast::string_view> path;
+
+    while (true) {
+        auto end = url.find('/');
+
+        if (end == boost::beast::string_view::npos) {
+            path.push_back(url);
+            break;
+        }
+
+        path.push_back(url.substr(0, end));
+        url.remove_prefix(end + 1);
+    }
+
+    std::vector<boost::beast::string_view> keys;
+    route_match best{routes_.size(), {}, {}};
+
+    search(&root_, path, 0, keys, best);
+
+    if (best.route_num >= routes_.size())
+        return nullptr;
+
+    const auto& route = routes_[best.route_num];
+
+    for (size_t k = 0; k < best.keys.size(); k++)
+        uri_params.emplace(std::make_pair(route->match_keys[k], static_cast<std::string>(best.keys[k])));
+
+    if (route->match_types)
+        uri_params.emplace(std::make_pair("FILETYPE", static_cast<std::string>(best.filetype)));
+
+    uri_params.emplace(std::make_pair("GETVARS", static_cast<std::string>(getvars)));
+
+    return route;
+}
+
+void kis_net_beast_route_table::search(const route_node *node, 
+        const std::vector<boost::beast::string_view>& path, size_t pos,
+        std::vector<boost::beast::string_view>& keys, route_match& best) const {
+
+    auto seg = path[pos];
+
+    if (pos + 1 < path.size()) {
+        auto c = node->children.find(static_cast<std::string>(seg));
+        if (c != node->children.end())
+            search(c->second.get(), path, pos + 1, keys, best);
+
+        if (node->key_child != nullptr && seg.length() > 0) {
+            keys.push_back(seg);
+            search(node->key_child.get(), path, pos + 1, keys, best);
+            keys.pop_back();
+        }
+
+        return;
+    }
+
+    // The final segment matches routes with no file type as-is, and routes with
+    // a file type when split at any '.' into a name and type
+    search_last(node, seg, {}, false, keys, best);
+
+    for (auto d = seg.find('.'); d != boost::beast::string_view::npos; d = seg.find('.', d + 1))
+        search_last(node, seg.substr(0, d), seg.substr(d + 1), true, keys, best);
+}
+
+void kis_net_beast_route_table::search_last(const route_node *node, 
+        boost::beast::string_view segment, boost::beast::string_view filetype, bool typed,
+        std::vector<boost::beast::string_view>& keys, route_match& best) const {
+
+    auto check = [&](const route_node *child, bool key) {
+        for (auto r : typed ? child->typed_routes : child->exact_routes) {
+            // Route lists are in registration order
+            if (r >= best.route_num)
+                break;
+
+            if (typed && !routes_[r]->match_extension(filetype))
+                continue;
+
+            best.route_num = r;
+            best.keys = keys;
+            if (key)
+                best.keys.push_back(segment);
+            best.filetype = filetype;
+            break;
+        }
+    };
+
+    auto c = node->children.find(static_cast<std::string>(segment));
+    if (c != node->children.end())
+        check(c->second.get(), false);
+
+    if (node->key_child != nullptr && segment.length() > 0)
+        check(node->key_child.get(), true);
 }
 
 void kis_net_beast_route::invoke(std::shared_ptr<kis_net_beast_httpd_connection> connection) {
@@ -1791,6 +2746,7 @@ kis_net_beast_auth::kis_net_beast_auth(const nlohmann::json& json)  {
         token_ = json["token"].get<std::string>();
         name_ = json["name"].get<std::string>();
         role_ = json["role"].get<std::string>();
+        role_bits_ = kis_net_beast_httpd::role_bit(role_);
         time_created_ = static_cast<time_t>(json["created"].get<unsigned int>());
         time_accessed_ = static_cast<time_t>(json["accessed"].get<unsigned int>());
         time_expires_ = static_cast<time_t>(json["expires"].get<unsigned int>());
@@ -1805,6 +2761,7 @@ kis_net_beast_auth::kis_net_beast_auth(const std::string& token, const std::stri
     token_{token},
     name_{name},
     role_{role},
+    role_bits_{kis_net_beast_httpd::role_bit(role)},
     time_created_{time(0)},
     time_accessed_{0},
     time_expires_{0} { }
@@ -1814,6 +2771,7 @@ kis_net_beast_auth::kis_net_beast_auth(const jwt::decoded_jwt<jwt::traits::kazuh
         token_ = "jwt";
         name_ = jwt.get_payload_claim("name").as_string();
         role_ = jwt.get_payload_claim("role").as_string();
+        role_bits_ = kis_net_beast_httpd::role_bit(role_);
         time_created_ = static_cast<time_t>(jwt.get_payload_claim("created").as_number());
         time_expires_ = static_cast<time_t>(jwt.get_payload_claim("expires").as_number());
     } catch (...) {
@@ -1888,6 +2846,138 @@ void kis_net_web_tracked_endpoint::handle_request(std::shared_ptr<kis_net_beast_
     }
 }
 
+std::string kis_net_web_cached_endpoint::cache_key(std::shared_ptr<kis_net_beast_httpd_connection> con) {
+    auto key = fmt::format("{}\n{}\n{}\n", con->login_valid() ? con->login_role() : "",
+            con->verb(), con->uri());
+
+    // Variables are unordered; sort them so that equivalent requests share an entry.  Login
+    // variables are skipped, the role already covers what the client may see.
+    std::vector<std::pair<std::string, std::string>> vars;
+
+    for (const auto& v : con->http_variables()) {
+        if (v.first == kis_net_beast_httpd::AUTH_COOKIE || v.first == "user" || v.first == "password")
+            continue;
+
+        vars.push_back(v);
+    }
+
+    std::sort(vars.begin(), vars.end());
+
+    for (const auto& v : vars)
+        key += fmt::format("{}={}\n", v.first, v.second);
+
+    key += con->request().body();
+
+    return key;
+}
+
+void kis_net_web_cached_endpoint::send_cached(std::shared_ptr<kis_net_beast_httpd_connection> con,
+        std::shared_ptr<const cached_response> response) {
+    con->set_status(response->status);
+
+    if (response->content_type.length())
+        con->set_mime_type(response->content_type);
+
+    if (response->disposition.length())
+        con->append_header("Content-Disposition", response->disposition);
+
+    std::ostream os(&con->response_stream());
+    os.write(response->content.data(), response->content.size());
+    os.flush();
+}
+
+void kis_net_web_cached_endpoint::handle_request(std::shared_ptr<kis_net_beast_httpd_connection> con) {
+    auto key = cache_key(con);
+    auto version = version_func != nullptr ? version_func() : 0;
+    auto now = std::chrono::steady_clock::now();
+
+    std::promise<std::shared_ptr<const cached_response>> generate_pr;
+    std::shared_future<std::shared_ptr<const cached_response>> response_ft;
+    bool generate = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(cache_mutex);
+
+        auto k = cache.find(key);
+
+        if (k != cache.end() && (k->second.pending || 
+                    (k->second.expires > now && k->second.version == version))) {
+            response_ft = k->second.response;
+        } else {
+            // Drop stale entries so that varied requests don't accumulate
+            for (auto i = cache.begin(); i != cache.end(); ) {
+                if (!i->second.pending && i->second.expires <= now)
+                    i = cache.erase(i);
+                else
+                    ++i;
+            }
+
+            generate = true;
+            response_ft = generate_pr.get_future().share();
+
+            auto& entry = cache[key];
+            entry.response = response_ft;
+            entry.pending = true;
+            entry.version = version;
+        }
+    }
+
+    if (!generate) {
+        auto response = response_ft.get();
+
+        if (response != nullptr)
+            return send_cached(con, response);
+
+        // The response wasn't cacheable; generate our own
+        return endpoint->handle_request(con);
+    }
+
+    auto content = std::string{};
+    std::shared_ptr<cached_response> response;
+
+    con->response_stream().set_capture(&content);
+
+    try {
+        endpoint->handle_request(con);
+    } catch (...) {
+        con->response_stream().set_capture(nullptr);
+
+        {
+            const std::lock_guard<std::mutex> lock(cache_mutex);
+            cache.erase(key);
+        }
+
+        generate_pr.set_value(nullptr);
+        throw;
+    }
+
+    con->response_stream().set_capture(nullptr);
+
+    if (con->response.result_int() == 200 && !con->response_stream().packetmode()) {
+        response = std::make_shared<cached_response>();
+        response->content = std::move(content);
+        response->status = 200;
+        response->content_type = 
+            static_cast<std::string>(con->response[boost::beast::http::field::content_type]);
+        response->disposition = 
+            static_cast<std::string>(con->response[boost::beast::http::field::content_disposition]);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(cache_mutex);
+
+        if (response != nullptr) {
+            auto& entry = cache[key];
+            entry.pending = false;
+            entry.expires = std::chrono::steady_clock::now() + ttl;
+        } else {
+            cache.erase(key);
+        }
+    }
+
+    generate_pr.set_value(response);
+}
+
 void kis_net_web_function_endpoint::handle_request(std::shared_ptr<kis_net_beast_httpd_connection> con) {
     kis_unique_lock<kis_mutex> lk(mutex, std::defer_lock, "function endpoint");
 
@@ -1917,7 +3007,9 @@ void kis_net_web_function_endpoint::handle_request(std::shared_ptr<kis_net_beast
 
 
 void kis_net_web_websocket_endpoint::close() {
-    close_impl();
+    boost::asio::post(strand_,
+            boost::beast::bind_front_handler(&kis_net_web_websocket_endpoint::close_impl,
+                shared_from_this()));
 }
 
 void kis_net_web_websocket_endpoint::close_impl() {
@@ -1927,11 +3019,21 @@ void kis_net_web_websocket_endpoint::close_impl() {
         ws_.next_layer().socket().shutdown(boost::asio::ip::tcp::socket::shutdown_send);
     } catch (...) { } 
 
-    try {
-        running_promise.set_value();
-    } catch (const std::future_error& e) {
-        // If somehow we already pulled the future, fail silently
-    }
+    if (closed_)
+        return;
+
+    closed_ = true;
+
+    auto httpd = Globalreg::fetch_global_as<kis_net_beast_httpd>();
+    if (httpd != nullptr)
+        httpd->remove_websocket(this);
+
+    // Drop the closure once it has run; it usually holds the listeners which hold us
+    auto cb = std::move(closure_cb);
+    closure_cb = nullptr;
+
+    if (cb != nullptr)
+        cb();
 }
 
 void kis_net_web_websocket_endpoint::start_read(std::shared_ptr<kis_net_web_websocket_endpoint> ref) {
@@ -1972,33 +3074,87 @@ void kis_net_web_websocket_endpoint::handle_read(boost::beast::error_code ec, st
     }
 }
 
-void kis_net_web_websocket_endpoint::on_write(const std::string& msg) {
+void kis_net_web_websocket_endpoint::on_write(const ws_message& msg) {
     if (!running || !ws_.is_open())
         return;
 
-    ws_write_queue_.push(msg);
+    // The front message is on the wire while writing and can't be replaced or dropped
+    auto first = ws_write_queue_.begin();
+    if (writing_ && first != ws_write_queue_.end())
+        ++first;
+
+    if (msg.coalesce_key.length() > 0) {
+        for (auto i = first; i != ws_write_queue_.end(); ++i) {
+            if (i->coalesce_key == msg.coalesce_key) {
+                queue_bytes_ += msg.data->size();
+                queue_bytes_ -= i->data->size();
+                i->data = msg.data;
+                ++n_coalesced_;
+                return;
+            }
+        }
+    }
+
+    if (max_queue_ > 0 && first != ws_write_queue_.end() &&
+            static_cast<size_t>(ws_write_queue_.end() - first) >= max_queue_) {
+        queue_bytes_ -= first->data->size();
+        ws_write_queue_.erase(first);
+        ++n_dropped_;
+    }
+
+    ws_write_queue_.push_back(msg);
+    queue_bytes_ += msg.data->size();
+    ++n_queued_;
+    update_queue_stats();
 
-    // _MSG_DEBUG("ws {} write len {} queue {}", fmt::ptr(this), msg.size(), ws_write_queue_.size());
+    // _MSG_DEBUG("ws {} write len {} queue {}", fmt::ptr(this), msg.data->size(), ws_write_queue_.size());
 
-    if (ws_write_queue_.size() > 1)
+    if (writing_)
         return;
 
-    boost::asio::post(strand_,
-            [self = shared_from_this()]() {
-                self->handle_write();
-            });
+    handle_write();
+}
+
+// queue_bytes_ is kept as messages are added and removed; this only refreshes what can be
+// read off the ends of the queue
+void kis_net_web_websocket_endpoint::update_queue_stats() {
+    queue_depth_ = ws_write_queue_.size();
+
+    if (ws_write_queue_.empty())
+        oldest_queued_ = 0;
+    else
+        oldest_queued_ = ws_write_queue_.front().queued.time_since_epoch().count();
+}
+
+std::chrono::milliseconds kis_net_web_websocket_endpoint::lag() const {
+    auto oldest = oldest_queued_.load();
+
+    if (oldest == 0)
+        return std::chrono::milliseconds(0);
+
+    auto queued = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(oldest));
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - queued);
 }
 
 void kis_net_web_websocket_endpoint::handle_write() {
     if (!running || !ws_.is_open() || ws_write_queue_.empty()) {
+        writing_ = false;
         return;
     }
 
-    ws_.async_write(boost::asio::buffer(ws_write_queue_.front()),
+    writing_ = true;
+
+    // Hold the buffer for the duration of the write; other sockets may share it
+    auto data = ws_write_queue_.front().data;
+
+    ws_.async_write(boost::asio::buffer(*data),
             boost::asio::bind_executor(
                 strand_,
                 std::bind(
-                    [self = shared_from_this()](const boost::system::error_code& ec, std::size_t) {
+                    [self = shared_from_this(), data](const boost::system::error_code& ec, std::size_t) {
+                        self->writing_ = false;
+
                         if (ec) {
                             if (ec != boost::beast::websocket::error::closed) {
                                 _MSG_ERROR("Websocket error: {}", ec.message());
@@ -2007,7 +3163,10 @@ void kis_net_web_websocket_endpoint::handle_write() {
                             return self->close_impl();
                         }
 
-                        self->ws_write_queue_.pop();
+                        self->queue_bytes_ -= self->ws_write_queue_.front().data->size();
+                        self->ws_write_queue_.pop_front();
+                        ++self->n_sent_;
+                        self->update_queue_stats();
 
                         if (!self->ws_write_queue_.empty()) {
                             return self->handle_write();
@@ -2020,22 +3179,33 @@ void kis_net_web_websocket_endpoint::handle_write() {
 
 void kis_net_web_websocket_endpoint::handle_request(std::shared_ptr<kis_net_beast_httpd_connection> con) {
     // _MSG_DEBUG("websocket {} - {}", fmt::ptr(this), con->uri());
-    thread_set_process_name("BEAST-WS");
 
     // Set the default timeouts
     ws_.set_option(boost::beast::websocket::stream_base::timeout::suggested(
                 boost::beast::role_type::server));
 
-    ws_.accept(con->request());
+    uri_ = static_cast<std::string>(con->uri());
+
+    boost::system::error_code ec;
+    auto remote = ws_.next_layer().socket().remote_endpoint(ec);
+    if (!ec)
+        remote_ = remote.address().to_string();
 
     running = true;
 
-    auto running_future = running_promise.get_future();
+    auto httpd = Globalreg::fetch_mandatory_global_as<kis_net_beast_httpd>();
+    httpd->register_websocket(shared_from_this());
 
-    // Launch an async read loop
-    start_read(shared_from_this());
+    // The handshake and the read loop it starts hold a reference to us, so the handler can
+    // return; the connection is held until the handshake has been built from its request
+    ws_.async_accept(con->request(),
+            boost::asio::bind_executor(
+                strand_,
+                [self = shared_from_this(), con](const boost::system::error_code& ec) {
+                    if (ec)
+                        return self->close_impl();
 
-    // That will eventually complete this future
-    running_future.wait();
+                    self->start_read(self);
+                }));
 }
 
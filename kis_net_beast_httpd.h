@@ -22,7 +22,12 @@
 #include "config.h"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <list>
+#include <mutex>
 #include <regex>
 #include <string>
 #include <thread>
@@ -50,9 +55,48 @@ template <>struct fmt::formatter<boost::beast::http::verb> : fmt::ostream_format
 template <>struct fmt::formatter<boost::beast::string_view> : fmt::ostream_formatter {};
 
 class kis_net_beast_httpd_connection;
+class kis_net_beast_httpd_session;
 class kis_net_beast_route;
+class kis_net_beast_route_table;
 class kis_net_beast_auth;
 class kis_net_web_endpoint;
+class kis_net_web_websocket_endpoint;
+
+// Bounded pool of threads which run endpoint handlers.  Socket IO is handled asynchronously
+// by the io_context threads; only the request handlers themselves, which may block on
+// locks or do heavy serialization, run here.
+//
+// Handlers which are going to block for the life of a stream call 
+// release_current(); the calling thread leaves the pool once its handler returns and a 
+// replacement worker is started, so long-running streams can't starve normal requests.
+class kis_net_beast_handler_pool : public std::enable_shared_from_this<kis_net_beast_handler_pool> {
+public:
+    kis_net_beast_handler_pool(unsigned int n_threads);
+
+    void start();
+    void stop();
+
+    void post(std::function<void ()> task);
+
+    // Release the calling thread from its pool, if it is a pool worker
+    static void release_current();
+
+    unsigned int n_threads() const { return n_threads_; }
+
+protected:
+    void spawn_worker();
+    void worker_loop();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void ()>> task_queue_;
+
+    unsigned int n_threads_;
+    bool running_;
+
+    static thread_local kis_net_beast_handler_pool *current_pool_;
+    static thread_local bool released_;
+};
 
 class kis_net_beast_httpd : public lifetime_global, public deferred_startup,
     public std::enable_shared_from_this<kis_net_beast_httpd> {
@@ -70,6 +114,13 @@ public:
     const static std::string RO_ROLE;
     const static std::string AUTH_COOKIE;
 
+    // Roles are interned to a permission bit so that routes can be checked with a mask; the
+    // logon role is always the first bit.  Once the bits are exhausted additional roles share
+    // the overflow bit and are compared by name.
+    const static uint64_t LOGON_ROLE_BIT;
+    const static uint64_t OVERFLOW_ROLE_BIT;
+    static uint64_t role_bit(const std::string& role);
+
 
 private:
     kis_net_beast_httpd(boost::asio::ip::tcp::endpoint& endpoint);
@@ -81,6 +132,10 @@ public:
     int stop_httpd();
 
     bool httpd_running() { return running; }
+    std::shared_ptr<kis_net_beast_handler_pool> handler_pool() { return handler_pool_; }
+    int compress_level() const { return compress_level_; }
+    size_t websocket_queue_max() const { return websocket_queue_max_; }
+    size_t bulk_body_limit() const { return bulk_body_limit_; }
     unsigned int fetch_port() { return port; }
     bool fetch_using_ssl() { return use_ssl; }
 
@@ -111,6 +166,13 @@ public:
             std::shared_ptr<kis_net_web_endpoint> handler);
     void remove_route(const std::string& route);
 
+    // Bulk routes accept large POST bodies, such as lists of thousands of devices.  The body
+    // is streamed to the handler as it arrives and JSON bodies are parsed incrementally, 
+    // instead of being buffered in full before the request is dispatched.
+    void register_bulk_route(const std::string& route, const std::list<std::string>& verbs, 
+            const std::string& role, const std::list<std::string>& extensions, 
+            std::shared_ptr<kis_net_web_endpoint> handler);
+
     // These routes do NOT require authentication; this is of course very dangerous and should
     // be limited to those endpoints used for logging in, etc
     void register_unauth_route(const std::string& route, const std::list<std::string>& verbs, 
@@ -142,10 +204,16 @@ public:
     void load_auth();
     void store_auth();
 
+    // Token checks do not take the auth lock; session tokens are found in a published 
+    // snapshot and verified JWTs are cached per thread
     std::shared_ptr<kis_net_beast_auth> check_auth_token(const boost::beast::string_view& token);
     std::shared_ptr<kis_net_beast_auth> check_jwt_token(const boost::beast::string_view& token);
     bool check_admin_login(const std::string& username, const std::string& password);
 
+    // Track open websockets for the queue metrics endpoint
+    void register_websocket(std::shared_ptr<kis_net_web_websocket_endpoint> ws);
+    void remove_websocket(kis_net_web_websocket_endpoint *ws);
+
 
     // Map a content directory into the virtual paths.  This is NOT THREAD SAFE and must not be
     // called concurrently or while the webserver is serving content.
@@ -156,6 +224,8 @@ public:
     std::shared_ptr<kis_net_beast_route> find_endpoint(std::shared_ptr<kis_net_beast_httpd_connection> con);
     // Find a websocket endpoint in the route table
     std::shared_ptr<kis_net_beast_route> find_websocket_endpoint(std::shared_ptr<kis_net_beast_httpd_connection> con);
+    // Does a request header target a bulk route, which should have its body streamed
+    bool streams_request_body(const boost::beast::http::request_header<>& header);
 
 
     const bool& allow_cors() { return allow_cors_; }
@@ -187,9 +257,29 @@ protected:
     std::vector<std::shared_ptr<kis_net_beast_route>> route_vec;
     std::vector<std::shared_ptr<kis_net_beast_route>> websocket_route_vec;
 
+    // Compiled snapshots of the route vectors; replaced under route_mutex whenever the
+    // routes change and read with atomic_load, so lookups never take the route lock
+    std::shared_ptr<const kis_net_beast_route_table> route_table_;
+    std::shared_ptr<const kis_net_beast_route_table> websocket_route_table_;
+
+    // Recompile the route tables; route_mutex must be held
+    void rebuild_route_tables();
+
     kis_mutex auth_mutex;
     std::vector<std::shared_ptr<kis_net_beast_auth>> auth_vec;
 
+    // Snapshot of the session tokens keyed by token hash, replaced under auth_mutex whenever
+    // auth_vec changes and read with atomic_load.  Auth records in the snapshot are never 
+    // modified; changes replace the record.
+    using auth_token_map_t = std::unordered_multimap<size_t, std::shared_ptr<kis_net_beast_auth>>;
+    std::shared_ptr<const auth_token_map_t> auth_tokens_;
+
+    // Republish the token snapshot; auth_mutex must be held
+    void rebuild_auth_tokens();
+
+    // Verified JWTs are reused for this long before being checked again
+    const static time_t jwt_cache_ttl = 300;
+
     class static_content_dir {
     public:
         static_content_dir(const std::string& prefix, const std::string& path) :
@@ -201,10 +291,68 @@ protected:
     };
     std::vector<static_content_dir> static_dir_vec;
 
+    // Static files are cached in memory on first request and revalidated against the
+    // file on disk by mtime and size.  Compressible types carry a gzip copy, and a brotli
+    // or gzip file shipped alongside the original (file.js.br, file.js.gz) is used as-is.
+    // Files which could never fit in the cache are streamed from disk; when the cache is full
+    // the least recently used assets are evicted to make room.
+    class static_asset {
+    public:
+        std::string path;
+        time_t mtime;
+        off_t size;
+        std::string last_modified;
+
+        // Entity tags for each encoding; cached assets use a strong tag derived from the
+        // content, streamed files a weak tag from the mtime and size
+        std::string etag;
+        std::string gzip_etag;
+        std::string brotli_etag;
+
+        std::shared_ptr<const std::string> identity;
+        std::shared_ptr<const std::string> gzip;
+        std::shared_ptr<const std::string> brotli;
+
+        size_t cached_sz() const {
+            return (identity ? identity->size() : 0) + (gzip ? gzip->size() : 0) +
+                (brotli ? brotli->size() : 0);
+        }
+    };
+
+    struct static_cache_entry {
+        std::shared_ptr<static_asset> asset;
+        std::list<std::string>::iterator lru_pos;
+    };
+
+    kis_mutex static_cache_mutex;
+    std::unordered_map<std::string, static_cache_entry> static_cache;
+    // Cached paths, most recently used first
+    std::list<std::string> static_cache_lru;
+    size_t static_cache_sz;
+    size_t static_cache_max;
+    std::string static_cache_control;
+
+    // gzip level for compressing text responses, 0 to disable
+    int compress_level_;
+
+    // Default bound for websocket subscribers which opt into a bounded queue
+    size_t websocket_queue_max_;
+
+    // Maximum size of a streamed bulk request body
+    size_t bulk_body_limit_;
+
+    kis_mutex websocket_mutex;
+    std::list<std::weak_ptr<kis_net_web_websocket_endpoint>> websocket_list;
+
+    std::shared_ptr<static_asset> find_static_asset(const std::string& path, const std::string& base);
+    void send_static_asset(std::shared_ptr<kis_net_beast_httpd_connection> con, 
+            std::shared_ptr<static_asset> asset, const std::string& uri);
+
 
     boost::asio::ip::tcp::endpoint endpoint;
     boost::asio::ip::tcp::acceptor acceptor;
 
+    std::shared_ptr<kis_net_beast_handler_pool> handler_pool_;
 
     void start_accept();
     void handle_connection(const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket);
@@ -237,10 +385,69 @@ protected:
 
 
 
-// Central entity which tracks everything about a connection, parsed variables, generator thread, etc.
+// A client socket; reads requests asynchronously on the socket strand and hands each one
+// to a kis_net_beast_httpd_connection on the handler pool, then resumes reading once the
+// response has been written if the connection is being kept alive.
+// Requests are read header first.  Most requests then read the complete body before the 
+// handler is dispatched; requests for bulk routes are dispatched as soon as the header 
+// arrives and, once the handler has authorized them, the body is fed to the handler as 
+// it is read.
+//
+// Requests are handled one at a time in the order they arrive; pipelined requests wait in
+// the read buffer and the next request is parsed once the previous response has been 
+// written (and, for streamed bodies, the body fully read).
+class kis_net_beast_httpd_session : public std::enable_shared_from_this<kis_net_beast_httpd_session> {
+public:
+    kis_net_beast_httpd_session(boost::asio::ip::tcp::socket&& socket,
+            std::shared_ptr<kis_net_beast_httpd> httpd);
+
+    void start();
+
+protected:
+    void do_read();
+    void on_header(boost::beast::error_code ec, std::size_t);
+    void on_read(boost::beast::error_code ec, std::size_t);
+    void start_read_body();
+    void do_read_body();
+    void on_read_body(boost::beast::error_code ec, std::size_t);
+    void on_complete(bool keep_alive);
+    void maybe_next_request();
+    void do_close();
+
+    void dispatch(std::shared_ptr<kis_net_beast_httpd_connection> con);
+
+    // Body limit for requests which aren't streamed, and for streamed bodies until the
+    // request is authorized
+    static constexpr size_t body_limit = 100000;
+
+    // Streamed bodies are read no further ahead of the handler than this
+    static constexpr size_t body_buffer_max = 1024 * 1024;
+
+    std::shared_ptr<kis_net_beast_httpd> httpd;
+
+    boost::beast::tcp_stream stream_;
+    boost::beast::flat_buffer buffer_;
+
+    boost::optional<boost::beast::http::request_parser<boost::beast::http::empty_body>> header_parser_;
+    boost::optional<boost::beast::http::request_parser<boost::beast::http::string_body>> parser_;
+
+    // Streamed body state; only touched on the socket strand
+    boost::optional<boost::beast::http::request_parser<boost::beast::http::buffer_body>> body_parser_;
+    std::shared_ptr<future_chainbuf> body_stream_;
+    std::vector<char> body_buf_;
+    bool body_done_;
+    bool body_failed_;
+    bool body_reading_;
+    bool response_done_;
+    bool keep_alive_;
+};
+
+// Central entity which tracks everything about a request, parsed variables, response stream, etc.
 class kis_net_beast_httpd_connection : public std::enable_shared_from_this<kis_net_beast_httpd_connection> {
 public:
     friend class kis_net_beast_httpd;
+    friend class kis_net_beast_httpd_session;
+    friend class kis_net_web_cached_endpoint;
 
     kis_net_beast_httpd_connection(boost::beast::tcp_stream& stream,
             std::shared_ptr<kis_net_beast_httpd> httpd);
@@ -248,7 +455,10 @@ public:
 
     using uri_param_t = std::unordered_map<std::string, std::string>;
 
-    bool start();
+    // Process the request; called on the handler pool.  complete_cb is called from the
+    // socket strand once the response has been written, with whether the socket can be
+    // reused for another request.
+    void start(std::function<void (bool)> complete_cb);
 
     boost::beast::http::request<boost::beast::http::string_body>& request() { return request_; }
     boost::beast::http::verb& verb() { return verb_; }
@@ -265,6 +475,7 @@ public:
     // Login validity
     bool login_valid() const { return login_valid_; }
     const std::string& login_role() const { return login_role_; }
+    uint64_t login_role_bits() const { return login_role_bits_; }
 
     // These may be set by the endpoint handler prior to the first writing of data; once the
     // first block of the response has been sent, it is too late to include these and they will 
@@ -285,6 +496,11 @@ public:
     kis_net_beast_httpd::http_cookie_map_t& cookies() { return cookies_; }
     nlohmann::json& json() { return json_; }
 
+    // Give up the handler pool thread running this request; endpoints which block for a long
+    // time (streams, proxied requests, websockets) call this so they don't starve the pool.
+    // Clearing the timeout implies the request is long-running and releases the thread.
+    void release_handler();
+
     // Optional closure callback to signal to an async operation that there's a problem (for example
     // long-running packet streams)
     void set_closure_cb(std::function<void ()> cb) {
@@ -299,27 +515,43 @@ protected:
     std::shared_ptr<kis_net_beast_httpd> httpd;
 
     std::function<void ()> closure_cb;
+    std::function<void (bool)> complete_cb_;
 
     boost::beast::tcp_stream& stream_;
-    boost::beast::flat_buffer buffer;
 
-    boost::optional<boost::beast::http::request_parser<boost::beast::http::string_body>> parser_;
     boost::beast::http::request<boost::beast::http::string_body> request_;
 
     boost::beast::http::response<boost::beast::http::buffer_body> response;
+    boost::optional<boost::beast::http::response_serializer<boost::beast::http::buffer_body,
+        boost::beast::http::fields>> serializer_;
     future_chainbuf response_stream_;
 
+    // Client asked for the connection to be closed after this request
+    bool client_req_close_;
+
+    // Long-running responses are exempt from the write timeout
+    std::atomic<bool> no_timeout_;
+
     // Request type
     boost::beast::http::verb verb_;
 
     // Login data
     bool login_valid_;
     std::string login_role_;
+    uint64_t login_role_bits_;
 
     kis_net_beast_httpd::http_var_map_t http_variables_;
+
+    // Body of a bulk request, streamed from the socket while the handler runs; the
+    // session doesn't read it until read_body_cb_ is called once the request is authorized
+    std::shared_ptr<future_chainbuf> request_body_;
+    std::function<void ()> read_body_cb_;
+    std::string streamed_post_;
+
     nlohmann::json json_;
     kis_net_beast_httpd::http_cookie_map_t cookies_;
     std::string auth_token_;
+    std::string trimmed_uri_;
     boost::beast::string_view uri_;
     uri_param_t uri_params_;
 
@@ -327,7 +559,34 @@ protected:
 
     std::atomic<bool> first_response_write;
 
-    bool do_close();
+    void do_close();
+
+    // Called on the strand once the response is finished or failed
+    void finish(bool keep_alive);
+
+    // Each write to the client has up to 30 seconds to complete unless the timeout
+    // has been cleared for a long-running response
+    void arm_write_timeout();
+
+    // Write the chunked response to the client as the handler produces it
+    void set_content_encoding();
+    void pump_response();
+    void write_response_chunks();
+    void write_response_last();
+
+    // Write a complete response and finish the request
+    template<class Body>
+    void send_response(std::shared_ptr<boost::beast::http::response<Body>> res, bool close) {
+        auto self = shared_from_this();
+
+        boost::asio::post(stream_.get_executor(), [self, res, close]() {
+            self->arm_write_timeout();
+            boost::beast::http::async_write(self->stream_, *res,
+                    [self, res, close](boost::beast::error_code ec, std::size_t) {
+                        self->finish(!ec && !close);
+                    });
+        });
+    }
 
     template<class Response>
     void append_common_headers(Response& r, boost::beast::string_view uri) {
@@ -514,6 +773,70 @@ protected:
     wrapper_func_t post_func;
 };
 
+// Caches the responses of another endpoint, for read-only endpoints which are polled by
+// many clients.  Identical requests - the same URI, variables, body, and login role - 
+// within the TTL are answered from the cache instead of being generated again, and 
+// identical requests which arrive while a response is being generated wait for it.
+//
+// An optional version function, such as a modification counter, invalidates cached 
+// responses as soon as it changes.  Only successful responses are cached.  This must not
+// be used for endpoints with side effects.
+class kis_net_web_cached_endpoint : public kis_net_web_endpoint {
+public:
+    using version_func_t = std::function<uint64_t ()>;
+
+    kis_net_web_cached_endpoint(std::shared_ptr<kis_net_web_endpoint> endpoint,
+            std::chrono::milliseconds ttl, version_func_t version_func = nullptr) :
+        kis_net_web_endpoint{},
+        endpoint{endpoint},
+        ttl{ttl},
+        version_func{version_func} { }
+
+    virtual ~kis_net_web_cached_endpoint() { }
+
+    virtual void handle_request(std::shared_ptr<kis_net_beast_httpd_connection> con) override;
+
+protected:
+    class cached_response {
+    public:
+        std::string content;
+        unsigned int status;
+        std::string content_type;
+        std::string disposition;
+    };
+
+    class cache_entry {
+    public:
+        std::shared_future<std::shared_ptr<const cached_response>> response;
+        bool pending;
+        uint64_t version;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    std::string cache_key(std::shared_ptr<kis_net_beast_httpd_connection> con);
+    void send_cached(std::shared_ptr<kis_net_beast_httpd_connection> con,
+            std::shared_ptr<const cached_response> response);
+
+    std::shared_ptr<kis_net_web_endpoint> endpoint;
+    std::chrono::milliseconds ttl;
+    version_func_t version_func;
+
+    std::mutex cache_mutex;
+    std::unordered_map<std::string, cache_entry> cache;
+};
+
+// Websocket endpoints queue outgoing messages as shared buffers, so a message serialized once
+// can be written to any number of subscribers without copying.
+//
+// By default the queue is unbounded, which is required for sockets carrying a protocol stream
+// (such as remote capture).  Subscribers which only need the most recent data can bound their
+// queue with set_queue_max(); when full, the oldest message which is not being written is
+// dropped.  Messages written with a coalesce key replace any waiting message with the same key,
+// so periodic state updates don't stack up behind a slow client.
+//
+// handle_request() starts the handshake and returns; the pending socket operations hold a
+// reference to the endpoint, which lives until the socket closes.  Anything feeding the socket
+// (event listeners, timers, packet handlers) should be released in the closure callback.
 class kis_net_web_websocket_endpoint : public kis_net_web_endpoint, 
     public std::enable_shared_from_this<kis_net_web_websocket_endpoint> {
 
@@ -530,26 +853,51 @@ public:
         kis_net_web_endpoint{},
         ws_{con->release_stream()},
 		strand_{Globalreg::globalreg->io},
-        handler_cb{handler_func} { }
+        handler_cb{handler_func},
+        running{false},
+        writing_{false},
+        max_queue_{0},
+        n_queued_{0},
+        n_sent_{0},
+        n_dropped_{0},
+        n_coalesced_{0},
+        queue_depth_{0},
+        queue_bytes_{0},
+        oldest_queued_{0},
+        closed_{false} { }
 
     virtual ~kis_net_web_websocket_endpoint() { }
 
     virtual void handle_request(std::shared_ptr<kis_net_beast_httpd_connection> con) override;
 
     void write(std::string data) {
-        boost::asio::post(strand_,
-                boost::beast::bind_front_handler(&kis_net_web_websocket_endpoint::on_write, 
-                    shared_from_this(), data));
+        write(std::make_shared<const std::string>(std::move(data)));
     }
 
     void write(const char *data, size_t len) {
+        write(std::make_shared<const std::string>(data, len));
+    }
+
+    void write(std::shared_ptr<const std::string> data, const std::string& coalesce_key = "") {
         boost::asio::post(strand_,
-                boost::beast::bind_front_handler(&kis_net_web_websocket_endpoint::on_write,
-                    shared_from_this(), std::string(data, len)));
+                boost::beast::bind_front_handler(&kis_net_web_websocket_endpoint::on_write, 
+                    shared_from_this(), 
+                    ws_message{data, coalesce_key, std::chrono::steady_clock::now()}));
     }
 
+    // Bound the number of messages waiting to be written; 0 is unbounded.  Must be set before
+    // handle_request.
+    void set_queue_max(size_t max) { max_queue_ = max; }
+
+    // Close the socket; safe to call from any thread, the close is run on the strand
     virtual void close();
 
+    // Called once, on the strand, when the socket closes for any reason.  Must be set before
+    // handle_request.
+    void set_closure_cb(std::function<void ()> cb) {
+        closure_cb = cb;
+    }
+
 	virtual void binary() {
 		ws_.binary(true);
 	}
@@ -560,29 +908,66 @@ public:
 
 	boost::asio::io_service::strand &strand() { return strand_; };
 
+    // Queue metrics, safe to read from any thread
+    const std::string& uri() const { return uri_; }
+    const std::string& remote() const { return remote_; }
+    size_t queue_max() const { return max_queue_; }
+    size_t queue_depth() const { return queue_depth_; }
+    size_t queue_bytes() const { return queue_bytes_; }
+    uint64_t queued() const { return n_queued_; }
+    uint64_t sent() const { return n_sent_; }
+    uint64_t dropped() const { return n_dropped_; }
+    uint64_t coalesced() const { return n_coalesced_; }
+
+    // How long the oldest queued message has been waiting
+    std::chrono::milliseconds lag() const;
+
 protected:
+    struct ws_message {
+        std::shared_ptr<const std::string> data;
+        std::string coalesce_key;
+        std::chrono::steady_clock::time_point queued;
+    };
+
     virtual void close_impl();
 
     virtual void start_read(std::shared_ptr<kis_net_web_websocket_endpoint> ref);
     void handle_read(boost::beast::error_code ec, std::size_t);
 
-    void on_write(const std::string& msg);
+    void on_write(const ws_message& msg);
     void handle_write();
+    void update_queue_stats();
 
     boost::beast::websocket::stream<boost::beast::tcp_stream> ws_;
 
     boost::beast::flat_buffer buffer_;
 	boost::asio::io_service::strand strand_;
 
-	std::queue<std::string, std::deque<std::string>> ws_write_queue_;
-
-    std::promise<void> handle_pr;
+    // Only touched on the strand; while writing_ is set the front message is on the wire
+	std::deque<ws_message> ws_write_queue_;
 
     handler_func_t handler_cb;
+    std::function<void ()> closure_cb;
 
     std::atomic<bool> running;
-    std::promise<void> running_promise;
 
+    bool writing_;
+    size_t max_queue_;
+
+    std::string uri_;
+    std::string remote_;
+
+    std::atomic<uint64_t> n_queued_, n_sent_, n_dropped_, n_coalesced_;
+
+    // Written only on the strand; queue_bytes_ is adjusted as each message is queued,
+    // replaced, dropped, or sent rather than recounted
+    std::atomic<size_t> queue_depth_, queue_bytes_;
+
+    // steady_clock ticks of the oldest queued message, 0 when empty
+    std::atomic<int64_t> oldest_queued_;
+
+    // Only touched on the strand; set once the closure has run
+    bool closed_;
 };
 
 // Routes map a templated URL path to a callback generator which creates the content.
@@ -599,8 +984,12 @@ protected:
 // Keys are extracted from the URL and placed in the uri_params dictionary.
 // The FILETYPE key is automatically populated with the extracted request file extension (HTML, JSON, etc)
 // The GETVARS key is automatically populated with the raw HTTP GET variables string
+//
+// Keys must be complete path segments; matching is done by kis_net_beast_route_table.
 class kis_net_beast_route {
 public:
+    friend class kis_net_beast_route_table;
+
     kis_net_beast_route(const std::string& route, const std::list<boost::beast::http::verb>& verbs,
             bool login, const std::list<std::string>& roles, 
             std::shared_ptr<kis_net_web_endpoint> handler);
@@ -609,15 +998,19 @@ public:
             const std::list<std::string>& extensions, 
             std::shared_ptr<kis_net_web_endpoint> handler);
 
-    // Does a URL match this route?  If so, populate uri params and uri variables
-    bool match_url(const std::string& url, kis_net_beast_httpd_connection::uri_param_t& uri_params,
-            kis_net_beast_httpd::http_var_map_t& uri_variables);
+    // Does a file extension satisfy this route?
+    bool match_extension(const boost::beast::string_view& ext) const;
 
     // Is the verb compatible?
     bool match_verb(boost::beast::http::verb verb);
 
     // Is the role compatible?
     bool match_role(bool login, const std::string& role);
+    bool match_role(bool login, uint64_t role_bits, const std::string& role) const;
+
+    // Bulk routes stream their request bodies
+    void set_stream_body(bool stream) { stream_body_ = stream; }
+    bool stream_body() const { return stream_body_; }
     
     // Invoke our registered callback
     void invoke(std::shared_ptr<kis_net_beast_httpd_connection> connection);
@@ -635,14 +1028,67 @@ protected:
 
     std::list<std::string> roles_;
 
-    const std::string path_id_pattern = ":([^\\/]+)?";
-    const std::string path_capture_pattern = "(?:([^\\/]+?))";
-    const std::regex path_re = std::regex(path_id_pattern);
+    // Permission bits of roles_, computed once at construction
+    uint64_t role_mask_;
+    bool any_role_;
+
+    bool stream_body_;
+
+    void compute_role_mask();
+
+    // Path segments, split on '/'; :key segments are flagged with is_key
+    struct route_segment {
+        std::string segment;
+        bool is_key;
+    };
+    std::vector<route_segment> segments_;
+
+    void parse_route();
 
     bool match_types;
+    std::vector<std::string> extensions_;
     std::vector<std::string> match_keys;
+};
+
+// Compiled route lookup.  Routes are arranged in a tree keyed by path segment, with a 
+// single wildcard child per node for :key segments, and routes which take a file type are 
+// matched against the final segment with the extension split off.
+//
+// Tables are immutable once built; the server builds a new table whenever the routes 
+// change and publishes it atomically.  When more than one route matches a URL the earliest 
+// registered route wins, the same as the original linear scan.
+class kis_net_beast_route_table {
+public:
+    kis_net_beast_route_table(const std::vector<std::shared_ptr<kis_net_beast_route>>& routes);
 
-    std::regex match_re;
+    // Find the route for a URL and populate the uri params
+    std::shared_ptr<kis_net_beast_route> match(boost::beast::string_view url,
+            kis_net_beast_httpd_connection::uri_param_t& uri_params) const;
+
+protected:
+    struct route_node {
+        std::unordered_map<std::string, std::unique_ptr<route_node>> children;
+        std::unique_ptr<route_node> key_child;
+
+        // Routes which end at this node, by registration order
+        std::vector<size_t> exact_routes;
+        std::vector<size_t> typed_routes;
+    };
+
+    struct route_match {
+        size_t route_num;
+        std::vector<boost::beast::string_view> keys;
+        boost::beast::string_view filetype;
+    };
+
+    void search(const route_node *node, const std::vector<boost::beast::string_view>& path, size_t pos,
+            std::vector<boost::beast::string_view>& keys, route_match& best) const;
+    void search_last(const route_node *node, boost::beast::string_view segment,
+            boost::beast::string_view filetype, bool typed,
+            std::vector<boost::beast::string_view>& keys, route_match& best) const;
+
+    route_node root_;
+    std::vector<std::shared_ptr<kis_net_beast_route>> routes_;
 };
 
 struct auth_construction_error : public std::exception {
@@ -666,6 +1112,7 @@ public:
     const std::string& token() { return token_; }
     const std::string& name() { return name_; }
     const std::string& role() { return role_; }
+    uint64_t role_bits() const { return role_bits_; }
 
     const time_t& expires() { return time_expires_; }
     const time_t& accessed() { return time_accessed_; }
@@ -674,7 +1121,10 @@ public:
     bool is_valid() const { return time_expires_ == 0 || time_expires_ < time(0); }
     void access() { time_accessed_ = time(0); }
     void set_expiration(time_t e) { time_expires_ = e; }
-    void set_role(const std::string& r) { role_ = r; }
+    void set_role(const std::string& r) { 
+        role_ = r; 
+        role_bits_ = kis_net_beast_httpd::role_bit(r);
+    }
 
     nlohmann::json as_json();
 
@@ -682,6 +1132,7 @@ protected:
     std::string token_;
     std::string name_;
     std::string role_;
+    uint64_t role_bits_;
     time_t time_created_, time_accessed_, time_expires_;
 
 };
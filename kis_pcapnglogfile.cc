@@ -18,9 +18,20 @@
 
 #include "config.h"
 
+#include <fstream>
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 #include "configfile.h"
 #include "kis_pcapnglogfile.h"
 #include "messagebus.h"
+#include "util.h"
 
 kis_pcapng_logfile::kis_pcapng_logfile(shared_log_builder in_builder) :
     kis_logfile(in_builder),
@@ -35,6 +46,20 @@ kis_pcapng_logfile::kis_pcapng_logfile(shared_log_builder in_builder) :
 
     auto packetchain = Globalreg::fetch_mandatory_global_as<packet_chain>("PACKETCHAIN");
     pack_comp_common = packetchain->register_packet_component("COMMON");
+
+    segment_max_bytes =
+        Globalreg::globalreg->kismet_config->fetch_opt_uint("pcapng_log_max_mb", 0) * (size_t) 1024 * 1024;
+    segment_max_sec =
+        Globalreg::globalreg->kismet_config->fetch_opt_uint("pcapng_log_max_minutes", 0) * 60;
+    segment_max_count =
+        Globalreg::globalreg->kismet_config->fetch_opt_uint("pcapng_log_max_segments", 0);
+    segment_compress =
+        Globalreg::globalreg->kismet_config->fetch_opt_bool("pcapng_log_compress", true);
+
+    segment_num = 0;
+    segment_bytes = 0;
+    segment_start = 0;
+    compress_shutdown = false;
 }
 
 kis_pcapng_logfile::~kis_pcapng_logfile() {
@@ -79,6 +104,23 @@ bool kis_pcapng_logfile::open_log(std::string in_path) {
 
     set_int_log_open(true);
 
+    if (rotation_enabled()) {
+        segment_stem = in_path;
+
+        if (segment_stem.length() > 7 &&
+                segment_stem.substr(segment_stem.length() - 7) == ".pcapng")
+            segment_stem = segment_stem.substr(0, segment_stem.length() - 7);
+
+        segment_num = 0;
+        segment_bytes = 0;
+        segment_start = time(0);
+        segment_header.clear();
+        closed_segments.clear();
+        compress_shutdown = false;
+
+        compress_t = std::thread([this]() { compress_thread(); });
+    }
+
     auto thread_p = std::promise<void>();
     auto thread_f = thread_p.get_future();
 
@@ -92,6 +134,18 @@ bool kis_pcapng_logfile::open_log(std::string in_path) {
 
                 auto sz = buffer.get(&data);
 
+                if (sz > 0 && rotation_enabled()) {
+                    // Rotate before caching the headers in this chunk, so that an IDB
+                    // carried by it is written to the new segment exactly once
+                    if (segment_full() && !rotate_segment()) {
+                        close_log();
+                        return;
+                    }
+
+                    cache_segment_header(data, sz);
+                    segment_bytes += sz;
+                }
+
                 if (sz > 0) {
                     if (fwrite(data, sz, 1, pcapng_file) == 0) {
                         _MSG_ERROR("Error writing to pcapng log '{}' - {}", get_log_path(),
@@ -117,6 +171,9 @@ void kis_pcapng_logfile::close_log() {
 
     set_int_log_open(false);
 
+    if (pcapng != nullptr)
+        pcapng->flush();
+
     buffer.cancel();
 
     if (stream_t.joinable())
@@ -126,5 +183,174 @@ void kis_pcapng_logfile::close_log() {
         fclose(pcapng_file);
 
     pcapng_file = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lk(compress_mutex);
+        compress_shutdown = true;
+    }
+    compress_cv.notify_all();
+
+    if (compress_t.joinable())
+        compress_t.join();
+}
+
+
+void kis_pcapng_logfile::cache_segment_header(const char *data, size_t sz) {
+    size_t offt = 0;
+
+    while (offt + 8 <= sz) {
+        uint32_t block_type, block_len;
+
+        memcpy(&block_type, data + offt, sizeof(uint32_t));
+        memcpy(&block_len, data + offt + 4, sizeof(uint32_t));
+
+        if (block_len < 12 || offt + block_len > sz)
+            return;
+
+        if (block_type == PCAPNG_SHB_TYPE_MAGIC)
+            segment_header.assign(data + offt, block_len);
+        else if (block_type == PCAPNG_IDB_BLOCK_TYPE)
+            segment_header.append(data + offt, block_len);
+
+        offt += block_len;
+    }
 }
 
+bool kis_pcapng_logfile::segment_full() const {
+    // Never rotate until at least one block beyond the headers has been written
+    if (segment_bytes <= segment_header.length())
+        return false;
+
+    if (segment_max_bytes > 0 && segment_bytes >= segment_max_bytes)
+        return true;
+
+    if (segment_max_sec > 0 && time(0) - segment_start >= segment_max_sec)
+        return true;
+
+    return false;
+}
+
+bool kis_pcapng_logfile::rotate_segment() {
+    auto closed_path = segment_num == 0 ? get_log_path() :
+        fmt::format("{}-{}.pcapng", segment_stem, segment_num);
+
+    fclose(pcapng_file);
+    pcapng_file = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lk(compress_mutex);
+        compress_queue.push_back(closed_path);
+    }
+    compress_cv.notify_one();
+
+    segment_num++;
+    auto next_path = fmt::format("{}-{}.pcapng", segment_stem, segment_num);
+
+    pcapng_file = fopen(next_path.c_str(), "w");
+
+    if (pcapng_file == nullptr) {
+        _MSG_ERROR("Failed to open pcapng log segment '{}' - {}",
+                next_path, kis_strerror_r(errno));
+        return false;
+    }
+
+    if (segment_header.length() > 0 &&
+            fwrite(segment_header.data(), segment_header.length(), 1, pcapng_file) == 0) {
+        _MSG_ERROR("Error writing to pcapng log segment '{}' - {}",
+                next_path, kis_strerror_r(errno));
+        return false;
+    }
+
+    segment_bytes = segment_header.length();
+    segment_start = time(0);
+
+    _MSG_INFO("Rotated pcapng log to segment '{}'", next_path);
+
+    return true;
+}
+
+void kis_pcapng_logfile::compress_thread() {
+    thread_set_process_name("PCAPNG-COMPRESS");
+
+#ifdef __linux__
+    // Compression is opportunistic; keep it out of the way of packet processing
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), 10);
+#endif
+
+    std::unique_lock<std::mutex> lk(compress_mutex);
+
+    while (true) {
+        compress_cv.wait(lk, [this]() { return compress_shutdown || compress_queue.size() > 0; });
+
+        if (compress_queue.size() == 0)
+            return;
+
+        auto path = compress_queue.front();
+        compress_queue.pop_front();
+
+        lk.unlock();
+
+        if (segment_compress)
+            path = compress_segment(path);
+
+        closed_segments.push_back(path);
+
+        // The active segment counts against the limit
+        while (segment_max_count > 0 && closed_segments.size() >= segment_max_count) {
+            auto expire = closed_segments.front();
+            closed_segments.pop_front();
+
+            if (unlink(expire.c_str()) < 0 && errno != ENOENT)
+                _MSG_ERROR("Failed to remove expired pcapng log segment '{}' - {}",
+                        expire, kis_strerror_r(errno));
+        }
+
+        lk.lock();
+    }
+}
+
+std::string kis_pcapng_logfile::compress_segment(const std::string& path) {
+    auto gz_path = fmt::format("{}.gz", path);
+
+    std::ifstream in(path, std::ios::binary);
+
+    if (!in.is_open()) {
+        _MSG_ERROR("Failed to open pcapng log segment '{}' for compression - {}",
+                path, kis_strerror_r(errno));
+        return path;
+    }
+
+    auto gz = gzopen(gz_path.c_str(), "wb6");
+
+    if (gz == nullptr) {
+        _MSG_ERROR("Failed to open compressed pcapng log segment '{}' - {}",
+                gz_path, kis_strerror_r(errno));
+        return path;
+    }
+
+    char buf[65536];
+    bool ok = true;
+
+    while (in) {
+        in.read(buf, sizeof(buf));
+        auto rd = in.gcount();
+
+        if (rd > 0 && gzwrite(gz, buf, rd) != rd) {
+            ok = false;
+            break;
+        }
+    }
+
+    if (gzclose(gz) != Z_OK)
+        ok = false;
+
+    if (!ok || in.bad()) {
+        _MSG_ERROR("Failed to compress pcapng log segment '{}', keeping it uncompressed", path);
+        unlink(gz_path.c_str());
+        return path;
+    }
+
+    unlink(path.c_str());
+
+    return gz_path;
+}
@@ -21,6 +21,10 @@
 
 #include "config.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
 #include "globalregistry.h"
 #include "logtracker.h"
 #include "pcapng_stream_futurebuf.h"
@@ -43,6 +47,42 @@ protected:
     bool log_data_packets;
 
     int pack_comp_common;
+
+    // Segment rotation; when a size or time limit is configured the log is split into
+    // numbered segments, each of which begins with the cached SHB and IDB blocks so
+    // that it is a complete pcapng file on its own
+    size_t segment_max_bytes;
+    time_t segment_max_sec;
+    unsigned int segment_max_count;
+    bool segment_compress;
+
+    std::string segment_stem;
+    unsigned int segment_num;
+    size_t segment_bytes;
+    time_t segment_start;
+    std::string segment_header;
+
+    bool rotation_enabled() const {
+        return segment_max_bytes > 0 || segment_max_sec > 0;
+    }
+
+    // Cache SHB and IDB blocks from a chunk of the stream; chunks always end on a
+    // block boundary
+    void cache_segment_header(const char *data, size_t sz);
+    bool segment_full() const;
+    bool rotate_segment();
+
+    // Closed segments are compressed and expired on a background thread, the oldest
+    // segments are removed once more than segment_max_count exist
+    std::thread compress_t;
+    std::mutex compress_mutex;
+    std::condition_variable compress_cv;
+    std::deque<std::string> compress_queue;
+    std::deque<std::string> closed_segments;
+    bool compress_shutdown;
+
+    void compress_thread();
+    std::string compress_segment(const std::string& path);
 };
 
 class pcapng_logfile_builder : public kis_logfile_builder {
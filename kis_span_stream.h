@@ -0,0 +1,164 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __KIS_SPAN_STREAM_H__
+#define __KIS_SPAN_STREAM_H__
+
+/* A kaitai-style reader over a non-owning span of bytes.
+ *
+ * This provides the subset of the kaitai::kstream read API used by the hand-written
+ * parsers, but reads directly from the buffer it was given instead of wrapping an
+ * istream over a copy of the data.  It holds only a pointer, length, and position,
+ * so it lives on the stack and performs no allocations; the buffer must outlive it.
+ *
+ * Reading past the end of the span throws std::runtime_error.
+ */
+
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+class kis_span_stream {
+public:
+    kis_span_stream(std::string_view data) :
+        m_data {data},
+        m_pos {0} { }
+
+    kis_span_stream(const char *data, size_t len) :
+        m_data {data, len},
+        m_pos {0} { }
+
+    bool is_eof() const {
+        return m_pos >= m_data.length();
+    }
+
+    void seek(uint64_t pos) {
+        if (pos > m_data.length())
+            throw std::runtime_error("kis_span_stream: seek past end of data");
+        m_pos = pos;
+    }
+
+    uint64_t pos() const {
+        return m_pos;
+    }
+
+    uint64_t size() const {
+        return m_data.length();
+    }
+
+    uint8_t read_u1() {
+        return static_cast<uint8_t>(*consume(1));
+    }
+
+    int8_t read_s1() {
+        return static_cast<int8_t>(read_u1());
+    }
+
+    uint16_t read_u2le() {
+        return read_le<uint16_t>();
+    }
+
+    uint32_t read_u4le() {
+        return read_le<uint32_t>();
+    }
+
+    uint64_t read_u8le() {
+        return read_le<uint64_t>();
+    }
+
+    uint16_t read_u2be() {
+        return read_be<uint16_t>();
+    }
+
+    uint32_t read_u4be() {
+        return read_be<uint32_t>();
+    }
+
+    uint64_t read_u8be() {
+        return read_be<uint64_t>();
+    }
+
+    int16_t read_s2le() {
+        return static_cast<int16_t>(read_u2le());
+    }
+
+    int32_t read_s4le() {
+        return static_cast<int32_t>(read_u4le());
+    }
+
+    int16_t read_s2be() {
+        return static_cast<int16_t>(read_u2be());
+    }
+
+    int32_t read_s4be() {
+        return static_cast<int32_t>(read_u4be());
+    }
+
+    // View into the underlying buffer, without copying
+    std::string_view read_span(size_t len) {
+        return std::string_view(consume(len), len);
+    }
+
+    std::string_view read_span_full() {
+        return read_span(m_data.length() - m_pos);
+    }
+
+    // Copies, for parsers which keep the bytes as a string
+    std::string read_bytes(size_t len) {
+        return std::string(read_span(len));
+    }
+
+    std::string read_bytes_full() {
+        return std::string(read_span_full());
+    }
+
+protected:
+    std::string_view m_data;
+    size_t m_pos;
+
+    const char *consume(size_t len) {
+        if (len > m_data.length() - m_pos)
+            throw std::runtime_error("kis_span_stream: read past end of data");
+
+        auto r = m_data.data() + m_pos;
+        m_pos += len;
+        return r;
+    }
+
+    template<typename T>
+    T read_le() {
+        auto d = reinterpret_cast<const uint8_t *>(consume(sizeof(T)));
+        T r = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            r |= static_cast<T>(d[i]) << (8 * i);
+        return r;
+    }
+
+    template<typename T>
+    T read_be() {
+        auto d = reinterpret_cast<const uint8_t *>(consume(sizeof(T)));
+        T r = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            r = static_cast<T>(r << 8) | d[i];
+        return r;
+    }
+};
+
+#endif
+
@@ -0,0 +1,292 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <string.h>
+
+#include "kis_string_scan.h"
+#include "util.h"
+
+// SIMD paths are compiled in where the toolchain can target them; AVX2 is
+// selected at runtime, SSE2 and NEON are part of the base ISA
+#if !defined(KIS_STRING_SCAN_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define STRING_SCAN_HAVE_SSE2
+#define STRING_SCAN_HAVE_AVX2
+#include <immintrin.h>
+#endif
+#if !defined(KIS_STRING_SCAN_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#define STRING_SCAN_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+static inline bool printable_byte(uint8_t c) {
+    return c >= 0x20 && c <= 0x7E;
+}
+
+static size_t printable_run_len_scalar(const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    while (i < len && printable_byte(data[i]))
+        i++;
+
+    return i;
+}
+
+static size_t printable_run_start_scalar(const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    while (i < len && !printable_byte(data[i]))
+        i++;
+
+    return i;
+}
+
+#ifdef STRING_SCAN_HAVE_SSE2
+// Bytes compare as signed, so everything >= 0x80 is negative and fails the > 0x1F
+// test; one mask bit per printable byte
+static inline uint32_t printable_mask_sse2(const uint8_t *p) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x1F)),
+            _mm_cmplt_epi8(v, _mm_set1_epi8(0x7F)));
+    return (uint32_t) _mm_movemask_epi8(ok);
+}
+
+static size_t printable_run_len_sse2(const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        uint32_t bad = ~printable_mask_sse2(data + i) & 0xFFFF;
+        if (bad != 0)
+            return i + __builtin_ctz(bad);
+    }
+
+    return i + printable_run_len_scalar(data + i, len - i);
+}
+
+static size_t printable_run_start_sse2(const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        uint32_t good = printable_mask_sse2(data + i);
+        if (good != 0)
+            return i + __builtin_ctz(good);
+    }
+
+    return i + printable_run_start_scalar(data + i, len - i);
+}
+#endif
+
+#ifdef STRING_SCAN_HAVE_AVX2
+__attribute__((target("avx2")))
+static inline uint32_t printable_mask_avx2(const uint8_t *p) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    const __m256i ok = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(0x1F)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7F), v));
+    return (uint32_t) _mm256_movemask_epi8(ok);
+}
+
+__attribute__((target("avx2")))
+static size_t printable_run_len_avx2(const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        uint32_t bad = ~printable_mask_avx2(data + i);
+        if (bad != 0)
+            return i + __builtin_ctz(bad);
+    }
+
+    return i + printable_run_len_sse2(data + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t printable_run_start_avx2(const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        uint32_t good = printable_mask_avx2(data + i);
+        if (good != 0)
+            return i + __builtin_ctz(good);
+    }
+
+    return i + printable_run_start_sse2(data + i, len - i);
+}
+
+static bool string_scan_have_avx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#ifdef STRING_SCAN_HAVE_NEON
+// NEON has no movemask; narrowing the compare result by 4 bits gives a 64 bit
+// mask with one nibble per byte
+static inline uint64_t printable_mask_neon(const uint8_t *p) {
+    const uint8x16_t v = vld1q_u8(p);
+    const uint8x16_t ok = vandq_u8(vcgtq_u8(v, vdupq_n_u8(0x1F)), vcltq_u8(v, vdupq_n_u8(0x7F)));
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(ok), 4)), 0);
+}
+
+static size_t printable_run_len_neon(const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        uint64_t bad = ~printable_mask_neon(data + i);
+        if (bad != 0)
+            return i + (__builtin_ctzll(bad) >> 2);
+    }
+
+    return i + printable_run_len_scalar(data + i, len - i);
+}
+
+static size_t printable_run_start_neon(const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        uint64_t good = printable_mask_neon(data + i);
+        if (good != 0)
+            return i + (__builtin_ctzll(good) >> 2);
+    }
+
+    return i + printable_run_start_scalar(data + i, len - i);
+}
+#endif
+
+namespace {
+    typedef size_t (*printable_scan_t)(const uint8_t *data, size_t len);
+
+    struct printable_dispatch {
+        printable_scan_t run_len;
+        printable_scan_t run_start;
+        const char *name;
+    };
+
+    // Probe the CPU once and pick the widest implementation
+    printable_dispatch printable_select() {
+#ifdef STRING_SCAN_HAVE_AVX2
+        if (string_scan_have_avx2())
+            return { printable_run_len_avx2, printable_run_start_avx2, "avx2" };
+#endif
+#ifdef STRING_SCAN_HAVE_SSE2
+        return { printable_run_len_sse2, printable_run_start_sse2, "sse2" };
+#endif
+#ifdef STRING_SCAN_HAVE_NEON
+        return { printable_run_len_neon, printable_run_start_neon, "neon" };
+#endif
+        return { printable_run_len_scalar, printable_run_start_scalar, "scalar" };
+    }
+
+    const printable_dispatch& printable_selected() {
+        static const printable_dispatch selected = printable_select();
+        return selected;
+    }
+}
+
+size_t printable_run_len(const uint8_t *data, size_t len) {
+    return printable_selected().run_len(data, len);
+}
+
+size_t printable_run_start(const uint8_t *data, size_t len) {
+    return printable_selected().run_start(data, len);
+}
+
+const char *printable_scan_impl() {
+    return printable_selected().name;
+}
+
+bool printable_json_safe(const nonstd::string_view& in_view) {
+    auto data = reinterpret_cast<const uint8_t *>(in_view.data());
+
+    if (printable_run_len(data, in_view.length()) != in_view.length())
+        return false;
+
+    return memchr(data, '"', in_view.length()) == nullptr &&
+        memchr(data, '\\', in_view.length()) == nullptr;
+}
+
+std::string munge_view_to_printable(const nonstd::string_view& in_view) {
+    if (printable_json_safe(in_view))
+        return std::string(in_view.data(), in_view.length());
+
+    return munge_to_printable(std::string(in_view.data(), in_view.length()));
+}
+
+#define DNS_NAME_PTR_MASK       0xC0
+#define DNS_NAME_PTR_ADDRESS    0x3FFF
+#define DNS_NAME_MAX            255
+
+size_t dns_name_extract(const uint8_t *msg, size_t msg_len, size_t offt,
+        std::string *out) {
+    size_t pos = offt;
+    size_t consumed = 0;
+    size_t namelen = 0;
+
+    // Compression pointers must point strictly backwards, which bounds the walk
+    // even on hostile packets that try to make names reference themselves
+    size_t ptr_limit = offt;
+
+    while (pos < msg_len) {
+        uint8_t len = msg[pos];
+
+        if (len == 0) {
+            if (consumed == 0)
+                consumed = pos + 1 - offt;
+            return consumed;
+        }
+
+        if ((len & DNS_NAME_PTR_MASK) == DNS_NAME_PTR_MASK) {
+            if (pos + 1 >= msg_len)
+                return 0;
+
+            size_t ptr = (((size_t) msg[pos] << 8) | msg[pos + 1]) & DNS_NAME_PTR_ADDRESS;
+
+            if (ptr >= ptr_limit)
+                return 0;
+
+            if (consumed == 0)
+                consumed = pos + 2 - offt;
+
+            ptr_limit = ptr;
+            pos = ptr;
+            continue;
+        }
+
+        // 0x40 and 0x80 label types are reserved/obsolete
+        if ((len & DNS_NAME_PTR_MASK) != 0)
+            return 0;
+
+        if (pos + 1 + len > msg_len)
+            return 0;
+
+        namelen += len + 1;
+        if (namelen > DNS_NAME_MAX)
+            return 0;
+
+        if (out != nullptr) {
+            if (!out->empty())
+                out->push_back('.');
+            out->append(munge_view_to_printable(
+                        nonstd::string_view(reinterpret_cast<const char *>(msg + pos + 1), len)));
+        }
+
+        pos += len + 1;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,86 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __KIS_STRING_SCAN_H__
+#define __KIS_STRING_SCAN_H__
+
+#include "config.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+#include "string_view.hpp"
+
+// Scanning helpers for pulling text out of packet payloads without copying.
+//
+// Printable means 7-bit ASCII 0x20 - 0x7E.  The run scanners probe the CPU once
+// and dispatch to AVX2 or SSE2 on x86-64, NEON on aarch64, or a scalar loop;
+// define KIS_STRING_SCAN_NO_SIMD to compile only the scalar path.
+
+// Length of the printable run at the start of data
+size_t printable_run_len(const uint8_t *data, size_t len);
+
+// Offset of the first printable byte in data, or len if there is none
+size_t printable_run_start(const uint8_t *data, size_t len);
+
+// Name of the implementation the run scanners selected for this CPU
+const char *printable_scan_impl();
+
+// Call fn with a view of each run of at least min_len printable bytes.  Views alias
+// data and are only valid as long as it is; fn returns false to stop scanning.
+template<typename F>
+void for_each_printable_run(const uint8_t *data, size_t len, size_t min_len, F&& fn) {
+    size_t offt = 0;
+
+    if (min_len == 0)
+        min_len = 1;
+
+    while (offt < len) {
+        offt += printable_run_start(data + offt, len - offt);
+
+        if (len - offt < min_len)
+            return;
+
+        auto run = printable_run_len(data + offt, len - offt);
+
+        if (run >= min_len &&
+                !fn(nonstd::string_view(reinterpret_cast<const char *>(data + offt), run)))
+            return;
+
+        offt += run;
+    }
+}
+
+// Is every byte of the view printable and safe to hand to JSON as-is?  Used to skip
+// munge_to_printable when there is nothing to escape.
+bool printable_json_safe(const nonstd::string_view& in_view);
+
+// Copy a view to a printable string, escaping only when needed
+std::string munge_view_to_printable(const nonstd::string_view& in_view);
+
+// Walk a DNS (or mDNS) encoded name starting at offt in a message of msg_len bytes,
+// following compression pointers.  Returns the number of bytes the name occupies
+// at offt, or 0 if it is malformed or loops.  If out is not null the labels are
+// appended to it, dot separated and munged to printable.
+size_t dns_name_extract(const uint8_t *msg, size_t msg_len, size_t offt,
+        std::string *out = nullptr);
+
+#endif
+
@@ -127,6 +127,7 @@
 #include "json_adapter.h"
 
 #include "kis_server_announce.h"
+#include "peertracker.h"
 
 #ifdef HAVE_LIBMOSQUITTO
 #include <mosquitto.h>
@@ -969,6 +970,9 @@ int main(int argc, char *argv[], char *envp[]) {
     // Add system monitor 
     Systemmonitor::create_systemmonitor();
 
+    // Subscribe to any federated peers
+    peer_tracker::create_peertracker();
+
     // Start up any code that needs everything to be loaded
     globalregistry->start_deferred();
 
@@ -92,6 +92,32 @@ nlohmann::json transform_json(const nlohmann::json &json) {
     }
 }
 
+// Apply a kismetdb device delta record to the device; 'replace' fields overwrite
+// top-level fields, 'merge' fields overwrite the sub-fields of top-level objects
+void apply_device_delta(nlohmann::json& device, const nlohmann::json& delta) {
+    auto replace = delta.find("replace");
+    if (replace != delta.end() && replace->is_object()) {
+        for (const auto& f : replace->items())
+            device[f.key()] = f.value();
+    }
+
+    auto merge = delta.find("merge");
+    if (merge != delta.end() && merge->is_object()) {
+        for (const auto& f : merge->items()) {
+            if (!f.value().is_object())
+                continue;
+
+            auto& target = device[f.key()];
+
+            if (!target.is_object() && !target.is_null())
+                continue;
+
+            for (const auto& sf : f.value().items())
+                target[sf.key()] = sf.value();
+        }
+    }
+}
+
 int main(int argc, char *argv[]) {
     static struct option longopt[] = {
         { "in", required_argument, 0, 'i' },
@@ -259,7 +285,10 @@ int main(int argc, char *argv[]) {
     if (!ekjson)
         fprintf(ofile, "[\n");
 
-    auto query = _SELECT(db, "devices", {"device"});
+    // Kismetdb v9 and newer log devices as a snapshot plus deltas
+    bool have_deltas = db_version >= 9;
+
+    auto query = _SELECT(db, "devices", {"device", "devkey"});
 
     unsigned long n_logs = 0;
     unsigned long n_division = (n_devices_db / 20);
@@ -288,6 +317,27 @@ int main(int argc, char *argv[]) {
 
             ss >> parsed_json;
 
+            if (have_deltas) {
+                auto devkey = sqlite3_column_as<std::string>(d, 1);
+
+                auto delta_query = _SELECT(db, "device_deltas", {"delta"},
+                        _WHERE("devkey", EQ, devkey),
+                        ORDERBY, "id");
+
+                for (auto dd : delta_query) {
+                    auto delta_json = sqlite3_column_as<std::string>(dd, 0);
+
+                    // A corrupt delta only loses that update, not the device
+                    try {
+                        apply_device_delta(parsed_json, nlohmann::json::parse(delta_json));
+                    } catch (const std::exception& e) {
+                        fmt::print(stderr, "ERROR:  Could not process device delta for {}: {}\n", 
+                                devkey, e.what());
+                        continue;
+                    }
+                }
+            }
+
             if (reformat)
                 parsed_json = transform_json(parsed_json);
 
@@ -451,6 +451,11 @@ public:
 class kis_string_info : public packet_component {
 public:
     kis_string_info() { }
+
+    void reset() {
+        extracted_strings.clear();
+    }
+
     std::vector<std::string> extracted_strings;
 };
 
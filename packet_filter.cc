@@ -133,14 +133,14 @@ packet_filter_mac_addr::packet_filter_mac_addr(const std::string& in_id, const s
     auto seturl = fmt::format("/filters/packet/{}/:phyname/:block/set_filter", get_filter_id());
     auto remurl = fmt::format("/filters/packet/{}/:phyname/:block/remove_filter", get_filter_id());
 
-    httpd->register_route(seturl, {"POST"}, httpd->LOGON_ROLE, {"cmd"},
+    httpd->register_bulk_route(seturl, {"POST"}, httpd->LOGON_ROLE, {"cmd"},
             std::make_shared<kis_net_web_function_endpoint>(
                 [this, seturl](std::shared_ptr<kis_net_beast_httpd_connection> con) {
                     kis_lock_guard<kis_mutex> lk(mutex, seturl);
                     return edit_endp_handler(con);
                 }));
 
-    httpd->register_route(remurl, {"POST"}, httpd->LOGON_ROLE, {"cmd"},
+    httpd->register_bulk_route(remurl, {"POST"}, httpd->LOGON_ROLE, {"cmd"},
             std::make_shared<kis_net_web_function_endpoint>(
                 [this, seturl](std::shared_ptr<kis_net_beast_httpd_connection> con) {
                     kis_lock_guard<kis_mutex> lk(mutex, seturl);
@@ -163,6 +163,7 @@ packet_chain::packet_chain() {
 
    timetracker = Globalreg::fetch_mandatory_global_as<time_tracker>();
     eventbus = Globalreg::fetch_mandatory_global_as<event_bus>();
+    eventbus->register_state_event(event_packetstats());
 
     event_timer_id = 
         timetracker->register_timer(std::chrono::seconds(1), true, 
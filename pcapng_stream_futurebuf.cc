@@ -31,13 +31,21 @@ pcapng_stream_futurebuf::pcapng_stream_futurebuf(future_chainbuf& buffer,
     max_backlog{backlog_sz},
     block_for_buffer{block_for_write}, 
     accept_cb{accept_filter},
-    selector_cb{data_selector} {
+    selector_cb{data_selector},
+    batch_cap{0},
+    batch_used{0} {
 
     pcap_mutex.set_name("pcapng_stream_futurebuf");
+    batch_mutex.set_name("pcapng_stream_futurebuf_batch");
+
+    // Batch up to 64k, but never more than half the backlog
+    batch_sz = std::min((size_t) 65536, std::max((size_t) 4096, max_backlog / 2));
 
     // Kick us out of stream mode into packet mode
     chainbuf.set_packetmode();
 
+    chainbuf.set_drain_cb([this]() { flush(); });
+
     packetchain = Globalreg::fetch_mandatory_global_as<packet_chain>();
     pack_comp_linkframe = packetchain->register_packet_component("LINKFRAME");
     pack_comp_datasrc = packetchain->register_packet_component("KISDATASRC");
@@ -45,6 +53,9 @@ pcapng_stream_futurebuf::pcapng_stream_futurebuf(future_chainbuf& buffer,
 }
 
 pcapng_stream_futurebuf::~pcapng_stream_futurebuf() {
+    flush();
+    chainbuf.set_drain_cb(nullptr);
+
     try {
         total_lifetime_promise.set_value();
     } catch (const std::future_error& e) {
@@ -72,6 +83,43 @@ bool pcapng_stream_futurebuf::block_until(size_t req_bytes) {
     return true;
 }
 
+char *pcapng_stream_futurebuf::batch_reserve(size_t sz) {
+    if (batch_buf != nullptr && batch_used + sz > batch_cap)
+        batch_publish();
+
+    if (batch_buf == nullptr) {
+        batch_cap = std::max(batch_sz, sz);
+        batch_buf = std::shared_ptr<char>(new char[batch_cap], std::default_delete<char[]>());
+        batch_used = 0;
+    }
+
+    return batch_buf.get() + batch_used;
+}
+
+void pcapng_stream_futurebuf::batch_commit(size_t sz) {
+    batch_used += sz;
+    log_size += sz;
+
+    if (batch_used >= batch_sz || chainbuf.waiting())
+        batch_publish();
+}
+
+void pcapng_stream_futurebuf::batch_publish() {
+    if (batch_buf == nullptr || batch_used == 0)
+        return;
+
+    chainbuf.put_data(batch_buf, batch_used);
+
+    batch_buf.reset();
+    batch_used = 0;
+    batch_cap = 0;
+}
+
+void pcapng_stream_futurebuf::flush() {
+    kis_lock_guard<kis_mutex> lk(batch_mutex, "pcapng_futurebuf flush");
+    batch_publish();
+}
+
 void pcapng_stream_futurebuf::stop_stream(std::string reason) {
     try {
         total_lifetime_promise.set_value();
@@ -89,7 +137,7 @@ void pcapng_stream_futurebuf::block_until_stream_done() {
 
 int pcapng_stream_futurebuf::pcapng_make_shb(const std::string& in_hw, const std::string& in_os, 
         const std::string& in_app) {
-    std::shared_ptr<char> buf;
+    char *buf;
 
     pcapng_shb *shb;
     pcapng_option *opt;
@@ -113,14 +161,13 @@ int pcapng_stream_futurebuf::pcapng_make_shb(const std::string& in_hw, const std
     if (!block_until(buf_sz + 4))
         return -1;
 
-    buf = std::shared_ptr<char>(new char[buf_sz + 4], std::default_delete<char[]>());
-    if (buf == nullptr) {
-        return -1;
-    }
+    kis_lock_guard<kis_mutex> lk(batch_mutex, "pcapng_futurebuf make_shb");
+
+    buf = batch_reserve(buf_sz + 4);
 
-    memset(buf.get(), 0, buf_sz + 4);
+    memset(buf, 0, buf_sz + 4);
 
-    shb = reinterpret_cast<pcapng_shb *>(buf.get());
+    shb = reinterpret_cast<pcapng_shb *>(buf);
 
     // Host-endian data
     shb->block_type = PCAPNG_SHB_TYPE_MAGIC;
@@ -168,13 +215,11 @@ int pcapng_stream_futurebuf::pcapng_make_shb(const std::string& in_hw, const std
     opt->option_length = 0;
 
     // Alias the last 4 bytes of the buffer for the completion size
-    auto end_sz = reinterpret_cast<uint32_t *>(buf.get() + buf_sz);
+    auto end_sz = reinterpret_cast<uint32_t *>(buf + buf_sz);
     *end_sz = buf_sz + 4;
 
     // Drop it into the buffer
-    chainbuf.put_data(buf, buf_sz + 4);
-
-    log_size += buf_sz + 4;
+    batch_commit(buf_sz + 4);
 
     return 1;
 }
@@ -241,16 +286,19 @@ int pcapng_stream_futurebuf::pcapng_make_idb(unsigned int in_sourcenumber, const
 
     datasource_id_map[index] = logid;
 
-    std::shared_ptr<char> buf;
+    char *buf;
 
     pcapng_idb *idb;
 
     pcapng_option *opt;
     size_t opt_offt = 0;
 
-    buf = std::shared_ptr<char>(new char[buf_sz + 4], std::default_delete<char[]>());
+    kis_lock_guard<kis_mutex> lk(batch_mutex, "pcapng_futurebuf make_idb");
+
+    buf = batch_reserve(buf_sz + 4);
+    memset(buf, 0, buf_sz + 4);
 
-    idb = reinterpret_cast<pcapng_idb *>(buf.get());
+    idb = reinterpret_cast<pcapng_idb *>(buf);
 
     idb->block_type = PCAPNG_IDB_BLOCK_TYPE;
     idb->block_length = buf_sz + 4;
@@ -280,12 +328,10 @@ int pcapng_stream_futurebuf::pcapng_make_idb(unsigned int in_sourcenumber, const
     opt->option_code = PCAPNG_OPT_ENDOFOPT;
     opt->option_length = 0;
 
-    uint32_t *end_sz = reinterpret_cast<uint32_t *>(buf.get() + buf_sz);
+    uint32_t *end_sz = reinterpret_cast<uint32_t *>(buf + buf_sz);
     *end_sz = buf_sz + 4;
 
-    chainbuf.put_data(buf, buf_sz + 4);
-
-    log_size += buf_sz + 4;
+    batch_commit(buf_sz + 4);
 
     return logid;
 }
@@ -302,7 +348,7 @@ int pcapng_stream_futurebuf::pcapng_write_packet(std::shared_ptr<kis_packet> in_
 
     int ng_interface_id = pcapng_make_idb(datasrcinfo->ref_source, in_data->dlt);
 
-    std::shared_ptr<char> buf;
+    char *buf;
 
     // Total buffer size starts header + data + options + end of option
     size_t buf_sz = sizeof(pcapng_epb_t) + PAD_TO_32BIT(in_data->length()) + sizeof(pcapng_option_t);
@@ -341,10 +387,12 @@ int pcapng_stream_futurebuf::pcapng_write_packet(std::shared_ptr<kis_packet> in_
     pcapng_epb *epb;
     pcapng_option *opt;
 
-    buf = std::shared_ptr<char>(new char[buf_sz + 4], std::default_delete<char[]>());
-    memset(buf.get(), 0x00, buf_sz + 4);
+    kis_lock_guard<kis_mutex> blk(batch_mutex, "pcapng_futurebuf pcapng_write_packet");
+
+    buf = batch_reserve(buf_sz + 4);
+    memset(buf, 0x00, buf_sz + 4);
 
-    epb = reinterpret_cast<pcapng_epb *>(buf.get());
+    epb = reinterpret_cast<pcapng_epb *>(buf);
 
     epb->block_type = PCAPNG_EPB_BLOCK_TYPE;
     epb->block_length = buf_sz + 4;
@@ -363,13 +411,13 @@ int pcapng_stream_futurebuf::pcapng_write_packet(std::shared_ptr<kis_packet> in_
     epb->original_length = in_data->length();
 
     // Copy the data after the epb header
-    memcpy(buf.get() + sizeof(pcapng_epb_t), in_data->data(), in_data->length());
+    memcpy(buf + sizeof(pcapng_epb_t), in_data->data(), in_data->length());
 
     // Offset to the end of the epb header + data + pad
     size_t opt_offt = sizeof(pcapng_epb_t) + PAD_TO_32BIT(in_data->length());
 
     if (in_packet->hash != 0) {
-        auto hopt = reinterpret_cast<pcapng_epb_hash_option_t *>(buf.get() + opt_offt);
+        auto hopt = reinterpret_cast<pcapng_epb_hash_option_t *>(buf + opt_offt);
 
         hopt->option_code = PCAPNG_OPT_EPB_HASH;
         hopt->option_length = 5;
@@ -380,7 +428,7 @@ int pcapng_stream_futurebuf::pcapng_write_packet(std::shared_ptr<kis_packet> in_
     }
 
     if (in_packet->packet_no != 0) {
-        auto popt = reinterpret_cast<pcapng_epb_packetid_option_t *>(buf.get() + opt_offt);
+        auto popt = reinterpret_cast<pcapng_epb_packetid_option_t *>(buf + opt_offt);
 
         popt->option_code = PCAPNG_OPT_EPB_PACKETID;
         popt->option_length = 8;
@@ -390,7 +438,7 @@ int pcapng_stream_futurebuf::pcapng_write_packet(std::shared_ptr<kis_packet> in_
     }
 
     if (gpsinfo != nullptr && gpsinfo->fix >= 2) {
-        auto gopt = reinterpret_cast<pcapng_custom_option_t *>(buf.get() + opt_offt);
+        auto gopt = reinterpret_cast<pcapng_custom_option_t *>(buf + opt_offt);
 
         // Always lon and lat
         uint32_t gps_fields = PCAPNG_GPS_FLAG_LAT | PCAPNG_GPS_FLAG_LON;
@@ -437,17 +485,15 @@ int pcapng_stream_futurebuf::pcapng_write_packet(std::shared_ptr<kis_packet> in_
     }
 
     // Place an end option after the data - header + pad32(data)
-    opt = reinterpret_cast<pcapng_option *>(buf.get() + opt_offt);
+    opt = reinterpret_cast<pcapng_option *>(buf + opt_offt);
     opt->option_code = PCAPNG_OPT_ENDOFOPT;
     opt->option_length = 0;
 
     // Final size
-    auto end_sz = reinterpret_cast<uint32_t *>(buf.get() + buf_sz);
+    auto end_sz = reinterpret_cast<uint32_t *>(buf + buf_sz);
     *end_sz = buf_sz + 4;
 
-    chainbuf.put_data(buf, buf_sz + 4);
-
-    log_size += buf_sz + 4;
+    batch_commit(buf_sz + 4);
 
     return 1;
 }
@@ -456,7 +502,7 @@ int pcapng_stream_futurebuf::pcapng_write_packet(int ng_interface_id, const stru
         const std::string& in_data) {
     kis_lock_guard<kis_mutex> lk(pcap_mutex, "pcapng_futurebuf pcapng_write_packet");
 
-    std::shared_ptr<char> buf;
+    char *buf;
 
     // Total buffer size is header + data + options
     size_t buf_sz = sizeof(pcapng_epb) + PAD_TO_32BIT(in_data.size()) + sizeof(pcapng_option);
@@ -467,10 +513,12 @@ int pcapng_stream_futurebuf::pcapng_write_packet(int ng_interface_id, const stru
     pcapng_epb *epb;
     pcapng_option *opt;
 
-    buf = std::shared_ptr<char>(new char[buf_sz + 4], std::default_delete<char[]>());
-    memset(buf.get(), 0, buf_sz + 4);
+    kis_lock_guard<kis_mutex> blk(batch_mutex, "pcapng_futurebuf pcapng_write_packet");
+
+    buf = batch_reserve(buf_sz + 4);
+    memset(buf, 0, buf_sz + 4);
 
-    epb = reinterpret_cast<pcapng_epb *>(buf.get());
+    epb = reinterpret_cast<pcapng_epb *>(buf);
 
     epb->block_type = PCAPNG_EPB_BLOCK_TYPE;
     epb->block_length = buf_sz + 4;
@@ -489,20 +537,18 @@ int pcapng_stream_futurebuf::pcapng_write_packet(int ng_interface_id, const stru
     epb->original_length = in_data.size();
 
     // Copy the data after the epb header
-    memcpy(buf.get() + sizeof(pcapng_epb), in_data.data(), in_data.size());
+    memcpy(buf + sizeof(pcapng_epb), in_data.data(), in_data.size());
 
     // Place an end option after the data - header + pad32(data)
-    opt = reinterpret_cast<pcapng_option *>(buf.get() + sizeof(pcapng_epb) + PAD_TO_32BIT(in_data.size()));
+    opt = reinterpret_cast<pcapng_option *>(buf + sizeof(pcapng_epb) + PAD_TO_32BIT(in_data.size()));
     opt->option_code = PCAPNG_OPT_ENDOFOPT;
     opt->option_length = 0;
 
     // Final size
-    auto end_sz = reinterpret_cast<uint32_t *>(buf.get() + buf_sz);
+    auto end_sz = reinterpret_cast<uint32_t *>(buf + buf_sz);
     *end_sz = buf_sz + 4;
 
-    chainbuf.put_data(buf, buf_sz + 4);
-
-    log_size += buf_sz + 4;
+    batch_commit(buf_sz + 4);
 
     return 1;
 }
@@ -534,6 +580,7 @@ void pcapng_stream_futurebuf::handle_packet(std::shared_ptr<kis_packet> in_packe
     log_packets++;
 
     if (check_over_size() || check_over_packets()) {
+        flush();
         chainbuf.cancel();
     }
 
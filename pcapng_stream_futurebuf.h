@@ -39,6 +39,12 @@
 //
 // Can be stalled until the lifetime of the stream completes, for easy inclusion in http request
 // threads
+//
+// Blocks are assembled directly into a contiguous batch buffer which is handed to the
+// chainbuf as a single chunk when it fills, or as soon as the consumer is waiting for data,
+// so that busy streams cost one chainbuf lock and one socket write per batch instead of
+// per packet.  Producers which write blocks directly must call flush() before completing
+// the chainbuf.
 
 class pcapng_stream_futurebuf : public streaming_agent, public std::enable_shared_from_this<pcapng_stream_futurebuf> {
 public:
@@ -55,6 +61,10 @@ public:
     virtual void stop_stream(std::string in_reason) override;
 
     virtual void block_until_stream_done();
+
+    // Hand any partial batch to the chainbuf
+    virtual void flush();
+
 protected:
     kis_mutex pcap_mutex;
 
@@ -75,6 +85,16 @@ protected:
     // Map kismet internal interface ID + DLT hash to log interface ID
     std::unordered_map<unsigned int, unsigned int> datasource_id_map;
 
+    kis_mutex batch_mutex;
+    std::shared_ptr<char> batch_buf;
+    size_t batch_sz, batch_cap, batch_used;
+
+    // Reserve space for a block in the current batch and commit it once it is written;
+    // batch_mutex must be held across both
+    char *batch_reserve(size_t sz);
+    void batch_commit(size_t sz);
+    void batch_publish();
+
     virtual bool block_until(size_t req_bytes);
 
     virtual int pcapng_make_shb(const std::string& in_hw, const std::string& in_os, const std::string& in_app);
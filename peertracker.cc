@@ -0,0 +1,420 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "peertracker.h"
+
+#include "configfile.h"
+#include "kis_net_beast_httpd.h"
+#include "messagebus.h"
+#include "timetracker.h"
+#include "util.h"
+
+kis_peer::kis_peer(peer_tracker *tracker, const std::string& name, const std::string& host,
+        const std::string& port, const std::string& apikey) :
+    tracker{tracker},
+    name_{name},
+    host_{host},
+    port_{port},
+    apikey_{apikey},
+    strand_{Globalreg::globalreg->io.get_executor()},
+    resolver_{strand_},
+    reconnect_timer_{strand_},
+    running_{false},
+    connected_{false},
+    n_messages_{0},
+    last_message_{0} {
+
+    error_mutex.set_name(fmt::format("kis_peer {} error", name));
+}
+
+void kis_peer::connect() {
+    running_ = true;
+
+    boost::asio::dispatch(strand_,
+            [self = shared_from_this()]() {
+                if (!self->running_)
+                    return;
+
+                self->subscribe_ = self->tracker->subscribe_request().dump();
+
+                self->resolver_.async_resolve(self->host_, self->port_,
+                        boost::beast::bind_front_handler(&kis_peer::on_resolve, self));
+            });
+}
+
+void kis_peer::close() {
+    running_ = false;
+
+    boost::asio::dispatch(strand_,
+            [self = shared_from_this()]() {
+                self->reconnect_timer_.cancel();
+                self->resolver_.cancel();
+
+                if (self->ws_) {
+                    boost::system::error_code ec;
+                    boost::beast::get_lowest_layer(*self->ws_).socket().close(ec);
+                }
+
+                self->connected_ = false;
+            });
+}
+
+std::string kis_peer::last_error() {
+    kis_lock_guard<kis_mutex> lk(error_mutex, "kis_peer last_error");
+    return last_error_;
+}
+
+void kis_peer::on_resolve(boost::beast::error_code ec,
+        boost::asio::ip::tcp::resolver::results_type results) {
+    if (ec)
+        return fail("resolving", ec);
+
+    ws_.emplace(strand_);
+
+    boost::beast::get_lowest_layer(*ws_).expires_after(std::chrono::seconds(30));
+    boost::beast::get_lowest_layer(*ws_).async_connect(results,
+            boost::beast::bind_front_handler(&kis_peer::on_connect, shared_from_this()));
+}
+
+void kis_peer::on_connect(boost::beast::error_code ec,
+        boost::asio::ip::tcp::resolver::results_type::endpoint_type) {
+    if (ec)
+        return fail("connecting", ec);
+
+    boost::beast::get_lowest_layer(*ws_).expires_never();
+
+    ws_->set_option(boost::beast::websocket::stream_base::timeout::suggested(
+                boost::beast::role_type::client));
+
+    auto target = fmt::format("/devices/monitor.ws?{}={}",
+            kis_net_beast_httpd::AUTH_COOKIE, apikey_);
+
+    ws_->async_handshake(fmt::format("{}:{}", host_, port_), target,
+            boost::beast::bind_front_handler(&kis_peer::on_handshake, shared_from_this()));
+}
+
+void kis_peer::on_handshake(boost::beast::error_code ec) {
+    if (ec)
+        return fail("negotiating websocket", ec);
+
+    ws_->text(true);
+    ws_->async_write(boost::asio::buffer(subscribe_),
+            boost::beast::bind_front_handler(&kis_peer::on_subscribe, shared_from_this()));
+}
+
+void kis_peer::on_subscribe(boost::beast::error_code ec, std::size_t) {
+    if (ec)
+        return fail("subscribing", ec);
+
+    _MSG_INFO("Connected to Kismet peer {} ({}:{})", name_, host_, port_);
+
+    connected_ = true;
+
+    do_read();
+}
+
+void kis_peer::do_read() {
+    ws_->async_read(buffer_,
+            boost::beast::bind_front_handler(&kis_peer::on_read, shared_from_this()));
+}
+
+void kis_peer::on_read(boost::beast::error_code ec, std::size_t) {
+    if (ec)
+        return fail("reading", ec);
+
+    if (!running_)
+        return;
+
+    ++n_messages_;
+    last_message_ = static_cast<time_t>(Globalreg::globalreg->last_tv_sec);
+
+    try {
+        auto record =
+            nlohmann::json::parse(boost::beast::buffers_to_string(buffer_.data()));
+        tracker->ingest(name_, record);
+    } catch (const std::exception& e) {
+        _MSG_DEBUG("Invalid device record from Kismet peer {}: {}", name_, e.what());
+    }
+
+    buffer_.consume(buffer_.size());
+
+    do_read();
+}
+
+void kis_peer::fail(const std::string& what, boost::beast::error_code ec) {
+    connected_ = false;
+
+    if (!running_)
+        return;
+
+    {
+        kis_lock_guard<kis_mutex> lk(error_mutex, "kis_peer fail");
+        last_error_ = fmt::format("error {}: {}", what, ec.message());
+    }
+
+    _MSG_ERROR("Kismet peer {} ({}:{}) error {}: {}; reconnecting in 5 seconds",
+            name_, host_, port_, what, ec.message());
+
+    if (ws_) {
+        boost::system::error_code cec;
+        boost::beast::get_lowest_layer(*ws_).socket().close(cec);
+    }
+
+    schedule_reconnect();
+}
+
+void kis_peer::schedule_reconnect() {
+    reconnect_timer_.expires_after(std::chrono::seconds(5));
+    reconnect_timer_.async_wait(
+            [self = shared_from_this()](boost::beast::error_code ec) {
+                if (ec || !self->running_)
+                    return;
+
+                self->buffer_.consume(self->buffer_.size());
+                self->connect();
+            });
+}
+
+
+peer_tracker::peer_tracker() :
+    lifetime_global(),
+    deferred_startup(),
+    device_timeout{0},
+    timeout_timer_id{-1} {
+
+    peer_mutex.set_name("peer_tracker");
+}
+
+peer_tracker::~peer_tracker() {
+    Globalreg::globalreg->remove_global(global_name());
+
+    auto timetracker = Globalreg::fetch_global_as<time_tracker>();
+    if (timetracker != nullptr && timeout_timer_id >= 0)
+        timetracker->remove_timer(timeout_timer_id);
+}
+
+void peer_tracker::trigger_deferred_startup() {
+    auto rate =
+        Globalreg::globalreg->kismet_config->fetch_opt_as<unsigned int>("peer_rate", 2);
+    device_timeout =
+        Globalreg::globalreg->kismet_config->fetch_opt_as<time_t>("peer_device_timeout", 0);
+
+    // Only the fields needed for a merged view are requested from peers
+    auto fields =
+        str_tokenize(Globalreg::globalreg->kismet_config->fetch_opt_dfl("peer_fields",
+                    "kismet.device.base.key,kismet.device.base.macaddr,kismet.device.base.phyname,"
+                    "kismet.device.base.name,kismet.device.base.commonname,kismet.device.base.type,"
+                    "kismet.device.base.manuf,kismet.device.base.first_time,kismet.device.base.last_time,"
+                    "kismet.device.base.channel,kismet.device.base.frequency,"
+                    "kismet.device.base.packets.total,"
+                    "kismet.device.base.signal/kismet.common.signal.last_signal"), ",");
+
+    // The key and timestamp are needed to merge records
+    for (const auto& f : {"kismet.device.base.key", "kismet.device.base.last_time"}) {
+        if (std::find(fields.begin(), fields.end(), f) == fields.end())
+            fields.push_back(f);
+    }
+
+    subscribe_request_["monitor"] = "*";
+    subscribe_request_["request"] = 1;
+    subscribe_request_["rate"] = std::max(1U, rate);
+    subscribe_request_["fields"] = fields;
+
+    auto httpd = Globalreg::fetch_mandatory_global_as<kis_net_beast_httpd>();
+
+    httpd->register_route("/peers/all_peers", {"GET", "POST"}, httpd->RO_ROLE, {"json"},
+            std::make_shared<kis_net_web_function_endpoint>(
+                [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
+                    std::unordered_map<std::string, size_t> device_counts;
+
+                    for (const auto& d : merged_devices) {
+                        for (const auto& s : d.second.sources)
+                            device_counts[s.first]++;
+                    }
+
+                    auto ret = nlohmann::json::array();
+
+                    for (const auto& p : peers) {
+                        nlohmann::json pj;
+
+                        pj["kismet.peer.name"] = p->name();
+                        pj["kismet.peer.host"] = p->host();
+                        pj["kismet.peer.port"] = p->port();
+                        pj["kismet.peer.connected"] = p->connected();
+                        pj["kismet.peer.messages"] = p->messages();
+                        pj["kismet.peer.last_message"] = p->last_message();
+                        pj["kismet.peer.last_error"] = p->last_error();
+                        pj["kismet.peer.devices"] = device_counts[p->name()];
+
+                        ret.push_back(pj);
+                    }
+
+                    std::ostream os(&con->response_stream());
+                    os << ret.dump();
+                }, peer_mutex));
+
+    httpd->register_route("/peers/devices", {"GET", "POST"}, httpd->RO_ROLE, {"json"},
+            std::make_shared<kis_net_web_function_endpoint>(
+                [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
+                    std::ostream os(&con->response_stream());
+                    serialize_devices(os, 0);
+                }, peer_mutex));
+
+    httpd->register_route("/peers/last-time/:timestamp/devices", {"GET", "POST"}, httpd->RO_ROLE, {"json"},
+            std::make_shared<kis_net_web_function_endpoint>(
+                [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
+                    auto ts_k = con->uri_params().find(":timestamp");
+                    auto tv = string_to_n<long>(ts_k->second);
+
+                    time_t ts;
+
+                    if (tv < 0) {
+                        ts = (time_t) Globalreg::globalreg->last_tv_sec + tv;
+                    } else {
+                        ts = tv;
+                    }
+
+                    std::ostream os(&con->response_stream());
+                    serialize_devices(os, ts);
+                }, peer_mutex));
+
+    auto peervec = Globalreg::globalreg->kismet_config->fetch_opt_vec("peer");
+    for (const auto& p : peervec) {
+        if (!create_peer(p))
+            _MSG_ERROR("Invalid Kismet peer definition '{}', expected "
+                    "peer=host=...,port=...,apikey=...[,name=...]", p);
+    }
+
+    if (device_timeout > 0) {
+        auto timetracker = Globalreg::fetch_mandatory_global_as<time_tracker>();
+
+        timeout_timer_id =
+            timetracker->register_timer(std::chrono::seconds(30), true,
+                    [this](int) -> int {
+                        kis_lock_guard<kis_mutex> lk(peer_mutex, "peer_tracker timeout");
+
+                        auto now = static_cast<time_t>(Globalreg::globalreg->last_tv_sec);
+
+                        for (auto d = merged_devices.begin(); d != merged_devices.end(); ) {
+                            if (d->second.updated + device_timeout < now)
+                                d = merged_devices.erase(d);
+                            else
+                                ++d;
+                        }
+
+                        return 1;
+                    });
+    }
+}
+
+void peer_tracker::trigger_deferred_shutdown() {
+    kis_lock_guard<kis_mutex> lk(peer_mutex, "peer_tracker shutdown");
+
+    for (const auto& p : peers)
+        p->close();
+}
+
+bool peer_tracker::create_peer(const std::string& definition) {
+    std::vector<opt_pair> options;
+
+    if (string_to_opts(definition, ",", &options) < 0)
+        return false;
+
+    auto host = fetch_opt("host", &options);
+    auto port = fetch_opt("port", &options, "2501");
+    auto apikey = fetch_opt("apikey", &options);
+    auto name = fetch_opt("name", &options, fmt::format("{}:{}", host, port));
+
+    if (host.length() == 0 || apikey.length() == 0)
+        return false;
+
+    auto peer = std::make_shared<kis_peer>(this, name, host, port, apikey);
+
+    {
+        kis_lock_guard<kis_mutex> lk(peer_mutex, "peer_tracker create_peer");
+        peers.push_back(peer);
+    }
+
+    _MSG_INFO("Subscribing to Kismet peer {} ({}:{})", name, host, port);
+
+    peer->connect();
+
+    return true;
+}
+
+void peer_tracker::ingest(const std::string& peer, nlohmann::json& record) {
+    auto key_j = record.find("kismet.device.base.key");
+    if (key_j == record.end() || !key_j->is_string())
+        return;
+
+    auto key = key_j->get<std::string>();
+    auto last_time = record.value("kismet.device.base.last_time", static_cast<uint64_t>(0));
+    auto signal = record.value("kismet.common.signal.last_signal", 0);
+
+    kis_lock_guard<kis_mutex> lk(peer_mutex, "peer_tracker ingest");
+
+    auto& md = merged_devices[key];
+
+    md.sources[peer] = peer_seen{last_time, signal};
+
+    if (md.record.is_null() || last_time >= md.last_time) {
+        md.record = std::move(record);
+        md.record_peer = peer;
+        md.last_time = last_time;
+    }
+
+    md.updated = static_cast<time_t>(Globalreg::globalreg->last_tv_sec);
+}
+
+void peer_tracker::serialize_devices(std::ostream& os, time_t since) {
+    bool first = true;
+
+    os << "[";
+
+    for (const auto& d : merged_devices) {
+        if (d.second.updated < since)
+            continue;
+
+        // Attribution is added to a copy of the summary; the records are small
+        auto record = d.second.record;
+
+        auto sources = nlohmann::json::array();
+        for (const auto& s : d.second.sources) {
+            nlohmann::json sj;
+            sj["kismet.peer.name"] = s.first;
+            sj["kismet.device.base.last_time"] = s.second.last_time;
+            sj["kismet.common.signal.last_signal"] = s.second.signal;
+            sources.push_back(sj);
+        }
+
+        record["kismet.peer.record_source"] = d.second.record_peer;
+        record["kismet.peer.update_time"] = d.second.updated;
+        record["kismet.peer.sources"] = sources;
+
+        if (!first)
+            os << ",";
+        first = false;
+
+        os << record.dump();
+    }
+
+    os << "]";
+}
+
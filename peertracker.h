@@ -0,0 +1,171 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __PEERTRACKER_H__
+#define __PEERTRACKER_H__
+
+#include "config.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "boost/asio.hpp"
+#include "boost/beast.hpp"
+#include "boost/optional.hpp"
+#include "nlohmann/json.hpp"
+
+#include "globalregistry.h"
+#include "kis_mutex.h"
+
+// Federation of multiple Kismet servers.
+//
+// A server configured with peer= lines subscribes to the device monitor websocket of each
+// peer and receives the devices which change on that peer, once per monitor interval.  The
+// records from every peer are merged by device key into a single view, which is served at
+// /peers/devices and /peers/last-time/:timestamp/devices; each merged device carries the
+// record from the peer which saw it most recently, and the list of peers which have seen it.
+//
+// Peers are defined as:
+//   peer=host=sensor1.local,port=2501,apikey=...,name=sensor1
+//
+// Peer records are kept as the JSON summaries sent by the peer, not as tracked devices; they
+// are not processed by the local device tracker, alerts, or logs.
+
+class peer_tracker;
+
+// Connection to a single peer
+class kis_peer : public std::enable_shared_from_this<kis_peer> {
+public:
+    kis_peer(peer_tracker *tracker, const std::string& name, const std::string& host,
+            const std::string& port, const std::string& apikey);
+
+    void connect();
+    void close();
+
+    const std::string& name() const { return name_; }
+    const std::string& host() const { return host_; }
+    const std::string& port() const { return port_; }
+
+    bool connected() const { return connected_; }
+    uint64_t messages() const { return n_messages_; }
+    time_t last_message() const { return last_message_; }
+    std::string last_error();
+
+protected:
+    void on_resolve(boost::beast::error_code ec, boost::asio::ip::tcp::resolver::results_type results);
+    void on_connect(boost::beast::error_code ec, boost::asio::ip::tcp::resolver::results_type::endpoint_type);
+    void on_handshake(boost::beast::error_code ec);
+    void on_subscribe(boost::beast::error_code ec, std::size_t);
+    void do_read();
+    void on_read(boost::beast::error_code ec, std::size_t);
+
+    void fail(const std::string& what, boost::beast::error_code ec);
+    void schedule_reconnect();
+
+    peer_tracker *tracker;
+
+    std::string name_;
+    std::string host_;
+    std::string port_;
+    std::string apikey_;
+
+    boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+    boost::asio::ip::tcp::resolver resolver_;
+    boost::asio::steady_timer reconnect_timer_;
+
+    boost::optional<boost::beast::websocket::stream<boost::beast::tcp_stream>> ws_;
+    boost::beast::flat_buffer buffer_;
+    std::string subscribe_;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> connected_;
+    std::atomic<uint64_t> n_messages_;
+    std::atomic<time_t> last_message_;
+
+    kis_mutex error_mutex;
+    std::string last_error_;
+};
+
+class peer_tracker : public lifetime_global, public deferred_startup {
+public:
+    static std::string global_name() { return "PEERTRACKER"; }
+
+    static std::shared_ptr<peer_tracker> create_peertracker() {
+        std::shared_ptr<peer_tracker> mon(new peer_tracker());
+        Globalreg::globalreg->register_lifetime_global(mon);
+        Globalreg::globalreg->register_deferred_global(mon);
+        Globalreg::globalreg->insert_global(global_name(), mon);
+        return mon;
+    }
+
+private:
+    peer_tracker();
+
+public:
+    virtual ~peer_tracker();
+
+    virtual void trigger_deferred_startup() override;
+    virtual void trigger_deferred_shutdown() override;
+
+    // Merge a device record from a peer
+    void ingest(const std::string& peer, nlohmann::json& record);
+
+    // Monitor request sent to each peer
+    const nlohmann::json& subscribe_request() const { return subscribe_request_; }
+
+protected:
+    kis_mutex peer_mutex;
+
+    std::vector<std::shared_ptr<kis_peer>> peers;
+
+    struct peer_seen {
+        uint64_t last_time;
+        int signal;
+    };
+
+    struct merged_device {
+        // Record from the peer which saw the device most recently
+        nlohmann::json record;
+        std::string record_peer;
+        uint64_t last_time;
+
+        // Local time the merged record last changed
+        time_t updated;
+
+        std::map<std::string, peer_seen> sources;
+    };
+
+    std::unordered_map<std::string, merged_device> merged_devices;
+
+    nlohmann::json subscribe_request_;
+
+    // Seconds without an update before a merged device is dropped, 0 to keep forever
+    time_t device_timeout;
+    int timeout_timer_id;
+
+    bool create_peer(const std::string& definition);
+
+    void serialize_devices(std::ostream& os, time_t since);
+};
+
+#endif
+
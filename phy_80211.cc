@@ -101,30 +101,17 @@ int phydot11_packethook_dot11(CHAINCALL_PARMS) {
     return ((kis_80211_phy *) auxdata)->packet_dot11_dissector(in_pack);
 }
 
-kis_80211_phy::kis_80211_phy(int in_phyid) : 
-    kis_phy_handler(in_phyid) {
-
-    alertracker = Globalreg::fetch_mandatory_global_as<alert_tracker>();
-    packetchain = Globalreg::fetch_mandatory_global_as<packet_chain>();
-    timetracker = Globalreg::fetch_mandatory_global_as<time_tracker>();
-    devicetracker = Globalreg::fetch_mandatory_global_as<device_tracker>();
-    eventbus = Globalreg::fetch_mandatory_global_as<event_bus>();
-    entrytracker = Globalreg::fetch_mandatory_global_as<entry_tracker>();
-    streamtracker = Globalreg::fetch_mandatory_global_as<stream_tracker>();
-
-    Globalreg::enable_pool_type<std::vector<ie_tag_tuple>>([](auto *t) { t->clear(); });
+int phydot11_packethook_strings(CHAINCALL_PARMS) {
+    return ((kis_80211_phy *) auxdata)->packet_dot11_string_dissector(in_pack);
+}
 
+void kis_80211_phy::enable_parser_pools() {
     // This is clunky but valuable
     Globalreg::enable_pool_type<dot11_action>([](auto *a) { a->reset(); });
     Globalreg::enable_pool_type<dot11_action::action_rmm>([](auto *a) { a->reset(); });
 
     Globalreg::enable_pool_type<dot11_ie>([](auto *a) { a->reset(); });
-    Globalreg::enable_pool_type<dot11_ie::dot11_ie_tag>([](auto *a) { a->reset(); });
-    Globalreg::enable_pool_type<dot11_ie::shared_ie_tag_vector>([](auto *a) { a->clear(); });
-    Globalreg::enable_pool_type<dot11_ie::shared_ie_tag_map>([](auto *a) { a->clear(); });
 
-    Globalreg::enable_pool_type<dot11_ie_150_vendor>([](auto *a) { a->reset(); });
-    Globalreg::enable_pool_type<dot11_ie_221_vendor>([](auto *a) { a->reset(); });
     Globalreg::enable_pool_type<dot11_ie_11_qbss>([](auto *a) { a->reset();  });
     Globalreg::enable_pool_type<dot11_ie_33_power>([](auto *a) { a->reset(); });
     Globalreg::enable_pool_type<dot11_ie_36_supported_channels>([](auto *a) { a->reset(); });
@@ -177,6 +164,22 @@ kis_80211_phy::kis_80211_phy(int in_phyid) :
     Globalreg::enable_pool_type<dot11_wfa_p2p_ie>([](auto *a) { a->reset(); });
     Globalreg::enable_pool_type<dot11_wfa_p2p_ie::shared_ie_tag_vector>([](auto *a) { a->clear(); });
     Globalreg::enable_pool_type<dot11_wfa_p2p_ie::dot11_wfa_p2p_ie_tag>([](auto *a) { a->reset(); });
+}
+
+kis_80211_phy::kis_80211_phy(int in_phyid) : 
+    kis_phy_handler(in_phyid) {
+
+    alertracker = Globalreg::fetch_mandatory_global_as<alert_tracker>();
+    packetchain = Globalreg::fetch_mandatory_global_as<packet_chain>();
+    timetracker = Globalreg::fetch_mandatory_global_as<time_tracker>();
+    devicetracker = Globalreg::fetch_mandatory_global_as<device_tracker>();
+    eventbus = Globalreg::fetch_mandatory_global_as<event_bus>();
+    entrytracker = Globalreg::fetch_mandatory_global_as<entry_tracker>();
+    streamtracker = Globalreg::fetch_mandatory_global_as<stream_tracker>();
+
+    Globalreg::enable_pool_type<std::vector<ie_tag_tuple>>([](auto *t) { t->clear(); });
+
+    enable_parser_pools();
 
     // Initialize the crc tables
     crc32_init_table_80211(Globalreg::globalreg->crc32_table);
@@ -194,6 +197,7 @@ kis_80211_phy::kis_80211_phy(int in_phyid) :
     packetchain->register_handler(&packet_dot11_scan_json_classifier, this, CHAINPOS_CLASSIFIER, -99);
     packetchain->register_handler(&phydot11_packethook_wep, this, CHAINPOS_DECRYPT, -100);
     packetchain->register_handler(&phydot11_packethook_dot11, this, CHAINPOS_LLCDISSECT, -100);
+    packetchain->register_handler(&phydot11_packethook_strings, this, CHAINPOS_DATADISSECT, -99);
 
     // If we haven't registered packet components yet, do so.  We have to
     // co-exist with the old tracker core for some time
@@ -221,6 +225,9 @@ kis_80211_phy::kis_80211_phy(int in_phyid) :
     pack_comp_datapayload =
         packetchain->register_packet_component("DATAPAYLOAD");
 
+    pack_comp_strings =
+        packetchain->register_packet_component("STRINGS");
+
     pack_comp_gps =
         packetchain->register_packet_component("GPS");
 
@@ -633,6 +640,11 @@ kis_80211_phy::kis_80211_phy(int in_phyid) :
     dissect_strings = 0;
     dissect_all_strings = 0;
 
+    string_extract_min_len =
+        Globalreg::globalreg->kismet_config->fetch_opt_uint("dot11_strings_min_len", 4);
+    string_extract_max_count =
+        Globalreg::globalreg->kismet_config->fetch_opt_uint("dot11_strings_max_per_packet", 32);
+
     // Load the wep keys from the config file
     if (load_wepkeys() < 0) {
         Globalreg::globalreg->fatal_condition = 1;
@@ -651,6 +663,16 @@ kis_80211_phy::kis_80211_phy(int in_phyid) :
     for (unsigned int wi = 0; wi < 256; wi++)
         wep_identity[wi] = wi;
 
+    wep_keystream_cache_max =
+        Globalreg::globalreg->kismet_config->fetch_opt_uint("wepkey_keystream_cache", 4096);
+
+    wep_decrypted_rrd_id =
+        Globalreg::globalreg->entrytracker->register_field("phy80211.wep_decrypted_rrd",
+                tracker_element_factory<kis_tracked_rrd<>>(),
+                "decrypted WEP frame rate rrd");
+    wep_decrypted_rrd =
+        std::make_shared<kis_tracked_rrd<>>(wep_decrypted_rrd_id);
+
     // Set up the device timeout
     device_idle_expiration =
         Globalreg::globalreg->kismet_config->fetch_opt_int("tracker_device_timeout", 0);
@@ -854,6 +876,9 @@ kis_80211_phy::kis_80211_phy(int in_phyid) :
 
     auto httpd = Globalreg::fetch_mandatory_global_as<kis_net_beast_httpd>();
 
+    httpd->register_route("/phy/phy80211/wep_decrypted", {"GET", "POST"}, httpd->RO_ROLE, {},
+            std::make_shared<kis_net_web_tracked_endpoint>(wep_decrypted_rrd));
+
     httpd->register_route("/phy/phy80211/clients-of/:key/clients", {"GET", "POST"}, httpd->RO_ROLE, {},
             std::make_shared<kis_net_web_tracked_endpoint>(
                 [this](std::shared_ptr<kis_net_beast_httpd_connection> con) {
@@ -1030,6 +1055,7 @@ kis_80211_phy::kis_80211_phy(int in_phyid) :
 kis_80211_phy::~kis_80211_phy() {
 	packetchain->remove_handler(&phydot11_packethook_wep, CHAINPOS_DECRYPT);
 	packetchain->remove_handler(&phydot11_packethook_dot11, CHAINPOS_LLCDISSECT);
+	packetchain->remove_handler(&phydot11_packethook_strings, CHAINPOS_DATADISSECT);
 	packetchain->remove_handler(&packet_dot11_common_classifier, CHAINPOS_CLASSIFIER);
 
     timetracker->remove_timer(device_idle_timer);
@@ -2519,30 +2545,71 @@ void kis_80211_phy::handle_ssid(std::shared_ptr<kis_tracked_device_base> basedev
         return;
     }
 
-    // If we've processed an identical ssid, don't waste time parsing again, just tweak
-    // the few fields we need to update
-    if (dot11dev->get_last_adv_ie_csum() == dot11info->ietag_csum) {
-        ssid = dot11dev->get_last_adv_ssid();
-
-        if (ssid != nullptr) {
-            if (ssid->get_last_time() < in_pack->ts.tv_sec)
+    // If we've processed this variant of the beacon or response recently, don't waste
+    // time parsing the IEs again, just tweak the few fields we need to update.
+    // Variants are keyed on the stable IE checksum so APs which rotate through several
+    // beacons still hit the cache; a variant is only reused while the ssid record still
+    // holds the crypt and channel it decoded to, otherwise a full rebuild catches the 
+    // change.  Failed parses aren't cached, so a corrupt variant is parsed (and alerted
+    // on) every time it's seen.
+    if (!dot11dev->get_snap_next_beacon()) {
+        auto cached = dot11dev->find_adv_ie_cache(dot11info->ietag_stable_csum);
+
+        if (cached != nullptr && cached->ssid->get_crypt_set() == cached->cryptset &&
+                cached->ssid->get_channel() == cached->channel) {
+            ssid = cached->ssid;
+
+            // Fill in what downstream consumers and loggers expect from the IEs; the
+            // BSS load was already picked up by the stable checksum
+            dot11info->ssid = ssid->get_ssid();
+            dot11info->ssid_len = ssid->get_ssid_len();
+            dot11info->ssid_blank = ssid->get_ssid_cloaked() && ssid->get_ssid_len() != 0;
+            dot11info->ssid_csum = ssid->get_ssid_hash();
+            dot11info->cryptset = cached->cryptset;
+            dot11info->channel = cached->channel;
+
+            if (ssid->get_last_time() < in_pack->ts.tv_sec) {
                 ssid->set_last_time(in_pack->ts.tv_sec);
 
+                if (dot11info->subtype == packet_sub_probe_resp)
+                    ssidtracker->handle_response_ssid(ssid->get_ssid(), ssid->get_ssid_len(),
+                            ssid->get_crypt_set(), basedev);
+                else
+                    ssidtracker->handle_broadcast_ssid(ssid->get_ssid(), ssid->get_ssid_len(),
+                            ssid->get_crypt_set(), basedev);
+            }
+
+            if (dot11dev->get_last_adv_ssid() != ssid) {
+                dot11dev->set_last_adv_ssid(ssid);
+                dot11dev->get_last_beaconed_ssid_record()->set(ssid);
+            }
+
             if (dot11info->subtype == packet_sub_beacon) {
+                dot11dev->set_beacon_fingerprint(cached->beacon_fingerprint);
+
                 ssid->inc_beacons_sec();
+
+                // BSS load isn't part of the variant checksum, refresh it from the raw tag
+                if (dot11info->qbss_stations >= 0 && ssid->get_dot11e_qbss()) {
+                    ssid->set_dot11e_qbss_stations(dot11info->qbss_stations);
+                    ssid->set_dot11e_qbss_channel_load(
+                            ((double) dot11info->qbss_chan_util / (double) 255.0f) * 100.0f);
+                }
             }
-        }
 
-        return;
-    }
+            add_ssid_location(ssid, pack_gpsinfo);
 
-    dot11dev->set_last_adv_ie_csum(dot11info->ietag_csum);
+            return;
+        }
+    }
 
     // If we fail parsing...
     if (packet_dot11_ie_dissector(in_pack, dot11info) < 0) {
         return;
     }
 
+    dot11dev->set_last_adv_ie_csum(dot11info->ietag_csum);
+
     // If we're looking for the beacon, snapshot it
     if (dot11info->subtype == packet_sub_beacon &&
             dot11dev->get_snap_next_beacon()) {
@@ -2648,9 +2715,9 @@ void kis_80211_phy::handle_ssid(std::shared_ptr<kis_tracked_device_base> basedev
         }
 
         if (dot11info->ie_tags != nullptr) {
-            auto meshid = dot11info->ie_tags->tags_map()->find(114);
-            if (meshid != dot11info->ie_tags->tags_map()->end()) {
-                ssid->set_meshid(munge_to_printable(meshid->second->tag_data()));
+            auto meshid = dot11info->ie_tags->find_tag(114);
+            if (meshid != nullptr) {
+                ssid->set_meshid(munge_to_printable(std::string(meshid->tag_data())));
             }
         }
 
@@ -2952,11 +3019,11 @@ void kis_80211_phy::handle_ssid(std::shared_ptr<kis_tracked_device_base> basedev
         // Pull specific tags we don't pre-parse
         if (dot11info->ie_tags != nullptr) {
             // Update mesh capabilities
-            auto meshcap = dot11info->ie_tags->tags_map()->find(113);
-            if (meshcap != dot11info->ie_tags->tags_map()->end()) {
+            auto meshcap = dot11info->ie_tags->find_tag(113);
+            if (meshcap != nullptr) {
                 try {
                     auto mc = Globalreg::new_from_pool<dot11_ie_113_mesh_config>();
-                    mc->parse(meshcap->second->tag_data_stream());
+                    mc->parse(meshcap->tag_data());
 
                     ssid->set_mesh_forwarding(mc->mesh_forwarding());
                     ssid->set_mesh_peerings(mc->num_peerings());
@@ -3148,21 +3215,7 @@ void kis_80211_phy::handle_ssid(std::shared_ptr<kis_tracked_device_base> basedev
     ssid->set_maxrate(dot11info->maxrate);
 
     // Add the location data, if any
-    if (pack_gpsinfo != NULL && pack_gpsinfo->fix > 1) {
-        auto loc = ssid->get_location();
-
-        if (loc->get_last_location_time() != Globalreg::globalreg->last_tv_sec) {
-            loc->set_last_location_time(Globalreg::globalreg->last_tv_sec);
-            loc->add_loc_with_avg(pack_gpsinfo->lat, pack_gpsinfo->lon,
-                    pack_gpsinfo->alt, pack_gpsinfo->fix, pack_gpsinfo->speed,
-                    pack_gpsinfo->heading);
-        } else {
-            loc->add_loc(pack_gpsinfo->lat, pack_gpsinfo->lon,
-                    pack_gpsinfo->alt, pack_gpsinfo->fix, pack_gpsinfo->speed,
-                    pack_gpsinfo->heading);
-        }
-
-    }
+    add_ssid_location(ssid, pack_gpsinfo);
 
     // Finalize processing and add it to the maps
     if (dot11info->subtype == packet_sub_probe_resp) {
@@ -3179,6 +3232,10 @@ void kis_80211_phy::handle_ssid(std::shared_ptr<kis_tracked_device_base> basedev
                 ssid->get_crypt_set(), basedev);
     }
 
+    dot11dev->cache_adv_ie(dot11info->ietag_stable_csum,
+            dot11info->subtype == packet_sub_beacon ? dot11dev->get_beacon_fingerprint() : 0,
+            ssid->get_crypt_set(), ssid->get_channel(), ssid);
+
     if (new_adv_ssid) {
         auto evt = eventbus->get_eventbus_event(dot11_new_advertised_ssid);
         evt->get_event_content()->insert(dot11_new_ssid_device, basedev);
@@ -3192,6 +3249,25 @@ void kis_80211_phy::handle_ssid(std::shared_ptr<kis_tracked_device_base> basedev
     }
 }
 
+void kis_80211_phy::add_ssid_location(std::shared_ptr<dot11_advertised_ssid> ssid,
+        std::shared_ptr<kis_gps_packinfo> pack_gpsinfo) {
+    if (pack_gpsinfo == nullptr || pack_gpsinfo->fix <= 1)
+        return;
+
+    auto loc = ssid->get_location();
+
+    if (loc->get_last_location_time() != Globalreg::globalreg->last_tv_sec) {
+        loc->set_last_location_time(Globalreg::globalreg->last_tv_sec);
+        loc->add_loc_with_avg(pack_gpsinfo->lat, pack_gpsinfo->lon,
+                pack_gpsinfo->alt, pack_gpsinfo->fix, pack_gpsinfo->speed,
+                pack_gpsinfo->heading);
+    } else {
+        loc->add_loc(pack_gpsinfo->lat, pack_gpsinfo->lon,
+                pack_gpsinfo->alt, pack_gpsinfo->fix, pack_gpsinfo->speed,
+                pack_gpsinfo->heading);
+    }
+}
+
 void kis_80211_phy::handle_probed_ssid(std::shared_ptr<kis_tracked_device_base> basedev,
         std::shared_ptr<dot11_tracked_device> dot11dev,
         std::shared_ptr<kis_packet> in_pack,
@@ -3587,7 +3663,14 @@ void kis_80211_phy::process_wpa_handshake(std::shared_ptr<kis_tracked_device_bas
         std::shared_ptr<kis_packet> in_pack,
         std::shared_ptr<dot11_packinfo> dot11info) {
 
-    std::shared_ptr<dot11_tracked_eapol> eapol = packet_dot11_eapol_handshake(in_pack, bssid_dot11);
+    // Handshake frames are processed for both the source and the destination, only
+    // dissect them once
+    if (!dot11info->eapol_checked) {
+        dot11info->eapol_checked = true;
+        dot11info->eapol = packet_dot11_eapol_handshake(in_pack, bssid_dot11);
+    }
+
+    auto eapol = dot11info->eapol;
 
     if (eapol == NULL)
         return;
@@ -3625,6 +3708,8 @@ void kis_80211_phy::process_wpa_handshake(std::shared_ptr<kis_tracked_device_bas
         bssid_vec = std::static_pointer_cast<tracker_element_vector>(bssid_vec_i->second);
     }
 
+    bool evicted = false;
+
     if (bssid_vec->size() > 16) {
         for (tracker_element_vector::iterator kvi = bssid_vec->begin();
                 kvi != bssid_vec->end(); ++kvi) {
@@ -3636,6 +3721,7 @@ void kis_80211_phy::process_wpa_handshake(std::shared_ptr<kis_tracked_device_bas
             // rid of this one
             if ((keymask & knum) == knum) {
                 bssid_vec->erase(kvi);
+                evicted = true;
                 break;
             }
 
@@ -3646,6 +3732,14 @@ void kis_80211_phy::process_wpa_handshake(std::shared_ptr<kis_tracked_device_bas
 
     bssid_vec->push_back(eapol);
 
+    // Keep the rendered pcap records in step; appends are incremental, evictions
+    // (and records restored without a rendering) re-render the whole vector
+    auto& records = bssid_dot11->handshake_pcap_records[dest_dev->get_macaddr()];
+    if (evicted || records.empty())
+        render_handshake_pcap_records(records, bssid_vec.get());
+    else
+        append_pcap_record(records, eapol->get_eapol_packet().get());
+
     // Calculate the key mask of seen handshake keys
     keymask = 0;
     for (const auto& kvi : *bssid_vec) {
@@ -3969,76 +4063,73 @@ void kis_80211_phy::generate_handshake_pcap(std::shared_ptr<kis_net_beast_httpd_
         uint32_t dlt = KDLT_IEEE802_11;
     } hdr;
 
-    // Hardcode the pcap packet header
-    struct pcap_packet_header {
-        uint32_t timeval_s;
-        uint32_t timeval_us;
-        uint32_t len;
-        uint32_t caplen;
-    } pkt_hdr;
-
     std::ostream stream(&con->response_stream());
 
     stream.write((const char *) &hdr, sizeof(hdr));
 
+    // Gather the records under lock, write them once we've released it
+    std::string records;
+
     kis_unique_lock<kis_mutex> list_locker(devicetracker->get_devicelist_mutex(),
             "phy80211 generate_handshake_pcap");
 
-
     /* Write the beacon */
-    if (dot11dev->get_beacon_packet_present()) {
-        auto packet = dot11dev->get_ssid_beacon_packet();
-
-        pkt_hdr.timeval_s = packet->get_ts_sec();
-        pkt_hdr.timeval_us = packet->get_ts_usec();
-
-        pkt_hdr.len = packet->get_data()->length();
-        pkt_hdr.caplen = pkt_hdr.len;
-
-        stream.write((const char *) &pkt_hdr, sizeof(pkt_hdr));
-        stream.write((const char *) packet->get_data()->get().data(), pkt_hdr.len);
-    }
+    if (dot11dev->get_beacon_packet_present())
+        append_pcap_record(records, dot11dev->get_ssid_beacon_packet().get());
 
     if (mode == "handshake") {
-        // Write all the handshakes
+        // Write all the handshakes, rendered as they were captured
         if (dot11dev->has_wpa_key_map()) {
             const auto hsm = dot11dev->get_wpa_key_map();
             const auto hsi = hsm->find(target_mac);
 
             if (hsi != hsm->end()) {
-                auto hsv = static_cast<tracker_element_vector *>(hsi->second.get());
-                for (const auto& i : *(hsv)) {
-                    auto eapol = static_cast<dot11_tracked_eapol *>(i.get());
+                auto& hs_records = dot11dev->handshake_pcap_records[target_mac];
 
-                    auto packet = eapol->get_eapol_packet();
+                if (hs_records.empty())
+                    render_handshake_pcap_records(hs_records,
+                            static_cast<tracker_element_vector *>(hsi->second.get()));
 
-                    // Make a pcap header
-                    pkt_hdr.timeval_s = packet->get_ts_sec();
-                    pkt_hdr.timeval_us = packet->get_ts_usec();
-
-                    pkt_hdr.len = packet->get_data()->length();
-                    pkt_hdr.caplen = pkt_hdr.len;
-
-                    stream.write((const char *) &pkt_hdr, sizeof(pkt_hdr));
-                    stream.write((const char *) packet->get_data()->get().data(), pkt_hdr.len);
-                }
+                records.append(hs_records);
             }
         }
     } else if (mode == "pmkid") {
         // Write just the pmkid
-        if (dot11dev->get_pmkid_present()) {
-            auto packet = dot11dev->get_pmkid_packet();
+        if (dot11dev->get_pmkid_present())
+            append_pcap_record(records, dot11dev->get_pmkid_packet().get());
+    }
 
-            pkt_hdr.timeval_s = packet->get_ts_sec();
-            pkt_hdr.timeval_us = packet->get_ts_usec();
+    list_locker.unlock();
 
-            pkt_hdr.len = packet->get_data()->length();
-            pkt_hdr.caplen = pkt_hdr.len;
+    stream.write(records.data(), records.length());
+}
 
-            stream.write((const char *) &pkt_hdr, sizeof(pkt_hdr));
-            stream.write((const char *) packet->get_data()->get().data(), pkt_hdr.len);
-        }
-    }
+void kis_80211_phy::append_pcap_record(std::string& records, kis_tracked_packet *packet) {
+    // Hardcode the pcap packet header
+    struct pcap_packet_header {
+        uint32_t timeval_s;
+        uint32_t timeval_us;
+        uint32_t len;
+        uint32_t caplen;
+    } pkt_hdr;
+
+    pkt_hdr.timeval_s = packet->get_ts_sec();
+    pkt_hdr.timeval_us = packet->get_ts_usec();
+
+    pkt_hdr.len = packet->get_data()->length();
+    pkt_hdr.caplen = pkt_hdr.len;
+
+    records.append((const char *) &pkt_hdr, sizeof(pkt_hdr));
+    records.append(packet->get_data()->get().data(), pkt_hdr.len);
+}
+
+void kis_80211_phy::render_handshake_pcap_records(std::string& records,
+        tracker_element_vector *eapol_vec) {
+    records.clear();
+
+    for (const auto& i : *eapol_vec)
+        append_pcap_record(records,
+                static_cast<dot11_tracked_eapol *>(i.get())->get_eapol_packet().get());
 }
 
 class phy80211_devicetracker_expire_worker : public device_tracker_view_worker {
@@ -4078,6 +4169,8 @@ public:
                         dot11dev->set_last_adv_ie_csum(0);
                     }
 
+                    dot11dev->clear_adv_ie_cache();
+
                     adv_ssid_map->erase(itr);
                     itr = adv_ssid_map->begin();
                     devicetracker->update_full_refresh();
@@ -4102,6 +4195,8 @@ public:
                         dot11dev->set_last_adv_ie_csum(0);
                     }
 
+                    dot11dev->clear_adv_ie_cache();
+
                     resp_ssid_map->erase(itr);
                     itr = resp_ssid_map->begin();
                     devicetracker->update_full_refresh();
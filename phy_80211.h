@@ -51,6 +51,8 @@
 #include "gpstracker.h"
 #include "uuid.h"
 #include "streamtracker.h"
+#include "trackedrrd.h"
+#include "unordered_dense.h"
 
 #include "devicetracker.h"
 #include "devicetracker_component.h"
@@ -88,6 +90,11 @@ class dot11_wep_key {
         unsigned int len;
         unsigned int decrypted;
         unsigned int failed;
+
+        // RC4 keystreams for recently seen IVs under this key; the keystream only
+        // depends on the IV and the key, so repeated IVs skip the key schedule
+        kis_mutex keystream_mutex;
+        ankerl::unordered_dense::map<uint32_t, std::shared_ptr<std::string>> keystreams;
 };
 
 // dot11 packet components
@@ -159,6 +166,9 @@ class dot11_packinfo : public packet_component {
 
             // Many of these will not be available until the IE tags are parsed
             ietag_csum = 0;
+            ietag_stable_csum = 0;
+            qbss_stations = -1;
+            qbss_chan_util = -1;
 
             dot11d_country = "";
 
@@ -202,6 +212,9 @@ class dot11_packinfo : public packet_component {
             rsn.reset();
             droneid.reset();
 
+            eapol_checked = false;
+            eapol.reset();
+
             basic_rates.clear();
             extended_rates.clear();
             mcs_rates.clear();
@@ -281,6 +294,16 @@ class dot11_packinfo : public packet_component {
         uint32_t ssid_csum;
         uint32_t ietag_csum;
 
+        // Checksum of the parts of a beacon or probe response which identify the
+        // variant; the timestamp and the tags which change from beacon to beacon
+        // (TIM, BSS load, quiet) are skipped.  Computed by the dissector without
+        // parsing the IEs.
+        uint32_t ietag_stable_csum;
+
+        // Raw BSS load picked up while computing the stable checksum, -1 if absent
+        int qbss_stations;
+        int qbss_chan_util;
+
         // Tupled hash map
         std::multimap<std::tuple<uint8_t, uint32_t, uint8_t>, size_t> ietag_hash_map;
 
@@ -320,6 +343,11 @@ class dot11_packinfo : public packet_component {
 
         std::shared_ptr<dot11_ie_221_dji_droneid> droneid;
 
+        // EAPOL key frame, dissected once per packet and shared between the
+        // source and destination handshake records
+        bool eapol_checked;
+        std::shared_ptr<dot11_tracked_eapol> eapol;
+
         double maxrate;
         // 11g rates
         std::vector<std::string> basic_rates;
@@ -439,8 +467,23 @@ public:
             unsigned char *in_key, int in_key_len,
             unsigned char *in_id);
 
-    // TODO - what do we do with the strings?  Can we make them phy-neutral?
-    // int packet_dot11string_dissector(kis_packet *in_pack);
+    // Generate the RC4 keystream for a WEP IV and key
+    static void wep_keystream(std::string& keystream, const uint8_t *iv,
+            const unsigned char *in_key, int in_key_len,
+            const unsigned char *in_id, size_t len);
+
+    // Decrypt a WEP frame with a keystream, returning the decrypted frame if the
+    // ICV matches
+    static std::shared_ptr<kis_datachunk> wep_apply_keystream(std::shared_ptr<dot11_packinfo> in_packinfo,
+            std::shared_ptr<kis_datachunk> in_chunk, const std::string& keystream);
+
+    // Extract printable runs from unencrypted or decrypted data payloads into a
+    // string packet component when string extraction is enabled
+    int packet_dot11_string_dissector(std::shared_ptr<kis_packet> in_pack);
+
+    // Register object pools for the IE and frame parsers; called by the phy, and by
+    // anything else which drives the parsers outside of it
+    static void enable_parser_pools();
 
     // 802.11 packet classifier to common for the devicetracker layer
     static int packet_dot11_common_classifier(CHAINCALL_PARMS);
@@ -510,6 +553,10 @@ protected:
             std::shared_ptr<dot11_packinfo> dot11info,
             std::shared_ptr<kis_gps_packinfo> pack_gpsinfo);
 
+    // Add the packet location to an advertised ssid
+    void add_ssid_location(std::shared_ptr<dot11_advertised_ssid> ssid,
+            std::shared_ptr<kis_gps_packinfo> pack_gpsinfo);
+
     // Handle probed SSIDs
     void handle_probed_ssid(std::shared_ptr<kis_tracked_device_base> basedev, 
             std::shared_ptr<dot11_tracked_device> dot11dev,
@@ -539,6 +586,12 @@ protected:
             std::shared_ptr<dot11_tracked_device> dot11dev, 
             mac_addr target_mac, std::string mode);
 
+    // Append a pcap packet record for a tracked packet
+    static void append_pcap_record(std::string& records, kis_tracked_packet *packet);
+    // Re-render the pcap records for a vector of eapol frames
+    static void render_handshake_pcap_records(std::string& records,
+            tracker_element_vector *eapol_vec);
+
     int dot11_device_entry_id;
 
     int load_wepkeys();
@@ -564,6 +617,9 @@ protected:
     // Do we pull strings?
     int dissect_strings, dissect_all_strings;
 
+    // Shortest printable run kept, and most runs kept per packet, when pulling strings
+    size_t string_extract_min_len, string_extract_max_count;
+
     // SSID regex filter
     std::shared_ptr<tracker_element_vector> ssid_regex_vec;
     int ssid_regex_vec_element_id;
@@ -585,6 +641,12 @@ protected:
     // Generated WEP identity / base
     unsigned char wep_identity[256];
 
+    // Maximum keystreams cached per WEP key
+    size_t wep_keystream_cache_max;
+
+    int wep_decrypted_rrd_id;
+    std::shared_ptr<kis_tracked_rrd<>> wep_decrypted_rrd;
+
     // Tracker alert references
     int alert_chan_ref, alert_dhcpcon_ref, alert_bcastdcon_ref, alert_airjackssid_ref,
         alert_wepflap_ref, alert_dhcpname_ref, alert_dhcpos_ref, alert_adhoc_ref,
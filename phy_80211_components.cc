@@ -18,9 +18,6 @@
 
 #include "config.h"
 #include "dot11_parsers/dot11_ie.h"
-#include "dot11_parsers/dot11_ie_150_vendor.h"
-#include "dot11_parsers/dot11_ie_221_vendor.h"
-#include "dot11_parsers/dot11_ie_255_ext_tag.h"
 #include "manuf.h"
 #include "phy_80211.h"
 #include "phy_80211_components.h"
@@ -370,7 +367,7 @@ void dot11_advertised_ssid::set_ietag_content_from_packet(std::shared_ptr<dot11_
     if (tags == nullptr)
         return;
 
-    for (auto t : *(tags->tags())) {
+    for (const auto& t : tags->tags()) {
         auto tag =
             Globalreg::new_from_pool<dot11_tracked_ietag>(ie_tag_builder.get());
         tag->set_from_tag(t);
@@ -412,71 +409,34 @@ void dot11_tracked_ietag::register_fields() {
         "Complete IE tag data", &complete_tag_data);
 }
 
-void dot11_tracked_ietag::set_from_tag(std::shared_ptr<dot11_ie::dot11_ie_tag> tag) {
-    set_tag_number(tag->tag_num());
-    set_complete_tag_data(tag->tag_data());
+void dot11_tracked_ietag::set_from_tag(const dot11_ie::dot11_ie_tag& tag) {
+    set_tag_number(tag.tag_num());
+    set_complete_tag_data(std::string(tag.tag_data()));
 
-    if (tag->tag_num() == 150) {
-        try {
-            tag->tag_data_stream()->seek(0);
+    if ((tag.tag_num() == 150 || tag.tag_num() == 221) && tag.has_vendor_oui()) {
+        set_tag_oui(tag.vendor_oui_int());
 
-            dot11_ie_150_vendor tag150;
-            tag150.parse(tag->tag_data_stream());
+        auto resolved_manuf = Globalreg::globalreg->manufdb->lookup_oui(tag.vendor_oui_int());
+        set_tag_oui_manuf(resolved_manuf->get());
 
-            set_tag_oui(tag150.vendor_oui_int());
+        set_tag_vendor_or_sub(tag.vendor_oui_type());
 
-            auto resolved_manuf = Globalreg::globalreg->manufdb->lookup_oui(tag150.vendor_oui_int());
-            set_tag_oui_manuf(resolved_manuf->get());
+        set_unique_tag_id(adler32_checksum(fmt::format("{}{}{}", tag.tag_num(), 
+                        tag.vendor_oui_int(), tag.vendor_oui_type())));
 
-            set_tag_vendor_or_sub(tag150.vendor_oui_type());
-
-            set_unique_tag_id(adler32_checksum(fmt::format("{}{}{}", tag->tag_num(), tag150.vendor_oui_int(), tag150.vendor_oui_type())));
-
-            return;
-        } catch (const std::exception& e) {
-            // Do nothing; fall through to setting the tag num
-            ;
-        }
-    } else if (tag->tag_num() == 221) {
-        try {
-            tag->tag_data_stream()->seek(0);
-
-            dot11_ie_221_vendor tag221;
-            tag221.parse(tag->tag_data_stream());
-
-            set_tag_oui(tag221.vendor_oui_int());
-
-            auto resolved_manuf = Globalreg::globalreg->manufdb->lookup_oui(tag221.vendor_oui_int());
-            set_tag_oui_manuf(resolved_manuf->get());
-
-            set_tag_vendor_or_sub(tag221.vendor_oui_type());
-
-            set_unique_tag_id(adler32_checksum(fmt::format("{}{}{}", tag->tag_num(), tag221.vendor_oui_int(), tag221.vendor_oui_type())));
-
-            return; 
-        } catch (const std::exception& e) {
-            // Do nothing; fall through to setting the tag num
-            ;
-        }
-    } else if (tag->tag_num() == 255) {
-        try {
-            tag->tag_data_stream()->seek(0);
-
-            dot11_ie_255_ext tag255;
-            tag255.parse(tag->tag_data_stream());
+        return;
+    } else if (tag.tag_num() == 255 && tag.tag_len() >= 1) {
+        // Extended tags carry the sub-tag number in the first byte
+        uint8_t subtag_num = tag.tag_data()[0];
 
-            set_tag_vendor_or_sub(tag255.subtag_num());
+        set_tag_vendor_or_sub(subtag_num);
             
-            set_unique_tag_id(adler32_checksum(fmt::format("{}{}", tag->tag_num(), tag255.subtag_num())));
-            return;
-        } catch (const std::exception& e) {
-            // Do nothing; fall through to setting the tag num
-            ;
-        }
-    } else {
+        set_unique_tag_id(adler32_checksum(fmt::format("{}{}", tag.tag_num(), subtag_num)));
+        return;
+    } else if (tag.tag_num() != 150 && tag.tag_num() != 221 && tag.tag_num() != 255) {
         set_tag_vendor_or_sub(-1);
     }
 
-    set_unique_tag_id(tag->tag_num());
+    set_unique_tag_id(tag.tag_num());
 }
 
@@ -27,6 +27,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -413,7 +414,7 @@ public:
     __Proxy(tag_vendor_or_sub, int16_t, int16_t, int16_t, tag_vendor_or_sub);
     __Proxy(complete_tag_data, std::string, std::string, std::string, complete_tag_data);
 
-    void set_from_tag(std::shared_ptr<dot11_ie::dot11_ie_tag> ie);
+    void set_from_tag(const dot11_ie::dot11_ie_tag& ie);
 
 protected:
     virtual void register_fields() override;
@@ -488,7 +489,7 @@ public:
         return r;
     }
 
-    __Proxy(ssid, std::string, std::string, std::string, ssid);
+    __ProxyInterned(ssid, ssid);
     __Proxy(ssid_len, uint32_t, unsigned int, unsigned int, ssid_len);
     __Proxy(bssid, mac_addr, mac_addr, mac_addr, bssid);
     __Proxy(first_time, uint64_t, time_t, time_t, first_time);
@@ -509,10 +510,10 @@ public:
     __ProxyFullyDynamic(wps_version, uint8_t, uint8_t, uint8_t, tracker_element_uint8, wps_version_id);
     __ProxyFullyDynamic(wps_state, uint32_t, uint32_t, uint32_t, tracker_element_uint32, wps_state_id);
     __ProxyFullyDynamic(wps_config_methods, uint16_t, uint16_t, uint16_t, tracker_element_uint16, wps_config_methods_id);
-    __ProxyFullyDynamic(wps_manuf, std::string, std::string, std::string, tracker_element_string, wps_manuf_id);
-    __ProxyFullyDynamic(wps_device_name, std::string, std::string, std::string, tracker_element_string, wps_device_name_id);
-    __ProxyFullyDynamic(wps_model_name, std::string, std::string, std::string, tracker_element_string, wps_model_name_id);
-    __ProxyFullyDynamic(wps_model_number, std::string, std::string, std::string, tracker_element_string, wps_model_number_id);
+    __ProxyFullyDynamicInterned(wps_manuf, wps_manuf_id);
+    __ProxyFullyDynamicInterned(wps_device_name, wps_device_name_id);
+    __ProxyFullyDynamicInterned(wps_model_name, wps_model_name_id);
+    __ProxyFullyDynamicInterned(wps_model_number, wps_model_number_id);
     __ProxyFullyDynamic(wps_serial_number, std::string, std::string, std::string, tracker_element_string, wps_serial_number_id);
     __ProxyFullyDynamic(wps_uuid_e, std::string, std::string, std::string, tracker_element_byte_array, wps_uuid_e_id);
 
@@ -658,7 +659,7 @@ public:
         return r;
     }
 
-    __Proxy(ssid, std::string, std::string, std::string, ssid);
+    __ProxyInterned(ssid, ssid);
     __Proxy(ssid_len, uint32_t, unsigned int, unsigned int, ssid_len);
 
     __Proxy(ssid_hash, uint64_t, uint64_t, uint64_t, ssid_hash);
@@ -670,15 +671,15 @@ public:
     __Proxy(ssid_beacon, uint8_t, bool, bool, ssid_beacon);
     __Proxy(ssid_probe_response, uint8_t, bool, bool, ssid_probe_response);
 
-    __Proxy(channel, std::string, std::string, std::string, channel);
-    __Proxy(ht_mode, std::string, std::string, std::string, ht_mode);
+    __ProxyInterned(channel, channel);
+    __ProxyInterned(ht_mode, ht_mode);
     __Proxy(ht_center_1, uint64_t, uint64_t, uint64_t, ht_center_1);
     __Proxy(ht_center_2, uint64_t, uint64_t, uint64_t, ht_center_2);
 
     __Proxy(first_time, uint64_t, time_t, time_t, first_time);
     __Proxy(last_time, uint64_t, time_t, time_t, last_time);
 
-    __ProxyFullyDynamic(beacon_info, std::string, std::string, std::string, tracker_element_string, beacon_info_id);
+    __ProxyFullyDynamicInterned(beacon_info, beacon_info_id);
 
     __Proxy(ssid_cloaked, uint8_t, bool, bool, ssid_cloaked);
 
@@ -696,8 +697,7 @@ public:
 
     __Proxy(ietag_checksum, uint32_t, uint32_t, uint32_t, ietag_checksum);
 
-    __ProxyFullyDynamic(dot11d_country, std::string, std::string, std::string, tracker_element_string, 
-            dot11d_country_id);
+    __ProxyFullyDynamicInterned(dot11d_country, dot11d_country_id);
 
     __ProxyFullyDynamicTrackable(dot11d_vec, tracker_element_vector, dot11d_vec_id);
     void set_dot11d_vec(std::vector<dot11_packinfo_dot11d_entry> vec);
@@ -706,13 +706,10 @@ public:
     __ProxyFullyDynamic(wps_state, uint32_t, uint32_t, uint32_t, tracker_element_uint32, wps_state_id);
     __ProxyFullyDynamic(wps_config_methods, uint16_t, uint16_t, uint16_t, tracker_element_uint16,
             wps_config_methods_id);
-    __ProxyFullyDynamic(wps_manuf, std::string, std::string, std::string, tracker_element_string, wps_manuf_id);
-    __ProxyFullyDynamic(wps_device_name, std::string, std::string, std::string, tracker_element_string, 
-            wps_device_name_id);
-    __ProxyFullyDynamic(wps_model_name, std::string, std::string, std::string, tracker_element_string,
-            wps_model_name_id);
-    __ProxyFullyDynamic(wps_model_number, std::string, std::string, std::string, tracker_element_string,
-            wps_model_number_id);
+    __ProxyFullyDynamicInterned(wps_manuf, wps_manuf_id);
+    __ProxyFullyDynamicInterned(wps_device_name, wps_device_name_id);
+    __ProxyFullyDynamicInterned(wps_model_name, wps_model_name_id);
+    __ProxyFullyDynamicInterned(wps_model_number, wps_model_number_id);
     __ProxyFullyDynamic(wps_serial_number, std::string, std::string, std::string, tracker_element_string,
             wps_serial_number_id);
     __ProxyFullyDynamic(wps_uuid_e, std::string, std::string, std::string, tracker_element_string,
@@ -736,7 +733,7 @@ public:
 
     void set_ietag_content_from_packet(std::shared_ptr<dot11_ie> tags);
 
-    __ProxyFullyDynamic(meshid, std::string, std::string, std::string, tracker_element_string, meshid_id);
+    __ProxyFullyDynamicInterned(meshid, meshid_id);
 	__ProxyFullyDynamic(mesh_gateway, uint8_t, bool, bool, tracker_element_uint8, mesh_gateway_id);
 	__ProxyFullyDynamic(mesh_peerings, uint8_t, uint8_t, uint8_t, tracker_element_uint8, mesh_peerings_id);
 	__ProxyFullyDynamic(mesh_forwarding, uint8_t, bool, bool, tracker_element_uint8, mesh_forwarding_id);
@@ -1277,6 +1274,52 @@ public:
         last_adv_ssid = adv_ssid;
     }
 
+    // Recently processed beacon / probe response variants, keyed on the stable IE
+    // checksum, and what they decoded to
+    struct adv_ie_cache_entry {
+        uint32_t ie_csum;
+        uint32_t beacon_fingerprint;
+        uint64_t cryptset;
+        std::string channel;
+        std::shared_ptr<dot11_advertised_ssid> ssid;
+    };
+
+    // Find a cached variant and move it to the front
+    const adv_ie_cache_entry *find_adv_ie_cache(uint32_t csum) {
+        for (auto i = adv_ie_cache.begin(); i != adv_ie_cache.end(); ++i) {
+            if (i->ie_csum != csum)
+                continue;
+
+            if (i != adv_ie_cache.begin())
+                std::rotate(adv_ie_cache.begin(), i, i + 1);
+
+            return &adv_ie_cache.front();
+        }
+
+        return nullptr;
+    }
+
+    void cache_adv_ie(uint32_t csum, uint32_t fingerprint, uint64_t cryptset,
+            const std::string& channel, std::shared_ptr<dot11_advertised_ssid> adv_ssid) {
+        auto i = std::find_if(adv_ie_cache.begin(), adv_ie_cache.end(),
+                [csum](const adv_ie_cache_entry& e) { return e.ie_csum == csum; });
+
+        if (i == adv_ie_cache.end()) {
+            if (adv_ie_cache.size() >= adv_ie_cache_max)
+                adv_ie_cache.pop_back();
+            adv_ie_cache.insert(adv_ie_cache.begin(),
+                    adv_ie_cache_entry{csum, fingerprint, cryptset, channel, adv_ssid});
+            return;
+        }
+
+        *i = adv_ie_cache_entry{csum, fingerprint, cryptset, channel, adv_ssid};
+        std::rotate(adv_ie_cache.begin(), i, i + 1);
+    }
+
+    void clear_adv_ie_cache() {
+        adv_ie_cache.clear();
+    }
+
     virtual void pre_serialize() override {
         if (client_map != nullptr)
             set_num_client_aps(client_map->size());
@@ -1615,6 +1658,14 @@ protected:
     uint32_t last_adv_ie_csum;
     std::shared_ptr<dot11_advertised_ssid> last_adv_ssid;
 
+    static constexpr size_t adv_ie_cache_max = 8;
+    std::vector<adv_ie_cache_entry> adv_ie_cache;
+
+    // Pcap packet records of the eapol frames kept per target in the wpa key map,
+    // rendered as frames arrive so handshake downloads don't re-assemble them.  Records
+    // are only created for targets present in the wpa key map and share its lifetime.
+    std::unordered_map<mac_addr, std::string> handshake_pcap_records;
+
     // Advertised in association requests but device-centric
     std::shared_ptr<tracker_element_uint8> min_tx_power;
     std::shared_ptr<tracker_element_uint8> max_tx_power;
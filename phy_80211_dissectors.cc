@@ -25,6 +25,7 @@
 #include <inttypes.h>
 #endif
 
+#include <array>
 #include <map>
 #include <iomanip>
 #include <sstream>
@@ -35,6 +36,7 @@
 #include "endian_magic.h"
 #include "phy_80211.h"
 #include "phy_80211_packetsignatures.h"
+#include "kis_string_scan.h"
 #include "packetchain.h"
 #include "alertracker.h"
 #include "configfile.h"
@@ -113,6 +115,20 @@ const double mcs_table[][4] = {
 };
 const int MCS_MAX = 32;
 
+// HT MCS names as reported in the rate list, built once instead of per beacon;
+// MCS32 is only the 40MHz duplicate mode
+static const std::string& dot11_ht_mcs_name(int mcsindex) {
+    static const auto names = []() {
+        std::array<std::string, MCS_MAX + 1> n;
+        for (int i = 0; i < MCS_MAX; i++)
+            n[i] = fmt::format("MCS{}", i);
+        n[MCS_MAX] = fmt::format("MCS{}(HTDUP)", MCS_MAX);
+        return n;
+    }();
+
+    return names[mcsindex];
+}
+
 // Indexed by VHT MCS index; contains base rates + extended vht
 // rates ordered as 0-9 per stream
 
@@ -172,61 +188,57 @@ const double vht_mcs_table[][8] {
 };
 const int VHT_MCS_MAX = 40;
 
-// CRC32 index for verifying WEP - cribbed from ethereal
-static const uint32_t dot11_wep_crc32_table[256] = {
-    0x00000000L, 0x77073096L, 0xee0e612cL, 0x990951baL, 0x076dc419L,
-    0x706af48fL, 0xe963a535L, 0x9e6495a3L, 0x0edb8832L, 0x79dcb8a4L,
-    0xe0d5e91eL, 0x97d2d988L, 0x09b64c2bL, 0x7eb17cbdL, 0xe7b82d07L,
-    0x90bf1d91L, 0x1db71064L, 0x6ab020f2L, 0xf3b97148L, 0x84be41deL,
-    0x1adad47dL, 0x6ddde4ebL, 0xf4d4b551L, 0x83d385c7L, 0x136c9856L,
-    0x646ba8c0L, 0xfd62f97aL, 0x8a65c9ecL, 0x14015c4fL, 0x63066cd9L,
-    0xfa0f3d63L, 0x8d080df5L, 0x3b6e20c8L, 0x4c69105eL, 0xd56041e4L,
-    0xa2677172L, 0x3c03e4d1L, 0x4b04d447L, 0xd20d85fdL, 0xa50ab56bL,
-    0x35b5a8faL, 0x42b2986cL, 0xdbbbc9d6L, 0xacbcf940L, 0x32d86ce3L,
-    0x45df5c75L, 0xdcd60dcfL, 0xabd13d59L, 0x26d930acL, 0x51de003aL,
-    0xc8d75180L, 0xbfd06116L, 0x21b4f4b5L, 0x56b3c423L, 0xcfba9599L,
-    0xb8bda50fL, 0x2802b89eL, 0x5f058808L, 0xc60cd9b2L, 0xb10be924L,
-    0x2f6f7c87L, 0x58684c11L, 0xc1611dabL, 0xb6662d3dL, 0x76dc4190L,
-    0x01db7106L, 0x98d220bcL, 0xefd5102aL, 0x71b18589L, 0x06b6b51fL,
-    0x9fbfe4a5L, 0xe8b8d433L, 0x7807c9a2L, 0x0f00f934L, 0x9609a88eL,
-    0xe10e9818L, 0x7f6a0dbbL, 0x086d3d2dL, 0x91646c97L, 0xe6635c01L,
-    0x6b6b51f4L, 0x1c6c6162L, 0x856530d8L, 0xf262004eL, 0x6c0695edL,
-    0x1b01a57bL, 0x8208f4c1L, 0xf50fc457L, 0x65b0d9c6L, 0x12b7e950L,
-    0x8bbeb8eaL, 0xfcb9887cL, 0x62dd1ddfL, 0x15da2d49L, 0x8cd37cf3L,
-    0xfbd44c65L, 0x4db26158L, 0x3ab551ceL, 0xa3bc0074L, 0xd4bb30e2L,
-    0x4adfa541L, 0x3dd895d7L, 0xa4d1c46dL, 0xd3d6f4fbL, 0x4369e96aL,
-    0x346ed9fcL, 0xad678846L, 0xda60b8d0L, 0x44042d73L, 0x33031de5L,
-    0xaa0a4c5fL, 0xdd0d7cc9L, 0x5005713cL, 0x270241aaL, 0xbe0b1010L,
-    0xc90c2086L, 0x5768b525L, 0x206f85b3L, 0xb966d409L, 0xce61e49fL,
-    0x5edef90eL, 0x29d9c998L, 0xb0d09822L, 0xc7d7a8b4L, 0x59b33d17L,
-    0x2eb40d81L, 0xb7bd5c3bL, 0xc0ba6cadL, 0xedb88320L, 0x9abfb3b6L,
-    0x03b6e20cL, 0x74b1d29aL, 0xead54739L, 0x9dd277afL, 0x04db2615L,
-    0x73dc1683L, 0xe3630b12L, 0x94643b84L, 0x0d6d6a3eL, 0x7a6a5aa8L,
-    0xe40ecf0bL, 0x9309ff9dL, 0x0a00ae27L, 0x7d079eb1L, 0xf00f9344L,
-    0x8708a3d2L, 0x1e01f268L, 0x6906c2feL, 0xf762575dL, 0x806567cbL,
-    0x196c3671L, 0x6e6b06e7L, 0xfed41b76L, 0x89d32be0L, 0x10da7a5aL,
-    0x67dd4accL, 0xf9b9df6fL, 0x8ebeeff9L, 0x17b7be43L, 0x60b08ed5L,
-    0xd6d6a3e8L, 0xa1d1937eL, 0x38d8c2c4L, 0x4fdff252L, 0xd1bb67f1L,
-    0xa6bc5767L, 0x3fb506ddL, 0x48b2364bL, 0xd80d2bdaL, 0xaf0a1b4cL,
-    0x36034af6L, 0x41047a60L, 0xdf60efc3L, 0xa867df55L, 0x316e8eefL,
-    0x4669be79L, 0xcb61b38cL, 0xbc66831aL, 0x256fd2a0L, 0x5268e236L,
-    0xcc0c7795L, 0xbb0b4703L, 0x220216b9L, 0x5505262fL, 0xc5ba3bbeL,
-    0xb2bd0b28L, 0x2bb45a92L, 0x5cb36a04L, 0xc2d7ffa7L, 0xb5d0cf31L,
-    0x2cd99e8bL, 0x5bdeae1dL, 0x9b64c2b0L, 0xec63f226L, 0x756aa39cL,
-    0x026d930aL, 0x9c0906a9L, 0xeb0e363fL, 0x72076785L, 0x05005713L,
-    0x95bf4a82L, 0xe2b87a14L, 0x7bb12baeL, 0x0cb61b38L, 0x92d28e9bL,
-    0xe5d5be0dL, 0x7cdcefb7L, 0x0bdbdf21L, 0x86d3d2d4L, 0xf1d4e242L,
-    0x68ddb3f8L, 0x1fda836eL, 0x81be16cdL, 0xf6b9265bL, 0x6fb077e1L,
-    0x18b74777L, 0x88085ae6L, 0xff0f6a70L, 0x66063bcaL, 0x11010b5cL,
-    0x8f659effL, 0xf862ae69L, 0x616bffd3L, 0x166ccf45L, 0xa00ae278L,
-    0xd70dd2eeL, 0x4e048354L, 0x3903b3c2L, 0xa7672661L, 0xd06016f7L,
-    0x4969474dL, 0x3e6e77dbL, 0xaed16a4aL, 0xd9d65adcL, 0x40df0b66L,
-    0x37d83bf0L, 0xa9bcae53L, 0xdebb9ec5L, 0x47b2cf7fL, 0x30b5ffe9L,
-    0xbdbdf21cL, 0xcabac28aL, 0x53b39330L, 0x24b4a3a6L, 0xbad03605L,
-    0xcdd70693L, 0x54de5729L, 0x23d967bfL, 0xb3667a2eL, 0xc4614ab8L,
-    0x5d681b02L, 0x2a6f2b94L, 0xb40bbe37L, 0xc30c8ea1L, 0x5a05df1bL,
-    0x2d02ef8dL
-};
+// Checksum the parts of a beacon or probe response which identify which variant the
+// AP sent, without parsing the IEs:  the beacon interval and capabilities, and every
+// IE tag except the ones which change from beacon to beacon.  Contiguous runs of
+// stable tags are checksummed at once.  The BSS load is picked up on the way past
+// so it can be refreshed without a full dissection.
+static void dot11_stable_ie_checksum(dot11_packinfo *packinfo, const uint8_t *data, size_t len) {
+    uint8_t subtype = packinfo->subtype;
+
+    // Skip the 8 byte timestamp at the start of the fixed parameters
+    uint32_t csum = crc32_fast(&subtype, 1);
+    csum = crc32_fast(data + 32, 4, csum);
+
+    size_t pos = packinfo->header_offset;
+    size_t run = pos;
+
+    while (pos + 2 <= len) {
+        uint8_t tag_len = data[pos + 1];
+        size_t tag_end = pos + 2 + tag_len;
+
+        if (tag_end > len)
+            break;
+
+        switch (data[pos]) {
+            case 11:
+                // BSS load
+                if (tag_len == 4 || tag_len == 5) {
+                    packinfo->qbss_stations = data[pos + 2] | (data[pos + 3] << 8);
+                    packinfo->qbss_chan_util = data[pos + 4];
+                }
+                [[fallthrough]];
+            case 5:
+                // TIM
+            case 40:
+                // Quiet
+                if (pos > run)
+                    csum = crc32_fast(data + run, pos - run, csum);
+                run = tag_end;
+                break;
+            default:
+                break;
+        }
+
+        pos = tag_end;
+    }
+
+    // Trailing stable tags and any truncated tag
+    if (len > run)
+        csum = crc32_fast(data + run, len - run, csum);
+
+    packinfo->ietag_stable_csum = csum;
+}
 
 // Convert WPA cipher elements into crypt_set stuff
 int kis_80211_phy::wpa_cipher_conv(uint8_t cipher_index) {
@@ -282,6 +294,144 @@ int kis_80211_phy::wpa_key_mgt_conv(uint8_t mgt_index) {
     return ret;
 }
 
+// Everything the dissector needs to know about a frame before it looks at the body
+// is fixed by the type and subtype in the frame control, so it is resolved once at
+// compile time instead of walking a chain of branches per packet.  Address roles
+// are indexes into the addr0..addr3 header slots, or -1 when the frame doesn't
+// carry that role.
+struct dot11_fc_dispatch {
+    int subtype;
+    // Shortest captured frame which isn't corrupt
+    uint8_t min_len;
+    // Body offset for management frames, or the QoS control length for data frames
+    uint8_t header_offset;
+    // Management frames with fixed parameters at byte 24
+    bool fixparm;
+    // Management frames with a tagged IE body we checksum
+    bool ie_csum;
+    int8_t dest;
+    int8_t source;
+    int8_t bssid;
+};
+
+static constexpr dot11_fc_dispatch fc_unknown() {
+    return {packet_sub_unknown, 0, 0, false, false, -1, -1, -1};
+}
+
+static constexpr dot11_fc_dispatch fc_mgmt(int subtype, uint8_t min_len, uint8_t offset,
+        bool fixparm, bool ie_csum) {
+    return {subtype, min_len, offset, fixparm, ie_csum, 0, 1, 2};
+}
+
+static constexpr dot11_fc_dispatch fc_phy(int subtype, uint8_t min_len,
+        int8_t dest, int8_t source, int8_t bssid) {
+    return {subtype, min_len, 0, false, false, dest, source, bssid};
+}
+
+static constexpr dot11_fc_dispatch fc_data(int subtype, uint8_t qos_len) {
+    return {subtype, 0, qos_len, false, false, -1, -1, -1};
+}
+
+static constexpr dot11_fc_dispatch dot11_fc_table[4][16] = {
+    // Management
+    {
+        fc_mgmt(packet_sub_association_req, 36, 24 + 4, true, true),
+        fc_mgmt(packet_sub_association_resp, 36, 24 + 12, true, true),
+        fc_mgmt(packet_sub_reassociation_req, 36, 24 + 10, true, true),
+        fc_mgmt(packet_sub_reassociation_resp, 0, 0, false, false),
+        fc_mgmt(packet_sub_probe_req, 0, 24, false, true),
+        fc_mgmt(packet_sub_probe_resp, 36, 24 + 12, true, true),
+        fc_unknown(),
+        fc_unknown(),
+        fc_mgmt(packet_sub_beacon, 36, 24 + 12, true, true),
+        fc_mgmt(packet_sub_atim, 36, 24 + 12, true, false),
+        fc_mgmt(packet_sub_disassociation, 0, 24, false, false),
+        fc_mgmt(packet_sub_authentication, 0, 24, false, false),
+        fc_mgmt(packet_sub_deauthentication, 0, 24, false, false),
+        // Action frames have their own structure and a non-traditional fixed
+        // parameters field
+        fc_mgmt(packet_sub_action, 30, 22, false, false),
+        fc_mgmt(packet_sub_action_noack, 30, 0, false, false),
+        fc_unknown(),
+    },
+    // Phy / control; these are shorter than a full header so only the addresses
+    // the frame actually carries are required
+    {
+        fc_unknown(),
+        fc_unknown(),
+        fc_unknown(),
+        fc_unknown(),
+        fc_unknown(),
+        fc_phy(packet_sub_vht_ndp, 16, 0, 1, -1),
+        fc_unknown(),
+        fc_unknown(),
+        fc_phy(packet_sub_block_ack_req, 16, 0, 1, -1),
+        fc_phy(packet_sub_block_ack, 16, 1, 0, -1),
+        fc_phy(packet_sub_pspoll, 0, -1, 0, 0),
+        fc_phy(packet_sub_rts, 16, 0, 1, -1),
+        fc_phy(packet_sub_cts, 0, 0, 0, -1),
+        fc_phy(packet_sub_ack, 0, 0, 0, -1),
+        fc_phy(packet_sub_cf_end, 0, -1, -1, -1),
+        fc_phy(packet_sub_cf_end_ack, 0, -1, -1, -1),
+    },
+    // Data
+    {
+        fc_data(packet_sub_data, 0),
+        fc_data(packet_sub_data_cf_ack, 0),
+        fc_data(packet_sub_data_cf_poll, 0),
+        fc_data(packet_sub_data_cf_ack_poll, 0),
+        fc_data(packet_sub_data_null, 0),
+        fc_data(packet_sub_cf_ack, 0),
+        fc_data(packet_sub_cf_ack_poll, 0),
+        fc_unknown(),
+        fc_data(packet_sub_data_qos_data, 2),
+        fc_data(packet_sub_data_qos_data_cf_ack, 2),
+        fc_data(packet_sub_data_qos_data_cf_poll, 2),
+        fc_data(packet_sub_data_qos_data_cf_ack_poll, 2),
+        fc_data(packet_sub_data_qos_null, 2),
+        fc_unknown(),
+        fc_data(packet_sub_data_qos_cf_poll_nod, 2),
+        fc_data(packet_sub_data_qos_cf_ack_poll, 2),
+    },
+    // Extension
+    {
+        fc_unknown(), fc_unknown(), fc_unknown(), fc_unknown(),
+        fc_unknown(), fc_unknown(), fc_unknown(), fc_unknown(),
+        fc_unknown(), fc_unknown(), fc_unknown(), fc_unknown(),
+        fc_unknown(), fc_unknown(), fc_unknown(), fc_unknown(),
+    },
+};
+
+// Distribution direction and data frame addressing, indexed by (to_ds << 1) | from_ds
+struct dot11_ds_dispatch {
+    ieee_80211_disttype distrib;
+    // Header length, and the shortest captured data frame which isn't corrupt
+    uint8_t header_len;
+    int8_t receive;
+    int8_t transmit;
+    int8_t dest;
+    int8_t source;
+    int8_t bssid;
+};
+
+static constexpr dot11_ds_dispatch dot11_ds_table[4] = {
+    {distrib_adhoc, 24, -1, -1, 0, 1, 2},
+    {distrib_from, 24, -1, -1, 0, 2, 1},
+    {distrib_to, 24, -1, -1, 2, 1, 0},
+    {distrib_inter, 30, 0, 1, 2, 3, -1},
+};
+
+// Header offsets of addr0..addr3; addr3 is only present on 4-address frames
+static constexpr unsigned int dot11_addr_offsets[4] = {4, 10, 16, 24};
+
+static inline mac_addr dot11_header_mac(const uint8_t *frame, int8_t slot) {
+    return mac_addr(frame + dot11_addr_offsets[slot], PHY80211_MAC_LEN);
+}
+
+static_assert(dot11_fc_table[packet_management][8].subtype == packet_sub_beacon);
+static_assert(dot11_fc_table[packet_phy][13].subtype == packet_sub_ack);
+static_assert(dot11_fc_table[packet_data][15].subtype == packet_sub_data_qos_cf_ack_poll);
+
 // This needs to be optimized and it needs to not use casting to do its magic
 int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
     if (in_pack->error) {
@@ -339,34 +489,21 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
         common->basic_crypt_set |= KIS_DEVICE_BASICCRYPT_ENCRYPTED;
     }
 
-    uint16_t duration = 0;
+    const auto frame = reinterpret_cast<const uint8_t *>(chunk->data());
 
-    // 18 bytes of normal address ranges
-    const uint8_t *addr0 = NULL;
-    const uint8_t *addr1 = NULL;
-    const uint8_t *addr2 = NULL;
-    // And an optional 6 bytes of address range for ds=0x03 packets
-    const uint8_t *addr3 = NULL;
+    // 18 bytes of normal address ranges; phy frames may only have addr0
+    const uint8_t *addr0 = &frame[4];
+    const uint8_t *addr1 = nullptr;
+    const uint8_t *addr2 = nullptr;
 
     // We'll fill these in as we go
     packinfo->type = packet_unknown;
     packinfo->subtype = packet_sub_unknown;
     packinfo->distrib = distrib_unknown;
 
-    // Endian swap the duration  ** Optimize this in the future **
-    memcpy(&duration, &(chunk->data()[2]), 2);
-    duration = kis_ntoh16(duration);
-
     // 2 bytes of sequence and fragment counts
     const wireless_fragseq *sequence;
 
-    // We always have addr0 even on phy
-    addr0 = reinterpret_cast<const uint8_t *>(&chunk->data()[4]);
-
-    // We may have addr1
-    if (chunk->length() >= 16)
-        addr1 = reinterpret_cast<const uint8_t *>(&chunk->data()[10]);
-
     if (fc->more_fragments)
         packinfo->fragmented = 1;
 
@@ -374,114 +511,31 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
         packinfo->retry = 1;
 
     // Assign the distribution direction this packet is traveling
-    if (fc->to_ds == 0 && fc->from_ds == 0)
-        packinfo->distrib = distrib_adhoc; 
-    else if (fc->to_ds == 0 && fc->from_ds == 1)
-        packinfo->distrib = distrib_from;
-    else if (fc->to_ds == 1 && fc->from_ds == 0)
-        packinfo->distrib = distrib_to;
-    else if (fc->to_ds == 1 && fc->from_ds == 1)
-        packinfo->distrib = distrib_inter;
+    const auto& ds_dispatch = dot11_ds_table[(fc->to_ds << 1) | fc->from_ds];
+    const auto& fc_dispatch = dot11_fc_table[fc->type][fc->subtype];
+
+    packinfo->distrib = ds_dispatch.distrib;
 
     // Shortcut PHYs here because they're shorter than normal packets
     if (fc->type == packet_phy) {
         packinfo->type = packet_phy;
         common->type = packet_basic_phy;
 
-        if (fc->subtype == 5) { 
-            packinfo->subtype = packet_sub_vht_ndp;
-
-            if (addr0 == NULL || addr1 == NULL) {
-                packinfo->corrupt = 1;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-            }
-
-            packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-
-        } else if (fc->subtype == 8) {
-            packinfo->subtype = packet_sub_block_ack_req;
-
-            if (addr0 == NULL || addr1 == NULL) {
-                packinfo->corrupt = 1;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-            }
-
-            packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-
-        } else if (fc->subtype == 9) {
-            packinfo->subtype = packet_sub_block_ack;
-
-            if (addr0 == NULL || addr1 == NULL) {
-                packinfo->corrupt = 1;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-            }
-
-            packinfo->source_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->dest_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-        } else if (fc->subtype == 10) {
-            packinfo->subtype = packet_sub_pspoll;
-
-            if (addr0 == NULL) {
-                packinfo->corrupt = 1;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-            }
-
-            packinfo->source_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->bssid_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-
-        } else if (fc->subtype == 11) {
-            packinfo->subtype = packet_sub_rts;
-
-            if (addr0 == NULL || addr1 == NULL) {
-                packinfo->corrupt = 1;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-            }
-
-            packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-
-        } else if (fc->subtype == 12) {
-            packinfo->subtype = packet_sub_cts;
-
-            if (addr0 == NULL) {
-                packinfo->corrupt = 1;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-            }
-
-            packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-
-        } else if (fc->subtype == 13) {
-            packinfo->subtype = packet_sub_ack;
-
-            if (addr0 == NULL) {
-                packinfo->corrupt = 1;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-            }
-
-            packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-
-        } else if (fc->subtype == 14) {
-            packinfo->subtype = packet_sub_cf_end;
-
-        } else if (fc->subtype == 15) {
-            packinfo->subtype = packet_sub_cf_end_ack;
+        packinfo->subtype = static_cast<ieee_80211_subtype>(fc_dispatch.subtype);
 
-        } else {
-            // fmt::print(stderr, "debug - unknown type - {} {}\n", fc->type, fc->subtype);
-            packinfo->subtype = packet_sub_unknown;
+        if (chunk->length() < fc_dispatch.min_len) {
+            packinfo->corrupt = 1;
+            in_pack->insert(pack_comp_80211, packinfo);
+            return 0;
         }
 
+        if (fc_dispatch.dest >= 0)
+            packinfo->dest_mac = dot11_header_mac(frame, fc_dispatch.dest);
+        if (fc_dispatch.source >= 0)
+            packinfo->source_mac = dot11_header_mac(frame, fc_dispatch.source);
+        if (fc_dispatch.bssid >= 0)
+            packinfo->bssid_mac = dot11_header_mac(frame, fc_dispatch.bssid);
+
         // Fill in the common addressing before we bail on a phy
         common->source = packinfo->source_mac;
         common->dest = packinfo->dest_mac;
@@ -502,12 +556,9 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
     }
 
     // We must have room for addr0..2 in 24 bytes
-    addr1 = reinterpret_cast<const uint8_t *>(&chunk->data()[10]);
-    addr2 = reinterpret_cast<const uint8_t *>(&chunk->data()[16]);
-    sequence = reinterpret_cast<const wireless_fragseq *>(&chunk->data()[22]);
-
-    // addr3 goes up to byte 30 so before we can use it, make sure we know we've got the data
-    addr3 = reinterpret_cast<const uint8_t *>(&chunk->data()[24]);
+    addr1 = &frame[10];
+    addr2 = &frame[16];
+    sequence = reinterpret_cast<const wireless_fragseq *>(&frame[22]);
 
     packinfo->sequence_number = sequence->sequence;
     packinfo->frag_number = sequence->frag;
@@ -531,169 +582,44 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
         } 
         */
 
-        if (addr0 == NULL || addr1 == NULL || addr2 == NULL) {
+        if (chunk->length() < fc_dispatch.min_len) {
             packinfo->corrupt = 1;
             in_pack->insert(pack_comp_80211, packinfo);
             return 0;
         }
 
-        const fixed_parameters *fixparm = NULL;
-
-        switch (fc->subtype) {
-            case 0:
-                if (chunk->length() < 36) {
-                    packinfo->corrupt = 1;
-                    in_pack->insert(pack_comp_80211, packinfo);
-                    return 0;
-                }
-
-                if (chunk->data() == nullptr) {
-                    return 0;
-                }
-
-                fixparm = reinterpret_cast<const fixed_parameters *>(&chunk->data()[24]);
-                packinfo->header_offset = 24 + 4;
-
-                packinfo->subtype = packet_sub_association_req;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
-                packinfo->ietag_csum =
-                    crc32_fast(chunk->data() + packinfo->header_offset,
-                            chunk->length() - packinfo->header_offset);
-
-                break;
-
-            case 1:
-                if (chunk->length() < 36) {
-                    packinfo->corrupt = 1;
-                    in_pack->insert(pack_comp_80211, packinfo);
-                    return 0;
-                }
-
-                if (chunk->data() == nullptr) {
-                    return 0;
-                }
-
-                fixparm = reinterpret_cast<const fixed_parameters *>(&chunk->data()[24]);
-                packinfo->header_offset = 24 + 12;
-
-                packinfo->subtype = packet_sub_association_resp;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
-                packinfo->ietag_csum =
-                    crc32_fast(chunk->data() + packinfo->header_offset,
-                            chunk->length() - packinfo->header_offset);
-
-                break;
-
-            case 2:
-                if (chunk->length() < 36) {
-                    packinfo->corrupt = 1;
-                    in_pack->insert(pack_comp_80211, packinfo);
-                    return 0;
-                }
-
-                if (chunk->data() == nullptr) {
-                    return 0;
-                }
-                    
-
-                fixparm = reinterpret_cast<const fixed_parameters *>(&chunk->data()[24]);
-                packinfo->header_offset = 24 + 10;
-
-                packinfo->subtype = packet_sub_reassociation_req;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
-                packinfo->ietag_csum =
-                    crc32_fast(chunk->data() + packinfo->header_offset,
-                            chunk->length() - packinfo->header_offset);
+        const fixed_parameters *fixparm = nullptr;
 
-                break;
+        packinfo->subtype = static_cast<ieee_80211_subtype>(fc_dispatch.subtype);
 
-            case 3:
-                packinfo->subtype = packet_sub_reassociation_resp;
+        if (fc_dispatch.subtype != packet_sub_unknown) {
+            packinfo->header_offset = fc_dispatch.header_offset;
 
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-                break;
+            packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
+            packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
+            packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
+        }
 
-            case 4:
-                if (chunk->data() == nullptr)
-                    return 0;
+        if (fc_dispatch.fixparm)
+            fixparm = reinterpret_cast<const fixed_parameters *>(&chunk->data()[24]);
 
-                packinfo->subtype = packet_sub_probe_req;
+        if (fc_dispatch.ie_csum)
+            packinfo->ietag_csum =
+                crc32_fast(chunk->data() + packinfo->header_offset,
+                        chunk->length() - packinfo->header_offset);
 
+        // Per-subtype handling beyond the common header
+        switch (fc->subtype) {
+            case packet_sub_probe_req:
                 packinfo->distrib = distrib_to;
-
-                packinfo->header_offset = 24;
-                fixparm = NULL;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
-                packinfo->ietag_csum =
-                    crc32_fast(chunk->data() + packinfo->header_offset,
-                            chunk->length() - packinfo->header_offset);
-
                 break;
 
-            case 5:
-                if (chunk->length() < 36) {
-                    packinfo->corrupt = 1;
-                    in_pack->insert(pack_comp_80211, packinfo);
-                    return 0;
-                }
-
-                if (chunk->data() == nullptr) {
-                    return 0;
-                }
-
-                fixparm = reinterpret_cast<const fixed_parameters *>(&chunk->data()[24]);
-                packinfo->header_offset = 24 + 12;
-
-                packinfo->subtype = packet_sub_probe_resp;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
-                packinfo->ietag_csum =
-                    crc32_fast(chunk->data() + packinfo->header_offset,
-                                           chunk->length() - packinfo->header_offset);
-
+            case packet_sub_probe_resp:
+                dot11_stable_ie_checksum(packinfo.get(),
+                        reinterpret_cast<const uint8_t *>(chunk->data()), chunk->length());
                 break;
 
-            case 8:
-                if (chunk->length() < 36) {
-                    packinfo->corrupt = 1;
-                    in_pack->insert(pack_comp_80211, packinfo);
-                    return 0;
-                }
-
-                if (chunk->data() == nullptr) {
-                    return 0;
-                }
-
-                fixparm = reinterpret_cast<const fixed_parameters *>(&chunk->data()[24]);
-                packinfo->header_offset = 24 + 12;
-
-                packinfo->subtype = packet_sub_beacon;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
+            case packet_sub_beacon:
                 if (fixparm->wep) {
                     packinfo->cryptset |= crypt_wep;
                     common->basic_crypt_set |= KIS_DEVICE_BASICCRYPT_ENCRYPTED;
@@ -714,41 +640,12 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
 
                 packinfo->beacon_interval = kis_letoh16(fixparm->beacon);
 
-                packinfo->ietag_csum =
-                    crc32_fast(chunk->data() + packinfo->header_offset,
-                            chunk->length() - packinfo->header_offset);
-
-                break;
-
-            case 9:
-                if (chunk->length() < 36) {
-                    packinfo->corrupt = 1;
-                    in_pack->insert(pack_comp_80211, packinfo);
-                    return 0;
-                }
-
-                fixparm = reinterpret_cast<const fixed_parameters *>(&chunk->data()[24]);
-                packinfo->header_offset = 24 + 12;
-
-                packinfo->subtype = packet_sub_atim;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
+                dot11_stable_ie_checksum(packinfo.get(),
+                        reinterpret_cast<const uint8_t *>(chunk->data()), chunk->length());
 
-                packinfo->distrib = distrib_unknown;
                 break;
 
-            case 10:
-                packinfo->subtype = packet_sub_disassociation;
-
-                packinfo->header_offset = 24;
-                fixparm = NULL;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
+            case packet_sub_disassociation:
                 packinfo->mgt_reason_code = (uint16_t) *((uint16_t *) &(chunk->data()[24])); 
 
                 if ((packinfo->mgt_reason_code >= 25 && packinfo->mgt_reason_code <= 31) ||
@@ -762,29 +659,11 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
 
                 break;
 
-            case 11:
-                packinfo->subtype = packet_sub_authentication;
-
-                packinfo->header_offset = 24;
-                fixparm = NULL;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
+            case packet_sub_authentication:
                 packinfo->mgt_reason_code = (uint16_t) *((uint16_t *) &(chunk->data()[24])); 
                 break;
 
-            case 12:
-                packinfo->subtype = packet_sub_deauthentication;
-
-                packinfo->header_offset = 24;
-                fixparm = NULL;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
+            case packet_sub_deauthentication:
                 packinfo->mgt_reason_code = (uint16_t) *((uint16_t *) &(chunk->data()[24])); 
 
                 if ((packinfo->mgt_reason_code >= 25 && packinfo->mgt_reason_code <= 31) ||
@@ -798,24 +677,7 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
 
                 break;
 
-            case 13:
-                if (chunk->length() < 30) {
-                    packinfo->corrupt = 1;
-                    in_pack->insert(pack_comp_80211, packinfo);
-                    return 0;
-                }
-
-                packinfo->subtype = packet_sub_action;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
-                // Action frames have their own structure and a non-traditional
-                // fixed parameters field, handle it all here
-                packinfo->header_offset = 22;
-                fixparm = NULL;
-
+            case packet_sub_action:
                 // Action frames can be encrypted; we can't do anything with them if they are.
 
                 if (!fc->wep) {
@@ -851,11 +713,11 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
                             return 0;
                         }
 
-                        for (auto t : *(rmm_tags->tags())) {
-                            if (t->tag_num() == 52) {
+                        for (const auto& t : rmm_tags->tags()) {
+                            if (t.tag_num() == 52) {
                                 try {
                                     dot11_ie_52_rmm ie_rmm;
-                                    ie_rmm.parse(t->tag_data_stream());
+                                    ie_rmm.parse(t.tag_data());
 
                                     if (ie_rmm.channel_number() > 0xE0) {
                                         std::stringstream ss;
@@ -881,26 +743,10 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
                     }
                 }
 
-                break;
-
-            case 14:
-                if (chunk->length() < 30) {
-                    packinfo->corrupt = 1;
-                    in_pack->insert(pack_comp_80211, packinfo);
-                    return 0;
-                }
 
-                packinfo->subtype = packet_sub_action_noack;
-
-                fixparm = nullptr;
-
-                packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-                packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-                packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
                 break;
 
             default:
-                packinfo->subtype = packet_sub_unknown;
                 break;
         }
 
@@ -926,134 +772,38 @@ int kis_80211_phy::packet_dot11_dissector(std::shared_ptr<kis_packet> in_pack) {
         packinfo->type = packet_data;
         common->type = packet_basic_data;
 
-        switch (fc->subtype) {
-            case 0:
-                packinfo->subtype = packet_sub_data;
-                break;
-            case 1:
-                packinfo->subtype = packet_sub_data_cf_ack;
-                break;
-            case 2:
-                packinfo->subtype = packet_sub_data_cf_poll;
-                break;
-            case 3:
-                packinfo->subtype = packet_sub_data_cf_ack_poll;
-                break;
-            case 4:
-                packinfo->subtype = packet_sub_data_null;
-                break;
-            case 5:
-                packinfo->subtype = packet_sub_cf_ack;
-                break;
-            case 6:
-                packinfo->subtype = packet_sub_cf_ack_poll;
-                break;
-            case 8:
-                packinfo->subtype = packet_sub_data_qos_data;
-                packinfo->header_offset += 2;
-                break;
-            case 9:
-                packinfo->subtype = packet_sub_data_qos_data_cf_ack;
-                packinfo->header_offset += 2;
-                break;
-            case 10:
-                packinfo->subtype = packet_sub_data_qos_data_cf_poll;
-                packinfo->header_offset += 2;
-                break;
-            case 11:
-                packinfo->subtype = packet_sub_data_qos_data_cf_ack_poll;
-                packinfo->header_offset += 2;
-                break;
-            case 12:
-                packinfo->subtype = packet_sub_data_qos_null;
-                packinfo->header_offset += 2;
-                break;
-            case 14:
-                packinfo->subtype = packet_sub_data_qos_cf_poll_nod;
-                packinfo->header_offset += 2;
-                break;
-            case 15:
-                packinfo->subtype = packet_sub_data_qos_cf_ack_poll;
-                packinfo->header_offset += 2;
-                break;
-            default:
-                packinfo->corrupt = 1;
-                packinfo->subtype = packet_sub_unknown;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-        }
-
-        // Extract ID's
-        switch (packinfo->distrib) {
-        case distrib_adhoc:
-
-            packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-            packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
-            if (packinfo->bssid_mac.longmac == 0)
-                packinfo->bssid_mac = packinfo->source_mac;
-
-            packinfo->header_offset += 24;
-            break;
-        case distrib_from:
-            packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->bssid_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
-            packinfo->header_offset += 24;
-            break;
-        case distrib_to:
-            packinfo->bssid_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-            packinfo->dest_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-
-            packinfo->header_offset += 24;
-            break;
-        case distrib_inter:
-            // If we aren't long enough to hold a intra-ds packet, bail
-            if (chunk->length() < 30) {
-                // fprintf(stderr, "debug - distrib unknown, chunk %d\n", chunk->length);
-                packinfo->corrupt = 1;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-            }
-
-            packinfo->receive_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->transmit_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-            packinfo->dest_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr3, PHY80211_MAC_LEN);
-
-            packinfo->distrib = distrib_inter;
+        packinfo->subtype = static_cast<ieee_80211_subtype>(fc_dispatch.subtype);
 
-            // First byte of offsets
-            packinfo->header_offset += 30;
-            break;
-
-        case distrib_unknown:
-            // If we aren't long enough to hold a intra-ds packet, bail
-            if (chunk->length() < 30) {
-                packinfo->corrupt = 1;
-                in_pack->insert(pack_comp_80211, packinfo);
-                return 0;
-            }
-
-            packinfo->bssid_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-            packinfo->source_mac = mac_addr(addr3, PHY80211_MAC_LEN);
-            packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
-
-            packinfo->distrib = distrib_inter;
+        if (fc_dispatch.subtype == packet_sub_unknown) {
+            packinfo->corrupt = 1;
+            in_pack->insert(pack_comp_80211, packinfo);
+            return 0;
+        }
 
-            // First byte of offsets
-            packinfo->header_offset += 30;
-            break;
-        default:
+        // If we aren't long enough to hold a intra-ds packet, bail
+        if (chunk->length() < ds_dispatch.header_len) {
             packinfo->corrupt = 1;
             in_pack->insert(pack_comp_80211, packinfo);
             return 0;
-            break;
         }
 
+        // Extract ID's
+        if (ds_dispatch.receive >= 0)
+            packinfo->receive_mac = dot11_header_mac(frame, ds_dispatch.receive);
+        if (ds_dispatch.transmit >= 0)
+            packinfo->transmit_mac = dot11_header_mac(frame, ds_dispatch.transmit);
+        if (ds_dispatch.bssid >= 0)
+            packinfo->bssid_mac = dot11_header_mac(frame, ds_dispatch.bssid);
+
+        packinfo->dest_mac = dot11_header_mac(frame, ds_dispatch.dest);
+        packinfo->source_mac = dot11_header_mac(frame, ds_dispatch.source);
+
+        if (packinfo->distrib == distrib_adhoc && packinfo->bssid_mac.longmac == 0)
+            packinfo->bssid_mac = packinfo->source_mac;
+
+        // First byte of offsets, after any QoS control
+        packinfo->header_offset += fc_dispatch.header_offset + ds_dispatch.header_len;
+
         // WEP/Protected on data frames means encrypted, not WEP, sometimes
         if (fc->wep) {
             bool alt_crypt = false;
@@ -1237,45 +987,28 @@ std::shared_ptr<std::vector<kis_80211_phy::ie_tag_tuple>> kis_80211_phy::packet_
         if (chunk->dlt != KDLT_IEEE802_11)
             return packinfo->ie_tags_listed;
 
-        membuf tags_membuf((char *) &(chunk->data()[packinfo->header_offset]), 
-                (char *) &(chunk->data()[chunk->length()]));
-        std::istream istream_ietags(&tags_membuf);
+        if (packinfo->header_offset >= chunk->length())
+            return packinfo->ie_tags_listed;
 
 		packinfo->ie_tags = Globalreg::new_from_pool<dot11_ie>();
 
         try {
-            std::shared_ptr<kaitai::kstream> stream_ietags(new kaitai::kstream(&istream_ietags));
-            packinfo->ie_tags->parse(stream_ietags);
+            packinfo->ie_tags->parse((const char *) &(chunk->data()[packinfo->header_offset]),
+                    chunk->length() - packinfo->header_offset);
         } catch (const std::exception& e) {
             return packinfo->ie_tags_listed;
         }
     }
 
-    for (auto ie_tag : *(packinfo->ie_tags->tags())) {
-        if (ie_tag->tag_num() == 150) {
-            try {
-                ie_tag->tag_data_stream()->seek(0);
-
-				auto vendor = Globalreg::new_from_pool<dot11_ie_150_vendor>();
-                vendor->parse(ie_tag->tag_data_stream());
-
-                packinfo->ie_tags_listed->push_back(ie_tag_tuple{150, vendor->vendor_oui_int(), vendor->vendor_oui_type()});
-            } catch (const std::exception &e) {
+    for (const auto& ie_tag : packinfo->ie_tags->tags()) {
+        if (ie_tag.tag_num() == 150 || ie_tag.tag_num() == 221) {
+            if (!ie_tag.has_vendor_oui())
                 return packinfo->ie_tags_listed;
-            }
-        } else if (ie_tag->tag_num() == 221) {
-            try {
-                ie_tag->tag_data_stream()->seek(0);
-
-				auto vendor = Globalreg::new_from_pool<dot11_ie_221_vendor>();
-                vendor->parse(ie_tag->tag_data_stream());
 
-                packinfo->ie_tags_listed->push_back(ie_tag_tuple{221, vendor->vendor_oui_int(), vendor->vendor_oui_type()});
-            } catch (const std::exception &e) {
-                return packinfo->ie_tags_listed;
-            }
+            packinfo->ie_tags_listed->push_back(ie_tag_tuple{ie_tag.tag_num(), 
+                    ie_tag.vendor_oui_int(), ie_tag.vendor_oui_type()});
         } else {
-            packinfo->ie_tags_listed->push_back(ie_tag_tuple{ie_tag->tag_num(), 0, 0});
+            packinfo->ie_tags_listed->push_back(ie_tag_tuple{ie_tag.tag_num(), 0, 0});
         }
     }
 
@@ -1305,15 +1038,16 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         return 0;
 
     if (packinfo->ie_tags == nullptr) {
-        membuf tags_membuf((char *) &(chunk->data()[packinfo->header_offset]), 
-                (char *) &(chunk->data()[chunk->length()]));
-        std::istream istream_ietags(&tags_membuf);
+        if (packinfo->header_offset > chunk->length()) {
+            packinfo->corrupt = 1;
+            return -1;
+        }
 
 		packinfo->ie_tags = Globalreg::new_from_pool<dot11_ie>();
 
         try {
-            std::shared_ptr<kaitai::kstream> stream_ietags(new kaitai::kstream(&istream_ietags));
-            packinfo->ie_tags->parse(stream_ietags);
+            packinfo->ie_tags->parse((const char *) &(chunk->data()[packinfo->header_offset]),
+                    chunk->length() - packinfo->header_offset);
         } catch (const std::exception& e) {
             // fmt::print(stderr, "debug - IE tag structure corrupt\n");
             packinfo->corrupt = 1;
@@ -1330,38 +1064,24 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
     // bool seen_mcsrates = false;
     unsigned int wmmtspec_responses = 0;
 
-    for (auto ie_tag : *(packinfo->ie_tags->tags())) {
-        auto hash = std::hash<std::string>{};
+    for (const auto& ie_tag : packinfo->ie_tags->tags()) {
+        auto hash = std::hash<std::string_view>{};
 
-        if (ie_tag->tag_num() == 150) {
-            try {
-				auto vendor = Globalreg::new_from_pool<dot11_ie_150_vendor>();
-                vendor->parse(ie_tag->tag_data_stream());
-
-                packinfo->ietag_hash_map.insert(std::make_pair(ie_tag_tuple{150, vendor->vendor_oui_int(), 
-                    vendor->vendor_oui_type()}, hash(ie_tag->tag_data())));
-            } catch (const std::exception& e) {
+        if (ie_tag.tag_num() == 150 || ie_tag.tag_num() == 221) {
+            if (!ie_tag.has_vendor_oui()) {
                 packinfo->corrupt = 1;
                 return -1;
             }
-        } else if (ie_tag->tag_num() == 221) {
-            try {
-				auto vendor = Globalreg::new_from_pool<dot11_ie_221_vendor>();
-                vendor->parse(ie_tag->tag_data_stream());
 
-                packinfo->ietag_hash_map.insert(std::make_pair(ie_tag_tuple{221, vendor->vendor_oui_int(), 
-                    vendor->vendor_oui_type()}, hash(ie_tag->tag_data())));
-            } catch (const std::exception& e) {
-                packinfo->corrupt = 1;
-                return -1;
-            }
+            packinfo->ietag_hash_map.insert(std::make_pair(ie_tag_tuple{ie_tag.tag_num(), 
+                        ie_tag.vendor_oui_int(), ie_tag.vendor_oui_type()}, hash(ie_tag.tag_data())));
         } else {
-            packinfo->ietag_hash_map.insert(std::make_pair(ie_tag_tuple{ie_tag->tag_num(), 0, 0}, 
-                                                           hash(ie_tag->tag_data())));
+            packinfo->ietag_hash_map.insert(std::make_pair(ie_tag_tuple{ie_tag.tag_num(), 0, 0}, 
+                                                           hash(ie_tag.tag_data())));
         }
 
         // IE 0 SSID
-        if (ie_tag->tag_num() == 0) {
+        if (ie_tag.tag_num() == 0) {
             /*
             if (seen_ssid) {
                 fprintf(stderr, "debug - multiple SSID ie tags?\n");
@@ -1370,9 +1090,9 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
             seen_ssid = true;
             */
 
-            packinfo->ssid_len = ie_tag->tag_data().length();
-            packinfo->ssid_csum = kis_80211_phy::ssid_hash(ie_tag->tag_data().data(), 
-                    ie_tag->tag_data().length());
+            packinfo->ssid_len = ie_tag.tag_data().length();
+            packinfo->ssid_csum = kis_80211_phy::ssid_hash(ie_tag.tag_data().data(), 
+                    ie_tag.tag_data().length());
 
             if (packinfo->ssid_len == 0) {
                 packinfo->ssid_blank = true;
@@ -1380,10 +1100,12 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
             }
 
             if (packinfo->ssid_len <= DOT11_PROTO_SSID_LEN) {
-                if (ie_tag->tag_data().find_first_not_of('\0') == std::string::npos) {
+                if (ie_tag.tag_data().find_first_not_of('\0') == std::string::npos) {
                     packinfo->ssid_blank = true;
                 } else {
-                    packinfo->ssid = munge_to_printable(ie_tag->tag_data().data());
+                    // Historically the SSID ends at the first NUL
+                    auto ssid_v = ie_tag.tag_data();
+                    packinfo->ssid = munge_to_printable(std::string(ssid_v.substr(0, ssid_v.find('\0'))));
                 }
             } else { 
                 _ALERT(alert_longssid_ref, in_pack, packinfo,
@@ -1400,8 +1122,8 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
 
         // IE 1 Basic Rates
         // IE 50 Extended Rates
-        if (ie_tag->tag_num() == 1 || ie_tag->tag_num() == 50) {
-            if (ie_tag->tag_num() == 1) {
+        if (ie_tag.tag_num() == 1 || ie_tag.tag_num() == 50) {
+            if (ie_tag.tag_num() == 1) {
                 /*
                 if (seen_basicrates) {
                     fprintf(stderr, "debug - seen multiple basicrates?\n");
@@ -1412,7 +1134,7 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
 
             }
 
-            if (ie_tag->tag_num() == 50) {
+            if (ie_tag.tag_num() == 50) {
                 /*
                 if (seen_extendedrates) {
                     fprintf(stderr, "debug - seen multiple extendedrates?\n");
@@ -1422,7 +1144,7 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
                 */
             }
 
-            if (ie_tag->tag_data().find("\x75\xEB\x49") != std::string::npos) {
+            if (ie_tag.tag_data().find("\x75\xEB\x49") != std::string::npos) {
                 _ALERT(alert_msfdlinkrate_ref, in_pack, packinfo,
                         "MSF-style poisoned rate field in beacon for network " +
                         packinfo->bssid_mac.mac_to_string() + ", exploit attempt "
@@ -1433,7 +1155,7 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
             }
 
             std::vector<std::string> basicrates;
-            for (uint8_t r : ie_tag->tag_data()) {
+            for (uint8_t r : ie_tag.tag_data()) {
                 std::string rate;
 
                 switch (r) {
@@ -1579,14 +1301,14 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         }
 
         // IE 3 channel
-        if (ie_tag->tag_num() == 3) {
-            if (ie_tag->tag_len() > 1) {
+        if (ie_tag.tag_num() == 3) {
+            if (ie_tag.tag_len() != 1) {
                 std::string al = fmt::format("IEEE80211 packet from {0} to {1} BSSID {2} included an IE "
                         "tag {3} entry with an invalid length; IE {3} should be {4} bytes, but was {5}. "
                         "This may be indicative of an as-yet-unknown buffer overflow attempt against "
                         "the Wi-Fi drivers or firmware, but could also be caused by a misconfigured device.",
                         packinfo->source_mac, packinfo->dest_mac, packinfo->bssid_mac, 
-                        3, 1, ie_tag->tag_len());
+                        3, 1, ie_tag.tag_len());
 
                 alertracker->raise_alert(alert_bad_fixlen_ie, in_pack, 
                         packinfo->bssid_mac, packinfo->source_mac, 
@@ -1596,17 +1318,17 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
                 return -1;
             }
                 
-            packinfo->channel = fmt::format("{}", (uint8_t) (ie_tag->tag_data()[0]));
+            packinfo->channel = fmt::format("{}", (uint8_t) (ie_tag.tag_data()[0]));
             continue;
         }
 
         // IE 7 802.11d
-        if (ie_tag->tag_num() == 7) {
+        if (ie_tag.tag_num() == 7) {
             try {
                 dot11_ie_7_country dot11d;
                 // Allow fragmented 11d, take what we can parse
                 dot11d.set_allow_fragments(true);
-                dot11d.parse(ie_tag->tag_data_stream());
+                dot11d.parse(ie_tag.tag_data());
 
                 packinfo->dot11d_country = munge_to_printable(dot11d.country_code());
 
@@ -1632,11 +1354,10 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         }
 
         // IE 11 QBSS
-        if (ie_tag->tag_num() == 11) {
+        if (ie_tag.tag_num() == 11) {
             try {
 				auto qbss = Globalreg::new_from_pool<dot11_ie_11_qbss>();
-                ie_tag->tag_data_stream()->seek(0);
-                qbss->parse(ie_tag->tag_data_stream());
+                qbss->parse(ie_tag.tag_data());
                 packinfo->qbss = qbss;
             } catch (const std::exception& e) {
                 // fprintf(stderr, "debug - corrupt QBSS %s\n", e.what());
@@ -1648,10 +1369,10 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         }
 
         // IE 33 advertised txpower in probe req
-        if (ie_tag->tag_num() == 33) {
+        if (ie_tag.tag_num() == 33) {
             try {
 				packinfo->tx_power = Globalreg::new_from_pool<dot11_ie_33_power>();
-                packinfo->tx_power->parse(ie_tag->tag_data_stream());
+                packinfo->tx_power->parse(ie_tag.tag_data());
             } catch (const std::exception& e) {
                 // fmt::print(stderr, "debug - corrupt IE33 power: {}\n", e.what());
             }
@@ -1661,17 +1382,17 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
 #if 0
         // We don't use this, don't decode
         // IE 36, advertised supported channels in probe req
-        if (ie_tag->tag_num() == 36) {
+        if (ie_tag.tag_num() == 36) {
             try {
 				packinfo->supported_channels = Globalreg::new_from_pool<dot11_ie_36_supported_channels>();
-                packinfo->supported_channels->parse(ie_tag->tag_data_stream());
+                packinfo->supported_channels->parse(ie_tag.tag_data());
             } catch (const std::exception& e) {
                 // fmt::print(stderr, "debug  corrupt ie36 supported channels: {}\n", e.what());
             }
         }
 #endif
 
-        if (ie_tag->tag_num() == 45) {
+        if (ie_tag.tag_num() == 45) {
             /*
             if (seen_mcsrates) {
                 fprintf(stderr, "debug - duplicate ie45 mcs rates\n");
@@ -1684,9 +1405,7 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
 
             try {
 				auto ht = Globalreg::new_from_pool<dot11_ie_45_ht_cap>();
-                ht->parse(ie_tag->tag_data_stream());
-
-                std::stringstream mcsstream;
+                ht->parse(ie_tag.tag_data());
 
                 // See if we support 40mhz channels and aren't 40mhz intolerant
                 bool ch40 = (ht->ht_cap_40mhz_channel() && !ht->ht_cap_40mhz_intolerant());
@@ -1706,21 +1425,14 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
                                 continue;
 
                             if (mcsindex == 32) {
-                                if (ch40) {
-                                    mcsstream.str("");
-                                    mcsstream << "MCS" << mcsindex << "(" <<
-                                        "HTDUP" << ")";
-                                    mcsrates.push_back(mcsstream.str());
-                                }
+                                if (ch40)
+                                    mcsrates.push_back(dot11_ht_mcs_name(mcsindex));
 
                                 continue;
                             }
 
                             double rate;
 
-                            mcsstream.str("");
-                            mcsstream << "MCS" << mcsindex;
-
                             if (ch40 && gi40) {
                                 rate = mcs_table[mcsindex][CH40GI400];
                             } else if (ch40) {
@@ -1734,7 +1446,7 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
                             if (packinfo->maxrate < rate)
                                 packinfo->maxrate = rate;
 
-                            mcsrates.push_back(mcsstream.str());
+                            mcsrates.push_back(dot11_ht_mcs_name(mcsindex));
                         }
                     }
 
@@ -1752,12 +1464,12 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         }
 
         // IE 48, RSN
-        if (ie_tag->tag_num() == 48) {
+        if (ie_tag.tag_num() == 48) {
             bool rsn_invalid = false;
 
             try {
 				auto rsn = Globalreg::new_from_pool<dot11_ie_48_rsn>();
-                rsn->parse(ie_tag->tag_data_stream());
+                rsn->parse(ie_tag.tag_data());
 
                 // TODO - don't aggregate these in the future
 
@@ -1798,8 +1510,7 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
             if (rsn_invalid) {
                 try {
 					auto rsn = Globalreg::new_from_pool<dot11_ie_48_rsn_partial>();
-                    ie_tag->tag_data_stream()->seek(0);
-                    rsn->parse(ie_tag->tag_data_stream());
+                    rsn->parse(ie_tag.tag_data());
 
                     if (rsn->pairwise_count() > 1024) {
                         alertracker->raise_alert(alert_atheros_rsnloop_ref, 
@@ -1827,10 +1538,10 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         }
 
         // IE 54 Mobility
-        if (ie_tag->tag_num() == 54) {
+        if (ie_tag.tag_num() == 54) {
             try {
 				auto mobility = Globalreg::new_from_pool<dot11_ie_54_mobility>();
-                mobility->parse(ie_tag->tag_data_stream());
+                mobility->parse(ie_tag.tag_data());
                 packinfo->dot11r_mobility = mobility;
             } catch (const std::exception& e) {
                 packinfo->corrupt = 1;
@@ -1840,10 +1551,10 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         }
 
         // IE 61 HT
-        if (ie_tag->tag_num() == 61) {
+        if (ie_tag.tag_num() == 61) {
             try {
 				auto ht = Globalreg::new_from_pool<dot11_ie_61_ht_op>();
-                ht->parse(ie_tag->tag_data_stream());
+                ht->parse(ie_tag.tag_data());
                 packinfo->dot11ht = ht;
             } catch (const std::exception& e) {
                 // fprintf(stderr, "debug - unparsable HT\n");
@@ -1855,10 +1566,10 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         }
 
         // IE 133 CISCO CCX
-        if (ie_tag->tag_num() == 133) {
+        if (ie_tag.tag_num() == 133) {
             try {
 				auto ccx1 = Globalreg::new_from_pool<dot11_ie_133_cisco_ccx>();
-                ccx1->parse(ie_tag->tag_data_stream());
+                ccx1->parse(ie_tag.tag_data());
                 packinfo->beacon_info = munge_to_printable(ccx1->ap_name());
             } catch (const std::exception& e) {
                 // fprintf(stderr, "debug - ccx error %s\n", e.what());
@@ -1868,13 +1579,13 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
             continue;
         }
 
-        if (ie_tag->tag_num() == 127) {
-            if (ie_tag->tag_len() > 13) {
+        if (ie_tag.tag_num() == 127) {
+            if (ie_tag.tag_len() > 13) {
                 std::string al = fmt::format("IEEE80211 Access Point BSSID {} sent a beacon with "
                     "an invalid IE 127 Extended Capabilities tag; this may indicate attempts to "
                     "exploit Qualcomm drivers using the CVE-2019-10539 vulnerability.  Extended "
                     "capability tags should typically have 10-11 bytes, but saw {}.",
-                    packinfo->bssid_mac, ie_tag->tag_len());
+                    packinfo->bssid_mac, ie_tag.tag_len());
 
                 alertracker->raise_alert(alert_qcom_extended_ref, in_pack, 
                         packinfo->bssid_mac, packinfo->source_mac, 
@@ -1887,12 +1598,12 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         }
 
 		// IE 113 Mesh ID field
-		if (ie_tag->tag_num() == 113) {
+		if (ie_tag.tag_num() == 113) {
 			// If we have no SSID tag, use the mesh ID as the SSID checksum to differentiate
 			// between multiple mesh advertisements; otherwise use the SSID
 			if (packinfo->ssid_len == 0) {
-				packinfo->ssid_csum = kis_80211_phy::ssid_hash(ie_tag->tag_data().data(), 
-						ie_tag->tag_data().length());
+				packinfo->ssid_csum = kis_80211_phy::ssid_hash(ie_tag.tag_data().data(), 
+						ie_tag.tag_data().length());
 			}
 
             continue;
@@ -1900,10 +1611,10 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
 
         // IE 191 VHT Capabilities TODO compbine with VHT OP to derive actual usable
         // rate
-        if (ie_tag->tag_num() == 191) {
+        if (ie_tag.tag_num() == 191) {
             try {
 				auto vht = Globalreg::new_from_pool<dot11_ie_191_vht_cap>();
-                vht->parse(ie_tag->tag_data_stream());
+                vht->parse(ie_tag.tag_data());
 
                 bool gi80 = vht->vht_cap_80mhz_shortgi();
                 bool gi160 = vht->vht_cap_160mhz_shortgi();
@@ -1980,15 +1691,11 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
 
 
         // Vendor 150 collection
-        if (ie_tag->tag_num() == 150) {
+        if (ie_tag.tag_num() == 150) {
             try {
-				auto vendor = Globalreg::new_from_pool<dot11_ie_150_vendor>();
-                ie_tag->tag_data_stream()->seek(0);
-                vendor->parse(ie_tag->tag_data_stream());
-
-                if (vendor->vendor_oui_int() == dot11_ie_150_cisco_powerlevel::cisco_oui()) {
+                if (ie_tag.vendor_oui_int() == dot11_ie_150_cisco_powerlevel::cisco_oui()) {
 					auto ccx_power = Globalreg::new_from_pool<dot11_ie_150_cisco_powerlevel>();
-                    ccx_power->parse(vendor->vendor_tag_stream());
+                    ccx_power->parse(ie_tag.vendor_tag_data());
 
                     packinfo->ccx_txpower = ccx_power->cisco_ccx_txpower();
                 }
@@ -2001,10 +1708,10 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
         }
 
         // IE 192 VHT Operation
-        if (ie_tag->tag_num() == 192) {
+        if (ie_tag.tag_num() == 192) {
             try {
 				auto vht = Globalreg::new_from_pool<dot11_ie_192_vht_op>();
-                vht->parse(ie_tag->tag_data_stream());
+                vht->parse(ie_tag.tag_data());
                 packinfo->dot11vht = vht;
 
             } catch (const std::exception& e) {
@@ -2015,17 +1722,17 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
             continue;
         }
 
-        if (ie_tag->tag_num() == 221) {
+        if (ie_tag.tag_num() == 221) {
             try {
-				auto vendor = Globalreg::new_from_pool<dot11_ie_221_vendor>();
-                ie_tag->tag_data_stream()->seek(0);
-                vendor->parse(ie_tag->tag_data_stream());
+                // Vendor tags must hold at least the OUI and vendor type
+                if (ie_tag.tag_len() < 4)
+                    throw std::runtime_error("short IE 221 vendor tag");
 
                 // Match mis-sized WMM
                 if (packinfo->subtype == packet_sub_beacon &&
-                        vendor->vendor_oui_int() == 0x0050f2 &&
-                        vendor->vendor_oui_type() == 2 &&
-                        ie_tag->tag_data().length() > 24) {
+                        ie_tag.vendor_oui_int() == 0x0050f2 &&
+                        ie_tag.vendor_oui_type() == 2 &&
+                        ie_tag.tag_data().length() > 24) {
 
                     std::string al = "IEEE80211 Access Point BSSID " + 
                         packinfo->bssid_mac.mac_to_string() + " sent association "
@@ -2043,11 +1750,10 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
                 // CVE-2017-11013 
                 // https://pleasestopnamingvulnerabilities.com/
                 if (packinfo->subtype == packet_sub_association_resp &&
-                        vendor->vendor_oui_int() == 0x0050f2 &&
-                        vendor->vendor_oui_type() == 2) {
+                        ie_tag.vendor_oui_int() == 0x0050f2 &&
+                        ie_tag.vendor_oui_type() == 2) {
                     dot11_ie_221_ms_wmm wmm;
-                    vendor->vendor_tag_stream()->seek(0);
-                    wmm.parse(vendor->vendor_tag_stream());
+                    wmm.parse(ie_tag.vendor_tag_data());
 
                     if (wmm.wme_subtype() == 0x02) {
                         wmmtspec_responses++;
@@ -2070,20 +1776,18 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
                 }
 
                 // Look for DJI DroneID OUIs
-                if (vendor->vendor_oui_int() == dot11_ie_221_dji_droneid::vendor_oui()) {
+                if (ie_tag.vendor_oui_int() == dot11_ie_221_dji_droneid::vendor_oui()) {
 					auto droneid = Globalreg::new_from_pool<dot11_ie_221_dji_droneid>();
-                    vendor->vendor_tag_stream()->seek(0);
-                    droneid->parse(vendor->vendor_tag_stream());
+                    droneid->parse(ie_tag.vendor_tag_data());
 
                     packinfo->droneid = droneid;
                 }
 
                 // Look for MS/WFA WPA
-                if (vendor->vendor_oui_int() == dot11_ie_221_wfa_wpa::ms_wps_oui() && 
-                        vendor->vendor_oui_type() == dot11_ie_221_wfa_wpa::wfa_wpa_subtype()) {
+                if (ie_tag.vendor_oui_int() == dot11_ie_221_wfa_wpa::ms_wps_oui() && 
+                        ie_tag.vendor_oui_type() == dot11_ie_221_wfa_wpa::wfa_wpa_subtype()) {
 					auto wpa = Globalreg::new_from_pool<dot11_ie_221_wfa_wpa>();
-                    vendor->vendor_tag_stream()->seek(0);
-                    wpa->parse(vendor->vendor_tag_stream());
+                    wpa->parse(ie_tag.vendor_tag_data());
 
                     // Merge the group cipher
                     packinfo->cryptset |= 
@@ -2110,43 +1814,40 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
                 }
 
                 // Look for cisco client MFP
-                if (vendor->vendor_oui_int() == dot11_ie_221_cisco_client_mfp::cisco_oui() &&
-                        vendor->vendor_oui_type() == dot11_ie_221_cisco_client_mfp::client_mfp_subtype()) {
+                if (ie_tag.vendor_oui_int() == dot11_ie_221_cisco_client_mfp::cisco_oui() &&
+                        ie_tag.vendor_oui_type() == dot11_ie_221_cisco_client_mfp::client_mfp_subtype()) {
 					auto mfp = Globalreg::new_from_pool<dot11_ie_221_cisco_client_mfp>();
-                    vendor->vendor_tag_stream()->seek(0);
-                    mfp->parse(vendor->vendor_tag_stream());
+                    mfp->parse(ie_tag.vendor_tag_data());
 
                     packinfo->cisco_client_mfp = mfp->client_mfp();
                 }
 
                 // Look for wpa owe transitional tags
-                if (vendor->vendor_oui_int() == dot11_ie_221_owe_transition::vendor_oui()) {
-                    if (vendor->vendor_oui_type() == dot11_ie_221_owe_transition::owe_transition_subtype()) {
+                if (ie_tag.vendor_oui_int() == dot11_ie_221_owe_transition::vendor_oui()) {
+                    if (ie_tag.vendor_oui_type() == dot11_ie_221_owe_transition::owe_transition_subtype()) {
 						auto owe_trans = Globalreg::new_from_pool<dot11_ie_221_owe_transition>();
-                        vendor->vendor_tag_stream()->seek(0);
-                        owe_trans->parse(vendor->vendor_tag_stream());
+                        owe_trans->parse(ie_tag.vendor_tag_data());
                         packinfo->owe_transition = owe_trans;
                         packinfo->cryptset |= crypt_wpa_owe;
                     }
                 }
 
                 // Look for WFA p2p to check the rtlwifi exploit
-                if (vendor->vendor_oui_int() == dot11_ie_221_wfa::wfa_oui()) {
+                if (ie_tag.vendor_oui_int() == dot11_ie_221_wfa::wfa_oui()) {
 					auto wfa = Globalreg::new_from_pool<dot11_ie_221_wfa>();
-                    vendor->vendor_tag_stream()->seek(0);
-                    wfa->parse(vendor->vendor_tag_stream());
+                    wfa->parse(ie_tag.vendor_tag_data());
 
                     if (wfa->wfa_subtype() == dot11_ie_221_wfa::wfa_sub_p2p()) {
 						auto ietags = Globalreg::new_from_pool<dot11_wfa_p2p_ie>();
-                        ietags->parse(wfa->wfa_content_stream());
+                        ietags->parse(wfa->wfa_content());
 
-                        for (auto ie_tag : *(ietags->tags())) {
-                            if (ie_tag->tag_num() == 12) {
+                        for (auto p2p_tag : *(ietags->tags())) {
+                            if (p2p_tag->tag_num() == 12) {
                                 // Affected code in rtlwifi:
                                 // noa_num = (noa_len - 2) / 13;
                                 // if (noa_num > P2P_MAX_NOA_NUM) 
                                 // and P2P_MAX_NOA_NUM is 2, therefor:
-                                if (ie_tag->tag_len() > 28) {
+                                if (p2p_tag->tag_len() > 28) {
                                     alertracker->raise_alert(alert_rtlwifi_p2p_ref, in_pack,
                                             packinfo->bssid_mac, packinfo->source_mac, 
                                             packinfo->dest_mac, packinfo->other_mac,
@@ -2161,11 +1862,10 @@ int kis_80211_phy::packet_dot11_ie_dissector(std::shared_ptr<kis_packet> in_pack
                 }
 
                 // Look for WPS MS
-                if (vendor->vendor_oui_int() == dot11_ie_221_ms_wps::ms_wps_oui() && 
-                        vendor->vendor_oui_type() == dot11_ie_221_ms_wps::ms_wps_subtype()) {
+                if (ie_tag.vendor_oui_int() == dot11_ie_221_ms_wps::ms_wps_oui() && 
+                        ie_tag.vendor_oui_type() == dot11_ie_221_ms_wps::ms_wps_subtype()) {
 					auto wps = Globalreg::new_from_pool<dot11_ie_221_ms_wps>();
-                    vendor->vendor_tag_stream()->seek(0);
-                    wps->parse(vendor->vendor_tag_stream());
+                    wps->parse(ie_tag.vendor_tag_data());
 
                     for (auto wpselem : *(wps->wps_elements())) {
                         auto version = wpselem->sub_element_version();
@@ -2257,41 +1957,43 @@ std::shared_ptr<kis_datachunk> kis_80211_phy::DecryptWEP(std::shared_ptr<dot11_p
         unsigned char *in_key, int in_key_len,
         unsigned char *in_id) {
 
-    std::shared_ptr<kis_datachunk> manglechunk;
-
-    // printf("debug - decryptwep\n");
     if (in_packinfo->corrupt)
         return NULL;
 
-    // printf("debug - decryptwep dlt %u want %u\n", in_chunk->dlt, KDLT_IEEE802_11);
     // If we don't have a dot11 frame, throw it away
     if (in_chunk->dlt != KDLT_IEEE802_11)
         return NULL;
 
-    // printf("debug - decryptwep size len %u offt %u\n", in_chunk->length, in_packinfo->header_offset);
     // Bail on size check
     if (in_chunk->length() < in_packinfo->header_offset ||
         in_chunk->length() - in_packinfo->header_offset <= 8)
         return NULL;
 
-    // printf("debug - decryptwep data header offt %u test head %02x %02x %02x %02x offt %02x %02x %02x %02x\n", in_packinfo->header_offset, in_chunk->data[0], in_chunk->data[1], in_chunk->data[2], in_chunk->data[3], in_chunk->data[in_packinfo->header_offset], in_chunk->data[in_packinfo->header_offset+1], in_chunk->data[in_packinfo->header_offset+2], in_chunk->data[in_packinfo->header_offset+3]);
+    std::string keystream;
+    wep_keystream(keystream, (const uint8_t *) &(in_chunk->data()[in_packinfo->header_offset]),
+            in_key, in_key_len, in_id,
+            in_chunk->length() - in_packinfo->header_offset - 4);
+
+    return wep_apply_keystream(in_packinfo, in_chunk, keystream);
+}
+
+void kis_80211_phy::wep_keystream(std::string& keystream, const uint8_t *iv,
+        const unsigned char *in_key, int in_key_len,
+        const unsigned char *in_id, size_t len) {
 
-    // printf("debug - password\n");
     // Password field
-    char pwd[WEPKEY_MAX + 3];
+    unsigned char pwd[WEPKEY_MAX + 3];
     memset(pwd, 0, WEPKEY_MAX + 3);
 
     // Extract the IV and add it to the key
-    pwd[0] = in_chunk->data()[in_packinfo->header_offset + 0] & 0xFF;
-    pwd[1] = in_chunk->data()[in_packinfo->header_offset + 1] & 0xFF;
-    pwd[2] = in_chunk->data()[in_packinfo->header_offset + 2] & 0xFF;
+    pwd[0] = iv[0];
+    pwd[1] = iv[1];
+    pwd[2] = iv[2];
 
     // Add the supplied password to the key
     memcpy(pwd + 3, in_key, WEPKEY_MAX);
     int pwdlen = 3 + in_key_len;
 
-    // printf("debug - wep stuff\n");
-
     // Prepare the keyblock for the rc4 cipher
     unsigned char keyblock[256];
     memcpy(keyblock, in_id, 256);
@@ -2303,21 +2005,10 @@ std::shared_ptr<kis_datachunk> kis_80211_phy::DecryptWEP(std::shared_ptr<dot11_p
         keyblock[kbb] = oldkey;
     }
 
+    keystream.resize(len);
 
-    // Allocate the mangled chunk -- 4 byte IV/Key# gone, 4 byte ICV gone
-    char manglebuf[in_chunk->length() - 8];
-
-    // Decrypt the data payload and check the CRC
     kba = kbb = 0;
-    uint32_t crc = ~0;
-    uint8_t c_crc[4];
-    uint8_t icv[4];
-
-    // Copy the ICV into the CRC buffer for checking
-    memcpy(icv, &(in_chunk->data()[in_chunk->length() - 4]), 4);
-
-    for (unsigned int dpos = in_packinfo->header_offset + 4; 
-         dpos < in_chunk->length() - 4; dpos++) {
+    for (size_t kpos = 0; kpos < len; kpos++) {
         kba = (kba + 1) & 0xFF;
         kbb = (kbb + keyblock[kba]) & 0xFF;
 
@@ -2325,49 +2016,52 @@ std::shared_ptr<kis_datachunk> kis_80211_phy::DecryptWEP(std::shared_ptr<dot11_p
         keyblock[kba] = keyblock[kbb];
         keyblock[kbb] = oldkey;
 
-        // Decode the packet into the mangle chunk
-        manglebuf[dpos - 4] = 
-            in_chunk->data()[dpos] ^ keyblock[(keyblock[kba] + keyblock[kbb]) & 0xFF];
-
-        crc = dot11_wep_crc32_table[(crc ^ manglebuf[dpos - 4]) & 0xFF] ^ (crc >> 8);
+        keystream[kpos] = keyblock[(keyblock[kba] + keyblock[kbb]) & 0xFF];
     }
+}
 
-    // Check the CRC
-    crc = ~crc;
-    c_crc[0] = crc;
-    c_crc[1] = crc >> 8;
-    c_crc[2] = crc >> 16;
-    c_crc[3] = crc >> 24;
+std::shared_ptr<kis_datachunk> kis_80211_phy::wep_apply_keystream(std::shared_ptr<dot11_packinfo> in_packinfo,
+        std::shared_ptr<kis_datachunk> in_chunk, const std::string& keystream) {
 
-    int crcfailure = 0;
-    for (unsigned int crcpos = 0; crcpos < 4; crcpos++) {
-        kba = (kba + 1) & 0xFF;
-        kbb = (kbb + keyblock[kba]) & 0xFF;
+    // Encrypted payload and ICV follow the 4 byte IV/Key#
+    size_t crypt_start = in_packinfo->header_offset + 4;
+    size_t crypt_len = in_chunk->length() - crypt_start;
 
-        unsigned char oldkey = keyblock[kba];
-        keyblock[kba] = keyblock[kbb];
-        keyblock[kbb] = oldkey;
+    if (keystream.length() < crypt_len || crypt_len < 4)
+        return NULL;
 
-        if ((c_crc[crcpos] ^ keyblock[(keyblock[kba] + 
-                                       keyblock[kbb]) & 0xFF]) != icv[crcpos]) {
-            crcfailure = 1;
-            break;
-        }
-    }
+    size_t payload_len = crypt_len - 4;
+
+    auto data = (const uint8_t *) in_chunk->data();
+
+    // Check the ICV before building the decrypted frame
+    uint8_t icv[4];
+    for (unsigned int i = 0; i < 4; i++)
+        icv[i] = data[crypt_start + payload_len + i] ^ (uint8_t) keystream[payload_len + i];
+
+    // Mangled chunk -- 4 byte IV/Key# gone, 4 byte ICV gone
+    auto manglechunk = std::make_shared<kis_datachunk>();
+    manglechunk->dlt = KDLT_IEEE802_11;
 
-    // If the CRC check failed, delete the moddata
-    if (crcfailure) {
+    auto& manglebuf = manglechunk->raw();
+    manglebuf.resize(in_packinfo->header_offset + payload_len);
+
+    memcpy(&manglebuf[0], data, in_packinfo->header_offset);
+
+    for (size_t dpos = 0; dpos < payload_len; dpos++)
+        manglebuf[in_packinfo->header_offset + dpos] = data[crypt_start + dpos] ^ keystream[dpos];
+
+    uint32_t crc = crc32_fast(&manglebuf[in_packinfo->header_offset], payload_len);
+
+    if (icv[0] != (crc & 0xFF) || icv[1] != ((crc >> 8) & 0xFF) ||
+            icv[2] != ((crc >> 16) & 0xFF) || icv[3] != ((crc >> 24) & 0xFF))
         return NULL;
-    }
 
     // Remove the privacy flag in the mangled data
-    auto fc = reinterpret_cast<frame_control *>(manglebuf);
+    auto fc = reinterpret_cast<frame_control *>(&manglebuf[0]);
     fc->wep = 0;
 
-    manglechunk = std::make_shared<kis_datachunk>();
-    manglechunk->dlt = KDLT_IEEE802_11;
-    manglechunk->copy_raw_data(manglebuf, in_chunk->length() - 8);
-
+    manglechunk->set_data(manglebuf);
 
     return manglechunk;
 }
@@ -2411,16 +2105,50 @@ int kis_80211_phy::packet_wep_decryptor(std::shared_ptr<kis_packet> in_pack) {
     if (bwmitr == wepkeys.end())
         return 0;
 
-    manglechunk = DecryptWEP(packinfo, chunk, (bwmitr->second)->key, (bwmitr->second)->len, wep_identity);
+    if (packinfo->corrupt || chunk->length() < packinfo->header_offset ||
+            chunk->length() - packinfo->header_offset <= 8)
+        return 0;
+
+    auto wepkey = bwmitr->second;
+    auto iv_bytes = (const uint8_t *) &(chunk->data()[packinfo->header_offset]);
+    uint32_t iv = (iv_bytes[0] << 16) | (iv_bytes[1] << 8) | iv_bytes[2];
+    size_t keystream_len = chunk->length() - packinfo->header_offset - 4;
+
+    std::shared_ptr<std::string> keystream;
+
+    {
+        kis_lock_guard<kis_mutex> lk(wepkey->keystream_mutex);
+        auto ksi = wepkey->keystreams.find(iv);
+        if (ksi != wepkey->keystreams.end() && ksi->second->length() >= keystream_len)
+            keystream = ksi->second;
+    }
+
+    // Cached keystreams are never modified once published, a longer frame with the
+    // same IV replaces the entry with a longer keystream
+    if (keystream == nullptr) {
+        keystream = std::make_shared<std::string>();
+        wep_keystream(*keystream, iv_bytes, wepkey->key, wepkey->len, wep_identity, keystream_len);
+
+        kis_lock_guard<kis_mutex> lk(wepkey->keystream_mutex);
+
+        if (wepkey->keystreams.size() >= wep_keystream_cache_max)
+            wepkey->keystreams.clear();
+
+        wepkey->keystreams[iv] = keystream;
+    }
+
+    manglechunk = wep_apply_keystream(packinfo, chunk, *keystream);
 
     if (manglechunk == NULL) {
-        (bwmitr->second)->failed++;
+        wepkey->failed++;
         return 0;
     }
 
-    (bwmitr->second)->decrypted++;
+    wepkey->decrypted++;
     packinfo->decrypted = 1;
 
+    wep_decrypted_rrd->add_sample(1, Globalreg::globalreg->last_tv_sec);
+
     in_pack->insert(pack_comp_mangleframe, manglechunk);
 
     in_pack->erase(pack_comp_datapayload);
@@ -2437,6 +2165,44 @@ int kis_80211_phy::packet_wep_decryptor(std::shared_ptr<kis_packet> in_pack) {
     return 1;
 }
 
+int kis_80211_phy::packet_dot11_string_dissector(std::shared_ptr<kis_packet> in_pack) {
+    if (dissect_strings == 0)
+        return 0;
+
+    if (in_pack->error)
+        return 0;
+
+    auto packinfo = in_pack->fetch<dot11_packinfo>(pack_comp_80211);
+    if (packinfo == nullptr)
+        return 0;
+
+    if (packinfo->corrupt || packinfo->type != packet_data)
+        return 0;
+
+    // Only present for unencrypted frames, or after decryption
+    auto datachunk = in_pack->fetch<kis_datachunk>(pack_comp_datapayload);
+    if (datachunk == nullptr || datachunk->length() < string_extract_min_len)
+        return 0;
+
+    // Runs are found in place and only the ones we keep are copied
+    std::shared_ptr<kis_string_info> stringinfo;
+
+    for_each_printable_run((const uint8_t *) datachunk->data(), datachunk->length(),
+            string_extract_min_len, [&](const nonstd::string_view& run) -> bool {
+                if (stringinfo == nullptr)
+                    stringinfo = packetchain->new_packet_component<kis_string_info>();
+
+                stringinfo->extracted_strings.emplace_back(run.data(), run.length());
+
+                return stringinfo->extracted_strings.size() < string_extract_max_count;
+            });
+
+    if (stringinfo != nullptr)
+        in_pack->insert(pack_comp_strings, stringinfo);
+
+    return 1;
+}
+
 int kis_80211_phy::packet_dot11_wps_m3(std::shared_ptr<kis_packet> in_pack) {
     if (in_pack->error) {
         return 0;
@@ -2717,16 +2483,12 @@ kis_80211_phy::packet_dot11_eapol_handshake(std::shared_ptr<kis_packet> in_pack,
 				auto ietags = Globalreg::new_from_pool<dot11_ie>();
                 ietags->parse(rsnkey->wpa_key_data_stream());
 
-                for (auto ie_tag : *(ietags->tags())) {
-                    if (ie_tag->tag_num() == 221) {
-                        auto vendor = std::make_shared<dot11_ie_221_vendor>();
-                        ie_tag->tag_data_stream()->seek(0);
-                        vendor->parse(ie_tag->tag_data_stream());
-
-                        if (vendor->vendor_oui_int() == dot11_ie_221_rsn_pmkid::vendor_oui() &&
-                                vendor->vendor_oui_type() == dot11_ie_221_rsn_pmkid::rsnpmkid_subtype()) {
+                for (const auto& ie_tag : ietags->tags()) {
+                    if (ie_tag.tag_num() == 221) {
+                        if (ie_tag.vendor_oui_int() == dot11_ie_221_rsn_pmkid::vendor_oui() &&
+                                ie_tag.vendor_oui_type() == dot11_ie_221_rsn_pmkid::rsnpmkid_subtype()) {
                             dot11_ie_221_rsn_pmkid pmkid;
-                            pmkid.parse(vendor->vendor_tag_stream());
+                            pmkid.parse(ie_tag.vendor_tag_data());
 
                             // Log the pmkid for the decoders
                             eapol->set_rsnpmkid_bytes(pmkid.pmkid());
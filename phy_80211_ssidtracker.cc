@@ -85,37 +85,52 @@ void dot11_tracked_ssid_group::reserve_fields(std::shared_ptr<tracker_element_ma
 
 }
 
-void dot11_tracked_ssid_group::add_advertising_device(std::shared_ptr<kis_tracked_device_base> device) {
+bool dot11_tracked_ssid_group::add_advertising_device(std::shared_ptr<kis_tracked_device_base> device) {
     kis_lock_guard<kis_mutex> lk(mutex);
-    advertising_device_map->insert(device->get_key(), nullptr);
+    auto added = advertising_device_map->insert(device->get_key(), nullptr).second;
+
+    if (added)
+        set_advertising_device_len(advertising_device_map->size());
 
     if (device->get_first_time() < get_first_time() || get_first_time() == 0)
         set_first_time(device->get_first_time());
 
     if (device->get_last_time() > get_last_time())
         set_last_time(device->get_last_time());
+
+    return added;
 }
 
-void dot11_tracked_ssid_group::add_probing_device(std::shared_ptr<kis_tracked_device_base> device) {
+bool dot11_tracked_ssid_group::add_probing_device(std::shared_ptr<kis_tracked_device_base> device) {
     kis_lock_guard<kis_mutex> lk(mutex);
-    probing_device_map->insert(device->get_key(), nullptr);
+    auto added = probing_device_map->insert(device->get_key(), nullptr).second;
+
+    if (added)
+        set_probing_device_len(probing_device_map->size());
 
     if (device->get_first_time() < get_first_time() || get_first_time() == 0)
         set_first_time(device->get_first_time());
 
     if (device->get_last_time() > get_last_time())
         set_last_time(device->get_last_time());
+
+    return added;
 }
 
-void dot11_tracked_ssid_group::add_responding_device(std::shared_ptr<kis_tracked_device_base> device) {
+bool dot11_tracked_ssid_group::add_responding_device(std::shared_ptr<kis_tracked_device_base> device) {
     kis_lock_guard<kis_mutex> lk(mutex);
-    responding_device_map->insert(device->get_key(), nullptr);
+    auto added = responding_device_map->insert(device->get_key(), nullptr).second;
+
+    if (added)
+        set_responding_device_len(responding_device_map->size());
 
     if (device->get_first_time() < get_first_time() || get_first_time() == 0)
         set_first_time(device->get_first_time());
 
     if (device->get_last_time() > get_last_time())
         set_last_time(device->get_last_time());
+
+    return added;
 }
 
 phy_80211_ssid_tracker::phy_80211_ssid_tracker() {
@@ -131,6 +146,17 @@ phy_80211_ssid_tracker::phy_80211_ssid_tracker() {
                 "Tracked SSID grouping");
     group_builder = std::make_shared<dot11_tracked_ssid_group>(tracked_ssid_id);
 
+    last_time_field_id =
+        Globalreg::globalreg->entrytracker->get_field_id("dot11.ssidgroup.last_time");
+    crypt_field_id =
+        Globalreg::globalreg->entrytracker->get_field_id("dot11.ssidgroup.crypt_set");
+    advertising_len_field_id =
+        Globalreg::globalreg->entrytracker->get_field_id("dot11.ssidgroup.advertising_devices_len");
+    responding_len_field_id =
+        Globalreg::globalreg->entrytracker->get_field_id("dot11.ssidgroup.responding_devices_len");
+    probing_len_field_id =
+        Globalreg::globalreg->entrytracker->get_field_id("dot11.ssidgroup.probing_devices_len");
+
     ssid_vector = std::make_shared<tracker_element_vector>();
 
     ssid_tracking_enabled = true;
@@ -307,6 +333,117 @@ void phy_80211_ssid_tracker::ssid_endpoint_handler(std::shared_ptr<kis_net_beast
         transmit = wrapper_elem;
     }
 
+    // Ordering on an indexed column, or no ordering at all, without a search or regex can be
+    // served straight from the indexes; only the requested window is copied out
+    bool sorted = in_order_column_num.length() && order_field.size() > 0;
+    const ssid_index *order_index = nullptr;
+
+    if (sorted && order_field.size() == 1) {
+        if (order_field[0] == last_time_field_id)
+            order_index = &last_time_index;
+        else if (order_field[0] == crypt_field_id)
+            order_index = &crypt_index;
+        else if (order_field[0] == advertising_len_field_id)
+            order_index = &advertising_len_index;
+        else if (order_field[0] == responding_len_field_id)
+            order_index = &responding_len_index;
+        else if (order_field[0] == probing_len_field_id)
+            order_index = &probing_len_index;
+    }
+
+    if (search_term.length() == 0 && regex.is_null() &&
+            (!sorted || order_index != nullptr) &&
+            (timestamp_min <= 0 || !sorted || order_index == &last_time_index)) {
+        std::vector<std::shared_ptr<tracker_element>> window;
+
+        {
+            kis_lock_guard<kis_mutex> lk(mutex, "phy_80211_ssid_tracker ssid_endpoint_handler");
+
+            total_sz_elem->set(ssid_vector->size());
+
+            if (sorted) {
+                auto first = order_index->begin();
+                size_t filtered = order_index->size();
+
+                // Only the last time index can be sorted and time filtered at once, so the
+                // filter is a range of it
+                if (timestamp_min > 0) {
+                    first = order_index->lower_bound({(uint64_t) timestamp_min, 0});
+                    filtered = std::distance(first, order_index->end());
+                }
+
+                if (in_window_start >= filtered)
+                    in_window_start = 0;
+
+                auto take = [&](auto i, auto end) {
+                    std::advance(i, in_window_start);
+
+                    for (; i != end && (in_window_len == 0 || window.size() < in_window_len); ++i)
+                        window.push_back(ssid_map.find(i->second)->second.group);
+                };
+
+                // Same direction convention as the sorted full view
+                if (in_order_direction == 0)
+                    take(first, order_index->end());
+                else
+                    take(order_index->rbegin(), std::make_reverse_iterator(first));
+
+                filtered_sz_elem->set(filtered);
+            } else if (timestamp_min > 0) {
+                size_t filtered = 0;
+
+                for (const auto& e : *ssid_vector) {
+                    if (static_cast<dot11_tracked_ssid_group *>(e.get())->get_last_time() < timestamp_min)
+                        continue;
+
+                    if (filtered >= in_window_start &&
+                            (in_window_len == 0 || window.size() < in_window_len))
+                        window.push_back(e);
+
+                    filtered++;
+                }
+
+                // Past the end of the filtered list restarts at the beginning
+                if (in_window_start >= filtered && filtered > 0) {
+                    in_window_start = 0;
+
+                    for (const auto& e : *ssid_vector) {
+                        if (in_window_len != 0 && window.size() >= in_window_len)
+                            break;
+
+                        if (static_cast<dot11_tracked_ssid_group *>(e.get())->get_last_time() >= timestamp_min)
+                            window.push_back(e);
+                    }
+                }
+
+                filtered_sz_elem->set(filtered);
+            } else {
+                if (in_window_start >= ssid_vector->size())
+                    in_window_start = 0;
+
+                auto i = std::next(ssid_vector->begin(), in_window_start);
+                for (; i != ssid_vector->end() && (in_window_len == 0 || window.size() < in_window_len); ++i)
+                    window.push_back(*i);
+
+                filtered_sz_elem->set(ssid_vector->size());
+            }
+        }
+
+        start_elem->set(in_window_start);
+        length_elem->set(window.size());
+
+        for (const auto& w : window)
+            output_ssids_elem->push_back(summarize_tracker_element(w, summary_vec, rename_map));
+
+        if (transmit == nullptr)
+            transmit = output_ssids_elem;
+
+        Globalreg::globalreg->entrytracker->serialize(static_cast<std::string>(con->uri()), stream,
+                transmit, rename_map);
+
+        return;
+    }
+
     // Next vector we do work on
     auto next_work_vec = std::make_shared<tracker_element_vector>();
 
@@ -418,38 +555,22 @@ std::shared_ptr<tracker_element> phy_80211_ssid_tracker::detail_endpoint_handler
     if (k == ssid_map.end())
         throw std::runtime_error("unknown ssid");
 
-    return k->second;
+    return k->second.group;
 }
 
 
-void phy_80211_ssid_tracker::handle_broadcast_ssid(const std::string& ssid, unsigned int ssid_len, 
-        uint64_t crypt_set, std::shared_ptr<kis_tracked_device_base> device) {
-
-    if (!ssid_tracking_enabled)
-        return;
-
-    if (ssid_len == 0)
+void phy_80211_ssid_tracker::reindex(ssid_index& index, uint64_t& indexed, uint64_t value,
+        size_t hash) {
+    if (indexed == value)
         return;
 
-    auto key = kis_80211_phy::ssid_hash(ssid, ssid_len);
-
-    kis_lock_guard<kis_mutex> lk(mutex);
-
-    auto mapdev = ssid_map.find(key);
-
-    if (mapdev == ssid_map.end()) {
-        auto tssid = std::make_shared<dot11_tracked_ssid_group>(group_builder.get(), ssid, ssid_len, crypt_set);
-        tssid->add_advertising_device(device);
-        ssid_map[key] = tssid;
-        ssid_vector->push_back(tssid);
-    } else {
-        auto tssid = static_cast<dot11_tracked_ssid_group *>(mapdev->second.get());
-        tssid->add_advertising_device(device);
-    }
+    index.erase({indexed, hash});
+    indexed = value;
+    index.insert({value, hash});
 }
 
-void phy_80211_ssid_tracker::handle_response_ssid(const std::string& ssid, unsigned int ssid_len, 
-        uint64_t crypt_set, std::shared_ptr<kis_tracked_device_base> device) {
+void phy_80211_ssid_tracker::handle_ssid(const std::string& ssid, unsigned int ssid_len,
+        uint64_t crypt_set, std::shared_ptr<kis_tracked_device_base> device, ssid_role role) {
 
     if (!ssid_tracking_enabled)
         return;
@@ -465,40 +586,50 @@ void phy_80211_ssid_tracker::handle_response_ssid(const std::string& ssid, unsig
 
     if (mapdev == ssid_map.end()) {
         auto tssid = std::make_shared<dot11_tracked_ssid_group>(group_builder.get(), ssid, ssid_len, crypt_set);
-        tssid->add_responding_device(device);
-        ssid_map[key] = tssid;
         ssid_vector->push_back(tssid);
-    } else {
-        auto tssid = static_cast<dot11_tracked_ssid_group *>(mapdev->second.get());
-        tssid->add_responding_device(device);
-    }
-
-}
-
-void phy_80211_ssid_tracker::handle_probe_ssid(const std::string& ssid, unsigned int ssid_len, 
-        uint64_t crypt_set, std::shared_ptr<kis_tracked_device_base> device) {
 
-    if (!ssid_tracking_enabled)
-        return;
-
-    if (ssid_len == 0)
-        return;
+        mapdev = ssid_map.insert({key, ssid_group_entry{tssid, 0, 0, 0, 0}}).first;
 
-    auto key = kis_80211_phy::ssid_hash(ssid, ssid_len);
+        last_time_index.insert({0, key});
+        crypt_index.insert({tssid->get_crypt_set(), key});
+        advertising_len_index.insert({0, key});
+        responding_len_index.insert({0, key});
+        probing_len_index.insert({0, key});
+    }
 
-    kis_lock_guard<kis_mutex> lk(mutex);
+    auto& entry = mapdev->second;
+
+    // Most packets only refresh an existing device, so the indexes only move when
+    // the last-seen second changes or a device joins the group
+    switch (role) {
+        case ssid_role::advertising:
+            if (entry.group->add_advertising_device(device))
+                reindex(advertising_len_index, entry.advertising_len, entry.advertising_len + 1, key);
+            break;
+        case ssid_role::responding:
+            if (entry.group->add_responding_device(device))
+                reindex(responding_len_index, entry.responding_len, entry.responding_len + 1, key);
+            break;
+        case ssid_role::probing:
+            if (entry.group->add_probing_device(device))
+                reindex(probing_len_index, entry.probing_len, entry.probing_len + 1, key);
+            break;
+    }
 
-    auto mapdev = ssid_map.find(key);
+    reindex(last_time_index, entry.last_time, entry.group->get_last_time(), key);
+}
 
-    if (mapdev == ssid_map.end()) {
-        auto tssid = std::make_shared<dot11_tracked_ssid_group>(group_builder.get(), ssid, ssid_len, crypt_set);
-        tssid->add_probing_device(device);
-        ssid_map[key] = tssid;
-        ssid_vector->push_back(tssid);
-    } else {
-        auto tssid = static_cast<dot11_tracked_ssid_group *>(mapdev->second.get());
-        tssid->add_probing_device(device);
-    }
+void phy_80211_ssid_tracker::handle_broadcast_ssid(const std::string& ssid, unsigned int ssid_len, 
+        uint64_t crypt_set, std::shared_ptr<kis_tracked_device_base> device) {
+    handle_ssid(ssid, ssid_len, crypt_set, device, ssid_role::advertising);
+}
 
+void phy_80211_ssid_tracker::handle_response_ssid(const std::string& ssid, unsigned int ssid_len, 
+        uint64_t crypt_set, std::shared_ptr<kis_tracked_device_base> device) {
+    handle_ssid(ssid, ssid_len, crypt_set, device, ssid_role::responding);
 }
 
+void phy_80211_ssid_tracker::handle_probe_ssid(const std::string& ssid, unsigned int ssid_len, 
+        uint64_t crypt_set, std::shared_ptr<kis_tracked_device_base> device) {
+    handle_ssid(ssid, ssid_len, crypt_set, device, ssid_role::probing);
+}
@@ -22,6 +22,7 @@
 #include "config.h"
 
 #include <functional>
+#include <set>
 
 #include "devicetracker.h"
 #include "devicetracker_component.h"
@@ -95,7 +96,7 @@ public:
     }
 
     __Proxy(ssid_hash, uint64_t, uint64_t, uint64_t, ssid_hash);
-    __Proxy(ssid, std::string, std::string, std::string, ssid);
+    __ProxyInterned(ssid, ssid);
     __Proxy(ssid_len, uint32_t, uint32_t, uint32_t, ssid_len);
     __Proxy(crypt_set, uint64_t, uint64_t, uint64_t, crypt_set);
 
@@ -106,9 +107,10 @@ public:
     __Proxy(probing_device_len, uint64_t, uint64_t, uint64_t, probing_device_len);
     __Proxy(responding_device_len, uint64_t, uint64_t, uint64_t, responding_device_len);
 
-    void add_advertising_device(std::shared_ptr<kis_tracked_device_base> device);
-    void add_probing_device(std::shared_ptr<kis_tracked_device_base> device);
-    void add_responding_device(std::shared_ptr<kis_tracked_device_base> device);
+    // Add a device to the group, returning true if it was not already present
+    bool add_advertising_device(std::shared_ptr<kis_tracked_device_base> device);
+    bool add_probing_device(std::shared_ptr<kis_tracked_device_base> device);
+    bool add_responding_device(std::shared_ptr<kis_tracked_device_base> device);
 
     virtual void pre_serialize() override {
         // We have to protect our maps so we lock around them
@@ -178,7 +180,39 @@ public:
 protected:
     kis_mutex mutex;
 
-    ankerl::unordered_dense::map<size_t, std::shared_ptr<dot11_tracked_ssid_group>> ssid_map;
+    enum class ssid_role {
+        advertising, responding, probing
+    };
+
+    void handle_ssid(const std::string& ssid, unsigned int ssid_len, uint64_t crypt_set,
+            std::shared_ptr<kis_tracked_device_base> device, ssid_role role);
+
+    // Ordered (value, ssid hash) indexes, maintained as groups change so the SSID view
+    // can page and sort on these columns without copying and sorting every group
+    using ssid_index = std::set<std::pair<uint64_t, size_t>>;
+
+    ssid_index last_time_index;
+    ssid_index crypt_index;
+    ssid_index advertising_len_index;
+    ssid_index responding_len_index;
+    ssid_index probing_len_index;
+
+    // Group and the values it is currently filed under in each index
+    struct ssid_group_entry {
+        std::shared_ptr<dot11_tracked_ssid_group> group;
+        uint64_t last_time;
+        uint64_t advertising_len;
+        uint64_t responding_len;
+        uint64_t probing_len;
+    };
+
+    static void reindex(ssid_index& index, uint64_t& indexed, uint64_t value, size_t hash);
+
+    // Field ids of the indexed columns, to match datatables ordering requests
+    int last_time_field_id, crypt_field_id;
+    int advertising_len_field_id, responding_len_field_id, probing_len_field_id;
+
+    ankerl::unordered_dense::map<size_t, ssid_group_entry> ssid_map;
     std::shared_ptr<tracker_element_vector> ssid_vector;
 
     int tracked_ssid_id;
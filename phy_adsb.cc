@@ -205,13 +205,15 @@ kis_adsb_phy::kis_adsb_phy(int in_phyid) :
 
                                         });
 
+                                ws->set_closure_cb([vs_cast]() {
+                                        vs_cast->close_virtual_interface();
+                                    });
+
                                 try {
                                     ws->handle_request(con);
                                 } catch (const std::exception& e) {
-                                    ;
+                                    ws->close();
                                 }
-
-                                vs_cast->close_virtual_interface();
                         }));
 
                     return virtual_source;
@@ -299,13 +301,15 @@ kis_adsb_phy::kis_adsb_phy(int in_phyid) :
 
                 ws->binary();
 
+                ws->set_closure_cb([this, beast_handler_id]() {
+                        packetchain->remove_handler(beast_handler_id, CHAINPOS_LOGGING);
+                    });
+
                 try {
                     ws->handle_request(con);
                 } catch (const std::exception& e) {
-                    ;
+                    ws->close();
                 }
-            
-                packetchain->remove_handler(beast_handler_id, CHAINPOS_LOGGING);
             }));
 
     httpd->register_websocket_route("/phy/ADSB/raw", {httpd->RO_ROLE, "ADSB"}, {"ws"},
@@ -354,13 +358,15 @@ kis_adsb_phy::kis_adsb_phy(int in_phyid) :
 
                 ws->text();
 
+                ws->set_closure_cb([this, beast_handler_id]() {
+                        packetchain->remove_handler(beast_handler_id, CHAINPOS_LOGGING);
+                    });
+
                 try {
                     ws->handle_request(con);
                 } catch (const std::exception& e) {
-                    ;
+                    ws->close();
                 }
-            
-                packetchain->remove_handler(beast_handler_id, CHAINPOS_LOGGING);
             }));
 
     httpd->register_websocket_route("/datasource/by-uuid/:uuid/adsb_raw", {httpd->RO_ROLE, "ADSB"}, {"ws"},
@@ -423,13 +429,15 @@ kis_adsb_phy::kis_adsb_phy(int in_phyid) :
 
                 ws->text();
 
+                ws->set_closure_cb([this, beast_handler_id]() {
+                        packetchain->remove_handler(beast_handler_id, CHAINPOS_LOGGING);
+                    });
+
                 try {
                     ws->handle_request(con);
                 } catch (const std::exception& e) {
-                    ;
+                    ws->close();
                 }
-            
-                packetchain->remove_handler(beast_handler_id, CHAINPOS_LOGGING);
             }));
 
 }
@@ -16,10 +16,93 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <mutex>
+#include <unordered_map>
+
 #include "sqlite3_cpp11.h"
 
 namespace kissqlite3 {
 
+    // Idle cached statements per enabled connection
+    static std::mutex stmt_cache_mutex;
+    static std::unordered_map<sqlite3 *, std::unordered_multimap<std::string, sqlite3_stmt *>> stmt_cache;
+
+    void enable_statement_cache(sqlite3 *db) {
+        std::lock_guard<std::mutex> lk(stmt_cache_mutex);
+        stmt_cache.emplace(db, std::unordered_multimap<std::string, sqlite3_stmt *>{});
+    }
+
+    void release_statement_cache(sqlite3 *db) {
+        std::lock_guard<std::mutex> lk(stmt_cache_mutex);
+
+        auto c = stmt_cache.find(db);
+        if (c == stmt_cache.end())
+            return;
+
+        for (const auto& s : c->second)
+            sqlite3_finalize(s.second);
+
+        stmt_cache.erase(c);
+    }
+
+    static std::shared_ptr<sqlite3_stmt> wrap_cached(sqlite3 *db, const std::string& sql, 
+            sqlite3_stmt *stmt_raw) {
+        // Return the statement to the cache when released; if the cache for this
+        // connection has been released in the meantime, finalize it
+        return std::shared_ptr<sqlite3_stmt>(stmt_raw, [db, sql](sqlite3_stmt *p) {
+                std::lock_guard<std::mutex> lk(stmt_cache_mutex);
+
+                auto c = stmt_cache.find(db);
+
+                if (c == stmt_cache.end()) {
+                    sqlite3_finalize(p);
+                    return;
+                }
+
+                sqlite3_reset(p);
+                sqlite3_clear_bindings(p);
+                c->second.emplace(sql, p);
+            });
+    }
+
+    std::shared_ptr<sqlite3_stmt> prepare_cached(sqlite3 *db, const std::string& sql) {
+        bool cacheable = false;
+
+        {
+            std::lock_guard<std::mutex> lk(stmt_cache_mutex);
+
+            auto c = stmt_cache.find(db);
+
+            if (c != stmt_cache.end()) {
+                cacheable = true;
+
+                auto s = c->second.find(sql);
+
+                if (s != c->second.end()) {
+                    auto stmt_raw = s->second;
+                    c->second.erase(s);
+                    return wrap_cached(db, sql, stmt_raw);
+                }
+            }
+        }
+
+        const char *pz = nullptr;
+        sqlite3_stmt *stmt_raw = nullptr;
+
+        auto r = sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt_raw, &pz);
+
+        if (r != SQLITE_OK)
+            throw std::runtime_error("Failed to prepare statement: " + sql + " " + 
+                    std::string(sqlite3_errmsg(db)));
+
+        if (cacheable)
+            return wrap_cached(db, sql, stmt_raw);
+
+        return std::shared_ptr<sqlite3_stmt>(stmt_raw, [](sqlite3_stmt *p) {
+                sqlite3_finalize(p);
+            });
+    }
+
     std::ostream& operator<<(std::ostream& os, const query_element& q) {
         if (q.nested_query.size() > 0) {
             os << "(";
@@ -115,6 +115,18 @@ namespace kissqlite3 {
             bool end = false;
     };
 
+    // Prepared statement cache, keyed by the SQL text, per connection.  Connections opt in
+    // with enable_statement_cache; statements prepared with prepare_cached on an enabled
+    // connection are reset and returned to the cache when the last reference is released,
+    // instead of being finalized.  Statements on other connections are finalized as usual.
+    //
+    // release_statement_cache MUST be called before closing an enabled connection, since
+    // sqlite3_close fails while cached statements are still open.
+    void enable_statement_cache(sqlite3 *db);
+    void release_statement_cache(sqlite3 *db);
+
+    std::shared_ptr<sqlite3_stmt> prepare_cached(sqlite3 *db, const std::string& sql);
+
     // Template compiletime grammar elements
     
     enum class BindType {
@@ -149,7 +161,7 @@ namespace kissqlite3 {
     typedef struct __LIKE { std::string op = "LIKE"; } _LIKE;
     static auto LIKE = _LIKE{};
 
-    typedef struct __ORDERBY { std::string op = "ORDER_BY"; } _ORDERBY;
+    typedef struct __ORDERBY { std::string op = "ORDER BY"; } _ORDERBY;
     static auto ORDERBY = _ORDERBY{};
 
     typedef struct __LIMIT { std::string op = "LIMIT"; } _LIMIT;
@@ -416,19 +428,12 @@ namespace kissqlite3 {
             }
 
             int r;
-            const char *pz = nullptr;
 
-            sqlite3_stmt *stmt_raw;
-            auto str = os.str();
-            r = sqlite3_prepare(db, str.c_str(), os.str().length(), &stmt_raw, &pz);
-
-            if (r != SQLITE_OK)
-                throw std::runtime_error("Failed to prepare statement: " + os.str() + " " + 
-                        std::string(sqlite3_errmsg(db)));
+            // Release any previous run of this query first, so that re-running a query
+            // can pick its own statement back up from the cache
+            stmt.reset();
 
-            stmt = std::shared_ptr<sqlite3_stmt>(stmt_raw, [](sqlite3_stmt *p) {
-                    sqlite3_finalize(p);
-                });
+            stmt = prepare_cached(db, os.str());
 
             std::function<void (std::shared_ptr<sqlite3_stmt>, unsigned int&, const query_element&)> bind_function = 
                 [&bind_function](std::shared_ptr<sqlite3_stmt> stmt, unsigned int& bind_pos, const query_element& c) {
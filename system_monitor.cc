@@ -49,6 +49,10 @@ Systemmonitor::Systemmonitor() :
     eventbus = Globalreg::fetch_mandatory_global_as<event_bus>();
     timetracker = Globalreg::fetch_mandatory_global_as<time_tracker>();
 
+    eventbus->register_state_event(event_timestamp());
+    eventbus->register_state_event(event_battery());
+    eventbus->register_state_event(event_stats());
+
     status = std::make_shared<tracked_system_status>();
 
 #ifdef SYS_LINUX
@@ -106,7 +110,9 @@ Systemmonitor::Systemmonitor() :
         Globalreg::fetch_mandatory_global_as<kis_net_beast_httpd>();
 
     monitor_endp = std::make_shared<kis_net_web_tracked_endpoint>(status, monitor_mutex);
-    httpd->register_route("/system/status", {"GET", "POST"}, httpd->RO_ROLE, {}, monitor_endp);
+    // Status is refreshed once a second; every UI polls it
+    httpd->register_route("/system/status", {"GET", "POST"}, httpd->RO_ROLE, {},
+            std::make_shared<kis_net_web_cached_endpoint>(monitor_endp, std::chrono::seconds(1)));
 
     user_monitor_endp = std::make_shared<kis_net_web_tracked_endpoint>(
             [this](std::shared_ptr<kis_net_beast_httpd_connection>) -> std::shared_ptr<tracker_element> {
@@ -20,6 +20,61 @@
 
 #include "trackedcomponent.h"
 
+tracker_element_string_interner& tracker_element_string_interner::get() {
+    static tracker_element_string_interner interner;
+    return interner;
+}
+
+std::shared_ptr<tracker_element_string> tracker_element_string_interner::intern(uint16_t in_id,
+        const std::string& in_str) {
+    auto& i = get();
+
+    // Field id prefixes the value, so the same string in different fields gets
+    // distinct elements with the right ids
+    std::string key;
+    key.reserve(sizeof(uint16_t) + in_str.length());
+    key.append(reinterpret_cast<const char *>(&in_id), sizeof(uint16_t));
+    key.append(in_str);
+
+    kis_lock_guard<kis_mutex> lk(i.mutex, "tracker_element_string_interner intern");
+
+    auto pi = i.pool.find(key);
+    if (pi != i.pool.end()) {
+        auto e = pi->second.lock();
+        if (e != nullptr)
+            return e;
+    }
+
+    auto e = std::make_shared<tracker_element_string>(in_id, in_str);
+
+    if (pi != i.pool.end()) {
+        pi->second = e;
+        return e;
+    }
+
+    i.pool.emplace(std::move(key), e);
+
+    // Values nobody holds any more are swept once the pool doubles
+    if (i.pool.size() >= i.sweep_at) {
+        for (auto si = i.pool.begin(); si != i.pool.end(); ) {
+            if (si->second.expired())
+                si = i.pool.erase(si);
+            else
+                ++si;
+        }
+
+        i.sweep_at = kismax(i.pool.size() * 2, (size_t) 1024);
+    }
+
+    return e;
+}
+
+size_t tracker_element_string_interner::size() {
+    auto& i = get();
+    kis_lock_guard<kis_mutex> lk(i.mutex, "tracker_element_string_interner size");
+    return i.pool.size();
+}
+
 std::string tracker_component::get_name() {
     return Globalreg::globalreg->entrytracker->get_field_name(get_id());
 }
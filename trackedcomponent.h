@@ -39,6 +39,25 @@
 #include "nlohmann/json.hpp"
 
 
+// Pool of shared string elements, keyed by field id and value, for fields proxied
+// with __ProxyInterned or __ProxyFullyDynamicInterned.  Pooled elements are never
+// modified; setting a different value swaps in another pooled element.
+class tracker_element_string_interner {
+public:
+    static std::shared_ptr<tracker_element_string> intern(uint16_t in_id, const std::string& in_str);
+
+    // Number of pooled values, including ones no longer referenced which have not
+    // been swept yet
+    static size_t size();
+
+protected:
+    static tracker_element_string_interner& get();
+
+    kis_mutex mutex;
+    ankerl::unordered_dense::map<std::string, std::weak_ptr<tracker_element_string>> pool;
+    size_t sweep_at = 1024;
+};
+
 // Complex trackable unit based on trackertype dataunion.
 //
 // All tracker_components are built from maps.
@@ -766,6 +785,50 @@ class tracker_component : public tracker_element_map {
             cvar = in; \
         }
 
+// Proxy a string through the shared interning pool; records with the same value
+// share one element, and setting a new value swaps the element instead of writing
+// to it
+#define __ProxyInterned(name, cvar) \
+    inline shared_tracker_element get_tracker_##name() const { \
+        return (std::shared_ptr<tracker_element>) cvar; \
+    } \
+    inline std::string get_##name() const { \
+        return cvar->get(); \
+    } \
+    inline void set_##name(const std::string& in) { \
+        if (cvar->get() == in) \
+            return; \
+        cvar = tracker_element_string_interner::intern(cvar->get_id(), in); \
+        insert(cvar); \
+    }
+
+// Interned string which is only present in the map once set
+#define __ProxyFullyDynamicInterned(name, id) \
+    inline std::string get_##name() const { \
+        const auto ci = this->find(id); \
+        if (ci == this->cend()) \
+            return std::string{}; \
+        return std::static_pointer_cast<tracker_element_string>(ci->second)->get(); \
+    } \
+    inline const std::string get_only_##name() const { \
+        return get_##name(); \
+    } \
+    inline void set_##name(const std::string& in) { \
+        const auto ci = this->find(id); \
+        if (ci != this->cend() && \
+                std::static_pointer_cast<tracker_element_string>(ci->second)->get() == in) \
+            return; \
+        insert(tracker_element_string_interner::intern(id, in)); \
+    } \
+    inline bool has_##name() const { \
+        return this->find(id) != this->cend(); \
+    } \
+    inline void clear_##name() { \
+        auto ci = this->find(id); \
+        if (ci != this->end()) \
+            this->erase(ci); \
+    }
+
 // Proxy bitset functions (name, trackable type, data type, class var)
 #define __ProxyBitset(name, dtype, cvar) \
     inline void bitset_##name(dtype bs) { \